@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Benchmark the coordtransform extension against per-row ctypes calls.
+
+Build both libraries first (see README, "Python Bindings"), then run:
+
+    python3 bench_python_bindings.py [rows] [path/to/libcoord_datum_transform.so]
+
+The extension must be importable (current directory or PYTHONPATH). NumPy is
+used for the arrays when installed; array.array otherwise. The script checks
+that the batch results match the per-row calls before printing timings.
+"""
+
+import array
+import ctypes
+import math
+import random
+import sys
+import time
+
+import coordtransform as ct
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+class GeoCoord(ctypes.Structure):
+    _fields_ = [("latitude", ctypes.c_double), ("longitude", ctypes.c_double),
+                ("altitude", ctypes.c_double), ("datum", ctypes.c_int)]
+
+
+class UTMPoint(ctypes.Structure):
+    _fields_ = [("zone", ctypes.c_int), ("band", ctypes.c_char),
+                ("easting", ctypes.c_double), ("northing", ctypes.c_double),
+                ("convergence", ctypes.c_double), ("scale_factor", ctypes.c_double),
+                ("datum", ctypes.c_int)]
+
+
+COORD_FORMAT_UTM = 3
+
+
+def doubles(values):
+    return np.array(values, dtype=np.float64) if np else array.array("d", values)
+
+
+def zeros(n, typecode="d"):
+    if np:
+        return np.zeros(n, dtype=np.float64 if typecode == "d" else np.uint8)
+    return array.array(typecode, bytes(n * array.array(typecode).itemsize))
+
+
+def timed(fn):
+    start = time.perf_counter()
+    fn()
+    return time.perf_counter() - start
+
+
+def main():
+    rows = int(sys.argv[1]) if len(sys.argv) > 1 else 200000
+    lib = ctypes.CDLL(sys.argv[2] if len(sys.argv) > 2 else "./libcoord_datum_transform.so")
+    lib.coord_create_context.restype = ctypes.c_void_p
+    lib.coord_create_context.argtypes = [ctypes.c_int]
+    lib.coord_destroy_context.argtypes = [ctypes.c_void_p]
+    lib.coord_convert.argtypes = [ctypes.c_void_p, ctypes.POINTER(GeoCoord), ctypes.c_int,
+                                  ctypes.c_int, ctypes.c_char_p, ctypes.c_size_t]
+    lib.coord_to_utm.argtypes = [ctypes.c_void_p, ctypes.POINTER(GeoCoord),
+                                 ctypes.POINTER(UTMPoint)]
+
+    rng = random.Random(95)
+    lat_list = [rng.uniform(-79.0, 83.0) for _ in range(rows)]
+    lon_list = [rng.uniform(-180.0, 180.0) for _ in range(rows)]
+    lat, lon = doubles(lat_list), doubles(lon_list)
+    easting, northing = zeros(rows), zeros(rows)
+    zone, band = zeros(rows, "B"), zeros(rows, "B")
+
+    ctx = lib.coord_create_context(0)
+    point, utm = GeoCoord(), UTMPoint()
+    text = ctypes.create_string_buffer(128)
+
+    def per_row_string():
+        for la, lo in zip(lat_list, lon_list):
+            point.latitude, point.longitude = la, lo
+            lib.coord_convert(ctx, ctypes.byref(point), COORD_FORMAT_UTM, 0, text, 128)
+
+    per_row = []
+
+    def per_row_struct():
+        for la, lo in zip(lat_list, lon_list):
+            point.latitude, point.longitude = la, lo
+            lib.coord_to_utm(ctx, ctypes.byref(point), ctypes.byref(utm))
+            per_row.append((utm.zone, utm.easting, utm.northing))
+
+    t_string = timed(per_row_string)
+    t_struct = timed(per_row_struct)
+    t_batch = timed(lambda: ct.to_utm(lat, lon, easting, northing, zone, band))
+    lib.coord_destroy_context(ctx)
+
+    worst = max(abs(e - easting[i]) + abs(n - northing[i]) + abs(z - zone[i])
+                for i, (z, e, n) in enumerate(per_row))
+    print(f"to_utm matches per-row coord_to_utm: {'pass' if worst < 1e-6 else 'fail'}")
+    print(f"  {rows} rows: ctypes coord_convert {t_string * 1e3:.1f} ms, "
+          f"ctypes coord_to_utm {t_struct * 1e3:.1f} ms, to_utm {t_batch * 1e3:.1f} ms "
+          f"({t_string / t_batch:.0f}x)")
+
+    # Round trip, datum shift in place and geodesics on the same columns
+    lat2, lon2 = zeros(rows), zeros(rows)
+    t_inverse = timed(lambda: ct.from_utm(easting, northing, zone, band, lat2, lon2))
+    err = max(abs(lat2[i] - lat_list[i]) for i in range(0, rows, 97))
+    print(f"from_utm round trip: {'pass' if err < 1e-6 else 'fail'}")
+    t_datum = timed(lambda: ct.convert_datum(lat2, lon2, lat2, lon2, ct.DATUM_WGS84,
+                                             ct.DATUM_ED50))
+    dist = zeros(rows)
+    t_dist = timed(lambda: ct.distance(lat, lon, lat2, lon2, dist))
+    print(f"  from_utm {t_inverse * 1e3:.1f} ms, convert_datum {t_datum * 1e3:.1f} ms, "
+          f"distance {t_dist * 1e3:.1f} ms")
+    shift = max(dist[i] for i in range(0, rows, 97))
+    print(f"ED50 shift distances plausible (<500 m): "
+          f"{'pass' if 0.0 < shift < 500.0 and not math.isnan(shift) else 'fail'}")
+
+
+if __name__ == "__main__":
+    main()
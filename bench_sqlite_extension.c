@@ -0,0 +1,147 @@
+/*
+ * =====================================================================================
+ *
+ * Copyright (c) 2026 Zepp Health. All Rights Reserved. This computer program includes
+ * Confidential, Proprietary Information and is a Trade Secret of Zepp Health Ltd.
+ * All use, disclosure, and/or reproduction is prohibited unless authorized in writing.
+ * Licensed under the MIT License. You can contact below email if need.
+ *
+ * version: 0.0.1
+ * Author: wangwenbing@zepp.com
+ *
+ * =====================================================================================
+ */
+
+// Benchmark of the SQLite extension over an in-memory waypoint table. Build
+// the extension first (see README, "SQLite Extension"), then:
+//
+//   gcc -O2 bench_sqlite_extension.c coord_datum_transform.c geodesic.c -o bench_sqlite -lsqlite3 -lm
+//   ./bench_sqlite [rows] [path/to/coordsqlite]
+//
+// coord_convert() is compared against a function that creates a context per
+// row, and the checks compare the SQL results with each other before the
+// timings are printed.
+
+#include <sqlite3.h>
+#include "coord_datum_transform.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// What a naive binding does: a fresh context for every row
+static void naive_convert(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    (void)argc;
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    GeoCoord point = {sqlite3_value_double(argv[0]), sqlite3_value_double(argv[1]),
+                      0.0, DATUM_WGS84
+                     };
+    char text[128];
+    if (ctx && coord_convert(ctx, &point, (CoordFormat)sqlite3_value_int(argv[2]),
+                             DATUM_WGS84, text, sizeof(text)) == COORD_SUCCESS)
+    {
+        sqlite3_result_text(context, text, -1, SQLITE_TRANSIENT);
+    }
+    else
+    {
+        sqlite3_result_null(context);
+    }
+    coord_destroy_context(ctx);
+}
+
+// Run a one-value query; returns its elapsed time in ms
+static double query(sqlite3 *db, const char *sql, double *value)
+{
+    sqlite3_stmt *stmt;
+    clock_t t0 = clock();
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "%s\n", sqlite3_errmsg(db));
+        exit(1);
+    }
+    if (sqlite3_step(stmt) != SQLITE_ROW)
+    {
+        fprintf(stderr, "%s\n", sqlite3_errmsg(db));
+        exit(1);
+    }
+    *value = sqlite3_column_double(stmt, 0);
+    sqlite3_finalize(stmt);
+    return 1000.0 * (clock() - t0) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+    long rows = argc > 1 ? atol(argv[1]) : 10000000;
+    const char *extension = argc > 2 ? argv[2] : "./coordsqlite";
+    sqlite3 *db;
+    char *error = NULL;
+    if (sqlite3_open(":memory:", &db) != SQLITE_OK ||
+            sqlite3_enable_load_extension(db, 1) != SQLITE_OK ||
+            sqlite3_load_extension(db, extension, NULL, &error) != SQLITE_OK)
+    {
+        fprintf(stderr, "Cannot load %s: %s\n", extension,
+                error ? error : sqlite3_errmsg(db));
+        return 1;
+    }
+    sqlite3_create_function(db, "naive_convert", 3, SQLITE_UTF8, NULL,
+                            naive_convert, NULL, NULL);
+
+    // A random-walk track across Europe
+    sqlite3_exec(db, "CREATE TABLE waypoints(id INTEGER PRIMARY KEY, lat REAL, lon REAL);"
+                 "BEGIN", NULL, NULL, NULL);
+    sqlite3_stmt *insert;
+    sqlite3_prepare_v2(db, "INSERT INTO waypoints(lat, lon) VALUES(?, ?)", -1,
+                       &insert, NULL);
+    unsigned long seed = 97;
+    double lat = 48.0, lon = 2.0;
+    for (long i = 0; i < rows; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lat += ((double)(seed >> 11) / 9007199254740992.0 - 0.5) * 0.002;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lon += ((double)(seed >> 11) / 9007199254740992.0 - 0.5) * 0.003;
+        lat = fmin(fmax(lat, 36.0), 70.0);
+        lon = fmin(fmax(lon, -10.0), 30.0);
+        sqlite3_bind_double(insert, 1, lat);
+        sqlite3_bind_double(insert, 2, lon);
+        sqlite3_step(insert);
+        sqlite3_reset(insert);
+    }
+    sqlite3_finalize(insert);
+    sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
+
+    double naive_count, count, mismatches, length, pairwise, parse_error;
+    double t_naive = query(db, "SELECT count(naive_convert(lat, lon, 4)) FROM waypoints",
+                           &naive_count);
+    double t_convert = query(db, "SELECT count(coord_convert(lat, lon, 'MGRS')) "
+                             "FROM waypoints", &count);
+    query(db, "SELECT count(*) FROM waypoints WHERE id % 100 = 0 AND "
+          "coord_convert(lat, lon, 'MGRS') IS NOT naive_convert(lat, lon, 4)",
+          &mismatches);
+    printf("coord_convert() matches per-row contexts: %s\n",
+           count == rows && naive_count == rows && mismatches == 0 ? "pass" : "fail");
+    printf("  %ld rows: per-row context %.0f ms, cached context %.0f ms (%.1fx)\n",
+           rows, t_naive, t_convert, t_naive / t_convert);
+
+    double t_track = query(db, "SELECT coord_track_length(lat, lon) FROM "
+                           "(SELECT lat, lon FROM waypoints ORDER BY id)", &length);
+    double t_pairwise = query(db, "SELECT sum(coord_distance(lat, lon, lat2, lon2)) FROM "
+                              "(SELECT lat, lon, lead(lat) OVER w AS lat2, "
+                              "lead(lon) OVER w AS lon2 FROM waypoints "
+                              "WINDOW w AS (ORDER BY id))", &pairwise);
+    printf("coord_track_length() matches summed coord_distance(): %s\n",
+           fabs(length - pairwise) <= 1e-9 * pairwise ? "pass" : "fail");
+    printf("  %.1f km: aggregate %.0f ms, lead() + coord_distance() %.0f ms\n",
+           length / 1000.0, t_track, t_pairwise);
+
+    double t_parse = query(db, "SELECT max(abs(coord_parse_lat(m) - lat) + "
+                           "abs(coord_parse_lon(m) - lon)) FROM (SELECT lat, lon, "
+                           "coord_convert(lat, lon, 'MGRS') AS m FROM waypoints "
+                           "WHERE id % 10 = 0)", &parse_error);
+    printf("coord_parse_lat/lon() recover MGRS 1 m squares: %s\n",
+           parse_error < 1e-4 ? "pass" : "fail");
+    printf("  %ld rows converted and parsed: %.0f ms\n", rows / 10, t_parse);
+    sqlite3_close(db);
+    return 0;
+}
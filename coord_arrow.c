@@ -0,0 +1,525 @@
+/*
+ * =====================================================================================
+ *
+ * Copyright (c) 2026 Zepp Health. All Rights Reserved. This computer program includes
+ * Confidential, Proprietary Information and is a Trade Secret of Zepp Health Ltd.
+ * All use, disclosure, and/or reproduction is prohibited unless authorized in writing.
+ * Licensed under the MIT License. You can contact below email if need.
+ *
+ * version: 0.0.1
+ * Author: wangwenbing@zepp.com
+ *
+ * =====================================================================================
+ */
+
+// Apache Arrow C Data Interface import/export over the packed batch APIs.
+// Imported float64 columns are used in place; exported columns are allocated
+// once and filled directly by the batch conversions, so an engine holding
+// Arrow arrays (DuckDB, Polars, pyarrow) round-trips without copies.
+
+#include "coord_arrow.h"
+#include "coord_internal.h"
+#include <string.h>
+
+#define ARROW_MAX_CHILDREN 4
+#define ARROW_MGRS_BLOCK 1024      // MGRS points converted per formatting pass
+#define ARROW_MGRS_MAX_TEXT 24     // "60X AB 100000 100000" and terminator
+
+// Field of an exported struct schema
+typedef struct
+{
+    const char *format;
+    const char *name;
+} ArrowField;
+
+static const ArrowField utm_fields[] =
+{
+    {"C", "zone"}, {"u", "band"}, {"g", "easting"}, {"g", "northing"}
+};
+
+static const ArrowField datum_fields[] =
+{
+    {"g", "lat"}, {"g", "lon"}, {"g", "alt"}
+};
+
+// Private data of an exported array: its buffers and the child structs
+typedef struct
+{
+    CoordAllocator allocator;   // Copy of the context allocator
+    void *data[2];              // Owned buffers (values, or offsets and text)
+    const void *buffers[3];
+    struct ArrowArray *children[ARROW_MAX_CHILDREN];
+    struct ArrowArray child_arrays[ARROW_MAX_CHILDREN];
+} ArrowArrayOwner;
+
+// Private data of an exported struct schema; leaf schemas have none
+typedef struct
+{
+    CoordAllocator allocator;
+    struct ArrowSchema *children[ARROW_MAX_CHILDREN];
+    struct ArrowSchema child_schemas[ARROW_MAX_CHILDREN];
+} ArrowSchemaOwner;
+
+// ==================== Import ====================
+
+// Whether any slot in [start, start + length) of the array is null
+static int arrow_has_nulls(const struct ArrowArray *array, int64_t start,
+                           int64_t length)
+{
+    const uint8_t *bits = (const uint8_t *)array->buffers[0];
+    if (array->null_count == 0 || !bits)
+    {
+        return 0;
+    }
+    int64_t begin = array->offset + start;
+    for (int64_t i = begin; i < begin + length; i++)
+    {
+        if (!(bits[i >> 3] & (1u << (i & 7))))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// View `length` float64 values of an array, starting at logical slot `start`
+static int arrow_float64_view(const struct ArrowSchema *schema,
+                              const struct ArrowArray *array, int64_t start,
+                              int64_t length, double **values)
+{
+    if (!schema || !array || !schema->format || strcmp(schema->format, "g") != 0 ||
+            !array->release || array->n_buffers != 2 || array->offset < 0 ||
+            start < 0 || length < 0 || array->length < start + length ||
+            (length > 0 && !array->buffers[1]))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (arrow_has_nulls(array, start, length))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    *values = (double *)array->buffers[1] + array->offset + start;
+    return COORD_SUCCESS;
+}
+
+int coord_arrow_import_columns(const struct ArrowSchema *lat_schema,
+                               const struct ArrowArray *lat,
+                               const struct ArrowSchema *lon_schema,
+                               const struct ArrowArray *lon,
+                               const struct ArrowSchema *alt_schema,
+                               const struct ArrowArray *alt,
+                               MapDatum datum, GeoBatch *geo)
+{
+    if (!lat || !lon || !geo || datum >= DATUM_MAX || lon->length != lat->length ||
+            (alt && alt->length != lat->length))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    double *lat_values = NULL;
+    double *lon_values = NULL;
+    double *alt_values = NULL;
+    int ret = arrow_float64_view(lat_schema, lat, 0, lat->length, &lat_values);
+    if (ret == COORD_SUCCESS)
+    {
+        ret = arrow_float64_view(lon_schema, lon, 0, lon->length, &lon_values);
+    }
+    if (ret == COORD_SUCCESS && (alt_schema || alt))
+    {
+        ret = arrow_float64_view(alt_schema, alt, 0, lat->length, &alt_values);
+    }
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    *geo = coord_geo_batch_soa(lat_values, lon_values, alt_values,
+                               (size_t)lat->length, datum);
+    return COORD_SUCCESS;
+}
+
+// Index of the named child of a struct schema, or -1
+static int64_t arrow_find_field(const struct ArrowSchema *schema,
+                                const char *name)
+{
+    for (int64_t i = 0; i < schema->n_children; i++)
+    {
+        const struct ArrowSchema *child = schema->children[i];
+        if (child && child->name && strcmp(child->name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int coord_arrow_import_struct(const struct ArrowSchema *schema,
+                              const struct ArrowArray *array,
+                              const char *lat_field, const char *lon_field,
+                              const char *alt_field, MapDatum datum,
+                              GeoBatch *geo)
+{
+    if (!schema || !array || !lat_field || !lon_field || !geo ||
+            datum >= DATUM_MAX || !schema->format ||
+            strcmp(schema->format, "+s") != 0 || !array->release ||
+            array->n_children != schema->n_children || array->offset < 0 ||
+            array->length < 0 || arrow_has_nulls(array, 0, array->length))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+
+    const char *names[3] = {lat_field, lon_field, alt_field};
+    double *values[3] = {NULL, NULL, NULL};
+    for (int k = 0; k < 3 && names[k]; k++)
+    {
+        int64_t field = arrow_find_field(schema, names[k]);
+        if (field < 0)
+        {
+            return COORD_ERROR_INVALID_INPUT;
+        }
+        // Struct children are addressed through the parent's offset
+        int ret = arrow_float64_view(schema->children[field],
+                                     array->children[field], array->offset,
+                                     array->length, &values[k]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    *geo = coord_geo_batch_soa(values[0], values[1], values[2],
+                               (size_t)array->length, datum);
+    return COORD_SUCCESS;
+}
+
+// ==================== Export ====================
+
+static void arrow_release_array(struct ArrowArray *array)
+{
+    ArrowArrayOwner *owner = (ArrowArrayOwner *)array->private_data;
+    for (int64_t i = 0; i < array->n_children; i++)
+    {
+        // Children moved out by the consumer are already marked released
+        struct ArrowArray *child = array->children[i];
+        if (child->release)
+        {
+            child->release(child);
+        }
+    }
+    CoordAllocator allocator = owner->allocator;
+    coord_free(&allocator, owner->data[0]);
+    coord_free(&allocator, owner->data[1]);
+    coord_free(&allocator, owner);
+    array->release = NULL;
+}
+
+static void arrow_release_schema(struct ArrowSchema *schema)
+{
+    ArrowSchemaOwner *owner = (ArrowSchemaOwner *)schema->private_data;
+    for (int64_t i = 0; i < schema->n_children; i++)
+    {
+        struct ArrowSchema *child = schema->children[i];
+        if (child->release)
+        {
+            child->release(child);
+        }
+    }
+    if (owner)
+    {
+        CoordAllocator allocator = owner->allocator;
+        coord_free(&allocator, owner);
+    }
+    schema->release = NULL;
+}
+
+// Make `array` a live export of `length` slots with no buffers allocated yet.
+// Child structs start released, so a partly built array can be released.
+static ArrowArrayOwner *arrow_array_start(const CoordAllocator *alloc,
+                                          struct ArrowArray *array,
+                                          size_t length, int n_buffers,
+                                          int n_children)
+{
+    ArrowArrayOwner *owner = (ArrowArrayOwner *)coord_alloc(alloc, sizeof(*owner));
+    if (!owner)
+    {
+        return NULL;
+    }
+    memset(owner, 0, sizeof(*owner));
+    owner->allocator = *alloc;
+    for (int i = 0; i < n_children; i++)
+    {
+        owner->children[i] = &owner->child_arrays[i];
+    }
+    array->length = (int64_t)length;
+    array->null_count = 0;
+    array->offset = 0;
+    array->n_buffers = n_buffers;
+    array->n_children = n_children;
+    array->buffers = owner->buffers;
+    array->children = n_children > 0 ? owner->children : NULL;
+    array->dictionary = NULL;
+    array->release = arrow_release_array;
+    array->private_data = owner;
+    return owner;
+}
+
+// Allocate buffer `index` after the (absent) validity bitmap
+static void *arrow_array_buffer(ArrowArrayOwner *owner, int index, size_t size)
+{
+    void *data = coord_alloc(&owner->allocator, size > 0 ? size : 1);
+    owner->data[index] = data;
+    owner->buffers[index + 1] = data;
+    return data;
+}
+
+// Start child `index` of a struct array as a fixed-width column
+static void *arrow_fixed_child(const CoordAllocator *alloc,
+                               struct ArrowArray *parent, int index,
+                               size_t count, size_t width)
+{
+    ArrowArrayOwner *owner = arrow_array_start(alloc, parent->children[index],
+                                               count, 2, 0);
+    return owner ? arrow_array_buffer(owner, 0, count * width) : NULL;
+}
+
+static void arrow_schema_set(struct ArrowSchema *schema, const char *format,
+                             const char *name, int n_children,
+                             ArrowSchemaOwner *owner)
+{
+    schema->format = format;
+    schema->name = name;
+    schema->metadata = NULL;
+    schema->flags = 0;
+    schema->n_children = n_children;
+    schema->children = owner ? owner->children : NULL;
+    schema->dictionary = NULL;
+    schema->release = arrow_release_schema;
+    schema->private_data = owner;
+}
+
+// Export a schema; formats and names are static strings, never freed
+static int arrow_schema_export(const CoordAllocator *alloc,
+                               struct ArrowSchema *schema, const char *format,
+                               const char *name, const ArrowField *fields,
+                               int n_fields)
+{
+    ArrowSchemaOwner *owner = NULL;
+    if (n_fields > 0)
+    {
+        owner = (ArrowSchemaOwner *)coord_alloc(alloc, sizeof(*owner));
+        if (!owner)
+        {
+            return COORD_ERROR_MEMORY;
+        }
+        memset(owner, 0, sizeof(*owner));
+        owner->allocator = *alloc;
+        for (int i = 0; i < n_fields; i++)
+        {
+            owner->children[i] = &owner->child_schemas[i];
+            arrow_schema_set(owner->children[i], fields[i].format,
+                             fields[i].name, 0, NULL);
+        }
+    }
+    arrow_schema_set(schema, format, name, n_fields, owner);
+    return COORD_SUCCESS;
+}
+
+static int arrow_export_begin(CoordContext *ctx, const GeoBatch *geo,
+                              struct ArrowSchema *schema,
+                              struct ArrowArray *array)
+{
+    if (schema)
+    {
+        memset(schema, 0, sizeof(*schema));
+    }
+    if (array)
+    {
+        memset(array, 0, sizeof(*array));
+    }
+    if (!ctx || !geo || !schema || !array)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    // Offsets of the utf8 columns are 32-bit
+    return geo->count > INT32_MAX / ARROW_MGRS_MAX_TEXT ?
+           COORD_ERROR_OUT_OF_RANGE : COORD_SUCCESS;
+}
+
+// Release whatever was built when the export failed
+static int arrow_export_finish(int ret, struct ArrowSchema *schema,
+                               struct ArrowArray *array)
+{
+    if (ret != COORD_SUCCESS)
+    {
+        if (array->release)
+        {
+            array->release(array);
+        }
+        if (schema->release)
+        {
+            schema->release(schema);
+        }
+    }
+    return ret;
+}
+
+int coord_arrow_export_utm(CoordContext *ctx, const GeoBatch *geo,
+                           struct ArrowSchema *schema, struct ArrowArray *array)
+{
+    int ret = arrow_export_begin(ctx, geo, schema, array);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    size_t count = geo->count;
+    const CoordAllocator *alloc = &ctx->allocator;
+    unsigned char *zone = NULL;
+    int32_t *band_offsets = NULL;
+    char *band = NULL;
+    double *easting = NULL;
+    double *northing = NULL;
+    if (arrow_array_start(alloc, array, count, 1, 4))
+    {
+        zone = (unsigned char *)arrow_fixed_child(alloc, array, 0, count, 1);
+        ArrowArrayOwner *band_owner = arrow_array_start(alloc, array->children[1],
+                                                        count, 3, 0);
+        if (band_owner)
+        {
+            band_offsets = (int32_t *)arrow_array_buffer(
+                               band_owner, 0, (count + 1) * sizeof(int32_t));
+            band = (char *)arrow_array_buffer(band_owner, 1, count);
+        }
+        easting = (double *)arrow_fixed_child(alloc, array, 2, count,
+                                              sizeof(double));
+        northing = (double *)arrow_fixed_child(alloc, array, 3, count,
+                                               sizeof(double));
+    }
+
+    if (!zone || !band_offsets || !band || !easting || !northing)
+    {
+        ret = COORD_ERROR_MEMORY;
+    }
+    else
+    {
+        // The band letters are the utf8 text, one byte per row
+        UTMBatch utm = coord_utm_batch_soa(easting, northing, zone, band, count,
+                                           geo->datum);
+        ret = coord_to_utm_packed(ctx, geo, &utm);
+        for (size_t i = 0; i <= count; i++)
+        {
+            band_offsets[i] = (int32_t)i;
+        }
+    }
+    if (ret == COORD_SUCCESS)
+    {
+        ret = arrow_schema_export(alloc, schema, "+s", NULL, utm_fields, 4);
+    }
+    return arrow_export_finish(ret, schema, array);
+}
+
+int coord_arrow_export_mgrs(CoordContext *ctx, const GeoBatch *geo,
+                            struct ArrowSchema *schema, struct ArrowArray *array)
+{
+    int ret = arrow_export_begin(ctx, geo, schema, array);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    size_t count = geo->count;
+    const CoordAllocator *alloc = &ctx->allocator;
+    int32_t *offsets = NULL;
+    char *text = NULL;
+    ArrowArrayOwner *owner = arrow_array_start(alloc, array, count, 3, 0);
+    if (owner)
+    {
+        offsets = (int32_t *)arrow_array_buffer(owner, 0,
+                                                (count + 1) * sizeof(int32_t));
+        text = (char *)arrow_array_buffer(owner, 1, count * ARROW_MGRS_MAX_TEXT);
+    }
+    size_t block_size = count < ARROW_MGRS_BLOCK ? count : ARROW_MGRS_BLOCK;
+    MGRSPoint *block = (MGRSPoint *)coord_alloc(
+                           alloc, (block_size > 0 ? block_size : 1) * sizeof(MGRSPoint));
+
+    if (!offsets || !text || !block)
+    {
+        ret = COORD_ERROR_MEMORY;
+    }
+    else
+    {
+        // Format each block straight into the text buffer; the worst case is
+        // reserved per row, so every row has room for its terminator
+        size_t used = 0;
+        offsets[0] = 0;
+        for (size_t start = 0; start < count && ret == COORD_SUCCESS;
+                start += block_size)
+        {
+            GeoBatch part = *geo;
+            part.lat += start * geo->stride;
+            part.lon += start * geo->stride;
+            part.alt = geo->alt ? geo->alt + start * geo->stride : NULL;
+            part.count = count - start < block_size ? count - start : block_size;
+            ret = coord_to_mgrs_packed(ctx, &part, block);
+            for (size_t i = 0; i < part.count && ret == COORD_SUCCESS; i++)
+            {
+                ret = coord_format_mgrs(&block[i], text + used,
+                                        ARROW_MGRS_MAX_TEXT);
+                used += strlen(text + used);
+                offsets[start + i + 1] = (int32_t)used;
+            }
+        }
+        // Give back the unused reservation
+        char *fitted = ret == COORD_SUCCESS ?
+                       (char *)coord_realloc(alloc, text, used > 0 ? used : 1) : NULL;
+        if (fitted)
+        {
+            owner->data[1] = fitted;
+            owner->buffers[2] = fitted;
+        }
+    }
+    coord_free(alloc, block);
+    if (ret == COORD_SUCCESS)
+    {
+        ret = arrow_schema_export(alloc, schema, "u", "mgrs", NULL, 0);
+    }
+    return arrow_export_finish(ret, schema, array);
+}
+
+int coord_arrow_export_datum(CoordContext *ctx, const GeoBatch *geo,
+                             MapDatum target_datum, struct ArrowSchema *schema,
+                             struct ArrowArray *array)
+{
+    int ret = arrow_export_begin(ctx, geo, schema, array);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    size_t count = geo->count;
+    const CoordAllocator *alloc = &ctx->allocator;
+    int n_fields = geo->alt ? 3 : 2;
+    double *columns[3] = {NULL, NULL, NULL};
+    int missing = 1;
+    if (arrow_array_start(alloc, array, count, 1, n_fields))
+    {
+        missing = 0;
+        for (int i = 0; i < n_fields; i++)
+        {
+            columns[i] = (double *)arrow_fixed_child(alloc, array, i, count,
+                                                     sizeof(double));
+            missing |= columns[i] == NULL;
+        }
+    }
+
+    if (missing)
+    {
+        ret = COORD_ERROR_MEMORY;
+    }
+    else
+    {
+        GeoBatch out = coord_geo_batch_soa(columns[0], columns[1], columns[2],
+                                           count, target_datum);
+        ret = coord_convert_datum_packed(ctx, geo, target_datum, &out);
+    }
+    if (ret == COORD_SUCCESS)
+    {
+        ret = arrow_schema_export(alloc, schema, "+s", NULL, datum_fields,
+                                  n_fields);
+    }
+    return arrow_export_finish(ret, schema, array);
+}
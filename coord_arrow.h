@@ -0,0 +1,99 @@
+/*
+ * =====================================================================================
+ *
+ * Copyright (c) 2026 Zepp Health. All Rights Reserved. This computer program includes
+ * Confidential, Proprietary Information and is a Trade Secret of Zepp Health Ltd.
+ * All use, disclosure, and/or reproduction is prohibited unless authorized in writing.
+ * Licensed under the MIT License. You can contact below email if need.
+ *
+ * version: 0.0.1
+ * Author: wangwenbing@zepp.com
+ *
+ * =====================================================================================
+ */
+
+#ifndef COORD_ARROW_H
+#define COORD_ARROW_H
+
+#include <stdint.h>
+#include "coord_datum_transform.h"
+
+// Apache Arrow C Data Interface structures, copied from the stable ABI
+// definition so that no Arrow library is needed. The guard matches the one in
+// Arrow's own abi.h, so either header may be included first.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+struct ArrowArray
+{
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+// Arrow import: float64 ("g") arrays without nulls are viewed in place as a
+// GeoBatch with stride 1, honouring the array offsets. The batch aliases the
+// Arrow buffers, which stay owned by their producer: use it as an input only,
+// and only until the arrays are released. alt may be NULL.
+int coord_arrow_import_columns(const struct ArrowSchema *lat_schema,
+                               const struct ArrowArray *lat,
+                               const struct ArrowSchema *lon_schema,
+                               const struct ArrowArray *lon,
+                               const struct ArrowSchema *alt_schema,
+                               const struct ArrowArray *alt,
+                               MapDatum datum, GeoBatch *geo);
+
+// As above for a struct ("+s") array such as an exported record batch; the
+// columns are found by field name. alt_field may be NULL.
+int coord_arrow_import_struct(const struct ArrowSchema *schema,
+                              const struct ArrowArray *array,
+                              const char *lat_field, const char *lon_field,
+                              const char *alt_field, MapDatum datum,
+                              GeoBatch *geo);
+
+// Arrow export: results are written straight into newly allocated Arrow
+// buffers (context allocator) and handed over as a schema/array pair whose
+// release callbacks free them, so they may outlive the context. Children may
+// be moved out and released on their own, as the interface allows. On error
+// nothing is returned and both structs have a NULL release callback.
+//
+// coord_arrow_export_utm:   struct<zone: uint8, band: utf8, easting: float64,
+//                                  northing: float64>
+// coord_arrow_export_mgrs:  utf8, formatted as coord_format_mgrs()
+// coord_arrow_export_datum: struct<lat: float64, lon: float64[, alt: float64]>
+//                           in target_datum; alt only when the batch has one
+int coord_arrow_export_utm(CoordContext *ctx, const GeoBatch *geo,
+                           struct ArrowSchema *schema, struct ArrowArray *array);
+int coord_arrow_export_mgrs(CoordContext *ctx, const GeoBatch *geo,
+                            struct ArrowSchema *schema, struct ArrowArray *array);
+int coord_arrow_export_datum(CoordContext *ctx, const GeoBatch *geo,
+                             MapDatum target_datum, struct ArrowSchema *schema,
+                             struct ArrowArray *array);
+
+#endif // COORD_ARROW_H
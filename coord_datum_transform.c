@@ -13,6 +13,7 @@
  */
 
 #include "coord_datum_transform.h"
+#include "coord_internal.h"
 #include "geodesic.h"
 #include <math.h>
 #include <string.h>
@@ -20,6 +21,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 // Constants
 #ifndef M_PI
@@ -31,6 +35,9 @@
 #define PPM_TO_SCALE 1e-6
 #define METERS_TO_FEET 3.280839895
 #define FEET_TO_METERS 0.3048
+#define WEB_MERCATOR_DEFAULT_ZOOM 18
+#define MESH_DEFAULT_MAX_CELLS 1048576     // Cell budget of coord_mesh_create()
+#define GEOHASH_MAX_PRECISION 12
 
 // Ellipsoid definitions
 static const Ellipsoid ELLIPSOIDS[] =
@@ -90,6 +97,26 @@ static const double OSGB36_LON0 = -2.0 * DEG_TO_RAD; // True origin longitude
 static const double JAPAN_GRID_A = 6377397.155;
 static const double JAPAN_GRID_F = 1.0 / 299.1528128;
 
+// Default transform parameters, shared by every context until
+// coord_set_transform_params() gives it a private copy. WGS84 <-> NAD83,
+// MGRS Grid and UTM Grid are identities (all zero).
+static const DatumTransform DEFAULT_TRANSFORMS[DATUM_MAX][DATUM_MAX] =
+{
+    [DATUM_WGS84] = {
+        // WGS84 -> NAD27 (NADCON parameters, CONUS)
+        // Source: National Geodetic Survey
+        [DATUM_NAD27] = {-8.0, 160.0, 176.0, -0.25, 0.75, -0.06, -0.34},
+        // WGS84 -> ED50 (EPSG parameters)
+        // Source: EPSG Dataset
+        [DATUM_ED50] = {-87.0, -98.0, -121.0, -0.59, -0.32, -1.12, -3.72},
+        // WGS84 -> Tokyo (approximate parameters)
+        [DATUM_TOKYO] = {-148.0, 507.0, 685.0, 0.0, 0.0, 0.0, 0.0},
+        // WGS84 -> OSGB36 (OSTN15 parameters)
+        // Source: Ordnance Survey National Grid (OSTN15)
+        [DATUM_OSGB36] = {-446.448, 125.157, -542.060, -0.1502, -0.2470, -0.8421, 20.4894}
+    }
+};
+
 // Error messages
 static const char *ERROR_MESSAGES[] =
 {
@@ -118,6 +145,54 @@ static void set_error(int code, const char *message)
     }
 }
 
+// Global allocator; contexts copy it when they are created
+static CoordAllocator global_allocator = {NULL, NULL, NULL, NULL};
+
+void *coord_alloc(const CoordAllocator *alloc, size_t size)
+{
+    return alloc->malloc_fn ? alloc->malloc_fn(size, alloc->user_data) :
+           malloc(size);
+}
+
+void *coord_realloc(const CoordAllocator *alloc, void *ptr, size_t size)
+{
+    return alloc->realloc_fn ? alloc->realloc_fn(ptr, size, alloc->user_data) :
+           realloc(ptr, size);
+}
+
+void coord_free(const CoordAllocator *alloc, void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+    if (alloc->free_fn)
+    {
+        alloc->free_fn(ptr, alloc->user_data);
+    }
+    else
+    {
+        free(ptr);
+    }
+}
+
+// Fill an allocator from hook arguments; all set or all NULL
+static int make_allocator(CoordMallocFn malloc_fn, CoordReallocFn realloc_fn,
+                          CoordFreeFn free_fn, void *user_data,
+                          CoordAllocator *alloc)
+{
+    int set = (malloc_fn != NULL) + (realloc_fn != NULL) + (free_fn != NULL);
+    if (set != 0 && set != 3)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    alloc->malloc_fn = malloc_fn;
+    alloc->realloc_fn = realloc_fn;
+    alloc->free_fn = free_fn;
+    alloc->user_data = set ? user_data : NULL;
+    return COORD_SUCCESS;
+}
+
 // ==================== Basic utility functions ====================
 int coord_is_valid_latitude(double lat)
 {
@@ -142,13 +217,17 @@ double coord_normalize_latitude(double lat)
     return lat;
 }
 
+// fmod() is exact, and the single +/-360 correction of a remainder in
+// (-360, 360) is exact too, so any finite input wraps in constant time.
+// Infinities and NaN return NaN.
 double coord_normalize_longitude(double lon)
 {
-    while (lon > 180.0)
+    lon = fmod(lon, 360.0);
+    if (lon > 180.0)
     {
         lon -= 360.0;
     }
-    while (lon < -180.0)
+    else if (lon < -180.0)
     {
         lon += 360.0;
     }
@@ -175,6 +254,356 @@ double coord_feet_to_meters(double feet)
     return feet * FEET_TO_METERS;
 }
 
+// ==================== Trig kernels ====================
+// sin/cos/atan2 of the UTM and datum paths and asinh of Web Mercator. By
+// default these are libm. With COORD_FAST_TRIG they are the fdlibm minimax
+// polynomials (Sun Microsystems, freely redistributable) behind fdlibm's
+// medium-size reduction by pi/2 for |x| < 2^19 pi/2; larger or non-finite
+// arguments fall back to libm. The
+// reduction takes pi/2 in three 33-bit parts and applies the second and third
+// only when the remainder cancels, so results near multiples of pi/2 (180E,
+// the poles) keep full relative precision. Errors against glibc stay within
+// 1 ulp (sincos) and 2 ulp (atan2; 1.5 ulp against the exact value, from the
+// pi/2 - atan(x/y) branch), checked on 5e7 random geodetic and ECEF arguments
+// and on k pi/2 and its neighbours. Only +, *, / and sqrt are used, so
+// results are the same on every IEEE-754 target as long as the compiler does
+// not contract them into FMA: GCC does not at -std=c99, but clang does by default
+// (-ffp-contract=on), so pass -ffp-contract=off there for identical results.
+// asinh is fdlibm's, over its log and log1p series: within 2 ulp of the exact
+// value (1.73 seen) and 1 ulp of glibc. It is not faster than glibc's, which
+// is the same algorithm, but makes Web Mercator tiles platform-independent.
+#if defined(COORD_FAST_TRIG)
+#define TRIG_REDUCE_LIMIT 823549.6      // 2^19 * pi/2: n * PIO2_1 stays exact
+#define TRIG_CANCEL_2 1.52587890625e-05         // 2^-16: apply the second part
+#define TRIG_CANCEL_3 1.7763568394002505e-15    // 2^-49: apply the third part
+
+static const double TRIG_2_PI = 6.36619772367581382433e-01;
+static const double TRIG_ROUND = 6755399441055744.0;           // 2^52 + 2^51
+static const double TRIG_PIO2_1 = 1.57079632673412561417e+00;  // First 33 bits of pi/2
+static const double TRIG_PIO2_1T = 6.07710050650619224932e-11; // pi/2 - PIO2_1
+static const double TRIG_PIO2_2 = 6.07710050630396597660e-11;  // Second 33 bits
+static const double TRIG_PIO2_2T = 2.02226624879595063154e-21; // pi/2 - (PIO2_1 + PIO2_2)
+static const double TRIG_PIO2_3 = 2.02226624871116645580e-21;  // Third 33 bits
+static const double TRIG_PIO2_3T = 8.47842766036889956997e-32; // pi/2 - (PIO2_1 + ... + PIO2_3)
+
+// sin and cos of hi + lo on [-pi/4, pi/4], lo being the reduction tail
+static inline double trig_sin_kernel(double x, double lo)
+{
+    double z = x * x;
+    double v = z * x;
+    double r = 8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04 +
+               z * (2.75573137070700676789e-06 + z * (-2.50507602534068634195e-08 +
+                    z * 1.58969099521155010221e-10)));
+    return x - ((z * (0.5 * lo - v * r) - lo) - v * -1.66666666666666324348e-01);
+}
+
+static inline double trig_cos_kernel(double x, double lo)
+{
+    double z = x * x;
+    double r = z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 +
+                    z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07 +
+                         z * (2.08757232129817482790e-09 +
+                              z * -1.13596475577881948265e-11)))));
+    double hz = 0.5 * z;
+    double w = 1.0 - hz;
+    return w + (((1.0 - w) - hz) + (z * r - x * lo));
+}
+
+static inline void trig_sincos(double x, double *s, double *c)
+{
+    if (!(fabs(x) < TRIG_REDUCE_LIMIT))
+    {
+        *s = sin(x);
+        *c = cos(x);
+        return;
+    }
+    // Round to nearest through the 2^52 + 2^51 shift
+    double n = (x * TRIG_2_PI + TRIG_ROUND) - TRIG_ROUND;
+    double r = x - n * TRIG_PIO2_1;
+    double w = n * TRIG_PIO2_1T;
+    double hi = r - w;
+    // Near a multiple of pi/2 the remainder cancels; the extra parts are rare
+    // and predictable, so these branches cost nothing on geodetic input
+    if (fabs(hi) < fabs(x) * TRIG_CANCEL_2)
+    {
+        double t = r;
+        w = n * TRIG_PIO2_2;
+        r = t - w;
+        w = n * TRIG_PIO2_2T - ((t - r) - w);
+        hi = r - w;
+        if (fabs(hi) < fabs(x) * TRIG_CANCEL_3)
+        {
+            t = r;
+            w = n * TRIG_PIO2_3;
+            r = t - w;
+            w = n * TRIG_PIO2_3T - ((t - r) - w);
+            hi = r - w;
+        }
+    }
+    double lo = (r - hi) - w;
+    double sr = trig_sin_kernel(hi, lo);
+    double cr = trig_cos_kernel(hi, lo);
+    // Quadrant without branches (the quadrant of random angles is unpredictable)
+    long q = (long)n;
+    double a = (q & 1) ? cr : sr;
+    double b = (q & 1) ? sr : cr;
+    *s = (q & 2) ? -a : a;
+    *c = ((q + 1) & 2) ? -b : b;
+}
+
+// atan by argument reduction around 0.5, 1, 1.5 and infinity
+static inline double trig_atan(double x)
+{
+    static const double atan_hi[4] =
+    {
+        4.63647609000806093515e-01, 7.85398163397448278999e-01,
+        9.82793723247329054082e-01, 1.57079632679489655800e+00
+    };
+    static const double atan_lo[4] =
+    {
+        2.26987774529616870924e-17, 3.06161699786838301793e-17,
+        1.39033110312309984516e-17, 6.12323399573676603587e-17
+    };
+    double ax = fabs(x);
+    int id;
+    if (ax < 0.4375)
+    {
+        id = -1;
+    }
+    else if (ax < 0.6875)
+    {
+        id = 0;
+        ax = (2.0 * ax - 1.0) / (2.0 + ax);
+    }
+    else if (ax < 1.1875)
+    {
+        id = 1;
+        ax = (ax - 1.0) / (ax + 1.0);
+    }
+    else if (ax < 2.4375)
+    {
+        id = 2;
+        ax = (ax - 1.5) / (1.0 + 1.5 * ax);
+    }
+    else
+    {
+        id = 3;
+        ax = -1.0 / ax;
+    }
+    double z = ax * ax;
+    double w = z * z;
+    double s1 = z * (3.33333333333329318027e-01 + w * (1.42857142725034663711e-01 +
+                     w * (9.09088713343650656196e-02 + w * (6.66107313738753120669e-02 +
+                          w * (4.97687799461593236017e-02 + w * 1.62858201153657823623e-02)))));
+    double s2 = w * (-1.99999999998764832476e-01 + w * (-1.11111104054623557880e-01 +
+                     w * (-7.69187620504482999495e-02 + w * (-5.83357013379057348645e-02 +
+                          w * -3.65315727442169155270e-02))));
+    double r = id < 0 ? ax - ax * (s1 + s2) :
+               atan_hi[id] - ((ax * (s1 + s2) - atan_lo[id]) - ax);
+    return x < 0.0 ? -r : r;
+}
+
+static inline double trig_atan2(double y, double x)
+{
+    // Zeros, infinities and NaN keep the libm conventions
+    if (x == 0.0 || y == 0.0 || !(fabs(x) < HUGE_VAL) || !(fabs(y) < HUGE_VAL))
+    {
+        return atan2(y, x);
+    }
+    static const double pi_lo = 1.2246467991473531772e-16;     // pi - M_PI
+    static const double pio2_lo = 6.1232339957367658860e-17;   // pi/2 - M_PI/2
+    if (fabs(x) >= fabs(y))
+    {
+        double r = trig_atan(y / x);
+        if (x > 0.0)
+        {
+            return r;
+        }
+        return y > 0.0 ? M_PI + (r + pi_lo) : -M_PI + (r - pi_lo);
+    }
+    // |y| > |x|: +-pi/2 - atan(x/y)
+    double r = trig_atan(x / y);
+    return y > 0.0 ? M_PI / 2.0 - (r - pio2_lo) : -M_PI / 2.0 - (r + pio2_lo);
+}
+
+// Splits finite x >= 1 into 2^k (1 + f), 1 + f in [sqrt(2)/2, sqrt(2)); hx
+// gets the top 20 bits of the fraction of x
+static inline int trig_log_reduce(double x, double *f, int32_t *hx)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int32_t high = (int32_t)(bits >> 32);
+    int k = (high >> 20) - 1023;
+    high &= 0x000fffff;
+    int32_t i = (high + 0x95f64) & 0x100000;
+    bits = (uint64_t)(uint32_t)(high | (i ^ 0x3ff00000)) << 32 | (bits & 0xffffffffu);
+    memcpy(&x, &bits, sizeof(x));
+    *f = x - 1.0;
+    *hx = high;
+    return k + (i >> 20);
+}
+
+// fdlibm's minimax series for log(1 + f) = 2 atanh(s), s = f / (2 + f): the
+// part beyond 2s, over s
+static inline double trig_log_series(double s)
+{
+    double z = s * s;
+    double w = z * z;
+    double t1 = w * (3.999999999940941908e-01 + w * (2.222219843214978396e-01 +
+                     w * 1.531383769920937332e-01));
+    double t2 = z * (6.666666666666735130e-01 + w * (2.857142874366239149e-01 +
+                     w * (1.818357216161805012e-01 + w * 1.479819860511658591e-01)));
+    return t2 + t1;
+}
+
+static const double TRIG_LN2_HI = 6.93147180369123816490e-01;
+static const double TRIG_LN2_LO = 1.90821492927058770002e-10;
+
+// log(x) for finite x >= 1, as fdlibm's e_log.c
+static inline double trig_log(double x)
+{
+    double f;
+    int32_t hx;
+    double dk = (double)trig_log_reduce(x, &f, &hx);
+    double s = f / (2.0 + f);
+    double r = trig_log_series(s);
+    // Near 1 + f = sqrt(2) the f^2 / 2 term is split off for accuracy
+    if (((hx - 0x6147a) | (0x6b851 - hx)) > 0)
+    {
+        double hfsq = 0.5 * f * f;
+        return dk * TRIG_LN2_HI - ((hfsq - (s * (hfsq + r) + dk * TRIG_LN2_LO)) - f);
+    }
+    return dk * TRIG_LN2_HI - ((s * (f - r) - dk * TRIG_LN2_LO) - f);
+}
+
+// log(1 + u) for finite u >= 0, as fdlibm's s_log1p.c: below sqrt(2) - 1 the
+// series takes u itself; above, 1 + u is rounded and the lost part c / (1 + u)
+// joins the sum before its last rounding
+static inline double trig_log1p(double u)
+{
+    double f = u;
+    double c = 0.0;
+    int k = 0;
+    if (u >= 0.41421356237309503)
+    {
+        double y = 1.0 + u;
+        int32_t hx;
+        c = (u - (y - 1.0)) / y;
+        k = trig_log_reduce(y, &f, &hx);
+    }
+    double dk = (double)k;
+    double hfsq = 0.5 * f * f;
+    double s = f / (2.0 + f);
+    double r = trig_log_series(s);
+    return dk * TRIG_LN2_HI - ((hfsq - (s * (hfsq + r) + (dk * TRIG_LN2_LO + c))) - f);
+}
+
+// asinh as fdlibm's s_asinh.c computes it
+static inline double trig_asinh(double x)
+{
+    double ax = fabs(x);
+    if (!(ax < 268435456.0))        // 2^28, infinities and NaN
+    {
+        return asinh(x);
+    }
+    if (ax < 3.7252902984619141e-09)    // 2^-28: asinh(x) rounds to x
+    {
+        return x;
+    }
+    double w;
+    if (ax > 2.0)
+    {
+        w = trig_log(2.0 * ax + 1.0 / (sqrt(ax * ax + 1.0) + ax));
+    }
+    else
+    {
+        double t = ax * ax;
+        w = trig_log1p(ax + t / (1.0 + sqrt(1.0 + t)));
+    }
+    return x < 0.0 ? -w : w;
+}
+
+#else
+static inline void trig_sincos(double x, double *s, double *c)
+{
+    *s = sin(x);
+    *c = cos(x);
+}
+
+static inline double trig_asinh(double x)
+{
+    return asinh(x);
+}
+
+static inline double trig_atan2(double y, double x)
+{
+    return atan2(y, x);
+}
+
+static inline double trig_atan(double x)
+{
+    return atan(x);
+}
+#endif
+
+void coord_sincos(double x, double *s, double *c)
+{
+    trig_sincos(x, s, c);
+}
+
+double coord_atan2(double y, double x)
+{
+    return trig_atan2(y, x);
+}
+
+double coord_asinh(double x)
+{
+    return trig_asinh(x);
+}
+
+// ==================== Geocentric helpers ====================
+// Geodetic (radians, meters) to geocentric Cartesian coordinates
+static void geodetic_to_ecef(double a, double e2, double lat_rad, double lon_rad,
+                             double alt, double xyz[3])
+{
+    double sin_lat, cos_lat, sin_lon, cos_lon;
+    trig_sincos(lat_rad, &sin_lat, &cos_lat);
+    trig_sincos(lon_rad, &sin_lon, &cos_lon);
+    double N = a / sqrt(1.0 - e2 * sin_lat * sin_lat);
+    xyz[0] = (N + alt) * cos_lat * cos_lon;
+    xyz[1] = (N + alt) * cos_lat * sin_lon;
+    xyz[2] = (N * (1.0 - e2) + alt) * sin_lat;
+}
+
+// Geocentric Cartesian to geodetic (Bowring's method)
+static void ecef_to_geodetic(const Ellipsoid *ell, double X, double Y, double Z,
+                             double *lat_rad, double *lon_rad, double *alt)
+{
+    double p = sqrt(X * X + Y * Y);
+    double theta = trig_atan2(Z * ell->a, p * ell->b);
+    double sin_theta, cos_theta;
+    trig_sincos(theta, &sin_theta, &cos_theta);
+    double lat = trig_atan2(Z + ell->ep2 * ell->b * sin_theta * sin_theta * sin_theta,
+                            p - ell->e2 * ell->a * cos_theta * cos_theta * cos_theta);
+    *lat_rad = lat;
+    *lon_rad = trig_atan2(Y, X);
+    if (alt)
+    {
+        double sin_lat, cos_lat;
+        trig_sincos(lat, &sin_lat, &cos_lat);
+        double N = ell->a / sqrt(1.0 - ell->e2 * sin_lat * sin_lat);
+        // Near the poles p/cos(lat) loses precision; use the Z form instead
+        if (fabs(cos_lat) > 1e-3)
+        {
+            *alt = p / cos_lat - N;
+        }
+        else
+        {
+            *alt = Z / sin_lat - N * (1.0 - ell->e2);
+        }
+    }
+}
+
 // ==================== Context management ====================
 CoordContext *coord_create_context(MapDatum datum)
 {
@@ -182,76 +611,23 @@ CoordContext *coord_create_context(MapDatum datum)
     {
         return NULL;
     }
-    CoordContext *ctx = (CoordContext *)malloc(sizeof(CoordContext));
+    CoordAllocator owner = global_allocator;
+    CoordContext *ctx = (CoordContext *)coord_alloc(&owner, sizeof(CoordContext));
     if (!ctx)
     {
         set_error(COORD_ERROR_MEMORY, "Memory allocation failed");
         return NULL;
     }
     memset(ctx, 0, sizeof(CoordContext));
+    ctx->owner = owner;
+    ctx->allocator = owner;
+    ctx->tile_zoom = WEB_MERCATOR_DEFAULT_ZOOM;
+    ctx->mesh_max_cells = MESH_DEFAULT_MAX_CELLS;
     // Set ellipsoid
     ctx->ellipsoid = ELLIPSOIDS[datum];
-    // Initialize GeographicLib geodesic object
-    ctx->geod = (struct geod_geodesic *)malloc(sizeof(struct geod_geodesic));
-    if (!ctx->geod)
-    {
-        free(ctx);
-        set_error(COORD_ERROR_MEMORY, "Failed to create geodesic object");
-        return NULL;
-    }
-    geod_init(ctx->geod, ctx->ellipsoid.a, ctx->ellipsoid.f);
-    // Initialize transform parameter table
-    memset(ctx->transforms, 0, sizeof(ctx->transforms));
-    // Set default transform parameters
-    // WGS84 <-> NAD83 (nearly identical)
-    ctx->transforms[DATUM_WGS84][DATUM_NAD83].dx = 0.0;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD83].dy = 0.0;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD83].dz = 0.0;
-    ctx->transforms[DATUM_NAD83][DATUM_WGS84] =
-        ctx->transforms[DATUM_WGS84][DATUM_NAD83];
-    // WGS84 <-> MGRS Grid (same)
-    ctx->transforms[DATUM_WGS84][DATUM_MGRS_GRID].dx = 0.0;
-    ctx->transforms[DATUM_WGS84][DATUM_MGRS_GRID].dy = 0.0;
-    ctx->transforms[DATUM_WGS84][DATUM_MGRS_GRID].dz = 0.0;
-    ctx->transforms[DATUM_MGRS_GRID][DATUM_WGS84] =
-        ctx->transforms[DATUM_WGS84][DATUM_MGRS_GRID];
-    // WGS84 <-> UTM Grid (same)
-    ctx->transforms[DATUM_WGS84][DATUM_UTM_GRID].dx = 0.0;
-    ctx->transforms[DATUM_WGS84][DATUM_UTM_GRID].dy = 0.0;
-    ctx->transforms[DATUM_WGS84][DATUM_UTM_GRID].dz = 0.0;
-    ctx->transforms[DATUM_UTM_GRID][DATUM_WGS84] =
-        ctx->transforms[DATUM_WGS84][DATUM_UTM_GRID];
-    // WGS84 -> NAD27 (NADCON parameters, CONUS)
-    // Source: National Geodetic Survey
-    ctx->transforms[DATUM_WGS84][DATUM_NAD27].dx = -8.0;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD27].dy = 160.0;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD27].dz = 176.0;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD27].rx = -0.25;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD27].ry = 0.75;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD27].rz = -0.06;
-    ctx->transforms[DATUM_WGS84][DATUM_NAD27].scale = -0.34;
-    // WGS84 -> ED50 (EPSG parameters)
-    // Source: EPSG Dataset
-    ctx->transforms[DATUM_WGS84][DATUM_ED50].dx = -87.0;
-    ctx->transforms[DATUM_WGS84][DATUM_ED50].dy = -98.0;
-    ctx->transforms[DATUM_WGS84][DATUM_ED50].dz = -121.0;
-    ctx->transforms[DATUM_WGS84][DATUM_ED50].rx = -0.59;
-    ctx->transforms[DATUM_WGS84][DATUM_ED50].ry = -0.32;
-    ctx->transforms[DATUM_WGS84][DATUM_ED50].rz = -1.12;
-    ctx->transforms[DATUM_WGS84][DATUM_ED50].scale = -3.72;
-    // WGS84 -> Tokyo (approximate parameters)
-    ctx->transforms[DATUM_WGS84][DATUM_TOKYO].dx = -148.0;
-    ctx->transforms[DATUM_WGS84][DATUM_TOKYO].dy = 507.0;
-    ctx->transforms[DATUM_WGS84][DATUM_TOKYO].dz = 685.0;
-    // WGS84 -> OSGB36 (OSTN15 parameters)
-    // Source: Ordnance Survey National Grid (OSTN15)
-    ctx->transforms[DATUM_WGS84][DATUM_OSGB36].dx = -446.448;
-    ctx->transforms[DATUM_WGS84][DATUM_OSGB36].dy = 125.157;
-    ctx->transforms[DATUM_WGS84][DATUM_OSGB36].dz = -542.060;
-    ctx->transforms[DATUM_WGS84][DATUM_OSGB36].rx = -0.1502;
-    ctx->transforms[DATUM_WGS84][DATUM_OSGB36].ry = -0.2470;
-    ctx->transforms[DATUM_WGS84][DATUM_OSGB36].rz = -0.8421;
-    ctx->transforms[DATUM_WGS84][DATUM_OSGB36].scale = 20.4894;
+    // The geodesic object is created on first use, and the transform table
+    // is shared until coord_set_transform_params() changes it
+    ctx->transforms = DEFAULT_TRANSFORMS;
     return ctx;
 }
 
@@ -259,12 +635,34 @@ void coord_destroy_context(CoordContext *ctx)
 {
     if (ctx)
     {
-        if (ctx->geod)
+        // Copy first: the allocator lives inside the block being freed
+        CoordAllocator owner = ctx->owner;
+        coord_free(&owner, ctx->geod);
+        if (ctx->transforms != DEFAULT_TRANSFORMS)
         {
-            free(ctx->geod);
+            coord_free(&owner, (void *)ctx->transforms);
         }
-        free(ctx);
+        coord_free(&owner, ctx);
+    }
+}
+
+int coord_set_allocator(CoordMallocFn malloc_fn, CoordReallocFn realloc_fn,
+                        CoordFreeFn free_fn, void *user_data)
+{
+    return make_allocator(malloc_fn, realloc_fn, free_fn, user_data,
+                          &global_allocator);
+}
+
+int coord_context_set_allocator(CoordContext *ctx, CoordMallocFn malloc_fn,
+                                CoordReallocFn realloc_fn, CoordFreeFn free_fn,
+                                void *user_data)
+{
+    if (!ctx)
+    {
+        return COORD_ERROR_INVALID_INPUT;
     }
+    return make_allocator(malloc_fn, realloc_fn, free_fn, user_data,
+                          &ctx->allocator);
 }
 
 int coord_set_datum(CoordContext *ctx, MapDatum datum)
@@ -274,114 +672,93 @@ int coord_set_datum(CoordContext *ctx, MapDatum datum)
         return COORD_ERROR_INVALID_INPUT;
     }
     ctx->ellipsoid = ELLIPSOIDS[datum];
-    geod_init(ctx->geod, ctx->ellipsoid.a, ctx->ellipsoid.f);
+    if (ctx->geod)
+    {
+        geod_init(ctx->geod, ctx->ellipsoid.a, ctx->ellipsoid.f);
+    }
     return COORD_SUCCESS;
 }
 
 // ==================== UTM zone calculation ====================
+// Zones and bands come from one table lookup instead of comparison chains.
+// Rows are latitude bands: row 0 is below 80S, rows 1-20 are C-X (X spans
+// 72N-84N) and row 21 is 84N and above. Zone exceptions only occur in V
+// (Norway) and X (Svalbard) between 0E and 42E, on 3-degree boundaries, so
+// each row holds overrides for 14 three-degree columns plus a zero sentinel
+// column used for every other longitude.
+#define UTM_BAND_ROWS 22
+#define UTM_EXCEPTION_COLUMNS 14
+
+static const char UTM_BAND_ROW_LETTER[UTM_BAND_ROWS + 1] = "CCDEFGHJKLMNPQRSTUVWXX";
+
+static const unsigned char UTM_ZONE_EXCEPTION[UTM_BAND_ROWS][UTM_EXCEPTION_COLUMNS + 1] =
+{
+    [18] = {0, 32, 32, 32},                                         // V: 3E-12E
+    [20] = {31, 31, 31, 33, 33, 33, 33, 35, 35, 35, 35, 37, 37, 37} // X
+};
+
+// Table row of a latitude. The latitude is clamped to [-88, 72] and floored
+// to a multiple of 8 by truncation plus a compare-and-subtract against the
+// exact band edge, so no step branches on data (and denormals stay south).
+static int utm_band_row(double latitude)
+{
+    double lat = latitude < -88.0 ? -88.0 : latitude;
+    lat = lat > 72.0 ? 72.0 : lat;
+    int row = (int)(lat / 8.0);
+    row -= (lat < row * 8.0);
+    return row + 11 + (latitude >= 84.0);
+}
+
+// Zone and band of a point already known to be in range
+static void utm_classify(double longitude, double latitude, int *zone,
+                         char *band)
+{
+    // Normalize longitude to [-180, 180); fmod() only for the rare wrap
+    double lon_norm = longitude;
+    if (!(longitude >= -180.0 && longitude < 180.0))
+    {
+        lon_norm = coord_normalize_longitude(longitude);
+        lon_norm -= (lon_norm >= 180.0) * 360.0;
+    }
+    // Standard UTM zone, clamped to 1-60
+    int z = (int)((lon_norm + 180.0) / 6.0) + 1;
+    z = z < 1 ? 1 : z;
+    z = z > 60 ? 60 : z;
+    // Exception column: 0-13 for 0E-42E, otherwise the zero sentinel
+    double c = lon_norm / 3.0;
+    int col = (int)c;
+    col = (c >= 0.0 && col < UTM_EXCEPTION_COLUMNS) ? col : UTM_EXCEPTION_COLUMNS;
+    int row = utm_band_row(latitude);
+    int exception = UTM_ZONE_EXCEPTION[row][col];
+    *zone = exception ? exception : z;
+    *band = UTM_BAND_ROW_LETTER[row];
+}
+
+// Zone lookup for a longitude/latitude already known to be in range
+static int utm_zone_unchecked(double longitude, double latitude)
+{
+    int zone;
+    char band;
+    utm_classify(longitude, latitude, &zone, &band);
+    return zone;
+}
+
 int coord_get_utm_zone(double longitude, double latitude)
 {
     if (!coord_is_valid_longitude(longitude) || !coord_is_valid_latitude(latitude))
     {
         return 0;
     }
-    // Normalize longitude
-    double lon_norm = longitude;
-    while (lon_norm < -180.0)
-    {
-        lon_norm += 360.0;
-    }
-    while (lon_norm >= 180.0)
-    {
-        lon_norm -= 360.0;
-    }
-    // Special-case regions
-    if (latitude >= 56.0 && latitude < 64.0)
-    {
-        if (lon_norm >= 3.0 && lon_norm < 12.0)
-        {
-            return 32;
-        }
-    }
-    if (latitude >= 72.0 && latitude < 84.0)
-    {
-        if (lon_norm >= 0.0 && lon_norm < 9.0)
-        {
-            return 31;
-        }
-        else if (lon_norm >= 9.0 && lon_norm < 21.0)
-        {
-            return 33;
-        }
-        else if (lon_norm >= 21.0 && lon_norm < 33.0)
-        {
-            return 35;
-        }
-        else if (lon_norm >= 33.0 && lon_norm < 42.0)
-        {
-            return 37;
-        }
-    }
-    // Standard UTM zone
-    int zone = (int)((lon_norm + 180.0) / 6.0) + 1;
-    if (zone < 1)
-    {
-        zone = 1;
-    }
-    if (zone > 60)
-    {
-        zone = 60;
-    }
-    return zone;
+    return utm_zone_unchecked(longitude, latitude);
 }
 
 char coord_get_utm_band(double latitude)
 {
-    if (latitude < -80.0)
-    {
-        return 'C';
-    }
-    if (latitude > 84.0)
-    {
-        return 'X';
-    }
-    // UTM latitude band table (8° per band, skipping I and O)
-    struct
-    {
-        double min, max;
-        char band;
-    } bands[] =
-    {
-        {80.0, 84.0, 'X'},
-        {72.0, 80.0, 'X'},
-        {64.0, 72.0, 'W'},
-        {56.0, 64.0, 'V'},
-        {48.0, 56.0, 'U'},
-        {40.0, 48.0, 'T'},
-        {32.0, 40.0, 'S'},
-        {24.0, 32.0, 'R'},
-        {16.0, 24.0, 'Q'},
-        {8.0, 16.0, 'P'},
-        {0.0, 8.0, 'N'},
-        {-8.0, 0.0, 'M'},
-        {-16.0, -8.0, 'L'},
-        {-24.0, -16.0, 'K'},
-        {-32.0, -24.0, 'J'},
-        {-40.0, -32.0, 'H'},
-        {-48.0, -40.0, 'G'},
-        {-56.0, -48.0, 'F'},
-        {-64.0, -56.0, 'E'},
-        {-72.0, -64.0, 'D'},
-        {-80.0, -72.0, 'C'}
-    };
-    for (int i = 0; i < 21; i++)
+    if (isnan(latitude))
     {
-        if (latitude >= bands[i].min && latitude < bands[i].max)
-        {
-            return bands[i].band;
-        }
+        return 'Z';
     }
-    return 'Z'; // Should not reach here
+    return UTM_BAND_ROW_LETTER[utm_band_row(latitude)];
 }
 
 // ==================== Coordinate validation ====================
@@ -395,7 +772,9 @@ int coord_validate_point(const GeoCoord *coord)
            coord_is_valid_longitude(coord->longitude);
 }
 
-int coord_validate_utm(const UTMPoint *utm)
+// UTM check with a caller-supplied easting range
+static int utm_in_range(const UTMPoint *utm, double easting_min,
+                        double easting_max)
 {
     if (!utm)
     {
@@ -411,30 +790,24 @@ int coord_validate_utm(const UTMPoint *utm)
         return 0;
     }
     // Relax easting check range
-    if (utm->easting < 100000.0 || utm->easting > 900000.0)
+    if (!(utm->easting >= easting_min && utm->easting <= easting_max))
     {
         return 0;
     }
-    // Relax northing check range, consider hemispheres
-    if (utm->band >= 'N' && utm->band <= 'X')
-    {
-        // Northern hemisphere: 0-10,000,000 m
-        if (utm->northing < 0.0 || utm->northing > 10000000.0)
-        {
-            return 0;
-        }
-    }
-    else
+    // Northing 0-10,000,000 m in both hemispheres (southern bands carry the
+    // 10,000,000 m false northing at the equator, as produced by coord_to_utm)
+    if (!(utm->northing >= 0.0 && utm->northing <= 10000000.0))
     {
-        // Southern hemisphere: 10,000,000-20,000,000 m (false northing)
-        if (utm->northing < 10000000.0 || utm->northing > 20000000.0)
-        {
-            return 0;
-        }
+        return 0;
     }
     return 1;
 }
 
+int coord_validate_utm(const UTMPoint *utm)
+{
+    return utm_in_range(utm, 100000.0, 900000.0);
+}
+
 static int coord_validate_mgrs(const MGRSPoint *mgrs)
 {
     if (!mgrs)
@@ -478,6 +851,19 @@ static int coord_validate_mgrs(const MGRSPoint *mgrs)
 }
 
 // ==================== Coordinate parsing ====================
+// Web Mercator kernels, defined with the Web Mercator tile functions below
+static int web_mercator_valid(const WebMercatorPoint *wm);
+static void geo_from_web_mercator_unchecked(const WebMercatorPoint *wm,
+        GeoCoord *geo);
+// Geohash and quadkey kernels, defined with the cell functions below
+static int geohash_decode(const char *hash, size_t length, GeoCoord *geo);
+static int quadkey_decode(const char *key, size_t length, GeoCoord *geo);
+static int geohash_from_geo_unchecked(const GeoCoord *geo, int precision,
+                                      GeohashPoint *gh);
+static int quadkey_from_geo_unchecked(const CoordContext *ctx,
+                                      const GeoCoord *geo, int zoom,
+                                      QuadkeyPoint *qk);
+
 ParseResult coord_parse_string(const char *str, CoordFormat format,
                                MapDatum datum)
 {
@@ -835,6 +1221,59 @@ ParseResult coord_parse_string(const char *str, CoordFormat format,
             result.success = 1;
             break;
         }
+        case COORD_FORMAT_WEB_MERCATOR:
+        {
+            // Format: "15/17062/10410 (128.00, 64.50)" or "15/17062/10410"
+            // (tile centre)
+            WebMercatorPoint wm = {0, 0, 0, 128.0, 128.0, DATUM_WGS84};
+            int count = sscanf(str, "%d/%d/%d (%lf, %lf)", &wm.zoom, &wm.x,
+                               &wm.y, &wm.pixel_x, &wm.pixel_y);
+            if (count != 3 && count != 5)
+            {
+                strcpy(result.error_msg, "Failed to parse Web Mercator format");
+                return result;
+            }
+            if (!web_mercator_valid(&wm))
+            {
+                strcpy(result.error_msg, "Invalid Web Mercator tile");
+                return result;
+            }
+            geo_from_web_mercator_unchecked(&wm, &result.coord);
+            result.success = 1;
+            break;
+        }
+        case COORD_FORMAT_GEOHASH:
+        case COORD_FORMAT_QUADKEY:
+        {
+            // Format: "u4pruydqqvj" or "120210233", a single token
+            size_t length = 0;
+            while (str[length] && !isspace((unsigned char)str[length]))
+            {
+                length++;
+            }
+            const char *rest = str + length;
+            while (isspace((unsigned char)*rest))
+            {
+                rest++;
+            }
+            int ret = *rest ? COORD_ERROR_PARSE_FAILED :
+                      format == COORD_FORMAT_GEOHASH ?
+                      geohash_decode(str, length, &result.coord) :
+                      quadkey_decode(str, length, &result.coord);
+            if (ret != COORD_SUCCESS)
+            {
+                snprintf(result.error_msg, sizeof(result.error_msg),
+                         "Failed to parse %s format",
+                         format == COORD_FORMAT_GEOHASH ? "Geohash" : "quadkey");
+                return result;
+            }
+            if (format == COORD_FORMAT_GEOHASH)
+            {
+                result.coord.datum = datum;
+            }
+            result.success = 1;
+            break;
+        }
         default:
             snprintf(result.error_msg, sizeof(result.error_msg),
                      "Unsupported format: %d", format);
@@ -916,6 +1355,16 @@ ParseResult coord_auto_parse(const char *str)
             }
         }
     }
+    // Check for Web Mercator tile format
+    int tile[3];
+    if (sscanf(s, "%d/%d/%d", &tile[0], &tile[1], &tile[2]) == 3)
+    {
+        result = coord_parse_string(str, COORD_FORMAT_WEB_MERCATOR, DATUM_WGS84);
+        if (result.success)
+        {
+            return result;
+        }
+    }
     // Check for Japan Grid format
     int j_zone;
     double x, y;
@@ -928,6 +1377,26 @@ ParseResult coord_auto_parse(const char *str)
             return result;
         }
     }
+    // Check for a single quadkey or Geohash token (digits 0-3 only read as
+    // a quadkey)
+    size_t length = strspn(s, "0123");
+    if (length > 0 && s[length + strspn(s + length, " \t\r\n")] == '\0')
+    {
+        result = coord_parse_string(str, COORD_FORMAT_QUADKEY, DATUM_WGS84);
+        if (result.success)
+        {
+            return result;
+        }
+    }
+    length = strspn(s, "0123456789bcdefghjkmnpqrstuvwxyz");
+    if (length > 0 && s[length + strspn(s + length, " \t\r\n")] == '\0')
+    {
+        result = coord_parse_string(str, COORD_FORMAT_GEOHASH, DATUM_WGS84);
+        if (result.success)
+        {
+            return result;
+        }
+    }
     // Try other formats
     CoordFormat formats[] = {COORD_FORMAT_DD, COORD_FORMAT_DMS, COORD_FORMAT_DMM};
     MapDatum datum = DATUM_WGS84;
@@ -964,12 +1433,34 @@ int coord_format_to_string(const GeoCoord *coord, CoordFormat format,
             return coord_format_dmm(coord, buffer, buffer_size);
         case COORD_FORMAT_DMS:
             return coord_format_dms(coord, buffer, buffer_size);
-        default:
-            return COORD_ERROR_UNSUPPORTED_FORMAT;
-    }
-}
-
-int coord_format_dd(const GeoCoord *coord, char *buffer, size_t buffer_size)
+        case COORD_FORMAT_GEOHASH:
+        {
+            GeohashPoint gh;
+            geohash_from_geo_unchecked(coord, GEOHASH_MAX_PRECISION, &gh);
+            return coord_format_geohash(&gh, buffer, buffer_size);
+        }
+        case COORD_FORMAT_QUADKEY:
+        {
+            // No context to shift other datums with
+            if (coord->datum != DATUM_WGS84)
+            {
+                return COORD_ERROR_DATUM_TRANSFORM;
+            }
+            QuadkeyPoint qk;
+            int ret = quadkey_from_geo_unchecked(NULL, coord,
+                                                 WEB_MERCATOR_DEFAULT_ZOOM, &qk);
+            if (ret != COORD_SUCCESS)
+            {
+                return ret;
+            }
+            return coord_format_quadkey(&qk, buffer, buffer_size);
+        }
+        default:
+            return COORD_ERROR_UNSUPPORTED_FORMAT;
+    }
+}
+
+int coord_format_dd(const GeoCoord *coord, char *buffer, size_t buffer_size)
 {
     if (!coord || !buffer)
     {
@@ -1082,49 +1573,101 @@ int coord_format_japan_grid(const JapanGridPoint *jg, char *buffer,
             || (size_t)written >= buffer_size) ? COORD_ERROR_FORMAT : COORD_SUCCESS;
 }
 
-// ==================== Coordinate conversion functions ====================
-// Geographic coordinate to UTM
-int coord_to_utm(CoordContext *ctx, const GeoCoord *geo, UTMPoint *utm)
+int coord_format_web_mercator(const WebMercatorPoint *wm, char *buffer,
+                              size_t buffer_size)
 {
-    if (!ctx || !geo || !utm)
+    if (!wm || !buffer)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_point(geo))
+    int written = snprintf(buffer, buffer_size, "%d/%d/%d (%.2f, %.2f)",
+                           wm->zoom, wm->x, wm->y, wm->pixel_x, wm->pixel_y);
+    return (written < 0
+            || (size_t)written >= buffer_size) ? COORD_ERROR_FORMAT : COORD_SUCCESS;
+}
+
+int coord_format_geohash(const GeohashPoint *gh, char *buffer,
+                         size_t buffer_size)
+{
+    if (!gh || !buffer)
     {
-        return COORD_ERROR_INVALID_COORD;
+        return COORD_ERROR_INVALID_INPUT;
     }
-    // Calculate UTM zone
-    int zone = coord_get_utm_zone(geo->longitude, geo->latitude);
-    if (zone < 1 || zone > 60)
+    int written = snprintf(buffer, buffer_size, "%.12s", gh->hash);
+    return (written < 0
+            || (size_t)written >= buffer_size) ? COORD_ERROR_FORMAT : COORD_SUCCESS;
+}
+
+int coord_format_quadkey(const QuadkeyPoint *qk, char *buffer,
+                         size_t buffer_size)
+{
+    if (!qk || !buffer)
     {
-        return COORD_ERROR_INVALID_UTM_ZONE;
+        return COORD_ERROR_INVALID_INPUT;
     }
-    // Calculate central meridian
-    double lon_center = (zone - 1) * 6.0 - 180.0 + 3.0;
-    // Convert to radians
-    double lat_rad = coord_deg_to_rad(geo->latitude);
-    double lon_rad = coord_deg_to_rad(geo->longitude);
-    double lon_center_rad = coord_deg_to_rad(lon_center);
-    // UTM conversion parameters
-    double k0 = 0.9996;  // UTM scale factor
-    double a = ctx->ellipsoid.a;
-    double f = ctx->ellipsoid.f;
+    int written = snprintf(buffer, buffer_size, "%.30s", qk->key);
+    return (written < 0
+            || (size_t)written >= buffer_size) ? COORD_ERROR_FORMAT : COORD_SUCCESS;
+}
+
+// ==================== Coordinate conversion functions ====================
+// Datum shift kernel, defined with the datum conversion functions below
+static void datum_convert_unchecked(const CoordContext *ctx,
+                                    const GeoCoord *src, MapDatum target_datum,
+                                    DatumShiftMethod method, GeoCoord *dst);
+
+// Ellipsoid constants of the UTM forward series, hoisted out of point loops
+typedef struct
+{
+    double a, e2;
+    double m0, m2, m4, m6;      // Meridional arc coefficients
+} UTMSeries;
+
+static void utm_series_init(const Ellipsoid *ell, UTMSeries *series)
+{
+    double a = ell->a;
+    double f = ell->f;
     double e2 = 2 * f - f * f;
-    double sin_lat = sin(lat_rad);
-    double cos_lat = cos(lat_rad);
+    series->a = a;
+    series->e2 = e2;
+    series->m0 = 1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 / 256.0;
+    series->m2 = 3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0;
+    series->m4 = 15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0;
+    series->m6 = 35.0 * e2 * e2 * e2 / 3072.0;
+}
+
+// Meridional arc length to the latitude. sin(2/4/6 lat) come from
+// multiple-angle identities, so callers that already hold sin/cos of the
+// latitude pay no further trig.
+static double utm_meridional_arc(const UTMSeries *series, double lat_rad,
+                                 double sin_lat, double cos_lat)
+{
+    double sin2 = 2.0 * sin_lat * cos_lat;
+    double cos2 = cos_lat * cos_lat - sin_lat * sin_lat;
+    double sin4 = 2.0 * sin2 * cos2;
+    double cos4 = cos2 * cos2 - sin2 * sin2;
+    double sin6 = sin4 * cos2 + cos4 * sin2;
+    return series->a * (series->m0 * lat_rad - series->m2 * sin2 + series->m4 * sin4
+                        - series->m6 * sin6);
+}
+
+// UTM forward series from the latitude, its sine/cosine and the longitude
+// offset from the central meridian (radians); northing excludes the false
+// northing.
+static void utm_forward_series(const UTMSeries *series, double lat_rad,
+                               double sin_lat, double cos_lat, double dlon_rad,
+                               double *easting, double *northing,
+                               double *convergence)
+{
+    double k0 = 0.9996;  // UTM scale factor
+    double a = series->a;
+    double e2 = series->e2;
     double tan_lat = sin_lat / cos_lat;
     double N = a / sqrt(1.0 - e2 * sin_lat * sin_lat);
     double T = tan_lat * tan_lat;
     double C = e2 * cos_lat * cos_lat / (1.0 - e2);
-    double A = (lon_rad - lon_center_rad) * cos_lat;
-    // Compute M (meridional arc length)
-    double M = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 /
-                     256.0) * lat_rad
-                    - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(
-                        2.0 * lat_rad)
-                    + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(4.0 * lat_rad)
-                    - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * lat_rad));
+    double A = dlon_rad * cos_lat;
+    double M = utm_meridional_arc(series, lat_rad, sin_lat, cos_lat);
     // Compute UTM coordinates
     double A2 = A * A;
     double A3 = A2 * A;
@@ -1132,41 +1675,103 @@ int coord_to_utm(CoordContext *ctx, const GeoCoord *geo, UTMPoint *utm)
     double A5 = A4 * A;
     double A6 = A5 * A;
     // Easting
-    utm->easting = k0 * N * (A + (1.0 - T + C) * A3 / 6.0
-                             + (5.0 - 18.0 * T + T * T + 72.0 * C - 58.0 * e2) * A5 / 120.0)
-                   + 500000.0;  // False easting
+    *easting = k0 * N * (A + (1.0 - T + C) * A3 / 6.0
+                         + (5.0 - 18.0 * T + T * T + 72.0 * C - 58.0 * e2) * A5 / 120.0)
+               + 500000.0;  // False easting
     // Northing
-    utm->northing = k0 * (M + N * tan_lat *
-                          (A2 / 2.0 + (5.0 - T + 9.0 * C + 4.0 * C * C) * A4 / 24.0
-                           + (61.0 - 58.0 * T + T * T + 600.0 * C - 330.0 * e2) * A6 / 720.0));
+    *northing = k0 * (M + N * tan_lat *
+                      (A2 / 2.0 + (5.0 - T + 9.0 * C + 4.0 * C * C) * A4 / 24.0
+                       + (61.0 - 58.0 * T + T * T + 600.0 * C - 330.0 * e2) * A6 / 720.0));
+    if (convergence)
+    {
+        double sin_dlon, cos_dlon;
+        trig_sincos(dlon_rad, &sin_dlon, &cos_dlon);
+        *convergence = trig_atan(tan_lat * sin_dlon);
+    }
+}
+
+static void utm_forward_trig(const Ellipsoid *ell, double lat_rad,
+                             double sin_lat, double cos_lat, double dlon_rad,
+                             double *easting, double *northing,
+                             double *convergence)
+{
+    UTMSeries series;
+    utm_series_init(ell, &series);
+    utm_forward_series(&series, lat_rad, sin_lat, cos_lat, dlon_rad, easting,
+                       northing, convergence);
+}
+
+// UTM forward series for a given zone; northing excludes the false northing
+static void utm_forward(const Ellipsoid *ell, double latitude, double longitude,
+                        int zone, double *easting, double *northing,
+                        double *convergence)
+{
+    // Calculate central meridian
+    double lon_center = (zone - 1) * 6.0 - 180.0 + 3.0;
+    // Convert to radians
+    double lat_rad = coord_deg_to_rad(latitude);
+    double dlon_rad = coord_deg_to_rad(longitude) - coord_deg_to_rad(lon_center);
+    // A forced zone may lie across the antimeridian from the point
+    if (dlon_rad > M_PI)
+    {
+        dlon_rad -= 2.0 * M_PI;
+    }
+    else if (dlon_rad < -M_PI)
+    {
+        dlon_rad += 2.0 * M_PI;
+    }
+    double sin_lat, cos_lat;
+    trig_sincos(lat_rad, &sin_lat, &cos_lat);
+    utm_forward_trig(ell, lat_rad, sin_lat, cos_lat, dlon_rad, easting, northing,
+                     convergence);
+}
+
+// Geographic coordinate to UTM
+// UTM forward kernel; geo must already have passed coord_validate_point
+static int utm_from_geo_unchecked(const CoordContext *ctx, const GeoCoord *geo,
+                                  UTMPoint *utm)
+{
+    // Calculate UTM zone and band
+    int zone;
+    char band;
+    utm_classify(geo->longitude, geo->latitude, &zone, &band);
+    utm_forward(&ctx->ellipsoid, geo->latitude, geo->longitude, zone,
+                &utm->easting, &utm->northing, &utm->convergence);
     // If southern hemisphere, add false northing
     if (geo->latitude < 0.0)
     {
         utm->northing += 10000000.0;
     }
     utm->zone = zone;
-    utm->band = coord_get_utm_band(geo->latitude);
-    utm->convergence = atan(tan_lat * sin(lon_rad - lon_center_rad));
-    utm->scale_factor = k0;
+    utm->band = band;
+    utm->scale_factor = 0.9996;
     utm->datum = geo->datum;
     return COORD_SUCCESS;
 }
 
-int coord_from_utm(CoordContext *ctx, const UTMPoint *utm, GeoCoord *geo)
+int coord_to_utm(CoordContext *ctx, const GeoCoord *geo, UTMPoint *utm)
 {
-    if (!ctx || !utm || !geo)
+    if (!ctx || !geo || !utm)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_utm(utm))
+    if (!coord_validate_point(geo))
     {
         return COORD_ERROR_INVALID_COORD;
     }
-    // Calculate central meridian
-    double lon_center = (utm->zone - 1) * 6.0 - 180.0 + 3.0;
+    return utm_from_geo_unchecked(ctx, geo, utm);
+}
+
+// UTM inverse series: latitude and longitude offset from the central meridian
+// (radians). sin_lat/cos_lat (may be NULL) are derived from the footpoint
+// latitude by angle addition instead of fresh trig calls.
+static void utm_inverse(const Ellipsoid *ell, const UTMPoint *utm,
+                        double *lat_rad, double *dlon_rad, double *sin_lat,
+                        double *cos_lat)
+{
     double k0 = 0.9996;
-    double a = ctx->ellipsoid.a;
-    double f = ctx->ellipsoid.f;
+    double a = ell->a;
+    double f = ell->f;
     double e2 = 2 * f - f * f;
     // Remove false easting
     double x = utm->easting - 500000.0;
@@ -1185,1239 +1790,5137 @@ int coord_from_utm(CoordContext *ctx, const UTMPoint *utm, GeoCoord *geo)
     double J2 = 21.0 * e1 * e1 / 16.0 - 55.0 * e1 * e1 * e1 * e1 / 32.0;
     double J3 = 151.0 * e1 * e1 * e1 / 96.0;
     double J4 = 1097.0 * e1 * e1 * e1 * e1 / 512.0;
-    double fp = mu + J1 * sin(2.0 * mu) + J2 * sin(4.0 * mu) + J3 * sin(
-                    6.0 * mu) + J4 * sin(8.0 * mu);
-    double sin_fp = sin(fp);
-    double cos_fp = cos(fp);
+    // sin(2/4/6/8 mu) from one sin/cos pair by multiple-angle identities
+    double sin_mu, cos_mu;
+    trig_sincos(mu, &sin_mu, &cos_mu);
+    double sin2 = 2.0 * sin_mu * cos_mu;
+    double cos2 = cos_mu * cos_mu - sin_mu * sin_mu;
+    double sin4 = 2.0 * sin2 * cos2;
+    double cos4 = cos2 * cos2 - sin2 * sin2;
+    double sin6 = sin4 * cos2 + cos4 * sin2;
+    double sin8 = 2.0 * sin4 * cos4;
+    double fp = mu + J1 * sin2 + J2 * sin4 + J3 * sin6 + J4 * sin8;
+    double sin_fp, cos_fp;
+    trig_sincos(fp, &sin_fp, &cos_fp);
     double tan_fp = sin_fp / cos_fp;
     double C1 = e2 * cos_fp * cos_fp;
     double T1 = tan_fp * tan_fp;
-    double R1 = a * (1.0 - e2) / pow(1.0 - e2 * sin_fp * sin_fp, 1.5);
-    double N1 = a / sqrt(1.0 - e2 * sin_fp * sin_fp);
+    double w = 1.0 - e2 * sin_fp * sin_fp;
+    double sqrt_w = sqrt(w);
+    double R1 = a * (1.0 - e2) / (w * sqrt_w);
+    double N1 = a / sqrt_w;
     double D = x / (N1 * k0);
+    double D2 = D * D;
+    double D3 = D2 * D;
+    double D4 = D2 * D2;
     double Q1 = N1 * tan_fp / R1;
-    double Q2 = D * D / 2.0;
-    double Q3 = (5.0 + 3.0 * T1 + 10.0 * C1 - 4.0 * C1 * C1 - 9.0 * e2) * pow(D,
-                4) / 24.0;
+    double Q2 = D2 / 2.0;
+    double Q3 = (5.0 + 3.0 * T1 + 10.0 * C1 - 4.0 * C1 * C1 - 9.0 * e2) * D4 / 24.0;
     double Q4 = (61.0 + 90.0 * T1 + 298.0 * C1 + 45.0 * T1 * T1 - 252.0 * e2 - 3.0 *
-                 C1 * C1) * pow(D, 6) / 720.0;
-    double lat_rad = fp - Q1 * (Q2 - Q3 + Q4);
+                 C1 * C1) * D4 * D2 / 720.0;
+    double d = Q1 * (Q2 - Q3 + Q4);
+    *lat_rad = fp - d;
     double Q5 = D;
-    double Q6 = (1.0 + 2.0 * T1 + C1) * pow(D, 3) / 6.0;
+    double Q6 = (1.0 + 2.0 * T1 + C1) * D3 / 6.0;
     double Q7 = (5.0 - 2.0 * C1 + 28.0 * T1 - 3.0 * C1 * C1 + 8.0 * e2 + 24.0 * T1 *
-                 T1) * pow(D, 5) / 120.0;
-    double lon_rad = coord_deg_to_rad(lon_center) + (Q5 - Q6 + Q7) / cos_fp;
+                 T1) * D3 * D2 / 120.0;
+    *dlon_rad = (Q5 - Q6 + Q7) / cos_fp;
+    if (sin_lat && cos_lat)
+    {
+        if (fabs(d) < 0.05)
+        {
+            // sin/cos of the small correction d by Taylor series (error < 1e-14)
+            double d2 = d * d;
+            double sin_d = d * (1.0 - d2 / 6.0 * (1.0 - d2 / 20.0 * (1.0 - d2 / 42.0)));
+            double cos_d = 1.0 - d2 / 2.0 * (1.0 - d2 / 12.0 * (1.0 - d2 / 30.0));
+            *sin_lat = sin_fp * cos_d - cos_fp * sin_d;
+            *cos_lat = cos_fp * cos_d + sin_fp * sin_d;
+        }
+        else
+        {
+            trig_sincos(*lat_rad, sin_lat, cos_lat);
+        }
+    }
+}
+
+// UTM inverse kernel; utm must already have passed coord_validate_utm
+static void geo_from_utm_unchecked(const CoordContext *ctx, const UTMPoint *utm,
+                                   GeoCoord *geo)
+{
+    // Calculate central meridian
+    double lon_center = (utm->zone - 1) * 6.0 - 180.0 + 3.0;
+    double lat_rad, dlon_rad;
+    utm_inverse(&ctx->ellipsoid, utm, &lat_rad, &dlon_rad, NULL, NULL);
+    double lon_rad = coord_deg_to_rad(lon_center) + dlon_rad;
     geo->latitude = coord_normalize_latitude(coord_rad_to_deg(lat_rad));
     geo->longitude = coord_normalize_longitude(coord_rad_to_deg(lon_rad));
     geo->altitude = 0.0;
     geo->datum = utm->datum;
-    return COORD_SUCCESS;
 }
 
-// Helper: get index of letter in MGRS alphabet (skip I and O)
-static int get_mgrs_letter_index(char letter)
+int coord_from_utm(CoordContext *ctx, const UTMPoint *utm, GeoCoord *geo)
 {
-    if (letter < 'A' || letter > 'Z' || letter == 'I' || letter == 'O')
-    {
-        return -1;
-    }
-    int index = letter - 'A';
-    if (letter > 'I')
+    if (!ctx || !utm || !geo)
     {
-        index--;
+        return COORD_ERROR_INVALID_INPUT;
     }
-    if (letter > 'O')
+    if (!coord_validate_utm(utm))
     {
-        index--;
+        return COORD_ERROR_INVALID_COORD;
     }
-    return index;
+    geo_from_utm_unchecked(ctx, utm, geo);
+    return COORD_SUCCESS;
 }
 
-// Helper: get MGRS letter from index (skip I and O)
-static char get_mgrs_letter_from_index(int index)
+// ==================== Forced-zone UTM ====================
+// Fill the UTM fields that follow from the latitude and target zone
+static void utm_finish(double lat_deg, int zone, MapDatum datum, UTMPoint *utm)
 {
-    if (index < 0 || index > 23)
-    {
-        return 'Z';
-    }
-    char letter = 'A' + index;
-    if (letter >= 'I')
+    if (lat_deg < 0.0)
     {
-        letter++;
+        utm->northing += 10000000.0;
     }
-    if (letter >= 'O')
+    utm->zone = zone;
+    utm->band = coord_get_utm_band(lat_deg);
+    utm->scale_factor = 0.9996;
+    utm->datum = datum;
+}
+
+// Fused zone-to-zone kernel: one inverse series feeds the forward series
+// directly. The longitude offset moves by whole 6 degree zones and the
+// latitude trig is reused, so no geographic round trip or extra sin/cos of
+// the latitude is needed.
+static void utm_to_zone_unchecked(const Ellipsoid *ell, const UTMPoint *src,
+                                  int zone, UTMPoint *dst)
+{
+    double lat_rad, dlon_rad, sin_lat, cos_lat;
+    utm_inverse(ell, src, &lat_rad, &dlon_rad, &sin_lat, &cos_lat);
+    // Shortest way round, so zones 60 and 1 are neighbours
+    int shift = src->zone - zone;
+    if (shift > 30)
     {
-        letter++;
+        shift -= 60;
     }
-    if (letter > 'Z')
+    else if (shift < -30)
     {
-        letter = 'Z';
+        shift += 60;
     }
-    return letter;
+    dlon_rad += coord_deg_to_rad(6.0 * shift);
+    MapDatum datum = src->datum;    // src may alias dst
+    utm_forward_trig(ell, lat_rad, sin_lat, cos_lat, dlon_rad, &dst->easting,
+                     &dst->northing, &dst->convergence);
+    utm_finish(coord_rad_to_deg(lat_rad), zone, datum, dst);
 }
 
-// ==================== Key functions to fix MGRS conversion ====================
-int coord_from_mgrs(CoordContext *ctx, const MGRSPoint *mgrs, GeoCoord *geo)
+int coord_to_utm_zone(CoordContext *ctx, const GeoCoord *geo, int zone,
+                      UTMPoint *utm)
 {
-    if (!ctx || !mgrs || !geo)
+    if (!ctx || !geo || !utm)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_mgrs(mgrs))
+    if (zone < 1 || zone > 60)
     {
-        return COORD_ERROR_INVALID_COORD;
+        return COORD_ERROR_INVALID_UTM_ZONE;
     }
-    int zone = mgrs->zone;
-    char band = mgrs->band;
-    char col_letter = mgrs->square[0];
-    char row_letter = mgrs->square[1];
-    double easting = mgrs->easting;
-    double northing = mgrs->northing;
-
-    // Reverse compute MGRS 100k grid column letter (WGS84/modern datums)
-    // Use the same 6-set system as coord_to_mgrs for reverse computation
-    //
-    // Logic to derive col_100k from column letter:
-    // 1. Determine set (zone % 6)
-    // 2. Get the start letter for the set
-    // 3. Count from the start letter until the target column letter
-
-    // Determine set (1-6)
-    int set = zone % 6;
-    if (set == 0)
-        set = 6;
-
-    // Get the start column letter for the set
-    char col_origin;
-    switch (set)
-    {
-        case 1:
-        case 4:
-            col_origin = 'A';
-            break;
-        case 2:
-        case 5:
-            col_origin = 'J';
-            break;
-        case 3:
-        case 6:
-            col_origin = 'S';
-            break;
-        default:
-            col_origin = 'A';
-            break;
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
     }
+    utm_forward(&ctx->ellipsoid, geo->latitude, geo->longitude, zone,
+                &utm->easting, &utm->northing, &utm->convergence);
+    utm_finish(geo->latitude, zone, geo->datum, utm);
+    return COORD_SUCCESS;
+}
 
-    // Count from start letter to target column letter, skipping I and O
-    int col_100k = 0;
-    int temp_code = col_origin;
-    while (temp_code != col_letter)
+int coord_utm_to_zone(CoordContext *ctx, const UTMPoint *src, int zone,
+                      UTMPoint *dst)
+{
+    if (!ctx || !src || !dst)
     {
-        temp_code++;
-        if (temp_code == 'I' || temp_code == 'O')
-            temp_code++;
-        if (temp_code > 'Z')
-        {
-            temp_code = temp_code - 'Z' + 'A' - 1;
-            if (temp_code == 'I' || temp_code == 'O')
-                temp_code++;
-        }
-        col_100k++;
+        return COORD_ERROR_INVALID_INPUT;
     }
+    return coord_utm_to_zone_batch(ctx, src, 1, zone, dst);
+}
 
-    // Reverse compute row letter
-    int row_idx = get_mgrs_letter_index(row_letter);
-    if (row_idx < 0)
+int coord_utm_to_zone_batch(CoordContext *ctx, const UTMPoint *src,
+                            size_t count, int zone, UTMPoint *dst)
+{
+    if (!ctx || (count > 0 && (!src || !dst)))
     {
-        return COORD_ERROR_INVALID_COORD;
+        return COORD_ERROR_INVALID_INPUT;
     }
-
-    int row_offset = 0;
-    int zone_parity = zone % 2;
-    if (band >= 'N' && band <= 'X')
+    if (zone < 1 || zone > 60)
     {
-        if (zone_parity == 0)
-        {
-            row_offset = 5;
-        }
-        else
-        {
-            row_offset = 0;
-        }
+        return COORD_ERROR_INVALID_UTM_ZONE;
     }
-    else
+    for (size_t i = 0; i < count; i++)
     {
-        if (zone_parity == 0)
+        // Sources may themselves be forced-zone points, up to 1000 km from
+        // their central meridian
+        if (!utm_in_range(&src[i], -500000.0, 1500000.0))
         {
-            row_offset = 0;
+            return COORD_ERROR_INVALID_COORD;
         }
-        else
+        if (src[i].zone == zone)
         {
-            row_offset = 5;
+            dst[i] = src[i];
         }
-    }
-    int row_100k = row_idx - row_offset;
-    if (row_100k < 0)
-    {
-        row_100k += 20;
-    }
-    UTMPoint utm;
-    utm.zone = zone;
-    utm.band = band;
-    utm.datum = mgrs->datum;
-    utm.convergence = 0.0;
-    utm.scale_factor = 0.9996;
-    utm.easting = col_100k * 100000.0 + easting;
-    if (band >= 'N' && band <= 'X')
-    {
-        utm.northing = row_100k * 100000.0 + northing;
-    }
-    else
-    {
-        double base_northing = row_100k * 100000.0 + northing;
-        if (base_northing < 0)
+        else
         {
-            base_northing += 2000000.0;
+            utm_to_zone_unchecked(&ctx->ellipsoid, &src[i], zone, &dst[i]);
         }
-        utm.northing = base_northing + 10000000.0;
     }
-    if (!coord_validate_utm(&utm))
+    return COORD_SUCCESS;
+}
+
+// ==================== Incremental track projection ====================
+#define TRACK_STENCIL_STEP 1e-3     // Finite-difference step (degrees)
+#define TRACK_PROBE_STEP 0.02       // Error probe offset (degrees)
+#define TRACK_MAX_RADIUS 0.05       // Upper bound for the expansion radius (degrees)
+
+// Exact projection in the anchor zone without false northing
+static void track_exact(const UTMTrackProjector *proj, double lat, double lon,
+                        double *e, double *n, double *conv)
+{
+    utm_forward(&proj->ctx->ellipsoid, lat, lon, proj->anchor_utm.zone, e, n,
+                conv);
+}
+
+// Evaluate the expansion around the anchor
+static void track_expand(const UTMTrackProjector *proj, double dlat, double dlon,
+                         double *e, double *n)
+{
+    double out[2];
+    for (int k = 0; k < 2; k++)
     {
-        return COORD_ERROR_INVALID_COORD;
+        out[k] = proj->jacobian[k][0] * dlat + proj->jacobian[k][1] * dlon
+                 + 0.5 * (proj->hessian[k][0] * dlat * dlat
+                          + 2.0 * proj->hessian[k][1] * dlat * dlon
+                          + proj->hessian[k][2] * dlon * dlon);
     }
-    int ret = coord_from_utm(ctx, &utm, geo);
+    *e = out[0];
+    *n = out[1];
+}
+
+// Full evaluation at the point and rebuild of the local expansion
+static int track_anchor(UTMTrackProjector *proj, const GeoCoord *geo,
+                        UTMPoint *utm)
+{
+    int ret = coord_to_utm(proj->ctx, geo, utm);
     if (ret != COORD_SUCCESS)
     {
+        proj->anchored = 0;
         return ret;
     }
+    proj->anchor = *geo;
+    proj->anchor_utm = *utm;
+    double lat = geo->latitude;
+    double lon = geo->longitude;
+    double h = TRACK_STENCIL_STEP;
+    double e0 = utm->easting;
+    double n0 = utm->northing - ((lat < 0.0) ? 10000000.0 : 0.0);
+    // Central differences on a 7-point stencil
+    double f[6][3];
+    const double offsets[6][2] =
+    {
+        {h, 0.0}, {-h, 0.0}, {0.0, h}, {0.0, -h}, {h, h}, {-h, -h}
+    };
+    for (int i = 0; i < 6; i++)
+    {
+        track_exact(proj, lat + offsets[i][0], lon + offsets[i][1],
+                    &f[i][0], &f[i][1], &f[i][2]);
+    }
+    double center[2] = {e0, n0};
+    for (int k = 0; k < 2; k++)
+    {
+        proj->jacobian[k][0] = (f[0][k] - f[1][k]) / (2.0 * h);
+        proj->jacobian[k][1] = (f[2][k] - f[3][k]) / (2.0 * h);
+        proj->hessian[k][0] = (f[0][k] - 2.0 * center[k] + f[1][k]) / (h * h);
+        proj->hessian[k][2] = (f[2][k] - 2.0 * center[k] + f[3][k]) / (h * h);
+        proj->hessian[k][1] = (f[4][k] + f[5][k] - f[0][k] - f[1][k] - f[2][k]
+                               - f[3][k] + 2.0 * center[k]) / (2.0 * h * h);
+    }
+    proj->convergence_gradient[0] = (f[0][2] - f[1][2]) / (2.0 * h);
+    proj->convergence_gradient[1] = (f[2][2] - f[3][2]) / (2.0 * h);
+    // Probe the third-order remainder on both diagonals; it grows with r^3
+    double r0 = TRACK_PROBE_STEP;
+    double worst = 0.0;
+    for (int i = 0; i < 2; i++)
+    {
+        double dlon = (i == 0) ? r0 : -r0;
+        double pe, pn, ae, an;
+        track_exact(proj, lat + r0, lon + dlon, &pe, &pn, NULL);
+        track_expand(proj, r0, dlon, &ae, &an);
+        double err = fmax(fabs(pe - e0 - ae), fabs(pn - n0 - an));
+        worst = fmax(worst, err);
+    }
+    proj->exact_count += 9;
+    double radius = TRACK_MAX_RADIUS;
+    if (worst > 0.0)
+    {
+        // Half the cube-root estimate leaves an 8x margin on the bound
+        radius = 0.5 * r0 * cbrt(proj->max_error / worst);
+    }
+    proj->radius = fmin(radius, TRACK_MAX_RADIUS);
+    proj->anchored = 1;
     return COORD_SUCCESS;
 }
 
-int coord_to_mgrs(CoordContext *ctx, const GeoCoord *geo, MGRSPoint *mgrs)
+int coord_track_projector_init(CoordContext *ctx, double max_error,
+                               UTMTrackProjector *proj)
 {
-    if (!ctx || !geo || !mgrs)
+    if (!ctx || !proj || !(max_error > 0.0))
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_point(geo))
-    {
-        return COORD_ERROR_INVALID_COORD;
-    }
-    UTMPoint utm;
-    int ret = coord_to_utm(ctx, geo, &utm);
-    if (ret != COORD_SUCCESS)
-    {
-        return ret;
-    }
-    int zone = utm.zone;
-    char band = utm.band;
-    int col_100k = (int)(utm.easting / 100000.0);
-
-    // Handle southern hemisphere northing
-    // Southern hemisphere UTM northing = 10000000 + true northing (positive south of equator)
-    // But MGRS uses true northing to compute 100km grid
-    double utm_northing_for_mgrs = utm.northing;
-    if (band < 'N')
-    {
-        // Southern hemisphere: remove false northing to get true northing (relative to southern origin)
-        // Note: in the southern hemisphere, true northing may be negative (relative to equator)
-        // But MGRS in the southern hemisphere is computed relative to the poleward direction
-        utm_northing_for_mgrs -= 10000000.0;
-    }
-
-    // Compute 100km grid indices
-    int row_100k = (int)(utm_northing_for_mgrs / 100000.0);
-
-    // Southern hemisphere special case: row_100k may be negative
-    // In the southern hemisphere, row_100k starts at 0 and increases southward
-    // If negative, the coordinate is in high southern latitudes
-    if (row_100k < 0)
-    {
-        // Polar region in southern hemisphere needs special handling
-        // Convert negative index to positive index
-        row_100k = 20 + (row_100k % 20);
-    }
-
-    // MGRS 100k grid column letter calculation (WGS84/modern datums)
-    // Reference: GeoTrellis MGRS implementation (based on proj4js/mgrs)
-    // Use 6-set cycle system instead of simple (zone-1)%3
-    //
-    // SET_ORIGIN_COLUMN_LETTERS = "AJSAJS" (6-set cycle)
-    // - Zone % 6 = 1: A (ASCII 65)
-    // - Zone % 6 = 2: J (ASCII 74)
-    // - Zone % 6 = 3: S (ASCII 83)
-    // - Zone % 6 = 4: A (ASCII 65)
-    // - Zone % 6 = 5: J (ASCII 74)
-    // - Zone % 6 = 0: S (ASCII 65)
-    //
-    // Formula: col_letter = origin + col_100k - 1
-    // Skip I (73) and O (79)
-    //
-    // Example: Zone 50, col_100k=5
-    // - set = 50 % 6 = 2
-    // - origin = 'J' (ASCII 74)
-    // - col = 'J' + 5 - 1 = 78 = 'N' ✓
-
-    // Determine set (1-6)
-    int set = zone % 6;
-    if (set == 0)
-        set = 6;
-
-    // Get the start column letter for the set
-    char col_origin;
-    switch (set)
-    {
-        case 1:
-        case 4:
-            col_origin = 'A';
-            break;
-        case 2:
-        case 5:
-            col_origin = 'J';
-            break;
-        case 3:
-        case 6:
-            col_origin = 'S';
-            break;
-        default:
-            col_origin = 'A';
-            break;
-    }
-
-    // Compute column letter, skipping I and O
-    int col_letter_code = col_origin + col_100k - 1;
-    char col_letter;
+    memset(proj, 0, sizeof(*proj));
+    proj->ctx = ctx;
+    proj->max_error = max_error;
+    return COORD_SUCCESS;
+}
 
-    // Handle I and O skipping
-    int temp_code = col_origin;
-    for (int i = 1; i < col_100k; i++)
+void coord_track_projector_reset(UTMTrackProjector *proj)
+{
+    if (proj)
     {
-        temp_code++;
-        if (temp_code == 'I' || temp_code == 'O')
-            temp_code++;
+        proj->anchored = 0;
+        proj->exact_count = 0;
+        proj->approx_count = 0;
     }
-    col_letter_code = temp_code;
+}
 
-    // Handle wrap-around (after Z back to A)
-    if (col_letter_code > 'Z')
+int coord_track_project(UTMTrackProjector *proj, const GeoCoord *geo,
+                        UTMPoint *utm)
+{
+    if (!proj || !proj->ctx || !geo || !utm)
     {
-        col_letter_code = col_letter_code - 'Z' + 'A' - 1;
-        // Re-check I and O
-        if (col_letter_code == 'I' || col_letter_code == 'O')
-            col_letter_code++;
+        return COORD_ERROR_INVALID_INPUT;
     }
-
-    col_letter = (char)col_letter_code;
-
-    // Compute row letter (using existing odd/even zone logic)
-    int zone_parity = zone % 2;
-    int row_offset = 0;
-    if (band >= 'N' && band <= 'X')
+    if (!coord_validate_point(geo))
     {
-        if (zone_parity == 0)
-        {
-            row_offset = 5;
-        }
-        else
-        {
-            row_offset = 0;
-        }
+        return COORD_ERROR_INVALID_COORD;
     }
-    else
+    if (proj->anchored)
     {
-        if (zone_parity == 0)
-        {
-            row_offset = 0;
-        }
-        else
+        double dlat = geo->latitude - proj->anchor.latitude;
+        double dlon = geo->longitude - proj->anchor.longitude;
+        if (fabs(dlat) <= proj->radius && fabs(dlon) <= proj->radius &&
+                coord_get_utm_zone(geo->longitude, geo->latitude) == proj->anchor_utm.zone &&
+                coord_get_utm_band(geo->latitude) == proj->anchor_utm.band)
         {
-            row_offset = 5;
+            double de, dn;
+            track_expand(proj, dlat, dlon, &de, &dn);
+            *utm = proj->anchor_utm;
+            utm->easting += de;
+            utm->northing += dn;
+            utm->convergence += proj->convergence_gradient[0] * dlat
+                                + proj->convergence_gradient[1] * dlon;
+            utm->datum = geo->datum;
+            proj->approx_count++;
+            return COORD_SUCCESS;
         }
     }
-    int row_idx = (row_100k + row_offset) % 20;
-    char row_letter = get_mgrs_letter_from_index(row_idx);
-    mgrs->zone = zone;
-    mgrs->band = band;
-    mgrs->square[0] = col_letter;
-    mgrs->square[1] = row_letter;
-    mgrs->square[2] = '\0';
-    mgrs->easting = fmod(utm.easting, 100000.0);
-    mgrs->northing = fmod(utm_northing_for_mgrs, 100000.0);
-    // Ensure northing is positive
-    if (mgrs->northing < 0)
-    {
-        mgrs->northing += 100000.0;
-    }
-    mgrs->datum = utm.datum;
-    return COORD_SUCCESS;
+    return track_anchor(proj, geo, utm);
 }
 
-// Geographic coordinate to British Grid
-int coord_to_british_grid(CoordContext *ctx, const GeoCoord *geo,
-                          BritishGridPoint *bg)
+// Helper: get index of letter in MGRS alphabet (skip I and O)
+static int get_mgrs_letter_index(char letter)
 {
-    if (!ctx || !geo || !bg)
+    if (letter < 'A' || letter > 'Z' || letter == 'I' || letter == 'O')
     {
-        return COORD_ERROR_INVALID_INPUT;
+        return -1;
     }
-    if (!coord_validate_point(geo))
+    int index = letter - 'A';
+    if (letter > 'I')
     {
-        return COORD_ERROR_INVALID_COORD;
+        index--;
+    }
+    if (letter > 'O')
+    {
+        index--;
     }
+    return index;
+}
 
-    // British National Grid must use OSGB36 datum and Airy 1830 ellipsoid
-    // If input is not OSGB36, convert datum first
-    GeoCoord osgb_geo;
-    if (geo->datum != DATUM_OSGB36)
+// Helper: get MGRS letter from index (skip I and O)
+static char get_mgrs_letter_from_index(int index)
+{
+    if (index < 0 || index > 23)
     {
-        int ret = coord_convert_datum(ctx, geo, DATUM_OSGB36, &osgb_geo);
-        if (ret != COORD_SUCCESS)
-        {
-            return ret;
-        }
+        return 'Z';
     }
-    else
+    char letter = 'A' + index;
+    if (letter >= 'I')
     {
-        osgb_geo = *geo;
+        letter++;
+    }
+    if (letter >= 'O')
+    {
+        letter++;
+    }
+    if (letter > 'Z')
+    {
+        letter = 'Z';
     }
+    return letter;
+}
 
-    // Use OSGB36/Airy 1830 ellipsoid parameters
-    double a = OSGB36_A;
-    double f = OSGB36_F;
-    double e2 = 2 * f - f * f;
+// ==================== MGRS lettering ====================
+// MGRS and UTM differ only in how the 100km square is written, so both
+// directions are integer arithmetic on the square indices:
+// - Column letters run from the set origin (zone % 6: A, J, S, A, J, S) over
+//   the 24-letter alphabet without I and O; col_100k is 1-8.
+// - Row letters cycle through A-V (20 letters, no I or O) every 2,000 km of
+//   the full UTM northing, shifted by 5 rows in even zones.
+// - The 2,000 km cycle is restored from the latitude band's minimum northing.
+
+// Minimum UTM northing (with false northing) for bands C-X, in units of 100km
+static const int MGRS_BAND_MIN_NORTHING[] =
+{
+    11, 20, 28, 37, 46, 55, 64, 73, 82, 91,    // C D E F G H J K L M
+    0, 8, 17, 26, 35, 44, 53, 62, 70, 79       // N P Q R S T U V W X
+};
 
-    double lat_rad = coord_deg_to_rad(osgb_geo.latitude);
-    double lon_rad = coord_deg_to_rad(osgb_geo.longitude);
-    double sin_lat = sin(lat_rad);
-    double cos_lat = cos(lat_rad);
-    double tan_lat = sin_lat / cos_lat;
-    double N = a / sqrt(1.0 - e2 * sin_lat * sin_lat);
-    double T = tan_lat * tan_lat;
-    double C = e2 * cos_lat * cos_lat / (1.0 - e2);
-    double A = (lon_rad - OSGB36_LON0) * cos_lat;
-    // Compute M
-    double M = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 /
-                     256.0) * lat_rad
-                    - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(
-                        2.0 * lat_rad)
-                    + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(4.0 * lat_rad)
-                    - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * lat_rad));
-    // Compute M0
-    double M0 = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 /
-                      256.0) * OSGB36_LAT0
-                     - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(
-                         2.0 * OSGB36_LAT0)
-                     + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(
-                         4.0 * OSGB36_LAT0)
-                     - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * OSGB36_LAT0));
-    double A2 = A * A;
-    double A3 = A2 * A;
-    double A4 = A3 * A;
-    double A5 = A4 * A;
-    double A6 = A5 * A;
-    bg->easting = OSGB36_E0 + OSGB36_F0 * N * (A + (1.0 - T + C) * A3 / 6.0
-                  + (5.0 - 18.0 * T + T * T + 72.0 * C - 58.0 * e2) * A5 / 120.0);
-    bg->northing = OSGB36_N0 + OSGB36_F0 * (M - M0 + N * tan_lat *
-                                            (A2 / 2.0 + (5.0 - T + 9.0 * C + 4.0 * C * C) * A4 / 24.0
-                                                    + (61.0 - 58.0 * T + T * T + 600.0 * C - 330.0 * e2) * A6 / 720.0));
+// Column letter index (0-23) of the first column in a zone
+static int mgrs_column_origin(int zone)
+{
+    return ((zone - 1) % 3) * 8;
+}
 
-    // Compute British National Grid letters
-    // British Grid uses a special 500km square letter system
-    // Note: for coordinates outside the UK, letters are not standard
-    // Here we use an extended cyclic computation
+// Row offset (in 100km rows) applied in even zones
+static int mgrs_row_offset(int zone)
+{
+    return (zone % 2 == 0) ? 5 : 0;
+}
 
-    // Compute 500km square index
-    int e500k = (int)(bg->easting / 500000.0);
-    int n500k = (int)(bg->northing / 500000.0);
+// Band index (0-19) for C-X, or -1
+static int mgrs_band_index(char band)
+{
+    int idx = get_mgrs_letter_index(band);
+    return (idx >= 2 && idx <= 21) ? idx - 2 : -1;
+}
 
-    // Handle negative indices
-    while (e500k < 0) e500k += 25;  // Ensure positive
-    while (n500k < 0) n500k += 25;
+// MGRS to UTM lettering kernel; mgrs must already have passed coord_validate_mgrs
+static int utm_from_mgrs_unchecked(const MGRSPoint *mgrs, UTMPoint *utm)
+{
+    int col_100k = get_mgrs_letter_index(mgrs->square[0]) -
+                   mgrs_column_origin(mgrs->zone) + 1;
+    int row_idx = get_mgrs_letter_index(mgrs->square[1]);
+    int band_idx = mgrs_band_index(mgrs->band);
+    if (col_100k < 1 || col_100k > 8 || row_idx < 0 || row_idx > 19 ||
+            band_idx < 0)
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    // Northing modulo 2,000 km, then the first cycle at or above the band floor
+    int row_100k = (row_idx - mgrs_row_offset(mgrs->zone) + 20) % 20;
+    int min_100k = MGRS_BAND_MIN_NORTHING[band_idx];
+    if (row_100k < min_100k % 20)
+    {
+        row_100k += 20;
+    }
+    row_100k += (min_100k / 20) * 20;
+    utm->zone = mgrs->zone;
+    utm->band = mgrs->band;
+    utm->easting = col_100k * 100000.0 + mgrs->easting;
+    utm->northing = row_100k * 100000.0 + mgrs->northing;
+    utm->convergence = 0.0;
+    utm->scale_factor = 0.9996;
+    utm->datum = mgrs->datum;
+    return COORD_SUCCESS;
+}
 
-    // Letters within 100km square
-    int e100k = (int)(fmod(fabs(bg->easting), 500000.0) / 100000.0);
-    int n100k = (int)(fmod(fabs(bg->northing), 500000.0) / 100000.0);
+int coord_from_mgrs(CoordContext *ctx, const MGRSPoint *mgrs, GeoCoord *geo)
+{
+    if (!ctx || !mgrs || !geo)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_mgrs(mgrs))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    UTMPoint utm;
+    int ret = utm_from_mgrs_unchecked(mgrs, &utm);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    if (!coord_validate_utm(&utm))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    geo_from_utm_unchecked(ctx, &utm, geo);
+    return COORD_SUCCESS;
+}
 
-    // Use British Grid alphabet (skip I)
-    const char *bg_letters = "ABCDEFGHJKLMNPQRSTUVWXYZ";
+// UTM to MGRS lettering kernel; utm must already have passed coord_validate_utm
+static void mgrs_from_utm_unchecked(const UTMPoint *utm, MGRSPoint *mgrs)
+{
+    int col_100k = (int)(utm->easting / 100000.0);
+    int row_100k = (int)(utm->northing / 100000.0);
+    int col_idx = (mgrs_column_origin(utm->zone) + col_100k - 1 + 24) % 24;
+    int row_idx = (row_100k + mgrs_row_offset(utm->zone)) % 20;
+    mgrs->zone = utm->zone;
+    mgrs->band = utm->band;
+    mgrs->square[0] = get_mgrs_letter_from_index(col_idx);
+    mgrs->square[1] = get_mgrs_letter_from_index(row_idx);
+    mgrs->square[2] = '\0';
+    mgrs->easting = utm->easting - col_100k * 100000.0;
+    mgrs->northing = utm->northing - row_100k * 100000.0;
+    mgrs->datum = utm->datum;
+}
 
-    // Compute easting letter (cycle alphabet)
-    int e_idx = (e500k * 5 + e100k) % 25;
-    bg->letters[0] = bg_letters[e_idx];
+int coord_utm_to_mgrs(const UTMPoint *utm, MGRSPoint *mgrs)
+{
+    if (!utm || !mgrs)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_utm(utm))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    mgrs_from_utm_unchecked(utm, mgrs);
+    return COORD_SUCCESS;
+}
 
-    // Compute northing letter (cycle alphabet)
-    int n_idx = (n500k * 5 + n100k) % 25;
-    bg->letters[1] = bg_letters[n_idx];
+int coord_mgrs_to_utm(const MGRSPoint *mgrs, UTMPoint *utm)
+{
+    if (!mgrs || !utm)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_mgrs(mgrs))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    return utm_from_mgrs_unchecked(mgrs, utm);
+}
 
-    bg->letters[2] = '\0';
-    bg->datum = DATUM_OSGB36;  // British Grid always uses OSGB36 datum
+// Geographic to MGRS kernel; geo must already have passed coord_validate_point
+static int mgrs_from_geo_unchecked(const CoordContext *ctx, const GeoCoord *geo,
+                                   MGRSPoint *mgrs)
+{
+    UTMPoint utm;
+    int ret = utm_from_geo_unchecked(ctx, geo, &utm);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    mgrs_from_utm_unchecked(&utm, mgrs);
     return COORD_SUCCESS;
 }
 
-int coord_from_british_grid(CoordContext *ctx, const BritishGridPoint *bg,
-                            GeoCoord *geo)
+int coord_to_mgrs(CoordContext *ctx, const GeoCoord *geo, MGRSPoint *mgrs)
 {
-    if (!ctx || !bg || !geo)
+    if (!ctx || !geo || !mgrs)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    return mgrs_from_geo_unchecked(ctx, geo, mgrs);
+}
 
-    // British National Grid (OSGB36) uses the Airy 1830 ellipsoid
-    // First convert British Grid coordinates to OSGB36 lat/lon
-    // Then convert to WGS84
+// ==================== Prevalidated batch conversion ====================
+size_t coord_validate_batch(const GeoCoord *geo, size_t count,
+                            uint64_t *valid_mask)
+{
+    if (count > 0 && (!geo || !valid_mask))
+    {
+        return 0;
+    }
+    size_t valid = 0;
+    for (size_t w = 0; w < (count + 63) / 64; w++)
+    {
+        size_t base = w * 64;
+        size_t n = count - base < 64 ? count - base : 64;
+        uint64_t bits = 0;
+        for (size_t k = 0; k < n; k++)
+        {
+            const GeoCoord *p = &geo[base + k];
+            // Bitwise AND keeps the range test free of short-circuit branches;
+            // NaN fails every comparison
+            uint64_t ok = (uint64_t)((p->latitude >= -90.0) &
+                                     (p->latitude <= 90.0) &
+                                     (p->longitude >= -180.0) &
+                                     (p->longitude <= 180.0) &
+                                     ((unsigned)p->datum < DATUM_MAX));
+            bits |= ok << k;
+            valid += (size_t)ok;
+        }
+        valid_mask[w] = bits;
+    }
+    return valid;
+}
 
-    // Remove easting and northing offsets
-    double E = bg->easting;
-    double N = bg->northing;
+// Mask bit for point i; invalid points are replaced by (0, 0) so the
+// kernels below always see in-range input
+static inline GeoCoord trusted_point(const GeoCoord *geo,
+                                     const uint64_t *valid_mask, size_t i,
+                                     int *bit)
+{
+    GeoCoord p = geo[i];
+    int ok = (int)((valid_mask[i >> 6] >> (i & 63)) & 1u);
+    p.latitude = ok ? p.latitude : 0.0;
+    p.longitude = ok ? p.longitude : 0.0;
+    *bit = ok;
+    return p;
+}
 
-    // Temporarily use WGS84 ellipsoid for simplified computation
-    // Note: full OSGB36 conversion requires Airy 1830 ellipsoid parameters
-    double a = OSGB36_A;
-    double f = OSGB36_F;
-    double e2 = 2 * f - f * f;
+int coord_to_utm_batch_trusted(CoordContext *ctx, const GeoCoord *geo,
+                               size_t count, const uint64_t *valid_mask,
+                               UTMPoint *utm)
+{
+    if (!ctx || (count > 0 && (!geo || !valid_mask || !utm)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int ok;
+        GeoCoord p = trusted_point(geo, valid_mask, i, &ok);
+        // Zone lookup cannot fail for in-range input
+        (void)utm_from_geo_unchecked(ctx, &p, &utm[i]);
+        utm[i].zone &= -ok;
+    }
+    return COORD_SUCCESS;
+}
 
-    // Compute central meridian and latitude of origin
-    double lon0 = OSGB36_LON0;
-    double E0 = OSGB36_E0;
-    double N0 = OSGB36_N0;
-    double F0 = OSGB36_F0;
+int coord_to_mgrs_batch_trusted(CoordContext *ctx, const GeoCoord *geo,
+                                size_t count, const uint64_t *valid_mask,
+                                MGRSPoint *mgrs)
+{
+    if (!ctx || (count > 0 && (!geo || !valid_mask || !mgrs)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int ok;
+        GeoCoord p = trusted_point(geo, valid_mask, i, &ok);
+        UTMPoint utm;
+        (void)utm_from_geo_unchecked(ctx, &p, &utm);
+        mgrs_from_utm_unchecked(&utm, &mgrs[i]);
+        mgrs[i].zone &= -ok;
+    }
+    return COORD_SUCCESS;
+}
 
-    // Initial latitude estimate
-    double M_prime = (N - N0) / F0;
-    double mu_prime = M_prime / (a * (1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0
-                                   - 5.0 * e2 * e2 * e2 / 256.0));
+// ==================== Packed batches ====================
+GeoBatch coord_geo_batch_soa(double *lat, double *lon, double *alt,
+                             size_t count, MapDatum datum)
+{
+    GeoBatch batch = {lat, lon, alt, 1, count, datum};
+    return batch;
+}
 
-    // Compute initial latitude
-    double e1 = (1.0 - sqrt(1.0 - e2)) / (1.0 + sqrt(1.0 - e2));
-    double J1 = 3.0 * e1 / 2.0 - 27.0 * e1 * e1 * e1 / 32.0;
-    double J2 = 21.0 * e1 * e1 / 16.0 - 55.0 * e1 * e1 * e1 * e1 / 32.0;
-    double J3 = 151.0 * e1 * e1 * e1 / 96.0;
-    double J4 = 1097.0 * e1 * e1 * e1 * e1 / 512.0;
+GeoBatch coord_geo_batch_pairs(double *lat_lon, size_t count, MapDatum datum)
+{
+    GeoBatch batch = {lat_lon, lat_lon ? lat_lon + 1 : NULL, NULL, 2, count,
+                      datum
+                     };
+    return batch;
+}
 
-    double lat_prime = mu_prime + J1 * sin(2.0 * mu_prime) + J2 * sin(4.0 * mu_prime)
-                      + J3 * sin(6.0 * mu_prime) + J4 * sin(8.0 * mu_prime);
+UTMBatch coord_utm_batch_soa(double *easting, double *northing,
+                             unsigned char *zone, char *band, size_t count,
+                             MapDatum datum)
+{
+    UTMBatch batch = {easting, northing, zone, band, 1, count, datum};
+    return batch;
+}
 
-    // Iteratively compute precise latitude and longitude
-    double lat_rad = lat_prime;
-    double lon_rad = lon0;
+UTMBatch coord_utm_batch_pairs(double *easting_northing, unsigned char *zone,
+                               char *band, size_t count, MapDatum datum)
+{
+    UTMBatch batch = {easting_northing,
+                      easting_northing ? easting_northing + 1 : NULL, zone,
+                      band, 2, count, datum
+                     };
+    return batch;
+}
 
-    for (int iter = 0; iter < 10; iter++)
+// A GeoCoord array is a packed batch with a stride in doubles only when the
+// struct is a whole number of doubles. On i386 SysV double is 4-byte aligned
+// and GeoCoord is 28 bytes, so there the GeoCoord batches view one point at a
+// time (a one-point view never uses its stride).
+#define GEO_COORD_STRIDABLE (sizeof(GeoCoord) % sizeof(double) == 0)
+
+// Packed view over a GeoCoord array, so one engine serves both layouts
+static GeoBatch geo_batch_view(const GeoCoord *geo, size_t count)
+{
+    GeoBatch batch = {NULL, NULL, NULL, sizeof(GeoCoord) / sizeof(double),
+                      count, DATUM_WGS84
+                     };
+    if (geo)
     {
-        double sin_lat = sin(lat_rad);
-        double cos_lat = cos(lat_rad);
-        double tan_lat = sin_lat / cos_lat;
-        double sec_lat = 1.0 / cos_lat;
+        batch.lat = (double *)&geo->latitude;
+        batch.lon = (double *)&geo->longitude;
+        batch.alt = (double *)&geo->altitude;
+        batch.datum = geo->datum;
+    }
+    return batch;
+}
 
-        double nu = a * F0 / sqrt(1.0 - e2 * sin_lat * sin_lat);
-        double rho = a * F0 * (1.0 - e2) / pow(1.0 - e2 * sin_lat * sin_lat, 1.5);
-        double eta2 = nu / rho - 1.0;
+static int geo_batch_usable(const GeoBatch *batch)
+{
+    return batch && batch->datum < DATUM_MAX &&
+           (batch->count == 0 || (batch->lat && batch->lon && batch->stride > 0));
+}
 
-        double M = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0
-                        - 5.0 * e2 * e2 * e2 / 256.0) * lat_rad
-                       - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0
-                          + 45.0 * e2 * e2 * e2 / 1024.0) * sin(2.0 * lat_rad)
-                       + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(4.0 * lat_rad)
-                       - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * lat_rad));
-
-        double dM = M - M_prime;
-
-        double delta_E = E - E0;
-        double delta_E2 = delta_E * delta_E;
-        double delta_E3 = delta_E2 * delta_E;
-        double delta_E4 = delta_E3 * delta_E;
-
-        double VII = tan_lat / (2.0 * rho * nu);
-        double VIII = tan_lat / (24.0 * rho * nu * nu * nu)
-                      * (5.0 + 3.0 * tan_lat * tan_lat + eta2 - 9.0 * tan_lat * tan_lat * eta2);
-        double IX = tan_lat / (720.0 * rho * pow(nu, 5))
-                    * (61.0 + 90.0 * tan_lat * tan_lat + 45.0 * pow(tan_lat, 4));
-        double X = sec_lat / nu;
-        double XI = sec_lat / (6.0 * nu * nu * nu) * (nu / rho + 2.0 * tan_lat * tan_lat);
-        double XII = sec_lat / (120.0 * pow(nu, 5))
-                     * (5.0 + 28.0 * tan_lat * tan_lat + 24.0 * pow(tan_lat, 4));
-        double XIIA = sec_lat / (5040.0 * pow(nu, 7))
-                      * (61.0 + 662.0 * tan_lat * tan_lat + 1320.0 * pow(tan_lat, 4)
-                         + 720.0 * pow(tan_lat, 6));
-
-        double lat_delta = VII * dM + VIII * dM * dM * dM + IX * dM * dM * dM * dM * dM;
-        lat_rad -= lat_delta;
+static void geo_batch_get(const GeoBatch *batch, size_t i, GeoCoord *geo)
+{
+    geo->latitude = batch->lat[i * batch->stride];
+    geo->longitude = batch->lon[i * batch->stride];
+    geo->altitude = batch->alt ? batch->alt[i * batch->stride] : 0.0;
+    geo->datum = batch->datum;
+}
 
-        double lon_delta = X * delta_E + XI * delta_E3 + XII * delta_E4 * delta_E
-                          + XIIA * delta_E4 * delta_E3;
-        lon_rad = lon0 + lon_delta;
+static void geo_batch_set(GeoBatch *batch, size_t i, const GeoCoord *geo)
+{
+    batch->lat[i * batch->stride] = geo->latitude;
+    batch->lon[i * batch->stride] = geo->longitude;
+    if (batch->alt)
+    {
+        batch->alt[i * batch->stride] = geo->altitude;
+    }
+}
 
-        // Check convergence
-        if (fabs(lat_delta) < 1e-12)
+int coord_from_utm_packed(CoordContext *ctx, const UTMBatch *utm,
+                          GeoBatch *geo)
+{
+    if (!ctx || !utm || utm->datum >= DATUM_MAX || !geo ||
+            (utm->count > 0 && (!utm->easting || !utm->northing || !utm->zone ||
+                                !utm->band || utm->stride == 0 || !geo->lat ||
+                                !geo->lon || geo->stride == 0)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < utm->count; i++)
+    {
+        UTMPoint point;
+        point.zone = utm->zone[i];
+        point.band = utm->band[i];
+        point.easting = utm->easting[i * utm->stride];
+        point.northing = utm->northing[i * utm->stride];
+        point.convergence = 0.0;
+        point.scale_factor = 0.9996;
+        point.datum = utm->datum;
+        if (!coord_validate_utm(&point))
         {
-            break;
+            return COORD_ERROR_INVALID_COORD;
         }
+        GeoCoord point_geo;
+        geo_from_utm_unchecked(ctx, &point, &point_geo);
+        geo_batch_set(geo, i, &point_geo);
     }
-
-    // Convert to degrees
-    geo->latitude = coord_rad_to_deg(lat_rad);
-    geo->longitude = coord_rad_to_deg(lon_rad);
-    geo->altitude = 0.0;
-
-    // Convert from OSGB36 to WGS84 (simplified approximation)
-    // Approximate Helmert transform parameters for the UK
-    double tx = -446.448;  // m
-    double ty = 125.157;   // m
-    double tz = -542.060;  // m
-    double rx = -0.1502;   // arc-seconds
-    double ry = -0.2470;   // arc-seconds
-    double rz = -0.8421;   // arc-seconds
-    double s = 20.4894;    // ppm
-
-    // Use 7-parameter transform
-    double lat_rad_osgb = lat_rad;
-    double lon_rad_osgb = lon_rad;
-
-    double sin_lat = sin(lat_rad_osgb);
-    double cos_lat = cos(lat_rad_osgb);
-    double sin_lon = sin(lon_rad_osgb);
-    double cos_lon = cos(lon_rad_osgb);
-
-    double nu = a / sqrt(1.0 - e2 * sin_lat * sin_lat);
-    double X = (nu + 0.0) * cos_lat * cos_lon;
-    double Y = (nu + 0.0) * cos_lat * sin_lon;
-    double Z = (nu * (1.0 - e2) + 0.0) * sin_lat;
-
-    // Apply 7-parameter transform
-    double rx_rad = rx * ARC_SEC_TO_RAD;
-    double ry_rad = ry * ARC_SEC_TO_RAD;
-    double rz_rad = rz * ARC_SEC_TO_RAD;
-    double scale_factor = 1.0 + s * PPM_TO_SCALE;
-
-    double X2 = tx + X * scale_factor + Y * rz_rad - Z * ry_rad;
-    double Y2 = ty - X * rz_rad + Y * scale_factor + Z * rx_rad;
-    double Z2 = tz + X * ry_rad - Y * rx_rad + Z * scale_factor;
-
-    // Convert back to WGS84 geodetic coordinates
-    const Ellipsoid *wgs84 = &ELLIPSOIDS[DATUM_WGS84];
-    double p = sqrt(X2 * X2 + Y2 * Y2);
-    double theta = atan2(Z2 * wgs84->a, p * wgs84->b);
-    double sin_theta = sin(theta);
-    double cos_theta = cos(theta);
-
-    double lat_rad_wgs84 = atan2(Z2 + wgs84->ep2 * wgs84->b * sin_theta * sin_theta * sin_theta,
-                                 p - wgs84->e2 * wgs84->a * cos_theta * cos_theta * cos_theta);
-    double lon_rad_wgs84 = atan2(Y2, X2);
-
-    geo->latitude = coord_rad_to_deg(lat_rad_wgs84);
-    geo->longitude = coord_rad_to_deg(lon_rad_wgs84);
-    geo->altitude = 0.0;
-    geo->datum = DATUM_WGS84;
-
+    geo->count = utm->count;
+    geo->datum = utm->datum;
     return COORD_SUCCESS;
 }
 
-// Japan plane rectangular coordinate system zone parameters
-static const struct
-{
-    int zone;
-    double lat0;
-    double lon0;
-    double false_e;   // Easting offset (false easting)
-    double false_n;   // Northing offset (false northing)
-    double scale;
-} japan_zones[] =
-{
-    {1,  33.0,  129.5,   0,       0,         0.9999},
-    {2,  33.0,  131.0,   0,       0,         0.9999},
-    {3,  36.0,  132.1667, 0,       0,         0.9999},
-    {4,  33.0,  133.5,   0,       0,         0.9999},
-    {5,  36.0,  134.3333, 0,       0,         0.9999},
-    {6,  36.0,  136.0,   0,       0,         0.9999},
-    {7,  36.0,  137.1667, 0,       0,         0.9999},
-    {8,  36.0,  138.5,   0,       0,         0.9999},
-    {9,  36.0,  139.8333, 0,       0,         0.9999},
-    {10, 40.0,  140.8333, 0,       0,         0.9999},
-    {11, 44.0,  140.25,  0,       0,         0.9999},
-    {12, 44.0,  142.25,  0,       0,         0.9999},
-    {13, 44.0,  144.25,  0,       0,         0.9999},
-    {14, 26.0,  142.0,   0,       0,         0.9999},
-    {15, 26.0,  127.5,   0,       0,         0.9999},
-    {16, 26.0,  124.0,   0,       0,         0.9999},
-    {17, 26.0,  131.0,   0,       0,         0.9999},
-    {18, 20.0,  136.0,   0,       0,         0.9999},
-    {19, 26.0,  154.0,   0,       0,         0.9999}
-};
-
-// Geographic coordinate to Japan Grid
-int coord_to_japan_grid(CoordContext *ctx, const GeoCoord *geo,
-                        JapanGridPoint *jg)
+// Stops at the first error, like coord_convert_datum_batch(); src and dst may
+// be the same view
+int coord_convert_datum_packed(CoordContext *ctx, const GeoBatch *src,
+                               MapDatum target_datum, GeoBatch *dst)
 {
-    if (!ctx || !geo || !jg)
+    if (!ctx || !geo_batch_usable(src) || !dst || target_datum >= DATUM_MAX ||
+            (src->count > 0 && (!dst->lat || !dst->lon || dst->stride == 0)))
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_point(geo))
+    size_t count = src->count;
+    for (size_t i = 0; i < count; i++)
     {
-        return COORD_ERROR_INVALID_COORD;
+        GeoCoord in;
+        GeoCoord out;
+        geo_batch_get(src, i, &in);
+        int ret = coord_convert_datum_ex(ctx, &in, target_datum,
+                                         ctx->shift_method, &out);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+        geo_batch_set(dst, i, &out);
     }
-    // Convert to Tokyo datum
-    GeoCoord tokyo_geo;
-    int ret = coord_convert_datum(ctx, geo, DATUM_TOKYO, &tokyo_geo);
-    if (ret != COORD_SUCCESS)
+    dst->count = count;
+    dst->datum = target_datum;
+    return COORD_SUCCESS;
+}
+
+size_t coord_classify_utm_packed(const GeoBatch *geo, int *zones, char *bands)
+{
+    if (!geo || (geo->count > 0 && (!geo->lat || !geo->lon || geo->stride == 0 ||
+                                    !zones || !bands)))
     {
-        return ret;
+        return 0;
     }
+    size_t valid = 0;
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        double lat = geo->lat[i * geo->stride];
+        double lon = geo->lon[i * geo->stride];
+        int ok = coord_is_valid_latitude(lat) && coord_is_valid_longitude(lon);
+        int zone;
+        char band;
+        utm_classify(ok ? lon : 0.0, ok ? lat : 0.0, &zone, &band);
+        zones[i] = zone & -ok;
+        bands[i] = ok ? band : 'Z';
+        valid += ok;
+    }
+    return valid;
+}
 
-    double lat = tokyo_geo.latitude;
-    double lon = tokyo_geo.longitude;
-
-    // Select the appropriate zone based on lat/lon (nearest central meridian)
-    // No geographic bounds; support any coordinates
-    int zone_idx = -1;
-    double min_dist = 1e308;
-    for (size_t i = 0; i < sizeof(japan_zones) / sizeof(japan_zones[0]); i++)
+// Packed prevalidation: the batch datum is checked once, the ranges per point
+size_t coord_validate_packed(const GeoBatch *geo, uint64_t *valid_mask)
+{
+    if (!geo || (geo->count > 0 && (!geo->lat || !geo->lon || geo->stride == 0 ||
+                                    !valid_mask)))
     {
-        double dx = (lon - japan_zones[i].lon0);
-        double dy = (lat - japan_zones[i].lat0);
-        double dist = dx * dx + dy * dy;
-        if (dist < min_dist)
+        return 0;
+    }
+    uint64_t datum_ok = (unsigned)geo->datum < DATUM_MAX;
+    size_t count = geo->count;
+    size_t valid = 0;
+    for (size_t w = 0; w < (count + 63) / 64; w++)
+    {
+        size_t base = w * 64;
+        size_t n = count - base < 64 ? count - base : 64;
+        uint64_t bits = 0;
+        for (size_t k = 0; k < n; k++)
         {
-            min_dist = dist;
-            zone_idx = i;
+            double lat = geo->lat[(base + k) * geo->stride];
+            double lon = geo->lon[(base + k) * geo->stride];
+            uint64_t ok = (uint64_t)((lat >= -90.0) & (lat <= 90.0) &
+                                     (lon >= -180.0) & (lon <= 180.0)) & datum_ok;
+            bits |= ok << k;
+            valid += (size_t)ok;
         }
+        valid_mask[w] = bits;
     }
+    return valid;
+}
 
-    if (zone_idx < 0)
+// Packed counterpart of trusted_point()
+static inline GeoCoord trusted_packed_point(const GeoBatch *geo,
+                                            const uint64_t *valid_mask,
+                                            size_t i, int *bit)
+{
+    GeoCoord p;
+    geo_batch_get(geo, i, &p);
+    int ok = (int)((valid_mask[i >> 6] >> (i & 63)) & 1u);
+    p.latitude = ok ? p.latitude : 0.0;
+    p.longitude = ok ? p.longitude : 0.0;
+    *bit = ok;
+    return p;
+}
+
+int coord_to_utm_packed_trusted(CoordContext *ctx, const GeoBatch *geo,
+                                const uint64_t *valid_mask, UTMBatch *utm)
+{
+    if (!ctx || !geo_batch_usable(geo) || !utm ||
+            (geo->count > 0 && (!valid_mask || !utm->easting || !utm->northing ||
+                                !utm->zone || !utm->band || utm->stride == 0)))
     {
-        return COORD_ERROR_OUT_OF_RANGE;
+        return COORD_ERROR_INVALID_INPUT;
     }
-
-    // Get zone parameters
-    double lat0 = japan_zones[zone_idx].lat0 * DEG_TO_RAD;
-    double lon0 = japan_zones[zone_idx].lon0 * DEG_TO_RAD;
-    double false_e = japan_zones[zone_idx].false_e;
-    double false_n = japan_zones[zone_idx].false_n;
-    double k0 = japan_zones[zone_idx].scale;
-
-    double lat_rad = tokyo_geo.latitude * DEG_TO_RAD;
-    double lon_rad = tokyo_geo.longitude * DEG_TO_RAD;
-
-    double sin_lat = sin(lat_rad);
-    double cos_lat = cos(lat_rad);
-    double tan_lat = sin_lat / cos_lat;
-
-    // Bessel 1841 ellipsoid parameters
-    double a = JAPAN_GRID_A;
-    double f = JAPAN_GRID_F;
-    double e2 = 2 * f - f * f;
-
-    // Compute meridional arc length M
-    double M = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 / 256.0) * lat_rad
-                   - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(2.0 * lat_rad)
-                   + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(4.0 * lat_rad)
-                   - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * lat_rad));
-
-    // Compute auxiliary parameters
-    double N = a / sqrt(1.0 - e2 * sin_lat * sin_lat);
-    double T = tan_lat * tan_lat;
-    double C = e2 * cos_lat * cos_lat / (1.0 - e2);
-    double A = (lon_rad - lon0) * cos_lat;
-    double A2 = A * A;
-    double A3 = A2 * A;
-    double A4 = A3 * A;
-    double A5 = A4 * A;
-    double A6 = A5 * A;
-
-    // Compute X (northing)
-    jg->x = k0 * (M + N * tan_lat * (A2 / 2.0 + (5.0 - T + 9.0 * C + 4.0 * C * C) * A4 / 24.0
-               + (61.0 - 58.0 * T + T * T + 600.0 * C - 330.0 * e2) * A6 / 720.0)) + false_n;
-
-    // Compute Y (easting)
-    jg->y = k0 * N * (A + (1.0 - T + C) * A3 / 6.0
-               + (5.0 - 18.0 * T + T * T + 72.0 * C - 58.0 * e2) * A5 / 120.0) + false_e;
-
-    jg->zone = japan_zones[zone_idx].zone;
-    jg->datum = DATUM_TOKYO;
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        int ok;
+        GeoCoord p = trusted_packed_point(geo, valid_mask, i, &ok);
+        UTMPoint point;
+        (void)utm_from_geo_unchecked(ctx, &p, &point);
+        utm->easting[i * utm->stride] = point.easting;
+        utm->northing[i * utm->stride] = point.northing;
+        utm->zone[i] = (unsigned char)(point.zone & -ok);
+        utm->band[i] = point.band;
+    }
+    utm->count = geo->count;
+    utm->datum = geo->datum;
     return COORD_SUCCESS;
 }
 
-int coord_from_japan_grid(CoordContext *ctx, const JapanGridPoint *jg,
-                          GeoCoord *geo)
+int coord_to_mgrs_packed_trusted(CoordContext *ctx, const GeoBatch *geo,
+                                 const uint64_t *valid_mask, MGRSPoint *mgrs)
 {
-    if (!ctx || !jg || !geo)
+    if (!ctx || !geo_batch_usable(geo) ||
+            (geo->count > 0 && (!valid_mask || !mgrs)))
     {
         return COORD_ERROR_INVALID_INPUT;
     }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        int ok;
+        GeoCoord p = trusted_packed_point(geo, valid_mask, i, &ok);
+        UTMPoint utm;
+        (void)utm_from_geo_unchecked(ctx, &p, &utm);
+        mgrs_from_utm_unchecked(&utm, &mgrs[i]);
+        mgrs[i].zone &= -ok;
+    }
+    return COORD_SUCCESS;
+}
 
-    // Get Bessel 1841 ellipsoid parameters
-    double a = JAPAN_GRID_A;
-    double f = JAPAN_GRID_F;
-    double e2 = 2 * f - f * f;
-
-    // Lookup zone parameters (using externally defined japan_zones array)
-    int zone_idx = -1;
-    for (size_t i = 0; i < sizeof(japan_zones) / sizeof(japan_zones[0]); i++)
+size_t coord_classify_utm_batch(const GeoCoord *geo, size_t count, int *zones,
+                                char *bands)
+{
+    if (count > 0 && !geo)
     {
-        if (japan_zones[i].zone == jg->zone)
+        return 0;
+    }
+    if (!GEO_COORD_STRIDABLE)
+    {
+        size_t valid = 0;
+        for (size_t i = 0; i < count; i++)
         {
-            zone_idx = i;
-            break;
+            GeoBatch one = geo_batch_view(&geo[i], 1);
+            valid += coord_classify_utm_packed(&one, &zones[i], &bands[i]);
         }
+        return valid;
     }
+    GeoBatch view = geo_batch_view(geo, count);
+    return coord_classify_utm_packed(&view, zones, bands);
+}
 
-    if (zone_idx < 0)
+// ==================== Locality ordering ====================
+// Bit i of v moved to bit 2i. With BMI2 this is a single pdep, which is
+// microcoded (and slower than the shifts) on AMD before Zen 3.
+static uint64_t interleave_spread(uint32_t v)
+{
+#if defined(__BMI2__)
+    return _pdep_u64(v, 0x5555555555555555ULL);
+#else
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+#endif
+}
+
+// Inverse of interleave_spread: bit 2i of x moved to bit i
+static uint32_t interleave_compact(uint64_t x)
+{
+#if defined(__BMI2__)
+    return (uint32_t)_pext_u64(x, 0x5555555555555555ULL);
+#else
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t)x;
+#endif
+}
+
+// Z-order key: bits of x and y interleaved (x in the even bits)
+static uint32_t morton_key(uint32_t x, uint32_t y)
+{
+    return (uint32_t)(interleave_spread(x) | (interleave_spread(y) << 1));
+}
+
+// Distance along the Hilbert curve over a 65536 x 65536 grid. The quadrant
+// rotation (reflect when rx && !ry, transpose when !ry) is done with masks,
+// since its branches are unpredictable on scattered input.
+static uint32_t hilbert_key(uint32_t x, uint32_t y)
+{
+    uint32_t d = 0;
+    for (int bit = 15; bit >= 0; bit--)
+    {
+        uint32_t s = 1u << bit;
+        uint32_t rx = (x >> bit) & 1;
+        uint32_t ry = (y >> bit) & 1;
+        d += s * s * ((3 * rx) ^ ry);
+        uint32_t flip = -(rx & (ry ^ 1)) & 0xFFFFu;
+        x ^= flip;
+        y ^= flip;
+        uint32_t swap = (x ^ y) & -(ry ^ 1);
+        x ^= swap;
+        y ^= swap;
+    }
+    return d;
+}
+
+int coord_locality_order(CoordContext *ctx, const GeoBatch *geo,
+                         LocalityCurve curve, size_t *order)
+{
+    if (!ctx || !geo_batch_usable(geo) || curve >= LOCALITY_MAX ||
+            (geo->count > 0 && !order))
     {
         return COORD_ERROR_INVALID_INPUT;
     }
+    size_t count = geo->count;
+    size_t stride = geo->stride;
+    if (count == 0)
+    {
+        return COORD_SUCCESS;
+    }
+    double lat_min = geo->lat[0], lat_max = geo->lat[0];
+    double lon_min = geo->lon[0], lon_max = geo->lon[0];
+    for (size_t i = 0; i < count; i++)
+    {
+        double lat = geo->lat[i * stride];
+        double lon = geo->lon[i * stride];
+        if (!coord_is_valid_latitude(lat) || !coord_is_valid_longitude(lon))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        lat_min = fmin(lat_min, lat);
+        lat_max = fmax(lat_max, lat);
+        lon_min = fmin(lon_min, lon);
+        lon_max = fmax(lon_max, lon);
+    }
+    // Keys and indices for an LSD radix sort, ping-ponging with order
+    uint32_t *keys = (uint32_t *)coord_alloc(&ctx->allocator,
+                     count * (2 * sizeof(uint32_t) + sizeof(size_t)));
+    if (!keys)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate locality keys");
+        return COORD_ERROR_MEMORY;
+    }
+    uint32_t *keys_tmp = keys + count;
+    size_t *order_tmp = (size_t *)(keys_tmp + count);
+    double lat_scale = lat_max > lat_min ? 65535.0 / (lat_max - lat_min) : 0.0;
+    double lon_scale = lon_max > lon_min ? 65535.0 / (lon_max - lon_min) : 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t x = (uint32_t)((geo->lon[i * stride] - lon_min) * lon_scale);
+        uint32_t y = (uint32_t)((geo->lat[i * stride] - lat_min) * lat_scale);
+        keys[i] = curve == LOCALITY_HILBERT ? hilbert_key(x, y) : morton_key(x, y);
+        order[i] = i;
+    }
+    // Four stable 8-bit passes; an even pass count leaves the result in order
+    uint32_t *key_src = keys, *key_dst = keys_tmp;
+    size_t *idx_src = order, *idx_dst = order_tmp;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        size_t start[257] = {0};
+        for (size_t i = 0; i < count; i++)
+        {
+            start[((key_src[i] >> shift) & 0xFF) + 1]++;
+        }
+        for (int b = 0; b < 256; b++)
+        {
+            start[b + 1] += start[b];
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t pos = start[(key_src[i] >> shift) & 0xFF]++;
+            key_dst[pos] = key_src[i];
+            idx_dst[pos] = idx_src[i];
+        }
+        uint32_t *key_swap = key_src;
+        key_src = key_dst;
+        key_dst = key_swap;
+        size_t *idx_swap = idx_src;
+        idx_src = idx_dst;
+        idx_dst = idx_swap;
+    }
+    coord_free(&ctx->allocator, keys);
+    return COORD_SUCCESS;
+}
+
+// ==================== UTM/MGRS batch projection ====================
+// Points are classified and projected in one pass, in input order, with the
+// ellipsoid series constants computed once per call. Grouping each block by
+// zone and hemisphere (hoisting the central meridian), or by zone and band
+// (also hoisting the band's sine and cosine for small-angle series), was
+// measured and dropped: once the zone/band lookup became a table, the staging
+// copy and scatter cost as much as the hoisted constants saved.
+
+// Shared engine for the UTM and MGRS batches. Points are read through a
+// packed view; points (may be NULL) supplies per-point datums for GeoCoord
+// input. Any of the three outputs may be NULL.
+static int utm_batch_project(CoordContext *ctx, const GeoBatch *geo,
+                             const GeoCoord *points, UTMPoint *utm,
+                             MGRSPoint *mgrs, UTMBatch *packed)
+{
+    size_t count = geo->count;
+    size_t stride = geo->stride;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!coord_is_valid_latitude(geo->lat[i * stride]) ||
+                !coord_is_valid_longitude(geo->lon[i * stride]))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+    }
+    UTMSeries series;
+    utm_series_init(&ctx->ellipsoid, &series);
+    for (size_t i = 0; i < count; i++)
+    {
+        double lat = geo->lat[i * stride];
+        double lon = geo->lon[i * stride];
+        UTMPoint point;
+        utm_classify(lon, lat, &point.zone, &point.band);
+        double lat_rad = coord_deg_to_rad(lat);
+        double center_rad = coord_deg_to_rad((point.zone - 1) * 6.0 - 180.0 + 3.0);
+        // 180E is classified into zone 1, across the antimeridian
+        double dlon_rad = coord_deg_to_rad(lon) - center_rad;
+        if (dlon_rad > M_PI)
+        {
+            dlon_rad -= 2.0 * M_PI;
+        }
+        else if (dlon_rad < -M_PI)
+        {
+            dlon_rad += 2.0 * M_PI;
+        }
+        double sin_lat, cos_lat;
+        trig_sincos(lat_rad, &sin_lat, &cos_lat);
+        utm_forward_series(&series, lat_rad, sin_lat, cos_lat, dlon_rad,
+                           &point.easting, &point.northing, &point.convergence);
+        if (lat < 0.0)
+        {
+            point.northing += 10000000.0;
+        }
+        point.scale_factor = 0.9996;
+        point.datum = points ? points[i].datum : geo->datum;
+        if (utm)
+        {
+            utm[i] = point;
+        }
+        if (mgrs)
+        {
+            mgrs_from_utm_unchecked(&point, &mgrs[i]);
+        }
+        if (packed)
+        {
+            packed->easting[i * packed->stride] = point.easting;
+            packed->northing[i * packed->stride] = point.northing;
+            packed->zone[i] = (unsigned char)point.zone;
+            packed->band[i] = point.band;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+// GeoCoord batches where the array cannot be strided (see GEO_COORD_STRIDABLE):
+// the whole input is validated first, then each point goes through the engine
+static int utm_batch_points(CoordContext *ctx, const GeoCoord *geo, size_t count,
+                            UTMPoint *utm, MGRSPoint *mgrs)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!coord_is_valid_latitude(geo[i].latitude) ||
+                !coord_is_valid_longitude(geo[i].longitude))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        GeoBatch one = geo_batch_view(&geo[i], 1);
+        utm_batch_project(ctx, &one, &geo[i], utm ? &utm[i] : NULL,
+                          mgrs ? &mgrs[i] : NULL, NULL);
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_to_utm_batch(CoordContext *ctx, const GeoCoord *geo, size_t count,
+                       UTMPoint *utm)
+{
+    if (!ctx || (count > 0 && (!geo || !utm)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!GEO_COORD_STRIDABLE)
+    {
+        return utm_batch_points(ctx, geo, count, utm, NULL);
+    }
+    GeoBatch view = geo_batch_view(geo, count);
+    return utm_batch_project(ctx, &view, geo, utm, NULL, NULL);
+}
+
+int coord_to_mgrs_batch(CoordContext *ctx, const GeoCoord *geo, size_t count,
+                        MGRSPoint *mgrs)
+{
+    if (!ctx || (count > 0 && (!geo || !mgrs)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!GEO_COORD_STRIDABLE)
+    {
+        return utm_batch_points(ctx, geo, count, NULL, mgrs);
+    }
+    GeoBatch view = geo_batch_view(geo, count);
+    return utm_batch_project(ctx, &view, geo, NULL, mgrs, NULL);
+}
+
+int coord_to_utm_packed(CoordContext *ctx, const GeoBatch *geo, UTMBatch *utm)
+{
+    if (!ctx || !geo_batch_usable(geo) || !utm ||
+            (geo->count > 0 && (!utm->easting || !utm->northing || !utm->zone ||
+                                !utm->band || utm->stride == 0)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    int ret = utm_batch_project(ctx, geo, NULL, NULL, NULL, utm);
+    if (ret == COORD_SUCCESS)
+    {
+        utm->count = geo->count;
+        utm->datum = geo->datum;
+    }
+    return ret;
+}
+
+int coord_to_mgrs_packed(CoordContext *ctx, const GeoBatch *geo,
+                         MGRSPoint *mgrs)
+{
+    if (!ctx || !geo_batch_usable(geo) || (geo->count > 0 && !mgrs))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    return utm_batch_project(ctx, geo, NULL, NULL, mgrs, NULL);
+}
+
+// British National Grid transverse Mercator on the Airy 1830 ellipsoid
+static void bng_forward(double latitude, double longitude, double *easting,
+                        double *northing)
+{
+    // Use OSGB36/Airy 1830 ellipsoid parameters
+    double a = OSGB36_A;
+    double f = OSGB36_F;
+    double e2 = 2 * f - f * f;
+
+    double lat_rad = coord_deg_to_rad(latitude);
+    double lon_rad = coord_deg_to_rad(longitude);
+    double sin_lat = sin(lat_rad);
+    double cos_lat = cos(lat_rad);
+    double tan_lat = sin_lat / cos_lat;
+    double N = a / sqrt(1.0 - e2 * sin_lat * sin_lat);
+    double T = tan_lat * tan_lat;
+    double C = e2 * cos_lat * cos_lat / (1.0 - e2);
+    double A = (lon_rad - OSGB36_LON0) * cos_lat;
+    // Compute M
+    double M = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 /
+                     256.0) * lat_rad
+                    - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(
+                        2.0 * lat_rad)
+                    + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(4.0 * lat_rad)
+                    - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * lat_rad));
+    // Compute M0
+    double M0 = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 /
+                      256.0) * OSGB36_LAT0
+                     - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(
+                         2.0 * OSGB36_LAT0)
+                     + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(
+                         4.0 * OSGB36_LAT0)
+                     - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * OSGB36_LAT0));
+    double A2 = A * A;
+    double A3 = A2 * A;
+    double A4 = A3 * A;
+    double A5 = A4 * A;
+    double A6 = A5 * A;
+    *easting = OSGB36_E0 + OSGB36_F0 * N * (A + (1.0 - T + C) * A3 / 6.0
+                  + (5.0 - 18.0 * T + T * T + 72.0 * C - 58.0 * e2) * A5 / 120.0);
+    *northing = OSGB36_N0 + OSGB36_F0 * (M - M0 + N * tan_lat *
+                                            (A2 / 2.0 + (5.0 - T + 9.0 * C + 4.0 * C * C) * A4 / 24.0
+                                                    + (61.0 - 58.0 * T + T * T + 600.0 * C - 330.0 * e2) * A6 / 720.0));
+}
+
+// Two-letter 100km square code for a British Grid easting/northing
+static void bng_set_letters(BritishGridPoint *bg)
+{
+    // British National Grid letters
+    // British Grid uses a special 500km square letter system
+    // Note: for coordinates outside the UK, letters are not standard
+    // Here we use an extended cyclic computation
+
+    // Compute 500km square index, reduced mod 25 before the int conversion so
+    // that far-field eastings cannot overflow it
+    int e500k = (int)fmod(trunc(bg->easting / 500000.0), 25.0);
+    int n500k = (int)fmod(trunc(bg->northing / 500000.0), 25.0);
+
+    // Handle negative indices
+    if (e500k < 0) e500k += 25;  // Ensure positive
+    if (n500k < 0) n500k += 25;
+
+    // Letters within 100km square
+    int e100k = (int)(fmod(fabs(bg->easting), 500000.0) / 100000.0);
+    int n100k = (int)(fmod(fabs(bg->northing), 500000.0) / 100000.0);
+
+    // Use British Grid alphabet (skip I)
+    const char *bg_letters = "ABCDEFGHJKLMNPQRSTUVWXYZ";
+
+    // Compute easting letter (cycle alphabet)
+    int e_idx = (e500k * 5 + e100k) % 25;
+    bg->letters[0] = bg_letters[e_idx];
+
+    // Compute northing letter (cycle alphabet)
+    int n_idx = (n500k * 5 + n100k) % 25;
+    bg->letters[1] = bg_letters[n_idx];
+
+    bg->letters[2] = '\0';
+}
+
+// Geographic coordinate to British Grid
+// BNG forward kernel; geo must already be a valid point on a known datum
+static int bng_from_geo_unchecked(const CoordContext *ctx, const GeoCoord *geo,
+                                  BritishGridPoint *bg)
+{
+    // British National Grid must use OSGB36 datum and Airy 1830 ellipsoid
+    // If input is not OSGB36, convert datum first
+    GeoCoord osgb_geo;
+    if (geo->datum != DATUM_OSGB36)
+    {
+        datum_convert_unchecked(ctx, geo, DATUM_OSGB36, ctx->shift_method,
+                                &osgb_geo);
+    }
+    else
+    {
+        osgb_geo = *geo;
+    }
+
+    bng_forward(osgb_geo.latitude, osgb_geo.longitude, &bg->easting,
+                &bg->northing);
+    bng_set_letters(bg);
+    bg->datum = DATUM_OSGB36;  // British Grid always uses OSGB36 datum
+    return COORD_SUCCESS;
+}
+
+int coord_to_british_grid(CoordContext *ctx, const GeoCoord *geo,
+                          BritishGridPoint *bg)
+{
+    if (!ctx || !geo || !bg || geo->datum >= DATUM_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    return bng_from_geo_unchecked(ctx, geo, bg);
+}
+
+int coord_from_british_grid(CoordContext *ctx, const BritishGridPoint *bg,
+                            GeoCoord *geo)
+{
+    if (!ctx || !bg || !geo)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+
+    // British National Grid (OSGB36) uses the Airy 1830 ellipsoid
+    // First convert British Grid coordinates to OSGB36 lat/lon
+    // Then convert to WGS84
+
+    // Remove easting and northing offsets
+    double E = bg->easting;
+    double N = bg->northing;
+
+    // Temporarily use WGS84 ellipsoid for simplified computation
+    // Note: full OSGB36 conversion requires Airy 1830 ellipsoid parameters
+    double a = OSGB36_A;
+    double f = OSGB36_F;
+    double e2 = 2 * f - f * f;
+
+    // Compute central meridian and latitude of origin
+    double lon0 = OSGB36_LON0;
+    double E0 = OSGB36_E0;
+    double N0 = OSGB36_N0;
+    double F0 = OSGB36_F0;
+
+    // Initial latitude estimate
+    double M_prime = (N - N0) / F0;
+    double mu_prime = M_prime / (a * (1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0
+                                   - 5.0 * e2 * e2 * e2 / 256.0));
+
+    // Compute initial latitude
+    double e1 = (1.0 - sqrt(1.0 - e2)) / (1.0 + sqrt(1.0 - e2));
+    double J1 = 3.0 * e1 / 2.0 - 27.0 * e1 * e1 * e1 / 32.0;
+    double J2 = 21.0 * e1 * e1 / 16.0 - 55.0 * e1 * e1 * e1 * e1 / 32.0;
+    double J3 = 151.0 * e1 * e1 * e1 / 96.0;
+    double J4 = 1097.0 * e1 * e1 * e1 * e1 / 512.0;
+
+    double lat_prime = mu_prime + J1 * sin(2.0 * mu_prime) + J2 * sin(4.0 * mu_prime)
+                      + J3 * sin(6.0 * mu_prime) + J4 * sin(8.0 * mu_prime);
+
+    // Iteratively compute precise latitude and longitude
+    double lat_rad = lat_prime;
+    double lon_rad = lon0;
+
+    for (int iter = 0; iter < 10; iter++)
+    {
+        double sin_lat = sin(lat_rad);
+        double cos_lat = cos(lat_rad);
+        double tan_lat = sin_lat / cos_lat;
+        double sec_lat = 1.0 / cos_lat;
+
+        double nu = a * F0 / sqrt(1.0 - e2 * sin_lat * sin_lat);
+        double rho = a * F0 * (1.0 - e2) / pow(1.0 - e2 * sin_lat * sin_lat, 1.5);
+        double eta2 = nu / rho - 1.0;
+
+        double M = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0
+                        - 5.0 * e2 * e2 * e2 / 256.0) * lat_rad
+                       - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0
+                          + 45.0 * e2 * e2 * e2 / 1024.0) * sin(2.0 * lat_rad)
+                       + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(4.0 * lat_rad)
+                       - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * lat_rad));
+
+        double dM = M - M_prime;
+
+        double delta_E = E - E0;
+        double delta_E2 = delta_E * delta_E;
+        double delta_E3 = delta_E2 * delta_E;
+        double delta_E4 = delta_E3 * delta_E;
+
+        double VII = tan_lat / (2.0 * rho * nu);
+        double VIII = tan_lat / (24.0 * rho * nu * nu * nu)
+                      * (5.0 + 3.0 * tan_lat * tan_lat + eta2 - 9.0 * tan_lat * tan_lat * eta2);
+        double IX = tan_lat / (720.0 * rho * pow(nu, 5))
+                    * (61.0 + 90.0 * tan_lat * tan_lat + 45.0 * pow(tan_lat, 4));
+        double X = sec_lat / nu;
+        double XI = sec_lat / (6.0 * nu * nu * nu) * (nu / rho + 2.0 * tan_lat * tan_lat);
+        double XII = sec_lat / (120.0 * pow(nu, 5))
+                     * (5.0 + 28.0 * tan_lat * tan_lat + 24.0 * pow(tan_lat, 4));
+        double XIIA = sec_lat / (5040.0 * pow(nu, 7))
+                      * (61.0 + 662.0 * tan_lat * tan_lat + 1320.0 * pow(tan_lat, 4)
+                         + 720.0 * pow(tan_lat, 6));
+
+        double lat_delta = VII * dM + VIII * dM * dM * dM + IX * dM * dM * dM * dM * dM;
+        lat_rad -= lat_delta;
+
+        double lon_delta = X * delta_E + XI * delta_E3 + XII * delta_E4 * delta_E
+                          + XIIA * delta_E4 * delta_E3;
+        lon_rad = lon0 + lon_delta;
+
+        // Check convergence
+        if (fabs(lat_delta) < 1e-12)
+        {
+            break;
+        }
+    }
+
+    // Convert to degrees
+    geo->latitude = coord_rad_to_deg(lat_rad);
+    geo->longitude = coord_rad_to_deg(lon_rad);
+    geo->altitude = 0.0;
+
+    // Convert from OSGB36 to WGS84 (simplified approximation)
+    // Approximate Helmert transform parameters for the UK
+    double tx = -446.448;  // m
+    double ty = 125.157;   // m
+    double tz = -542.060;  // m
+    double rx = -0.1502;   // arc-seconds
+    double ry = -0.2470;   // arc-seconds
+    double rz = -0.8421;   // arc-seconds
+    double s = 20.4894;    // ppm
+
+    // Use 7-parameter transform
+    double lat_rad_osgb = lat_rad;
+    double lon_rad_osgb = lon_rad;
+
+    double xyz[3];
+    geodetic_to_ecef(a, e2, lat_rad_osgb, lon_rad_osgb, 0.0, xyz);
+    double X = xyz[0];
+    double Y = xyz[1];
+    double Z = xyz[2];
+
+    // Apply 7-parameter transform
+    double rx_rad = rx * ARC_SEC_TO_RAD;
+    double ry_rad = ry * ARC_SEC_TO_RAD;
+    double rz_rad = rz * ARC_SEC_TO_RAD;
+    double scale_factor = 1.0 + s * PPM_TO_SCALE;
+
+    double X2 = tx + X * scale_factor + Y * rz_rad - Z * ry_rad;
+    double Y2 = ty - X * rz_rad + Y * scale_factor + Z * rx_rad;
+    double Z2 = tz + X * ry_rad - Y * rx_rad + Z * scale_factor;
+
+    // Convert back to WGS84 geodetic coordinates
+    double lat_rad_wgs84, lon_rad_wgs84;
+    ecef_to_geodetic(&ELLIPSOIDS[DATUM_WGS84], X2, Y2, Z2,
+                     &lat_rad_wgs84, &lon_rad_wgs84, NULL);
+
+    geo->latitude = coord_rad_to_deg(lat_rad_wgs84);
+    geo->longitude = coord_rad_to_deg(lon_rad_wgs84);
+    geo->altitude = 0.0;
+    geo->datum = DATUM_WGS84;
+
+    return COORD_SUCCESS;
+}
+
+// Japan plane rectangular coordinate system zone parameters
+static const struct
+{
+    int zone;
+    double lat0;
+    double lon0;
+    double false_e;   // Easting offset (false easting)
+    double false_n;   // Northing offset (false northing)
+    double scale;
+} japan_zones[] =
+{
+    {1,  33.0,  129.5,   0,       0,         0.9999},
+    {2,  33.0,  131.0,   0,       0,         0.9999},
+    {3,  36.0,  132.1667, 0,       0,         0.9999},
+    {4,  33.0,  133.5,   0,       0,         0.9999},
+    {5,  36.0,  134.3333, 0,       0,         0.9999},
+    {6,  36.0,  136.0,   0,       0,         0.9999},
+    {7,  36.0,  137.1667, 0,       0,         0.9999},
+    {8,  36.0,  138.5,   0,       0,         0.9999},
+    {9,  36.0,  139.8333, 0,       0,         0.9999},
+    {10, 40.0,  140.8333, 0,       0,         0.9999},
+    {11, 44.0,  140.25,  0,       0,         0.9999},
+    {12, 44.0,  142.25,  0,       0,         0.9999},
+    {13, 44.0,  144.25,  0,       0,         0.9999},
+    {14, 26.0,  142.0,   0,       0,         0.9999},
+    {15, 26.0,  127.5,   0,       0,         0.9999},
+    {16, 26.0,  124.0,   0,       0,         0.9999},
+    {17, 26.0,  131.0,   0,       0,         0.9999},
+    {18, 20.0,  136.0,   0,       0,         0.9999},
+    {19, 26.0,  154.0,   0,       0,         0.9999}
+};
+
+// Geographic coordinate to Japan Grid
+// Japan plane grid forward kernel; geo must already be a valid point on a known datum
+static int japan_grid_from_geo_unchecked(const CoordContext *ctx,
+        const GeoCoord *geo, JapanGridPoint *jg)
+{
+    // Convert to Tokyo datum
+    GeoCoord tokyo_geo;
+    datum_convert_unchecked(ctx, geo, DATUM_TOKYO, ctx->shift_method,
+                            &tokyo_geo);
+
+    double lat = tokyo_geo.latitude;
+    double lon = tokyo_geo.longitude;
+
+    // Select the appropriate zone based on lat/lon (nearest central meridian)
+    // No geographic bounds; support any coordinates
+    int zone_idx = -1;
+    double min_dist = 1e308;
+    for (size_t i = 0; i < sizeof(japan_zones) / sizeof(japan_zones[0]); i++)
+    {
+        double dx = (lon - japan_zones[i].lon0);
+        double dy = (lat - japan_zones[i].lat0);
+        double dist = dx * dx + dy * dy;
+        if (dist < min_dist)
+        {
+            min_dist = dist;
+            zone_idx = i;
+        }
+    }
+
+    if (zone_idx < 0)
+    {
+        return COORD_ERROR_OUT_OF_RANGE;
+    }
+
+    // Get zone parameters
+    double lat0 = japan_zones[zone_idx].lat0 * DEG_TO_RAD;
+    double lon0 = japan_zones[zone_idx].lon0 * DEG_TO_RAD;
+    double false_e = japan_zones[zone_idx].false_e;
+    double false_n = japan_zones[zone_idx].false_n;
+    double k0 = japan_zones[zone_idx].scale;
+
+    double lat_rad = tokyo_geo.latitude * DEG_TO_RAD;
+    double lon_rad = tokyo_geo.longitude * DEG_TO_RAD;
+
+    double sin_lat = sin(lat_rad);
+    double cos_lat = cos(lat_rad);
+    double tan_lat = sin_lat / cos_lat;
+
+    // Bessel 1841 ellipsoid parameters
+    double a = JAPAN_GRID_A;
+    double f = JAPAN_GRID_F;
+    double e2 = 2 * f - f * f;
+
+    // Compute meridional arc length M
+    double M = a * ((1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0 - 5.0 * e2 * e2 * e2 / 256.0) * lat_rad
+                   - (3.0 * e2 / 8.0 + 3.0 * e2 * e2 / 32.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(2.0 * lat_rad)
+                   + (15.0 * e2 * e2 / 256.0 + 45.0 * e2 * e2 * e2 / 1024.0) * sin(4.0 * lat_rad)
+                   - (35.0 * e2 * e2 * e2 / 3072.0) * sin(6.0 * lat_rad));
+
+    // Compute auxiliary parameters
+    double N = a / sqrt(1.0 - e2 * sin_lat * sin_lat);
+    double T = tan_lat * tan_lat;
+    double C = e2 * cos_lat * cos_lat / (1.0 - e2);
+    double A = (lon_rad - lon0) * cos_lat;
+    double A2 = A * A;
+    double A3 = A2 * A;
+    double A4 = A3 * A;
+    double A5 = A4 * A;
+    double A6 = A5 * A;
+
+    // Compute X (northing)
+    jg->x = k0 * (M + N * tan_lat * (A2 / 2.0 + (5.0 - T + 9.0 * C + 4.0 * C * C) * A4 / 24.0
+               + (61.0 - 58.0 * T + T * T + 600.0 * C - 330.0 * e2) * A6 / 720.0)) + false_n;
+
+    // Compute Y (easting)
+    jg->y = k0 * N * (A + (1.0 - T + C) * A3 / 6.0
+               + (5.0 - 18.0 * T + T * T + 72.0 * C - 58.0 * e2) * A5 / 120.0) + false_e;
+
+    jg->zone = japan_zones[zone_idx].zone;
+    jg->datum = DATUM_TOKYO;
+    return COORD_SUCCESS;
+}
+
+int coord_to_japan_grid(CoordContext *ctx, const GeoCoord *geo,
+                        JapanGridPoint *jg)
+{
+    if (!ctx || !geo || !jg || geo->datum >= DATUM_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    return japan_grid_from_geo_unchecked(ctx, geo, jg);
+}
+
+int coord_from_japan_grid(CoordContext *ctx, const JapanGridPoint *jg,
+                          GeoCoord *geo)
+{
+    if (!ctx || !jg || !geo)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+
+    // Get Bessel 1841 ellipsoid parameters
+    double a = JAPAN_GRID_A;
+    double f = JAPAN_GRID_F;
+    double e2 = 2 * f - f * f;
+
+    // Lookup zone parameters (using externally defined japan_zones array)
+    int zone_idx = -1;
+    for (size_t i = 0; i < sizeof(japan_zones) / sizeof(japan_zones[0]); i++)
+    {
+        if (japan_zones[i].zone == jg->zone)
+        {
+            zone_idx = i;
+            break;
+        }
+    }
+
+    if (zone_idx < 0)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+
+    double lat0 = japan_zones[zone_idx].lat0 * DEG_TO_RAD;
+    double lon0 = japan_zones[zone_idx].lon0 * DEG_TO_RAD;
+    double false_e = japan_zones[zone_idx].false_e;
+    double false_n = japan_zones[zone_idx].false_n;
+    double k0 = japan_zones[zone_idx].scale;
+
+    // Gauss-Kruger inverse projection
+    // Remove false offsets
+    // Note: jg->x is northing, jg->y is easting
+    double northing = jg->x - false_n;   // Northing
+    double easting = jg->y - false_e;     // Easting
+
+    // Compute auxiliary parameters
+    // M is the meridional arc length, computed from northing
+    double M = northing / k0;
+    double mu = M / (a * (1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0
+                        - 5.0 * e2 * e2 * e2 / 256.0));
+
+    // Compute footpoint latitude
+    double e1 = (1.0 - sqrt(1.0 - e2)) / (1.0 + sqrt(1.0 - e2));
+    double J1 = 3.0 * e1 / 2.0 - 27.0 * e1 * e1 * e1 / 32.0;
+    double J2 = 21.0 * e1 * e1 / 16.0 - 55.0 * e1 * e1 * e1 * e1 / 32.0;
+    double J3 = 151.0 * e1 * e1 * e1 / 96.0;
+    double J4 = 1097.0 * e1 * e1 * e1 * e1 / 512.0;
+
+    double fp = mu + J1 * sin(2.0 * mu) + J2 * sin(4.0 * mu)
+                + J3 * sin(6.0 * mu) + J4 * sin(8.0 * mu);
+
+    double sin_fp = sin(fp);
+    double cos_fp = cos(fp);
+    double tan_fp = sin_fp / cos_fp;
+
+    double C1 = e2 * cos_fp * cos_fp / (1.0 - e2);
+    double T1 = tan_fp * tan_fp;
+    double R1 = a * (1.0 - e2) / pow(1.0 - e2 * sin_fp * sin_fp, 1.5);
+    double N1 = a / sqrt(1.0 - e2 * sin_fp * sin_fp);
+
+    // D computed from easting
+    double D = easting / (N1 * k0);
+    double D2 = D * D;
+    double D3 = D2 * D;
+    double D4 = D3 * D;
+    double D5 = D4 * D;
+    double D6 = D5 * D;
+
+    // Compute latitude correction
+    double Q1 = N1 * tan_fp / R1;
+    double Q2 = 0.5 * D2;
+    double Q3 = (5.0 + 3.0 * T1 + 10.0 * C1 - 4.0 * C1 * C1
+                - 9.0 * e2) * D4 / 24.0;
+    double Q4 = (61.0 + 90.0 * T1 + 298.0 * C1 + 45.0 * T1 * T1
+                - 252.0 * e2 - 3.0 * C1 * C1) * D6 / 720.0;
+
+    double lat_rad = fp - Q1 * (Q2 - Q3 + Q4);
+
+    // Compute longitude correction
+    double Q5 = D;
+    double Q6 = (1.0 + 2.0 * T1 + C1) * D3 / 6.0;
+    double Q7 = (5.0 - 2.0 * C1 + 28.0 * T1 - 3.0 * C1 * C1
+                + 8.0 * e2 + 24.0 * T1 * T1) * D5 / 120.0;
+
+    double lon_rad = lon0 + (Q5 - Q6 + Q7) / cos_fp;
+
+    // Convert to degrees
+    geo->latitude = coord_rad_to_deg(lat_rad);
+    geo->longitude = coord_rad_to_deg(lon_rad);
+    geo->altitude = 0.0;
+    geo->datum = DATUM_TOKYO;
+
+    // If WGS84 coordinates are needed, perform datum conversion
+    if (geo->datum == DATUM_WGS84)
+    {
+        GeoCoord tokyo_coord = *geo;
+        tokyo_coord.datum = DATUM_TOKYO;
+        int ret = coord_convert_datum(ctx, &tokyo_coord, DATUM_WGS84, geo);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+
+    return COORD_SUCCESS;
+}
+
+// ==================== Web Mercator tiles ====================
+#define WEB_MERCATOR_MAX_LAT 85.051128779806589  // atan(sinh(pi)), degrees
+#define WEB_MERCATOR_MAX_ZOOM 30
+#define WEB_MERCATOR_TILE_SIZE 256.0
+
+// Normalized map position of a WGS84 point: (0, 0) is the north-west corner
+// of the world square, (1, 1) the south-east corner
+static void web_mercator_normalized(double lat, double lon, double *mx,
+                                    double *my)
+{
+    // Isometric latitude asinh(tan(lat)) of the sphere
+    double s, c;
+    trig_sincos(lat * DEG_TO_RAD, &s, &c);
+    *mx = (lon + 180.0) / 360.0;
+    *my = 0.5 - trig_asinh(s / c) / (2.0 * M_PI);
+}
+
+// WGS84 view of a valid point, shifted with the context's method if needed
+static const GeoCoord *web_mercator_wgs84(const CoordContext *ctx,
+        const GeoCoord *geo, GeoCoord *tmp)
+{
+    if (geo->datum == DATUM_WGS84)
+    {
+        return geo;
+    }
+    datum_convert_unchecked(ctx, geo, DATUM_WGS84, ctx->shift_method, tmp);
+    return tmp;
+}
+
+// Web Mercator forward kernel; geo must be a valid point, zoom in range
+static int web_mercator_from_geo_unchecked(const CoordContext *ctx,
+        const GeoCoord *geo, int zoom, WebMercatorPoint *wm)
+{
+    GeoCoord tmp;
+    const GeoCoord *p = web_mercator_wgs84(ctx, geo, &tmp);
+    if (!(fabs(p->latitude) <= WEB_MERCATOR_MAX_LAT))
+    {
+        return COORD_ERROR_OUT_OF_RANGE;
+    }
+    double mx, my;
+    web_mercator_normalized(p->latitude, p->longitude, &mx, &my);
+    // Points on the east or south edge belong to the last tile
+    double n = ldexp(1.0, zoom);
+    double fx = fmin(fmax(mx * n, 0.0), n);
+    double fy = fmin(fmax(my * n, 0.0), n);
+    int last = (int)n - 1;
+    wm->zoom = zoom;
+    wm->x = (int)fx > last ? last : (int)fx;
+    wm->y = (int)fy > last ? last : (int)fy;
+    wm->pixel_x = (fx - wm->x) * WEB_MERCATOR_TILE_SIZE;
+    wm->pixel_y = (fy - wm->y) * WEB_MERCATOR_TILE_SIZE;
+    wm->datum = DATUM_WGS84;
+    return COORD_SUCCESS;
+}
+
+static int web_mercator_valid(const WebMercatorPoint *wm)
+{
+    if (wm->zoom < 0 || wm->zoom > WEB_MERCATOR_MAX_ZOOM)
+    {
+        return 0;
+    }
+    int n = 1 << wm->zoom;
+    return wm->x >= 0 && wm->x < n && wm->y >= 0 && wm->y < n &&
+           wm->pixel_x >= 0.0 && wm->pixel_x <= WEB_MERCATOR_TILE_SIZE &&
+           wm->pixel_y >= 0.0 && wm->pixel_y <= WEB_MERCATOR_TILE_SIZE;
+}
+
+static void geo_from_web_mercator_unchecked(const WebMercatorPoint *wm,
+        GeoCoord *geo)
+{
+    double n = ldexp(1.0, wm->zoom);
+    double mx = (wm->x + wm->pixel_x / WEB_MERCATOR_TILE_SIZE) / n;
+    double my = (wm->y + wm->pixel_y / WEB_MERCATOR_TILE_SIZE) / n;
+    geo->latitude = atan(sinh(M_PI * (1.0 - 2.0 * my))) * RAD_TO_DEG;
+    geo->longitude = mx * 360.0 - 180.0;
+    geo->altitude = 0.0;
+    geo->datum = DATUM_WGS84;
+}
+
+int coord_to_web_mercator(CoordContext *ctx, const GeoCoord *geo, int zoom,
+                          WebMercatorPoint *wm)
+{
+    if (!ctx || !geo || !wm || geo->datum >= DATUM_MAX || zoom < 0 ||
+            zoom > WEB_MERCATOR_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    return web_mercator_from_geo_unchecked(ctx, geo, zoom, wm);
+}
+
+int coord_from_web_mercator(CoordContext *ctx, const WebMercatorPoint *wm,
+                            GeoCoord *geo)
+{
+    if (!ctx || !wm || !geo)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!web_mercator_valid(wm))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    geo_from_web_mercator_unchecked(wm, geo);
+    return COORD_SUCCESS;
+}
+
+int coord_set_tile_zoom(CoordContext *ctx, int zoom)
+{
+    if (!ctx || zoom < 0 || zoom > WEB_MERCATOR_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    ctx->tile_zoom = zoom;
+    return COORD_SUCCESS;
+}
+
+int coord_to_web_mercator_packed(CoordContext *ctx, const GeoBatch *geo,
+                                 int zoom, WebMercatorPoint *wm)
+{
+    if (!ctx || !geo_batch_usable(geo) || (geo->count > 0 && !wm) ||
+            zoom < 0 || zoom > WEB_MERCATOR_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        GeoCoord point;
+        geo_batch_get(geo, i, &point);
+        if (!coord_validate_point(&point))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        int ret = web_mercator_from_geo_unchecked(ctx, &point, zoom, &wm[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_from_web_mercator_packed(CoordContext *ctx,
+                                   const WebMercatorPoint *wm, size_t count,
+                                   GeoBatch *geo)
+{
+    if (!ctx || !geo || (count > 0 && (!wm || !geo->lat || !geo->lon ||
+                                       geo->stride == 0)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!web_mercator_valid(&wm[i]))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        GeoCoord point;
+        geo_from_web_mercator_unchecked(&wm[i], &point);
+        geo_batch_set(geo, i, &point);
+    }
+    geo->count = count;
+    geo->datum = DATUM_WGS84;
+    return COORD_SUCCESS;
+}
+
+// Normalized coordinate in 32-bit fixed point; the tile at zoom z is then the
+// top z bits, which equals floor(m * 2^z) exactly since the scaling is by a
+// power of two
+static uint64_t web_mercator_fixed(double m)
+{
+    double f = m * 4294967296.0;
+    return f <= 0.0 ? 0 : (f >= 4294967295.0 ? 4294967295u : (uint64_t)f);
+}
+
+int coord_web_mercator_tiles(CoordContext *ctx, const GeoBatch *geo, int zoom,
+                             uint32_t *tile_x, uint32_t *tile_y)
+{
+    if (!ctx || !geo_batch_usable(geo) ||
+            (geo->count > 0 && (!tile_x || !tile_y)) || zoom < 0 ||
+            zoom > WEB_MERCATOR_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    int shift = 32 - zoom;
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        GeoCoord point, tmp;
+        geo_batch_get(geo, i, &point);
+        if (!coord_validate_point(&point))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        const GeoCoord *p = web_mercator_wgs84(ctx, &point, &tmp);
+        if (!(fabs(p->latitude) <= WEB_MERCATOR_MAX_LAT))
+        {
+            return COORD_ERROR_OUT_OF_RANGE;
+        }
+        double mx, my;
+        web_mercator_normalized(p->latitude, p->longitude, &mx, &my);
+        tile_x[i] = (uint32_t)(web_mercator_fixed(mx) >> shift);
+        tile_y[i] = (uint32_t)(web_mercator_fixed(my) >> shift);
+    }
+    return COORD_SUCCESS;
+}
+
+// ==================== Geohash and quadkey ====================
+#define QUADKEY_MAX_ZOOM 30
+
+static const char GEOHASH_ALPHABET[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+
+// Length of a string stored in a fixed array, or size if unterminated
+static size_t bounded_length(const char *s, size_t size)
+{
+    const char *end = (const char *)memchr(s, '\0', size);
+    return end ? (size_t)(end - s) : size;
+}
+
+// Fraction of an axis in 30-bit fixed point (the bisection bits of a
+// 12-character geohash)
+static uint32_t geohash_quantize(double u)
+{
+    double f = u * 1073741824.0;
+    return f <= 0.0 ? 0 : (f >= 1073741823.0 ? 1073741823u : (uint32_t)f);
+}
+
+// Full 60-bit geohash of a valid point: longitude bits in the odd positions,
+// so the first bisection (longitude) is the most significant bit
+static uint64_t geohash_code60(double lat, double lon)
+{
+    uint32_t lat_q = geohash_quantize((lat + 90.0) / 180.0);
+    uint32_t lon_q = geohash_quantize((lon + 180.0) / 360.0);
+    return (interleave_spread(lon_q) << 1) | interleave_spread(lat_q);
+}
+
+static void geohash_string(uint64_t code60, int precision, char *hash)
+{
+    for (int k = 0; k < precision; k++)
+    {
+        hash[k] = GEOHASH_ALPHABET[(code60 >> (55 - 5 * k)) & 31];
+    }
+    hash[precision] = '\0';
+}
+
+// Centre of the geohash cell; COORD_ERROR_PARSE_FAILED on a bad character
+static int geohash_decode(const char *hash, size_t length, GeoCoord *geo)
+{
+    if (length < 1 || length > GEOHASH_MAX_PRECISION)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    uint64_t code60 = 0;
+    for (size_t k = 0; k < length; k++)
+    {
+        const char *c = hash[k] ? strchr(GEOHASH_ALPHABET,
+                                         tolower((unsigned char)hash[k])) : NULL;
+        if (!c)
+        {
+            return COORD_ERROR_PARSE_FAILED;
+        }
+        code60 |= (uint64_t)(c - GEOHASH_ALPHABET) << (55 - 5 * k);
+    }
+    int bits = 5 * (int)length;
+    int lon_bits = (bits + 1) / 2;
+    int lat_bits = bits / 2;
+    double lat_q = interleave_compact(code60);
+    double lon_q = interleave_compact(code60 >> 1);
+    geo->latitude = (lat_q + ldexp(0.5, 30 - lat_bits)) / 1073741824.0 * 180.0 - 90.0;
+    geo->longitude = (lon_q + ldexp(0.5, 30 - lon_bits)) / 1073741824.0 * 360.0 - 180.0;
+    geo->altitude = 0.0;
+    return COORD_SUCCESS;
+}
+
+// Interleaved tile path of a valid point: tile x in the even bits, so each
+// base-4 digit is x_bit + 2 * y_bit
+static int quadkey_code_unchecked(const CoordContext *ctx, const GeoCoord *geo,
+                                  int zoom, uint64_t *code)
+{
+    GeoCoord tmp;
+    const GeoCoord *p = web_mercator_wgs84(ctx, geo, &tmp);
+    if (!(fabs(p->latitude) <= WEB_MERCATOR_MAX_LAT))
+    {
+        return COORD_ERROR_OUT_OF_RANGE;
+    }
+    double mx, my;
+    web_mercator_normalized(p->latitude, p->longitude, &mx, &my);
+    int shift = 32 - zoom;
+    uint32_t x = (uint32_t)(web_mercator_fixed(mx) >> shift);
+    uint32_t y = (uint32_t)(web_mercator_fixed(my) >> shift);
+    *code = interleave_spread(x) | (interleave_spread(y) << 1);
+    return COORD_SUCCESS;
+}
+
+static void quadkey_string(uint64_t code, int zoom, char *key)
+{
+    for (int k = 0; k < zoom; k++)
+    {
+        key[k] = (char)('0' + ((code >> (2 * (zoom - 1 - k))) & 3));
+    }
+    key[zoom] = '\0';
+}
+
+// Centre of the quadkey tile; COORD_ERROR_PARSE_FAILED on a bad digit
+static int quadkey_decode(const char *key, size_t length, GeoCoord *geo)
+{
+    if (length < 1 || length > QUADKEY_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    uint64_t code = 0;
+    for (size_t k = 0; k < length; k++)
+    {
+        if (key[k] < '0' || key[k] > '3')
+        {
+            return COORD_ERROR_PARSE_FAILED;
+        }
+        code = (code << 2) | (uint64_t)(key[k] - '0');
+    }
+    WebMercatorPoint wm = {(int)length, (int)interleave_compact(code),
+                           (int)interleave_compact(code >> 1),
+                           WEB_MERCATOR_TILE_SIZE / 2, WEB_MERCATOR_TILE_SIZE / 2,
+                           DATUM_WGS84
+                          };
+    geo_from_web_mercator_unchecked(&wm, geo);
+    return COORD_SUCCESS;
+}
+
+// Forward kernels; geo must be a valid point and precision/zoom in range
+static int geohash_from_geo_unchecked(const GeoCoord *geo, int precision,
+                                      GeohashPoint *gh)
+{
+    geohash_string(geohash_code60(geo->latitude, geo->longitude), precision,
+                   gh->hash);
+    gh->datum = geo->datum;
+    return COORD_SUCCESS;
+}
+
+static int quadkey_from_geo_unchecked(const CoordContext *ctx,
+                                      const GeoCoord *geo, int zoom,
+                                      QuadkeyPoint *qk)
+{
+    uint64_t code;
+    int ret = quadkey_code_unchecked(ctx, geo, zoom, &code);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    quadkey_string(code, zoom, qk->key);
+    qk->datum = DATUM_WGS84;
+    return COORD_SUCCESS;
+}
+
+int coord_to_geohash(CoordContext *ctx, const GeoCoord *geo, int precision,
+                     GeohashPoint *gh)
+{
+    if (!ctx || !geo || !gh || geo->datum >= DATUM_MAX || precision < 1 ||
+            precision > GEOHASH_MAX_PRECISION)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    return geohash_from_geo_unchecked(geo, precision, gh);
+}
+
+int coord_from_geohash(CoordContext *ctx, const GeohashPoint *gh,
+                       GeoCoord *geo)
+{
+    if (!ctx || !gh || !geo || gh->datum >= DATUM_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    int ret = geohash_decode(gh->hash, bounded_length(gh->hash, sizeof(gh->hash)), geo);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret == COORD_ERROR_PARSE_FAILED ? COORD_ERROR_INVALID_COORD : ret;
+    }
+    geo->datum = gh->datum;
+    return COORD_SUCCESS;
+}
+
+int coord_to_quadkey(CoordContext *ctx, const GeoCoord *geo, int zoom,
+                     QuadkeyPoint *qk)
+{
+    if (!ctx || !geo || !qk || geo->datum >= DATUM_MAX || zoom < 1 ||
+            zoom > QUADKEY_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    return quadkey_from_geo_unchecked(ctx, geo, zoom, qk);
+}
+
+int coord_from_quadkey(CoordContext *ctx, const QuadkeyPoint *qk,
+                       GeoCoord *geo)
+{
+    if (!ctx || !qk || !geo)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    int ret = quadkey_decode(qk->key, bounded_length(qk->key, sizeof(qk->key)), geo);
+    return ret == COORD_ERROR_PARSE_FAILED ? COORD_ERROR_INVALID_COORD : ret;
+}
+
+int coord_to_geohash_packed(CoordContext *ctx, const GeoBatch *geo,
+                            int precision, GeohashPoint *gh)
+{
+    if (!ctx || !geo_batch_usable(geo) || (geo->count > 0 && !gh) ||
+            precision < 1 || precision > GEOHASH_MAX_PRECISION)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        GeoCoord point;
+        geo_batch_get(geo, i, &point);
+        if (!coord_validate_point(&point))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        geohash_from_geo_unchecked(&point, precision, &gh[i]);
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_to_quadkey_packed(CoordContext *ctx, const GeoBatch *geo, int zoom,
+                            QuadkeyPoint *qk)
+{
+    if (!ctx || !geo_batch_usable(geo) || (geo->count > 0 && !qk) ||
+            zoom < 1 || zoom > QUADKEY_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        GeoCoord point;
+        geo_batch_get(geo, i, &point);
+        if (!coord_validate_point(&point))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        int ret = quadkey_from_geo_unchecked(ctx, &point, zoom, &qk[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_geohash_codes(const GeoBatch *geo, int precision, uint64_t *codes)
+{
+    if (!geo_batch_usable(geo) || (geo->count > 0 && !codes) ||
+            precision < 1 || precision > GEOHASH_MAX_PRECISION)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    int shift = 60 - 5 * precision;
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        double lat = geo->lat[i * geo->stride];
+        double lon = geo->lon[i * geo->stride];
+        if (!coord_is_valid_latitude(lat) || !coord_is_valid_longitude(lon))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        codes[i] = geohash_code60(lat, lon) >> shift;
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_quadkey_codes(CoordContext *ctx, const GeoBatch *geo, int zoom,
+                        uint64_t *codes)
+{
+    if (!ctx || !geo_batch_usable(geo) || (geo->count > 0 && !codes) ||
+            zoom < 1 || zoom > QUADKEY_MAX_ZOOM)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        GeoCoord point;
+        geo_batch_get(geo, i, &point);
+        if (!coord_validate_point(&point))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        int ret = quadkey_code_unchecked(ctx, &point, zoom, &codes[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+// ==================== Compressed tracks ====================
+// Layout: magic "CT", version, codec, datum, zone, two reserved bytes, point
+// count as a varint, then one zigzag varint per coordinate of each point,
+// delta-coded against the previous point (the first against zero).
+#define TRACK_HEADER_SIZE 8
+#define TRACK_VERSION 1
+#define TRACK_E7_SCALE 1e7
+#define TRACK_CM_SCALE 100.0
+
+// Append a varint; returns 0 once the buffer would overflow (out == NULL
+// only counts)
+static int track_put_varint(unsigned char *out, size_t size, size_t *pos,
+                            uint64_t v)
+{
+    do
+    {
+        unsigned char byte = (unsigned char)(v & 0x7F);
+        v >>= 7;
+        if (out)
+        {
+            if (*pos >= size)
+            {
+                return 0;
+            }
+            out[*pos] = byte | (v ? 0x80 : 0);
+        }
+        (*pos)++;
+    }
+    while (v);
+    return 1;
+}
+
+// Read a varint; returns 0 on truncated or over-long input
+static int track_get_varint(const unsigned char *in, size_t size, size_t *pos,
+                            uint64_t *v)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *pos < size; shift += 7)
+    {
+        unsigned char byte = in[(*pos)++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *v = result;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint64_t track_zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t track_unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// Quantized pair of one point: E7 latitude/longitude, or centimetre easting
+// and signed northing (no false northing) in the track zone
+static void track_quantize(const CoordContext *ctx, TrackCodec codec, int zone,
+                           double lat, double lon, int64_t value[2])
+{
+    if (codec == TRACK_CODEC_E7)
+    {
+        value[0] = llround(lat * TRACK_E7_SCALE);
+        value[1] = llround(lon * TRACK_E7_SCALE);
+        return;
+    }
+    double easting, northing;
+    utm_forward(&ctx->ellipsoid, lat, lon, zone, &easting, &northing, NULL);
+    value[0] = llround(easting * TRACK_CM_SCALE);
+    value[1] = llround(northing * TRACK_CM_SCALE);
+}
+
+int coord_track_encode(CoordContext *ctx, const GeoBatch *geo, TrackCodec codec,
+                       void *buffer, size_t buffer_size, size_t *encoded_size)
+{
+    if (!ctx || !geo_batch_usable(geo) || codec >= TRACK_CODEC_MAX ||
+            !encoded_size)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    size_t count = geo->count;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!coord_is_valid_latitude(geo->lat[i * geo->stride]) ||
+                !coord_is_valid_longitude(geo->lon[i * geo->stride]))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+    }
+    int zone = 0;
+    if (codec == TRACK_CODEC_UTM_CM && count > 0)
+    {
+        zone = utm_zone_unchecked(geo->lon[0], geo->lat[0]);
+    }
+    unsigned char *out = (unsigned char *)buffer;
+    if (out)
+    {
+        if (buffer_size < TRACK_HEADER_SIZE)
+        {
+            return COORD_ERROR_FORMAT;
+        }
+        unsigned char header[TRACK_HEADER_SIZE] =
+        {
+            'C', 'T', TRACK_VERSION, (unsigned char)codec,
+            (unsigned char)geo->datum, (unsigned char)zone, 0, 0
+        };
+        memcpy(out, header, sizeof(header));
+    }
+    size_t pos = TRACK_HEADER_SIZE;
+    int ok = track_put_varint(out, buffer_size, &pos, count);
+    int64_t prev[2] = {0, 0};
+    for (size_t i = 0; i < count && ok; i++)
+    {
+        int64_t value[2];
+        track_quantize(ctx, codec, zone, geo->lat[i * geo->stride],
+                       geo->lon[i * geo->stride], value);
+        ok = track_put_varint(out, buffer_size, &pos,
+                              track_zigzag(value[0] - prev[0])) &&
+             track_put_varint(out, buffer_size, &pos,
+                              track_zigzag(value[1] - prev[1]));
+        prev[0] = value[0];
+        prev[1] = value[1];
+    }
+    if (!ok)
+    {
+        return COORD_ERROR_FORMAT;
+    }
+    *encoded_size = pos;
+    return COORD_SUCCESS;
+}
+
+int coord_track_decoder_init(CoordContext *ctx, const void *buffer, size_t size,
+                             TrackDecoder *dec)
+{
+    if (!ctx || !buffer || !dec)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    const unsigned char *in = (const unsigned char *)buffer;
+    uint64_t count;
+    size_t pos = TRACK_HEADER_SIZE;
+    if (size < TRACK_HEADER_SIZE || in[0] != 'C' || in[1] != 'T' ||
+            in[2] != TRACK_VERSION || in[3] >= TRACK_CODEC_MAX ||
+            in[4] >= DATUM_MAX || in[5] > 60 ||
+            (in[3] == TRACK_CODEC_UTM_CM && in[5] == 0) ||
+            !track_get_varint(in, size, &pos, &count))
+    {
+        set_error(COORD_ERROR_PARSE_FAILED, "Invalid track buffer");
+        return COORD_ERROR_PARSE_FAILED;
+    }
+    dec->ctx = ctx;
+    dec->data = in;
+    dec->size = size;
+    dec->pos = pos;
+    dec->remaining = (size_t)count;
+    dec->codec = (TrackCodec)in[3];
+    dec->datum = (MapDatum)in[4];
+    dec->zone = in[5];
+    dec->value[0] = 0;
+    dec->value[1] = 0;
+    return COORD_SUCCESS;
+}
+
+// Advance the decoder by one point
+static int track_next(TrackDecoder *dec)
+{
+    uint64_t d0, d1;
+    if (!track_get_varint(dec->data, dec->size, &dec->pos, &d0) ||
+            !track_get_varint(dec->data, dec->size, &dec->pos, &d1))
+    {
+        return 0;
+    }
+    dec->value[0] += track_unzigzag(d0);
+    dec->value[1] += track_unzigzag(d1);
+    dec->remaining--;
+    return 1;
+}
+
+int coord_track_decode(TrackDecoder *dec, size_t max_points, GeoBatch *out)
+{
+    if (!dec || !out || (max_points > 0 && (!out->lat || !out->lon ||
+                                            out->stride == 0)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    size_t n = max_points < dec->remaining ? max_points : dec->remaining;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!track_next(dec))
+        {
+            set_error(COORD_ERROR_PARSE_FAILED, "Truncated track buffer");
+            return COORD_ERROR_PARSE_FAILED;
+        }
+        GeoCoord geo;
+        if (dec->codec == TRACK_CODEC_E7)
+        {
+            geo.latitude = dec->value[0] / TRACK_E7_SCALE;
+            geo.longitude = dec->value[1] / TRACK_E7_SCALE;
+            geo.altitude = 0.0;
+        }
+        else
+        {
+            UTMPoint utm;
+            utm.zone = dec->zone;
+            utm.easting = dec->value[0] / TRACK_CM_SCALE;
+            utm.northing = dec->value[1] / TRACK_CM_SCALE;
+            utm.band = utm.northing < 0.0 ? 'M' : 'N';
+            utm.northing += utm.northing < 0.0 ? 10000000.0 : 0.0;
+            utm.datum = dec->datum;
+            geo_from_utm_unchecked(dec->ctx, &utm, &geo);
+        }
+        geo_batch_set(out, i, &geo);
+    }
+    out->count = n;
+    out->datum = dec->datum;
+    return COORD_SUCCESS;
+}
+
+// Sums segment lengths without materializing points. E7 segments use the
+// meridional and prime vertical radii at the segment start; UTM_CM segments
+// divide grid distance by the point scale factor. Both are within ~1e-6 of
+// the geodesic for segments up to a few kilometres.
+int coord_track_length(CoordContext *ctx, const void *buffer, size_t size,
+                       double *length)
+{
+    if (!length)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    TrackDecoder dec;
+    int ret = coord_track_decoder_init(ctx, buffer, size, &dec);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    double a = ctx->ellipsoid.a;
+    double e2 = ctx->ellipsoid.e2;
+    double k0 = 0.9996;
+    // Footpoint latitude per metre of northing (first term of the series)
+    double mu_per_m = 1.0 / (k0 * a * (1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0));
+    double total = 0.0;
+    int64_t prev[2] = {0, 0};
+    for (size_t i = 0; dec.remaining > 0; i++)
+    {
+        if (!track_next(&dec))
+        {
+            set_error(COORD_ERROR_PARSE_FAILED, "Truncated track buffer");
+            return COORD_ERROR_PARSE_FAILED;
+        }
+        int64_t d0 = dec.value[0] - prev[0];
+        int64_t d1 = dec.value[1] - prev[1];
+        if (i > 0 && dec.codec == TRACK_CODEC_E7)
+        {
+            // Longitude steps across the antimeridian
+            d1 += d1 > 1800000000 ? -3600000000LL : d1 < -1800000000 ? 3600000000LL : 0;
+            double lat_rad = coord_deg_to_rad(prev[0] / TRACK_E7_SCALE);
+            double sin_lat = sin(lat_rad);
+            double w2 = 1.0 - e2 * sin_lat * sin_lat;
+            double n = a / sqrt(w2);
+            double m = n * (1.0 - e2) / w2;
+            double dlat = coord_deg_to_rad(d0 / TRACK_E7_SCALE);
+            double dlon = coord_deg_to_rad(d1 / TRACK_E7_SCALE);
+            total += hypot(m * dlat, n * cos(lat_rad) * dlon);
+        }
+        else if (i > 0)
+        {
+            // k = k0 (1 + x^2 / 2 rho nu) with the radii at the footpoint
+            double x = (0.5 * (dec.value[0] + prev[0]) / TRACK_CM_SCALE) - 500000.0;
+            double sin_mu = sin(prev[1] / TRACK_CM_SCALE * mu_per_m);
+            double w2 = 1.0 - e2 * sin_mu * sin_mu;
+            double rho_nu = a * a * (1.0 - e2) / (w2 * w2);
+            double k = k0 * (1.0 + x * x / (2.0 * k0 * k0 * rho_nu));
+            total += hypot((double)d0, (double)d1) / TRACK_CM_SCALE / k;
+        }
+        prev[0] = dec.value[0];
+        prev[1] = dec.value[1];
+    }
+    *length = total;
+    return COORD_SUCCESS;
+}
+
+// ==================== Datum conversion functions ====================
+// 7-parameter Helmert transform of geocentric Cartesian coordinates
+static void helmert_ecef(const DatumTransform *params, const double *xyz,
+                         double *out)
+{
+    double X = xyz[0];
+    double Y = xyz[1];
+    double Z = xyz[2];
+    double rx_rad = params->rx * ARC_SEC_TO_RAD;
+    double ry_rad = params->ry * ARC_SEC_TO_RAD;
+    double rz_rad = params->rz * ARC_SEC_TO_RAD;
+    double scale_factor = 1.0 + params->scale * PPM_TO_SCALE;
+    out[0] = params->dx + X * scale_factor + Y * rz_rad - Z * ry_rad;
+    out[1] = params->dy - X * rz_rad + Y * scale_factor + Z * rx_rad;
+    out[2] = params->dz + X * ry_rad - Y * rx_rad + Z * scale_factor;
+}
+
+// Full 7-parameter Helmert shift through geocentric Cartesian coordinates
+static void datum_shift_helmert(const DatumTransform *params,
+                                const Ellipsoid *src_ell, const Ellipsoid *dst_ell,
+                                const GeoCoord *src, GeoCoord *dst)
+{
+    // Convert lat/lon to geocentric Cartesian coordinates
+    double xyz[3];
+    geodetic_to_ecef(src_ell->a, src_ell->e2, coord_deg_to_rad(src->latitude),
+                     coord_deg_to_rad(src->longitude), src->altitude, xyz);
+    // Apply 7-parameter transform
+    double out[3];
+    helmert_ecef(params, xyz, out);
+    // Convert back to geodetic coordinates
+    double lat_rad_out, lon_rad_out, alt_out;
+    ecef_to_geodetic(dst_ell, out[0], out[1], out[2], &lat_rad_out, &lon_rad_out,
+                     &alt_out);
+    dst->latitude = coord_normalize_latitude(coord_rad_to_deg(lat_rad_out));
+    dst->longitude = coord_normalize_longitude(coord_rad_to_deg(lon_rad_out));
+    dst->altitude = alt_out;
+}
+
+// Molodensky shift applied directly to lat/lon/height
+// Only the translation (dx, dy, dz) and the ellipsoid differences are used;
+// rotation and scale parameters are ignored by this method.
+static void datum_shift_molodensky(const DatumTransform *params,
+                                   const Ellipsoid *src_ell, const Ellipsoid *dst_ell,
+                                   const GeoCoord *src, int abridged, GeoCoord *dst)
+{
+    double a = src_ell->a;
+    double f = src_ell->f;
+    double b = src_ell->b;
+    double e2 = src_ell->e2;
+    double da = dst_ell->a - a;
+    double df = dst_ell->f - f;
+    double lat_rad = coord_deg_to_rad(src->latitude);
+    double lon_rad = coord_deg_to_rad(src->longitude);
+    double h = src->altitude;
+    double sin_lat, cos_lat, sin_lon, cos_lon;
+    trig_sincos(lat_rad, &sin_lat, &cos_lat);
+    trig_sincos(lon_rad, &sin_lon, &cos_lon);
+    double w2 = 1.0 - e2 * sin_lat * sin_lat;
+    double w = sqrt(w2);
+    double Rn = a / w;                          // Prime vertical radius
+    double Rm = a * (1.0 - e2) / (w2 * w);      // Meridian radius
+    // Common translation terms
+    double t_lat = -params->dx * sin_lat * cos_lon - params->dy * sin_lat * sin_lon
+                   + params->dz * cos_lat;
+    double t_lon = -params->dx * sin_lon + params->dy * cos_lon;
+    double t_h = params->dx * cos_lat * cos_lon + params->dy * cos_lat * sin_lon
+                 + params->dz * sin_lat;
+    double dlat, dlon, dh;
+    if (abridged)
+    {
+        double adf_fda = a * df + f * da;
+        dlat = (t_lat + adf_fda * 2.0 * sin_lat * cos_lat) / Rm;
+        dlon = t_lon / (Rn * cos_lat);
+        dh = t_h + adf_fda * sin_lat * sin_lat - da;
+    }
+    else
+    {
+        dlat = (t_lat + da * (Rn * e2 * sin_lat * cos_lat) / a
+                + df * (Rm * a / b + Rn * b / a) * sin_lat * cos_lat) / (Rm + h);
+        dlon = t_lon / ((Rn + h) * cos_lat);
+        dh = t_h - da * a / Rn + df * (b / a) * Rn * sin_lat * sin_lat;
+    }
+    dst->latitude = coord_normalize_latitude(src->latitude + coord_rad_to_deg(dlat));
+    dst->longitude = coord_normalize_longitude(src->longitude + coord_rad_to_deg(
+                         dlon));
+    dst->altitude = h + dh;
+}
+
+static void datum_convert_unchecked(const CoordContext *ctx,
+                                    const GeoCoord *src, MapDatum target_datum,
+                                    DatumShiftMethod method, GeoCoord *dst)
+{
+    if (src->datum == target_datum)
+    {
+        *dst = *src;
+        return;
+    }
+    // Get transform parameters
+    const DatumTransform *params = &ctx->transforms[src->datum][target_datum];
+    if (params->dx == 0.0 && params->dy == 0.0 && params->dz == 0.0 &&
+            params->rx == 0.0 && params->ry == 0.0 && params->rz == 0.0 &&
+            params->scale == 0.0)
+    {
+        // No transform parameters; return directly
+        *dst = *src;
+        dst->datum = target_datum;
+        return;
+    }
+    // Get source and target ellipsoid parameters
+    const Ellipsoid *src_ell = &ELLIPSOIDS[src->datum];
+    const Ellipsoid *dst_ell = &ELLIPSOIDS[target_datum];
+    switch (method)
+    {
+        case DATUM_SHIFT_MOLODENSKY:
+            datum_shift_molodensky(params, src_ell, dst_ell, src, 0, dst);
+            break;
+        case DATUM_SHIFT_ABRIDGED_MOLODENSKY:
+            datum_shift_molodensky(params, src_ell, dst_ell, src, 1, dst);
+            break;
+        default:
+            datum_shift_helmert(params, src_ell, dst_ell, src, dst);
+            break;
+    }
+    dst->datum = target_datum;
+}
+
+int coord_convert_datum_ex(CoordContext *ctx, const GeoCoord *src,
+                           MapDatum target_datum, DatumShiftMethod method,
+                           GeoCoord *dst)
+{
+    if (!ctx || !src || !dst || method >= DATUM_SHIFT_MAX ||
+            src->datum >= DATUM_MAX || target_datum >= DATUM_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (src->datum != target_datum && !coord_validate_point(src))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    datum_convert_unchecked(ctx, src, target_datum, method, dst);
+    return COORD_SUCCESS;
+}
+
+int coord_convert_datum(CoordContext *ctx, const GeoCoord *src,
+                        MapDatum target_datum, GeoCoord *dst)
+{
+    if (!ctx)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    return coord_convert_datum_ex(ctx, src, target_datum, ctx->shift_method, dst);
+}
+
+int coord_convert_datum_batch(CoordContext *ctx, const GeoCoord *src,
+                              size_t count, MapDatum target_datum,
+                              GeoCoord *dst)
+{
+    if (!ctx || (count > 0 && (!src || !dst)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int ret = coord_convert_datum_ex(ctx, &src[i], target_datum,
+                                         ctx->shift_method, &dst[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_set_datum_shift_method(CoordContext *ctx, DatumShiftMethod method)
+{
+    if (!ctx || method >= DATUM_SHIFT_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    ctx->shift_method = method;
+    return COORD_SUCCESS;
+}
+
+// ==================== ECEF and local ENU functions ====================
+int coord_to_ecef(CoordContext *ctx, const GeoCoord *geo, ECEFPoint *ecef)
+{
+    if (!ctx || !geo || !ecef || geo->datum >= DATUM_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(geo))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    const Ellipsoid *ell = &ELLIPSOIDS[geo->datum];
+    double xyz[3];
+    geodetic_to_ecef(ell->a, ell->e2, coord_deg_to_rad(geo->latitude),
+                     coord_deg_to_rad(geo->longitude), geo->altitude, xyz);
+    ecef->x = xyz[0];
+    ecef->y = xyz[1];
+    ecef->z = xyz[2];
+    ecef->datum = geo->datum;
+    return COORD_SUCCESS;
+}
+
+int coord_from_ecef(CoordContext *ctx, const ECEFPoint *ecef, GeoCoord *geo)
+{
+    if (!ctx || !ecef || !geo || ecef->datum >= DATUM_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (ecef->x == 0.0 && ecef->y == 0.0 && ecef->z == 0.0)
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    double lat_rad, lon_rad, alt;
+    ecef_to_geodetic(&ELLIPSOIDS[ecef->datum], ecef->x, ecef->y, ecef->z,
+                     &lat_rad, &lon_rad, &alt);
+    geo->latitude = coord_normalize_latitude(coord_rad_to_deg(lat_rad));
+    geo->longitude = coord_normalize_longitude(coord_rad_to_deg(lon_rad));
+    geo->altitude = alt;
+    geo->datum = ecef->datum;
+    return COORD_SUCCESS;
+}
+
+int coord_to_ecef_batch(CoordContext *ctx, const GeoCoord *geo, size_t count,
+                        ECEFPoint *ecef)
+{
+    if (!ctx || (count > 0 && (!geo || !ecef)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int ret = coord_to_ecef(ctx, &geo[i], &ecef[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_from_ecef_batch(CoordContext *ctx, const ECEFPoint *ecef,
+                          size_t count, GeoCoord *geo)
+{
+    if (!ctx || (count > 0 && (!ecef || !geo)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int ret = coord_from_ecef(ctx, &ecef[i], &geo[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_init_local_origin(CoordContext *ctx, const GeoCoord *origin,
+                            LocalOrigin *local)
+{
+    if (!ctx || !origin || !local)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    ECEFPoint ecef;
+    int ret = coord_to_ecef(ctx, origin, &ecef);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    double lat_rad = coord_deg_to_rad(origin->latitude);
+    double lon_rad = coord_deg_to_rad(origin->longitude);
+    double sin_lat = sin(lat_rad);
+    double cos_lat = cos(lat_rad);
+    double sin_lon = sin(lon_rad);
+    double cos_lon = cos(lon_rad);
+    local->origin = *origin;
+    local->ecef[0] = ecef.x;
+    local->ecef[1] = ecef.y;
+    local->ecef[2] = ecef.z;
+    // East
+    local->rotation[0][0] = -sin_lon;
+    local->rotation[0][1] = cos_lon;
+    local->rotation[0][2] = 0.0;
+    // North
+    local->rotation[1][0] = -sin_lat * cos_lon;
+    local->rotation[1][1] = -sin_lat * sin_lon;
+    local->rotation[1][2] = cos_lat;
+    // Up
+    local->rotation[2][0] = cos_lat * cos_lon;
+    local->rotation[2][1] = cos_lat * sin_lon;
+    local->rotation[2][2] = sin_lat;
+    return COORD_SUCCESS;
+}
+
+int coord_to_enu(CoordContext *ctx, const LocalOrigin *local,
+                 const GeoCoord *geo, ENUPoint *enu)
+{
+    if (!ctx || !local || !geo || !enu)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    // Express the point in the origin datum
+    GeoCoord same_datum;
+    int ret = coord_convert_datum(ctx, geo, local->origin.datum, &same_datum);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    ECEFPoint ecef;
+    ret = coord_to_ecef(ctx, &same_datum, &ecef);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    double dx = ecef.x - local->ecef[0];
+    double dy = ecef.y - local->ecef[1];
+    double dz = ecef.z - local->ecef[2];
+    const double (*R)[3] = local->rotation;
+    enu->east = R[0][0] * dx + R[0][1] * dy + R[0][2] * dz;
+    enu->north = R[1][0] * dx + R[1][1] * dy + R[1][2] * dz;
+    enu->up = R[2][0] * dx + R[2][1] * dy + R[2][2] * dz;
+    return COORD_SUCCESS;
+}
+
+int coord_from_enu(CoordContext *ctx, const LocalOrigin *local,
+                   const ENUPoint *enu, GeoCoord *geo)
+{
+    if (!ctx || !local || !enu || !geo)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    // ECEF = origin + R^T * ENU
+    const double (*R)[3] = local->rotation;
+    ECEFPoint ecef;
+    ecef.x = local->ecef[0] + R[0][0] * enu->east + R[1][0] * enu->north
+             + R[2][0] * enu->up;
+    ecef.y = local->ecef[1] + R[0][1] * enu->east + R[1][1] * enu->north
+             + R[2][1] * enu->up;
+    ecef.z = local->ecef[2] + R[0][2] * enu->east + R[1][2] * enu->north
+             + R[2][2] * enu->up;
+    ecef.datum = local->origin.datum;
+    return coord_from_ecef(ctx, &ecef, geo);
+}
+
+int coord_to_enu_batch(CoordContext *ctx, const LocalOrigin *local,
+                       const GeoCoord *geo, size_t count, ENUPoint *enu)
+{
+    if (!ctx || !local || (count > 0 && (!geo || !enu)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int ret = coord_to_enu(ctx, local, &geo[i], &enu[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_from_enu_batch(CoordContext *ctx, const LocalOrigin *local,
+                         const ENUPoint *enu, size_t count, GeoCoord *geo)
+{
+    if (!ctx || !local || (count > 0 && (!enu || !geo)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int ret = coord_from_enu(ctx, local, &enu[i], &geo[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+// Packed ECEF/ENU batches stop at the first error, like the GeoCoord batches
+int coord_to_ecef_packed(CoordContext *ctx, const GeoBatch *geo, ECEFPoint *ecef)
+{
+    if (!ctx || !geo_batch_usable(geo) || (geo->count > 0 && !ecef))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        GeoCoord point;
+        geo_batch_get(geo, i, &point);
+        int ret = coord_to_ecef(ctx, &point, &ecef[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+// The output view carries one datum, so every point must share ecef[0]'s
+int coord_from_ecef_packed(CoordContext *ctx, const ECEFPoint *ecef,
+                           size_t count, GeoBatch *geo)
+{
+    if (!ctx || !geo || (count > 0 && (!ecef || !geo->lat || !geo->lon ||
+                                       geo->stride == 0)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (ecef[i].datum != ecef[0].datum)
+        {
+            return COORD_ERROR_INVALID_INPUT;
+        }
+        GeoCoord point;
+        int ret = coord_from_ecef(ctx, &ecef[i], &point);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+        geo_batch_set(geo, i, &point);
+    }
+    geo->count = count;
+    if (count > 0)
+    {
+        geo->datum = ecef[0].datum;
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_to_enu_packed(CoordContext *ctx, const LocalOrigin *local,
+                        const GeoBatch *geo, ENUPoint *enu)
+{
+    if (!ctx || !local || !geo_batch_usable(geo) || (geo->count > 0 && !enu))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        GeoCoord point;
+        geo_batch_get(geo, i, &point);
+        int ret = coord_to_enu(ctx, local, &point, &enu[i]);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_from_enu_packed(CoordContext *ctx, const LocalOrigin *local,
+                          const ENUPoint *enu, size_t count, GeoBatch *geo)
+{
+    if (!ctx || !local || !geo || (count > 0 && (!enu || !geo->lat || !geo->lon ||
+                                                 geo->stride == 0)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        GeoCoord point;
+        int ret = coord_from_enu(ctx, local, &enu[i], &point);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+        geo_batch_set(geo, i, &point);
+    }
+    geo->count = count;
+    geo->datum = local->origin.datum;
+    return COORD_SUCCESS;
+}
+
+// ==================== Lattice projection ====================
+// Latitude-only terms of the transverse Mercator series
+typedef struct
+{
+    double cos_lat;
+    double N_tan;       // N * tan(lat)
+    double N;
+    double M;           // Meridional arc length
+    double c3, c5;      // Easting coefficients of A^3 and A^5
+    double c4, c6;      // Northing coefficients of A^4 and A^6
+} TMRow;
+
+// Latitude terms from the shared UTM series constants of the ellipsoid
+static void tm_row_init(const UTMSeries *series, double lat_rad, TMRow *row)
+{
+    double e2 = series->e2;
+    double sin_lat, cos_lat;
+    trig_sincos(lat_rad, &sin_lat, &cos_lat);
+    double tan_lat = sin_lat / cos_lat;
+    double T = tan_lat * tan_lat;
+    double C = e2 * cos_lat * cos_lat / (1.0 - e2);
+    row->cos_lat = cos_lat;
+    row->N = series->a / sqrt(1.0 - e2 * sin_lat * sin_lat);
+    row->N_tan = row->N * tan_lat;
+    row->M = utm_meridional_arc(series, lat_rad, sin_lat, cos_lat);
+    row->c3 = (1.0 - T + C) / 6.0;
+    row->c5 = (5.0 - 18.0 * T + T * T + 72.0 * C - 58.0 * e2) / 120.0;
+    row->c4 = (5.0 - T + 9.0 * C + 4.0 * C * C) / 24.0;
+    row->c6 = (61.0 - 58.0 * T + T * T + 600.0 * C - 330.0 * e2) / 720.0;
+}
+
+// Scaled projection offsets for a longitude difference from the central meridian
+static void tm_row_eval(const TMRow *row, double k0, double dlon_rad,
+                        double *x, double *y)
+{
+    double A = dlon_rad * row->cos_lat;
+    double A2 = A * A;
+    *x = k0 * row->N * A * (1.0 + A2 * (row->c3 + A2 * row->c5));
+    *y = k0 * (row->M + row->N_tan * A2 * (0.5 + A2 * (row->c4 + A2 * row->c6)));
+}
+
+static int lattice_project_utm(CoordContext *ctx, double lat0, double dlat,
+                               size_t nlat, double lon0, double dlon, size_t nlon,
+                               double *easting, double *northing, int *zones)
+{
+    UTMSeries series;
+    utm_series_init(&ctx->ellipsoid, &series);
+    // Longitude terms: standard zone and offset from its central meridian
+    if (nlon > SIZE_MAX / (sizeof(double) + sizeof(int)))
+    {
+        set_error(COORD_ERROR_MEMORY, "Lattice too wide");
+        return COORD_ERROR_MEMORY;
+    }
+    double *col_dl = (double *)coord_alloc(&ctx->allocator,
+                                           nlon * (sizeof(double) + sizeof(int)));
+    if (!col_dl)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate lattice columns");
+        return COORD_ERROR_MEMORY;
+    }
+    int *col_zone = (int *)(col_dl + nlon);
+    for (size_t j = 0; j < nlon; j++)
+    {
+        double lon = lon0 + dlon * (double)j;
+        col_zone[j] = coord_get_utm_zone(lon, 0.0);
+        col_dl[j] = coord_deg_to_rad(lon - ((col_zone[j] - 1) * 6.0 - 180.0 + 3.0));
+    }
+    for (size_t i = 0; i < nlat; i++)
+    {
+        double lat = lat0 + dlat * (double)i;
+        TMRow row;
+        tm_row_init(&series, coord_deg_to_rad(lat), &row);
+        double false_northing = (lat < 0.0) ? 10000000.0 : 0.0;
+        // Norway and Svalbard exceptions depend on latitude as well
+        int special = (lat >= 56.0 && lat < 64.0) || (lat >= 72.0 && lat < 84.0);
+        for (size_t j = 0; j < nlon; j++)
+        {
+            size_t k = i * nlon + j;
+            int zone = col_zone[j];
+            double dl = col_dl[j];
+            if (special)
+            {
+                double lon = lon0 + dlon * (double)j;
+                zone = coord_get_utm_zone(lon, lat);
+                if (zone != col_zone[j])
+                {
+                    dl = coord_deg_to_rad(lon - ((zone - 1) * 6.0 - 180.0 + 3.0));
+                }
+            }
+            double x, y;
+            tm_row_eval(&row, 0.9996, dl, &x, &y);
+            easting[k] = x + 500000.0;
+            northing[k] = y + false_northing;
+            if (zones)
+            {
+                zones[k] = zone;
+            }
+        }
+    }
+    coord_free(&ctx->allocator, col_dl);
+    return COORD_SUCCESS;
+}
+
+static int lattice_project_bng(CoordContext *ctx, double lat0, double dlat,
+                               size_t nlat, double lon0, double dlon, size_t nlon,
+                               MapDatum datum, double *easting, double *northing)
+{
+    UTMSeries airy;
+    utm_series_init(&ELLIPSOIDS[DATUM_OSGB36], &airy);
+    TMRow origin_row;
+    tm_row_init(&airy, OSGB36_LAT0, &origin_row);
+    double M0 = origin_row.M;
+    const DatumTransform *params = &ctx->transforms[datum][DATUM_OSGB36];
+    int identity = (datum == DATUM_OSGB36) ||
+                   (params->dx == 0.0 && params->dy == 0.0 && params->dz == 0.0 &&
+                    params->rx == 0.0 && params->ry == 0.0 && params->rz == 0.0 &&
+                    params->scale == 0.0);
+    if (identity)
+    {
+        // Fully separable: one TM row per latitude
+        for (size_t i = 0; i < nlat; i++)
+        {
+            TMRow row;
+            tm_row_init(&airy, coord_deg_to_rad(lat0 + dlat * (double)i), &row);
+            for (size_t j = 0; j < nlon; j++)
+            {
+                double x, y;
+                tm_row_eval(&row, OSGB36_F0,
+                            coord_deg_to_rad(lon0 + dlon * (double)j) - OSGB36_LON0, &x, &y);
+                easting[i * nlon + j] = OSGB36_E0 + x;
+                northing[i * nlon + j] = OSGB36_N0 + y - OSGB36_F0 * M0;
+            }
+        }
+        return COORD_SUCCESS;
+    }
+    if (ctx->shift_method != DATUM_SHIFT_HELMERT)
+    {
+        // Molodensky shifts are not separable; project node by node
+        for (size_t i = 0; i < nlat; i++)
+        {
+            for (size_t j = 0; j < nlon; j++)
+            {
+                GeoCoord src = {lat0 + dlat * (double)i, lon0 + dlon * (double)j, 0.0, datum};
+                GeoCoord osgb;
+                int ret = coord_convert_datum(ctx, &src, DATUM_OSGB36, &osgb);
+                if (ret != COORD_SUCCESS)
+                {
+                    return ret;
+                }
+                bng_forward(osgb.latitude, osgb.longitude, &easting[i * nlon + j],
+                            &northing[i * nlon + j]);
+            }
+        }
+        return COORD_SUCCESS;
+    }
+    // Helmert shift: the geodetic->ECEF step is separable by row and column
+    const Ellipsoid *src_ell = &ELLIPSOIDS[datum];
+    const Ellipsoid *dst_ell = &ELLIPSOIDS[DATUM_OSGB36];
+    if (nlon > SIZE_MAX / (2 * sizeof(double)))
+    {
+        set_error(COORD_ERROR_MEMORY, "Lattice too wide");
+        return COORD_ERROR_MEMORY;
+    }
+    double *col_cos = (double *)coord_alloc(&ctx->allocator,
+                                            2 * nlon * sizeof(double));
+    if (!col_cos)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate lattice columns");
+        return COORD_ERROR_MEMORY;
+    }
+    double *col_sin = col_cos + nlon;
+    for (size_t j = 0; j < nlon; j++)
+    {
+        trig_sincos(coord_deg_to_rad(lon0 + dlon * (double)j), &col_sin[j], &col_cos[j]);
+    }
+    for (size_t i = 0; i < nlat; i++)
+    {
+        double sin_lat, cos_lat;
+        trig_sincos(coord_deg_to_rad(lat0 + dlat * (double)i), &sin_lat, &cos_lat);
+        double N = src_ell->a / sqrt(1.0 - src_ell->e2 * sin_lat * sin_lat);
+        double r = N * cos_lat;
+        double xyz[3] = {0.0, 0.0, N * (1.0 - src_ell->e2) * sin_lat};
+        for (size_t j = 0; j < nlon; j++)
+        {
+            xyz[0] = r * col_cos[j];
+            xyz[1] = r * col_sin[j];
+            double out[3];
+            helmert_ecef(params, xyz, out);
+            double lat_out, lon_out;
+            ecef_to_geodetic(dst_ell, out[0], out[1], out[2], &lat_out, &lon_out, NULL);
+            bng_forward(coord_rad_to_deg(lat_out), coord_rad_to_deg(lon_out),
+                        &easting[i * nlon + j], &northing[i * nlon + j]);
+        }
+    }
+    coord_free(&ctx->allocator, col_cos);
+    return COORD_SUCCESS;
+}
+
+int coord_project_lattice(CoordContext *ctx, double lat0, double dlat,
+                          size_t nlat, double lon0, double dlon, size_t nlon,
+                          MapDatum datum, CoordFormat format,
+                          double *easting, double *northing, int *zones)
+{
+    if (!ctx || !easting || !northing || datum >= DATUM_MAX)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (nlat == 0 || nlon == 0)
+    {
+        return COORD_SUCCESS;
+    }
+    // Lattice coordinates are monotonic, so checking the corners is enough
+    double lat1 = lat0 + dlat * (double)(nlat - 1);
+    double lon1 = lon0 + dlon * (double)(nlon - 1);
+    if (!coord_is_valid_latitude(lat0) || !coord_is_valid_latitude(lat1) ||
+            !coord_is_valid_longitude(lon0) || !coord_is_valid_longitude(lon1))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    switch (format)
+    {
+        case COORD_FORMAT_UTM:
+            return lattice_project_utm(ctx, lat0, dlat, nlat, lon0, dlon, nlon,
+                                       easting, northing, zones);
+        case COORD_FORMAT_BRITISH_GRID:
+            return lattice_project_bng(ctx, lat0, dlat, nlat, lon0, dlon, nlon,
+                                       datum, easting, northing);
+        default:
+            return COORD_ERROR_UNSUPPORTED_FORMAT;
+    }
+}
+
+// ==================== Interpolation meshes ====================
+#define MESH_MAX_DEPTH 16
+#define MESH_CELL_LIMIT (INT32_MAX / 32)  // Keeps int32 node and value offsets valid
+#define MESH_DERIV_STEP 1e-4        // Finite-difference step for corner derivatives (degrees)
+#define MESH_MAGIC 0x4D54444Du      // "MDTM"
+#define MESH_VERSION 1u
+
+// Quadtree node; children are stored as four consecutive nodes (SW, SE, NW, NE)
+typedef struct
+{
+    int32_t child;              // First child index, -1 for leaves
+    int32_t data;               // Offset of the leaf samples in values[]
+} MeshNode;
+
+struct ProjectionMesh
+{
+    CoordFormat format;
+    MeshInterp interp;
+    MapDatum datum;
+    int zone;                   // UTM zone used for the whole mesh
+    int southern;               // UTM false northing flag
+    double lat_min, lon_min;
+    double lat_size, lon_size;
+    double max_error;
+    MeshNode *nodes;
+    size_t node_count, node_capacity;
+    double *values;
+    size_t value_count, value_capacity;
+    CoordContext *ctx;          // Only valid while building
+    CoordAllocator allocator;   // Owns nodes, values and the mesh itself
+};
+
+// On-disk header
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t format;
+    int32_t interp;
+    int32_t datum;
+    int32_t zone;
+    int32_t southern;
+    int32_t reserved;
+    double lat_min, lon_min, lat_size, lon_size, max_error;
+    uint64_t node_count;
+    uint64_t value_count;
+} MeshHeader;
+
+static size_t mesh_values_per_leaf(MeshInterp interp)
+{
+    // Per corner and output: f (bilinear) or f, f_lat, f_lon, f_lat_lon (bicubic)
+    return (interp == MESH_INTERP_BICUBIC) ? 32 : 8;
+}
+
+// Exact projection used to sample the mesh
+static int mesh_exact(const ProjectionMesh *mesh, double lat, double lon,
+                      double out[2])
+{
+    if (mesh->format == COORD_FORMAT_UTM)
+    {
+        utm_forward(&mesh->ctx->ellipsoid, lat, lon, mesh->zone, &out[0], &out[1],
+                    NULL);
+        if (mesh->southern)
+        {
+            out[1] += 10000000.0;
+        }
+        return COORD_SUCCESS;
+    }
+    GeoCoord geo = {lat, lon, 0.0, mesh->datum};
+    GeoCoord osgb;
+    int ret = coord_convert_datum(mesh->ctx, &geo, DATUM_OSGB36, &osgb);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    bng_forward(osgb.latitude, osgb.longitude, &out[0], &out[1]);
+    return COORD_SUCCESS;
+}
+
+// Corner samples for a cell in leaf layout: [corner][output][f, fu, fv, fuv]
+static int mesh_sample_cell(const ProjectionMesh *mesh, double lat0, double lon0,
+                            double slat, double slon, double *leaf)
+{
+    double h = MESH_DERIV_STEP;
+    for (int c = 0; c < 4; c++)
+    {
+        double lat = lat0 + ((c >> 1) ? slat : 0.0);
+        double lon = lon0 + ((c & 1) ? slon : 0.0);
+        double f[2];
+        int ret = mesh_exact(mesh, lat, lon, f);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+        if (mesh->interp != MESH_INTERP_BICUBIC)
+        {
+            leaf[c * 2] = f[0];
+            leaf[c * 2 + 1] = f[1];
+            continue;
+        }
+        double pp[2], pm[2], mp[2], mm[2], p0[2], m0[2], p1[2], m1[2];
+        if ((ret = mesh_exact(mesh, lat + h, lon, p0)) != COORD_SUCCESS ||
+                (ret = mesh_exact(mesh, lat - h, lon, m0)) != COORD_SUCCESS ||
+                (ret = mesh_exact(mesh, lat, lon + h, p1)) != COORD_SUCCESS ||
+                (ret = mesh_exact(mesh, lat, lon - h, m1)) != COORD_SUCCESS ||
+                (ret = mesh_exact(mesh, lat + h, lon + h, pp)) != COORD_SUCCESS ||
+                (ret = mesh_exact(mesh, lat + h, lon - h, pm)) != COORD_SUCCESS ||
+                (ret = mesh_exact(mesh, lat - h, lon + h, mp)) != COORD_SUCCESS ||
+                (ret = mesh_exact(mesh, lat - h, lon - h, mm)) != COORD_SUCCESS)
+        {
+            return ret;
+        }
+        for (int k = 0; k < 2; k++)
+        {
+            double *d = &leaf[(c * 2 + k) * 4];
+            // Derivatives scaled to unit-cell coordinates
+            d[0] = f[k];
+            d[1] = (p0[k] - m0[k]) / (2.0 * h) * slat;
+            d[2] = (p1[k] - m1[k]) / (2.0 * h) * slon;
+            d[3] = (pp[k] - pm[k] - mp[k] + mm[k]) / (4.0 * h * h) * slat * slon;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+// Interpolate within a leaf at unit-cell coordinates (u: latitude, v: longitude)
+static void mesh_interpolate(MeshInterp interp, const double *leaf, double u,
+                             double v, double out[2])
+{
+    if (interp != MESH_INTERP_BICUBIC)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            double south = leaf[k] + (leaf[2 + k] - leaf[k]) * v;
+            double north = leaf[4 + k] + (leaf[6 + k] - leaf[4 + k]) * v;
+            out[k] = south + (north - south) * u;
+        }
+        return;
+    }
+    // Cubic Hermite basis: value (h0) and derivative (h1) weights per end
+    double u2 = u * u, u3 = u2 * u;
+    double v2 = v * v, v3 = v2 * v;
+    double hu0[2] = {2.0 * u3 - 3.0 * u2 + 1.0, -2.0 * u3 + 3.0 * u2};
+    double hu1[2] = {u3 - 2.0 * u2 + u, u3 - u2};
+    double hv0[2] = {2.0 * v3 - 3.0 * v2 + 1.0, -2.0 * v3 + 3.0 * v2};
+    double hv1[2] = {v3 - 2.0 * v2 + v, v3 - v2};
+    for (int k = 0; k < 2; k++)
+    {
+        double sum = 0.0;
+        for (int c = 0; c < 4; c++)
+        {
+            int i = c >> 1;
+            int j = c & 1;
+            const double *d = &leaf[(c * 2 + k) * 4];
+            sum += d[0] * hu0[i] * hv0[j] + d[1] * hu1[i] * hv0[j]
+                   + d[2] * hu0[i] * hv1[j] + d[3] * hu1[i] * hv1[j];
+        }
+        out[k] = sum;
+    }
+}
+
+static int mesh_push_nodes(ProjectionMesh *mesh, size_t n)
+{
+    if (mesh->node_count + n > mesh->node_capacity)
+    {
+        size_t capacity = mesh->node_capacity ? mesh->node_capacity * 2 : 64;
+        while (capacity < mesh->node_count + n)
+        {
+            capacity *= 2;
+        }
+        MeshNode *nodes = (MeshNode *)coord_realloc(&mesh->allocator, mesh->nodes,
+                          capacity * sizeof(MeshNode));
+        if (!nodes)
+        {
+            return -1;
+        }
+        mesh->nodes = nodes;
+        mesh->node_capacity = capacity;
+    }
+    int first = (int)mesh->node_count;
+    for (size_t i = 0; i < n; i++)
+    {
+        mesh->nodes[mesh->node_count + i].child = -1;
+        mesh->nodes[mesh->node_count + i].data = -1;
+    }
+    mesh->node_count += n;
+    return first;
+}
+
+static int mesh_push_leaf(ProjectionMesh *mesh, const double *leaf)
+{
+    size_t n = mesh_values_per_leaf(mesh->interp);
+    if (mesh->value_count + n > mesh->value_capacity)
+    {
+        size_t capacity = mesh->value_capacity ? mesh->value_capacity * 2 : 64 * n;
+        double *values = (double *)coord_realloc(&mesh->allocator, mesh->values,
+                         capacity * sizeof(double));
+        if (!values)
+        {
+            return -1;
+        }
+        mesh->values = values;
+        mesh->value_capacity = capacity;
+    }
+    memcpy(&mesh->values[mesh->value_count], leaf, n * sizeof(double));
+    int offset = (int)mesh->value_count;
+    mesh->value_count += n;
+    return offset;
+}
+
+static int mesh_build(ProjectionMesh *mesh, int node, double lat0, double lon0,
+                      double slat, double slon, int depth)
+{
+    double leaf[32];
+    int ret = mesh_sample_cell(mesh, lat0, lon0, slat, slon, leaf);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    // Compare against the exact projection on a 3x3 interior grid; the check
+    // points only sample the cell, so accept at half the requested bound
+    double tolerance = 0.5 * mesh->max_error;
+    double worst = 0.0;
+    if (depth < MESH_MAX_DEPTH)
+    {
+        for (int i = 1; i <= 3 && worst <= tolerance; i++)
+        {
+            for (int j = 1; j <= 3; j++)
+            {
+                double exact[2], approx[2];
+                ret = mesh_exact(mesh, lat0 + slat * i / 4.0, lon0 + slon * j / 4.0, exact);
+                if (ret != COORD_SUCCESS)
+                {
+                    return ret;
+                }
+                mesh_interpolate(mesh->interp, leaf, i / 4.0, j / 4.0, approx);
+                worst = fmax(worst, fmax(fabs(exact[0] - approx[0]),
+                                         fabs(exact[1] - approx[1])));
+            }
+        }
+    }
+    if (worst <= tolerance)
+    {
+        int offset = mesh_push_leaf(mesh, leaf);
+        if (offset < 0)
+        {
+            set_error(COORD_ERROR_MEMORY, "Failed to allocate mesh");
+            return COORD_ERROR_MEMORY;
+        }
+        mesh->nodes[node].data = offset;
+        return COORD_SUCCESS;
+    }
+    // Every split turns one cell into four; stop before the budget is passed
+    size_t splits = (mesh->node_count - 1) / 4;
+    if (1 + 3 * (splits + 1) > mesh->ctx->mesh_max_cells)
+    {
+        set_error(COORD_ERROR_MEMORY, "Mesh cell budget exceeded");
+        return COORD_ERROR_MEMORY;
+    }
+    int child = mesh_push_nodes(mesh, 4);
+    if (child < 0)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate mesh");
+        return COORD_ERROR_MEMORY;
+    }
+    mesh->nodes[node].child = child;
+    double hlat = slat * 0.5;
+    double hlon = slon * 0.5;
+    for (int q = 0; q < 4; q++)
+    {
+        ret = mesh_build(mesh, child + q, lat0 + ((q >> 1) ? hlat : 0.0),
+                         lon0 + ((q & 1) ? hlon : 0.0), hlat, hlon, depth + 1);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+ProjectionMesh *coord_mesh_create(CoordContext *ctx, CoordFormat format,
+                                  MapDatum datum, double lat_min, double lat_max,
+                                  double lon_min, double lon_max,
+                                  double max_error, MeshInterp interp)
+{
+    if (!ctx || datum >= DATUM_MAX || interp >= MESH_INTERP_MAX ||
+            !(max_error > 0.0) || !(lat_max > lat_min) || !(lon_max > lon_min) ||
+            !coord_is_valid_latitude(lat_min) || !coord_is_valid_latitude(lat_max) ||
+            !coord_is_valid_longitude(lon_min) || !coord_is_valid_longitude(lon_max))
+    {
+        set_error(COORD_ERROR_INVALID_INPUT, "Invalid mesh parameters");
+        return NULL;
+    }
+    if (format != COORD_FORMAT_UTM && format != COORD_FORMAT_BRITISH_GRID)
+    {
+        set_error(COORD_ERROR_UNSUPPORTED_FORMAT, "Mesh supports UTM and British Grid");
+        return NULL;
+    }
+    ProjectionMesh *mesh = (ProjectionMesh *)coord_alloc(&ctx->allocator,
+                           sizeof(ProjectionMesh));
+    if (!mesh)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate mesh");
+        return NULL;
+    }
+    memset(mesh, 0, sizeof(ProjectionMesh));
+    mesh->allocator = ctx->allocator;
+    mesh->format = format;
+    mesh->interp = interp;
+    mesh->datum = datum;
+    mesh->lat_min = lat_min;
+    mesh->lon_min = lon_min;
+    mesh->lat_size = lat_max - lat_min;
+    mesh->lon_size = lon_max - lon_min;
+    mesh->max_error = max_error;
+    mesh->ctx = ctx;
+    double lat_c = 0.5 * (lat_min + lat_max);
+    mesh->zone = coord_get_utm_zone(0.5 * (lon_min + lon_max), lat_c);
+    mesh->southern = lat_c < 0.0;
+    int ret = (mesh_push_nodes(mesh, 1) < 0) ? COORD_ERROR_MEMORY
+              : mesh_build(mesh, 0, lat_min, lon_min, mesh->lat_size, mesh->lon_size, 0);
+    mesh->ctx = NULL;
+    if (ret != COORD_SUCCESS)
+    {
+        // Memory errors carry their own message (allocation or cell budget)
+        if (ret != COORD_ERROR_MEMORY)
+        {
+            set_error(ret, "Failed to build projection mesh");
+        }
+        coord_mesh_destroy(mesh);
+        return NULL;
+    }
+    return mesh;
+}
+
+int coord_set_mesh_max_cells(CoordContext *ctx, size_t max_cells)
+{
+    if (!ctx || max_cells == 0 || max_cells > MESH_CELL_LIMIT)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    ctx->mesh_max_cells = max_cells;
+    return COORD_SUCCESS;
+}
+
+void coord_mesh_destroy(ProjectionMesh *mesh)
+{
+    if (mesh)
+    {
+        CoordAllocator alloc = mesh->allocator;
+        coord_free(&alloc, mesh->nodes);
+        coord_free(&alloc, mesh->values);
+        coord_free(&alloc, mesh);
+    }
+}
+
+size_t coord_mesh_cell_count(const ProjectionMesh *mesh)
+{
+    if (!mesh)
+    {
+        return 0;
+    }
+    return mesh->value_count / mesh_values_per_leaf(mesh->interp);
+}
+
+int coord_mesh_eval(const ProjectionMesh *mesh, double lat, double lon,
+                    double *easting, double *northing)
+{
+    if (!mesh || !easting || !northing)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    double u = (lat - mesh->lat_min) / mesh->lat_size;
+    double v = (lon - mesh->lon_min) / mesh->lon_size;
+    if (!(u >= 0.0 && u <= 1.0 && v >= 0.0 && v <= 1.0))
+    {
+        *easting = NAN;
+        *northing = NAN;
+        return COORD_ERROR_OUT_OF_RANGE;
+    }
+    // Descend to the leaf; built and deserialized meshes are at most
+    // MESH_MAX_DEPTH levels deep, so this is O(MESH_MAX_DEPTH)
+    const MeshNode *node = &mesh->nodes[0];
+    while (node->child >= 0)
+    {
+        int qi = u >= 0.5;
+        int qj = v >= 0.5;
+        u = 2.0 * u - qi;
+        v = 2.0 * v - qj;
+        node = &mesh->nodes[node->child + qi * 2 + qj];
+    }
+    double out[2];
+    mesh_interpolate(mesh->interp, &mesh->values[node->data], u, v, out);
+    *easting = out[0];
+    *northing = out[1];
+    return COORD_SUCCESS;
+}
+
+// Mesh batch, visiting points in the given order (NULL for input order)
+// Mesh batch over lat/lon arrays with the given element stride, visiting
+// points in the given order (NULL for input order)
+static int mesh_eval_batch(const ProjectionMesh *mesh, const double *lat,
+                           const double *lon, size_t stride, size_t count,
+                           const size_t *order, double *easting, double *northing)
+{
+    if (!mesh || (count > 0 && (!lat || !lon || stride == 0 || !easting ||
+                                !northing)))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    int result = COORD_SUCCESS;
+    for (size_t n = 0; n < count; n++)
+    {
+        size_t i = order ? order[n] : n;
+        if (i >= count)
+        {
+            return COORD_ERROR_INVALID_INPUT;
+        }
+        if (coord_mesh_eval(mesh, lat[i * stride], lon[i * stride], &easting[i],
+                            &northing[i]) != COORD_SUCCESS)
+        {
+            result = COORD_ERROR_OUT_OF_RANGE;
+        }
+    }
+    return result;
+}
+
+int coord_mesh_eval_batch(const ProjectionMesh *mesh, const double *lat,
+                          const double *lon, size_t count,
+                          double *easting, double *northing)
+{
+    return mesh_eval_batch(mesh, lat, lon, 1, count, NULL, easting, northing);
+}
+
+int coord_mesh_eval_batch_ordered(const ProjectionMesh *mesh,
+                                  const double *lat, const double *lon,
+                                  size_t count, const size_t *order,
+                                  double *easting, double *northing)
+{
+    if (count > 0 && !order)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    return mesh_eval_batch(mesh, lat, lon, 1, count, order, easting, northing);
+}
+
+// Packed input must be on the datum the mesh was sampled from
+int coord_mesh_eval_packed(const ProjectionMesh *mesh, const GeoBatch *geo,
+                           double *easting, double *northing)
+{
+    if (!mesh || !geo_batch_usable(geo) || geo->datum != mesh->datum)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    return mesh_eval_batch(mesh, geo->lat, geo->lon, geo->stride, geo->count,
+                           NULL, easting, northing);
+}
+
+int coord_mesh_eval_packed_ordered(const ProjectionMesh *mesh,
+                                   const GeoBatch *geo, const size_t *order,
+                                   double *easting, double *northing)
+{
+    if (!mesh || !geo_batch_usable(geo) || geo->datum != mesh->datum ||
+            (geo->count > 0 && !order))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    return mesh_eval_batch(mesh, geo->lat, geo->lon, geo->stride, geo->count,
+                           order, easting, northing);
+}
+
+size_t coord_mesh_serialized_size(const ProjectionMesh *mesh)
+{
+    if (!mesh)
+    {
+        return 0;
+    }
+    return sizeof(MeshHeader) + mesh->node_count * sizeof(MeshNode)
+           + mesh->value_count * sizeof(double);
+}
+
+int coord_mesh_serialize(const ProjectionMesh *mesh, void *buffer,
+                         size_t buffer_size)
+{
+    if (!mesh || !buffer)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (buffer_size < coord_mesh_serialized_size(mesh))
+    {
+        return COORD_ERROR_FORMAT;
+    }
+    MeshHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MESH_MAGIC;
+    header.version = MESH_VERSION;
+    header.format = mesh->format;
+    header.interp = mesh->interp;
+    header.datum = mesh->datum;
+    header.zone = mesh->zone;
+    header.southern = mesh->southern;
+    header.lat_min = mesh->lat_min;
+    header.lon_min = mesh->lon_min;
+    header.lat_size = mesh->lat_size;
+    header.lon_size = mesh->lon_size;
+    header.max_error = mesh->max_error;
+    header.node_count = mesh->node_count;
+    header.value_count = mesh->value_count;
+    unsigned char *out = (unsigned char *)buffer;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    memcpy(out, mesh->nodes, mesh->node_count * sizeof(MeshNode));
+    out += mesh->node_count * sizeof(MeshNode);
+    memcpy(out, mesh->values, mesh->value_count * sizeof(double));
+    return COORD_SUCCESS;
+}
+
+ProjectionMesh *coord_mesh_deserialize(const void *buffer, size_t size)
+{
+    MeshHeader header;
+    if (!buffer || size < sizeof(header))
+    {
+        set_error(COORD_ERROR_INVALID_INPUT, "Mesh buffer too small");
+        return NULL;
+    }
+    memcpy(&header, buffer, sizeof(header));
+    // Same limits as coord_mesh_create(): the projection, zone and window
+    // must be ones a build could have produced
+    if (header.magic != MESH_MAGIC || header.version != MESH_VERSION ||
+            header.interp < 0 || header.interp >= MESH_INTERP_MAX ||
+            (header.format != COORD_FORMAT_UTM && header.format != COORD_FORMAT_BRITISH_GRID) ||
+            header.datum < 0 || header.datum >= DATUM_MAX ||
+            header.zone < 1 || header.zone > 60 ||
+            (header.southern != 0 && header.southern != 1) ||
+            !coord_is_valid_latitude(header.lat_min) ||
+            !coord_is_valid_longitude(header.lon_min) ||
+            !(header.lat_size > 0.0 && header.lat_size <= 180.0) ||
+            !(header.lon_size > 0.0 && header.lon_size <= 360.0) ||
+            !(header.max_error > 0.0) ||
+            header.node_count == 0 || header.node_count > INT32_MAX ||
+            header.value_count > (uint64_t)MESH_CELL_LIMIT *
+            mesh_values_per_leaf((MeshInterp)header.interp) ||
+            (size - sizeof(header)) / sizeof(MeshNode) < header.node_count ||
+            size - sizeof(header) - header.node_count * sizeof(MeshNode) <
+            header.value_count * sizeof(double))
+    {
+        set_error(COORD_ERROR_PARSE_FAILED, "Invalid mesh buffer");
+        return NULL;
+    }
+    CoordAllocator alloc = global_allocator;
+    ProjectionMesh *mesh = (ProjectionMesh *)coord_alloc(&alloc,
+                           sizeof(ProjectionMesh));
+    if (!mesh)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate mesh");
+        return NULL;
+    }
+    memset(mesh, 0, sizeof(ProjectionMesh));
+    mesh->allocator = alloc;
+    mesh->format = (CoordFormat)header.format;
+    mesh->interp = (MeshInterp)header.interp;
+    mesh->datum = (MapDatum)header.datum;
+    mesh->zone = header.zone;
+    mesh->southern = header.southern;
+    mesh->lat_min = header.lat_min;
+    mesh->lon_min = header.lon_min;
+    mesh->lat_size = header.lat_size;
+    mesh->lon_size = header.lon_size;
+    mesh->max_error = header.max_error;
+    mesh->node_count = mesh->node_capacity = (size_t)header.node_count;
+    mesh->value_count = mesh->value_capacity = (size_t)header.value_count;
+    mesh->nodes = (MeshNode *)coord_alloc(&alloc, mesh->node_count *
+                                          sizeof(MeshNode));
+    mesh->values = (double *)coord_alloc(&alloc, mesh->value_count *
+                                         sizeof(double));
+    if (!mesh->nodes || !mesh->values)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate mesh");
+        coord_mesh_destroy(mesh);
+        return NULL;
+    }
+    const unsigned char *in = (const unsigned char *)buffer + sizeof(header);
+    memcpy(mesh->nodes, in, mesh->node_count * sizeof(MeshNode));
+    in += mesh->node_count * sizeof(MeshNode);
+    memcpy(mesh->values, in, mesh->value_count * sizeof(double));
+    // Reject node links that would index outside the arrays, and trees deeper
+    // than a build produces. Children follow their parents, so one forward
+    // pass settles each node's depth before it is visited.
+    unsigned char *depth = (unsigned char *)coord_alloc(&alloc, mesh->node_count);
+    if (!depth)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate mesh");
+        coord_mesh_destroy(mesh);
+        return NULL;
+    }
+    memset(depth, 0, mesh->node_count);
+    size_t leaf_size = mesh_values_per_leaf(mesh->interp);
+    int valid = 1;
+    for (size_t i = 0; i < mesh->node_count && valid; i++)
+    {
+        const MeshNode *node = &mesh->nodes[i];
+        if (node->child >= 0)
+        {
+            valid = (size_t)node->child > i && (size_t)node->child + 4 <= mesh->node_count &&
+                    depth[i] < MESH_MAX_DEPTH;
+            for (int q = 0; q < 4 && valid; q++)
+            {
+                unsigned char *d = &depth[node->child + q];
+                *d = (unsigned char)(depth[i] + 1 > *d ? depth[i] + 1 : *d);
+            }
+        }
+        else
+        {
+            valid = node->data >= 0 && (size_t)node->data + leaf_size <= mesh->value_count;
+        }
+    }
+    coord_free(&alloc, depth);
+    if (!valid)
+    {
+        set_error(COORD_ERROR_PARSE_FAILED, "Corrupt mesh buffer");
+        coord_mesh_destroy(mesh);
+        return NULL;
+    }
+    return mesh;
+}
+
+// ==================== Grid-cell aggregation ====================
+// Cell keys: UTM/MGRS cells pack (zone * 2 + southern) above the easting and
+// northing cell indices; British Grid cells pack the two indices only.
+// Indices fit 24 bits each down to 1 m cells; anything beyond is counted as
+// outside.
+#define GRID_KEY_EMPTY UINT64_MAX
+#define GRID_KEY_INDEX_LIMIT 16777216.0    // 2^24: easting/northing index fields
+#define GRID_AGG_BLOCK 4096
+#define GRID_AGG_MIN_CAPACITY 64
+
+struct GridAggregator
+{
+    CoordContext *ctx;          // Context used for projection and labels
+    CoordAllocator allocator;   // Owns the table, scratch and the aggregator
+    CoordFormat format;         // UTM, MGRS or British Grid
+    double cell_size;           // Cell edge (meters, power of ten)
+    int digits;                 // Grid reference digits per axis in labels
+    GridCell *cells;            // Open-addressing table (linear probing)
+    size_t capacity;            // Power of two
+    int shift;                  // 64 - log2(capacity), for the hash
+    size_t size;                // Occupied slots
+    uint64_t outside;           // Points outside the grid's coverage
+    double *scratch;            // Projected block: eastings, northings
+    uint64_t *keys;             // Projected block: cell keys
+    unsigned char *zones;       // Projected block: zones
+    char *bands;                // Projected block: bands
+};
+
+static size_t grid_agg_index(const GridAggregator *agg, uint64_t key)
+{
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> agg->shift);
+}
+
+static int grid_agg_resize(GridAggregator *agg, size_t capacity)
+{
+    GridCell *cells = (GridCell *)coord_alloc(&agg->allocator,
+                                              capacity * sizeof(GridCell));
+    if (!cells)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to grow aggregation table");
+        return COORD_ERROR_MEMORY;
+    }
+    for (size_t i = 0; i < capacity; i++)
+    {
+        cells[i].key = GRID_KEY_EMPTY;
+    }
+    GridCell *old = agg->cells;
+    size_t old_capacity = agg->capacity;
+    agg->cells = cells;
+    agg->capacity = capacity;
+    agg->shift = 64;
+    for (size_t c = capacity; c > 1; c >>= 1)
+    {
+        agg->shift--;
+    }
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old[i].key == GRID_KEY_EMPTY)
+        {
+            continue;
+        }
+        size_t slot = grid_agg_index(agg, old[i].key);
+        while (cells[slot].key != GRID_KEY_EMPTY)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        cells[slot] = old[i];
+    }
+    coord_free(&agg->allocator, old);
+    return COORD_SUCCESS;
+}
+
+// Slot for key, inserted empty if missing; the table stays at most half full
+static GridCell *grid_agg_slot(GridAggregator *agg, uint64_t key)
+{
+    size_t mask = agg->capacity - 1;
+    size_t slot = grid_agg_index(agg, key);
+    while (agg->cells[slot].key != key)
+    {
+        if (agg->cells[slot].key == GRID_KEY_EMPTY)
+        {
+            if (2 * (agg->size + 1) > agg->capacity)
+            {
+                if (grid_agg_resize(agg, 2 * agg->capacity) != COORD_SUCCESS)
+                {
+                    return NULL;
+                }
+                return grid_agg_slot(agg, key);
+            }
+            agg->size++;
+            agg->cells[slot].key = key;
+            agg->cells[slot].count = 0;
+            agg->cells[slot].sum = 0.0;
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return &agg->cells[slot];
+}
+
+GridAggregator *coord_grid_agg_create(CoordContext *ctx, CoordFormat format,
+                                      double cell_size)
+{
+    int digits = 5;
+    double size = 1.0;
+    while (digits > 0 && size < cell_size)
+    {
+        size *= 10.0;
+        digits--;
+    }
+    if (!ctx || size != cell_size)
+    {
+        set_error(COORD_ERROR_INVALID_INPUT,
+                  "Cell size must be a power of ten from 1 m to 100 km");
+        return NULL;
+    }
+    if (format != COORD_FORMAT_UTM && format != COORD_FORMAT_MGRS &&
+            format != COORD_FORMAT_BRITISH_GRID)
+    {
+        set_error(COORD_ERROR_UNSUPPORTED_FORMAT,
+                  "Aggregation supports UTM, MGRS and British Grid");
+        return NULL;
+    }
+    GridAggregator *agg = (GridAggregator *)coord_alloc(&ctx->allocator,
+                          sizeof(GridAggregator));
+    if (!agg)
+    {
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate aggregator");
+        return NULL;
+    }
+    memset(agg, 0, sizeof(GridAggregator));
+    agg->ctx = ctx;
+    agg->allocator = ctx->allocator;
+    agg->format = format;
+    agg->cell_size = cell_size;
+    agg->digits = digits;
+    agg->scratch = (double *)coord_alloc(&agg->allocator, GRID_AGG_BLOCK *
+                                         (2 * sizeof(double) + sizeof(uint64_t) + 2));
+    if (!agg->scratch || grid_agg_resize(agg, GRID_AGG_MIN_CAPACITY) != COORD_SUCCESS)
+    {
+        coord_grid_agg_destroy(agg);
+        set_error(COORD_ERROR_MEMORY, "Failed to allocate aggregator");
+        return NULL;
+    }
+    agg->keys = (uint64_t *)(agg->scratch + 2 * GRID_AGG_BLOCK);
+    agg->zones = (unsigned char *)(agg->keys + GRID_AGG_BLOCK);
+    agg->bands = (char *)(agg->zones + GRID_AGG_BLOCK);
+    return agg;
+}
 
-    double lat0 = japan_zones[zone_idx].lat0 * DEG_TO_RAD;
-    double lon0 = japan_zones[zone_idx].lon0 * DEG_TO_RAD;
-    double false_e = japan_zones[zone_idx].false_e;
-    double false_n = japan_zones[zone_idx].false_n;
-    double k0 = japan_zones[zone_idx].scale;
+void coord_grid_agg_destroy(GridAggregator *agg)
+{
+    if (agg)
+    {
+        CoordAllocator alloc = agg->allocator;
+        coord_free(&alloc, agg->cells);
+        coord_free(&alloc, agg->scratch);
+        coord_free(&alloc, agg);
+    }
+}
 
-    // Gauss-Kruger inverse projection
-    // Remove false offsets
-    // Note: jg->x is northing, jg->y is easting
-    double northing = jg->x - false_n;   // Northing
-    double easting = jg->y - false_e;     // Easting
+static int grid_agg_accumulate(GridAggregator *agg, uint64_t key, double value)
+{
+    GridCell *cell = grid_agg_slot(agg, key);
+    if (!cell)
+    {
+        return COORD_ERROR_MEMORY;
+    }
+    cell->count++;
+    cell->sum += value;
+    return COORD_SUCCESS;
+}
 
-    // Compute auxiliary parameters
-    // M is the meridional arc length, computed from northing
-    double M = northing / k0;
-    double mu = M / (a * (1.0 - e2 / 4.0 - 3.0 * e2 * e2 / 64.0
-                        - 5.0 * e2 * e2 * e2 / 256.0));
+// UTM/MGRS cells of one block, projected by the batch engine
+static int grid_agg_add_utm(GridAggregator *agg, const GeoBatch *block,
+                            const double *values)
+{
+    UTMBatch utm = coord_utm_batch_soa(agg->scratch, agg->scratch + GRID_AGG_BLOCK,
+                                       agg->zones, agg->bands, block->count,
+                                       block->datum);
+    int ret = coord_to_utm_packed(agg->ctx, block, &utm);
+    if (ret != COORD_SUCCESS)
+    {
+        return ret;
+    }
+    // Keys first, then the table updates: the key loop has no branches and
+    // the update loop's cache misses overlap
+    uint64_t *keys = agg->keys;
+    for (size_t i = 0; i < block->count; i++)
+    {
+        double lat = block->lat[i * block->stride];
+        double e = utm.easting[i] / agg->cell_size;
+        double n = utm.northing[i] / agg->cell_size;
+        // Indices must fit their 24-bit fields; casting a negative or larger
+        // value would be undefined or spill into the zone bits
+        int in_range = (e >= 0.0) & (e < GRID_KEY_INDEX_LIMIT) &
+                       (n >= 0.0) & (n < GRID_KEY_INDEX_LIMIT);
+        e = in_range ? e : 0.0;
+        n = in_range ? n : 0.0;
+        uint64_t key = ((uint64_t)(utm.zone[i] * 2 + (lat < 0.0)) << 48) |
+                       ((uint64_t)e << 24) | (uint64_t)n;
+        // UTM and MGRS stop at 80S and 84N (the polar UPS grids are not built)
+        keys[i] = (in_range && lat >= -80.0 && lat <= 84.0) ? key : GRID_KEY_EMPTY;
+    }
+    for (size_t i = 0; ret == COORD_SUCCESS && i < block->count; i++)
+    {
+        if (keys[i] == GRID_KEY_EMPTY)
+        {
+            agg->outside++;
+            continue;
+        }
+        ret = grid_agg_accumulate(agg, keys[i], values ? values[i] : 0.0);
+    }
+    return ret;
+}
+
+// British Grid cells of one block (OSGB36 full easting/northing)
+static int grid_agg_add_bng(GridAggregator *agg, const GeoBatch *block,
+                            const double *values)
+{
+    const CoordContext *ctx = agg->ctx;
+    for (size_t i = 0; i < block->count; i++)
+    {
+        GeoCoord point, osgb;
+        geo_batch_get(block, i, &point);
+        if (point.datum != DATUM_OSGB36)
+        {
+            datum_convert_unchecked(ctx, &point, DATUM_OSGB36, ctx->shift_method,
+                                    &osgb);
+            point = osgb;
+        }
+        double easting, northing;
+        bng_forward(point.latitude, point.longitude, &easting, &northing);
+        if (!(easting >= 0.0 && easting < 700000.0 && northing >= 0.0 &&
+                northing < 1300000.0))
+        {
+            agg->outside++;
+            continue;
+        }
+        uint64_t key = ((uint64_t)(easting / agg->cell_size) << 24) |
+                       (uint64_t)(northing / agg->cell_size);
+        int ret = grid_agg_accumulate(agg, key, values ? values[i] : 0.0);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_grid_agg_add(GridAggregator *agg, const GeoBatch *geo,
+                       const double *values)
+{
+    if (!agg || !geo_batch_usable(geo))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < geo->count; i++)
+    {
+        if (!coord_is_valid_latitude(geo->lat[i * geo->stride]) ||
+                !coord_is_valid_longitude(geo->lon[i * geo->stride]))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+    }
+    for (size_t base = 0; base < geo->count; base += GRID_AGG_BLOCK)
+    {
+        GeoBatch block = *geo;
+        block.lat += base * geo->stride;
+        block.lon += base * geo->stride;
+        block.alt = NULL;
+        block.count = geo->count - base < GRID_AGG_BLOCK ? geo->count - base
+                      : GRID_AGG_BLOCK;
+        const double *block_values = values ? values + base : NULL;
+        int ret = agg->format == COORD_FORMAT_BRITISH_GRID ?
+                  grid_agg_add_bng(agg, &block, block_values) :
+                  grid_agg_add_utm(agg, &block, block_values);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_grid_agg_merge(GridAggregator *dst, const GridAggregator *src)
+{
+    if (!dst || !src || dst == src || src->cell_size != dst->cell_size ||
+            (src->format == COORD_FORMAT_BRITISH_GRID) !=
+            (dst->format == COORD_FORMAT_BRITISH_GRID))
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    for (size_t i = 0; i < src->capacity; i++)
+    {
+        if (src->cells[i].key == GRID_KEY_EMPTY)
+        {
+            continue;
+        }
+        GridCell *cell = grid_agg_slot(dst, src->cells[i].key);
+        if (!cell)
+        {
+            return COORD_ERROR_MEMORY;
+        }
+        cell->count += src->cells[i].count;
+        cell->sum += src->cells[i].sum;
+    }
+    dst->outside += src->outside;
+    return COORD_SUCCESS;
+}
+
+static int grid_cell_compare(const void *a, const void *b)
+{
+    uint64_t ka = ((const GridCell *)a)->key;
+    uint64_t kb = ((const GridCell *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+size_t coord_grid_agg_cells(const GridAggregator *agg, GridCell *cells,
+                            size_t max_cells)
+{
+    if (!agg)
+    {
+        return 0;
+    }
+    if (!cells || max_cells < agg->size)
+    {
+        return agg->size;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < agg->capacity; i++)
+    {
+        if (agg->cells[i].key != GRID_KEY_EMPTY)
+        {
+            cells[n++] = agg->cells[i];
+        }
+    }
+    qsort(cells, n, sizeof(GridCell), grid_cell_compare);
+    return n;
+}
+
+uint64_t coord_grid_agg_outside(const GridAggregator *agg)
+{
+    return agg ? agg->outside : 0;
+}
+
+int coord_grid_cell_label(const GridAggregator *agg, uint64_t key,
+                          char *buffer, size_t buffer_size)
+{
+    if (!agg || !buffer || key == GRID_KEY_EMPTY)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    double easting = (double)((key >> 24) & 0xFFFFFF) * agg->cell_size;
+    double northing = (double)(key & 0xFFFFFF) * agg->cell_size;
+    int scale = 1;
+    for (int d = 0; d < 5 - agg->digits; d++)
+    {
+        scale *= 10;
+    }
+    int written;
+    if (agg->format == COORD_FORMAT_BRITISH_GRID)
+    {
+        BritishGridPoint bg = {"", easting, northing, DATUM_OSGB36};
+        bng_set_letters(&bg);
+        written = agg->digits == 0 ?
+                  snprintf(buffer, buffer_size, "%s", bg.letters) :
+                  snprintf(buffer, buffer_size, "%s %0*d %0*d", bg.letters,
+                           agg->digits, (int)fmod(easting, 100000.0) / scale,
+                           agg->digits, (int)fmod(northing, 100000.0) / scale);
+    }
+    else
+    {
+        // The band comes from the cell centre, so a cell crossing a band edge
+        // is labelled on the side holding most of it
+        int zone_key = (int)(key >> 48);
+        UTMPoint utm = {zone_key / 2, (zone_key & 1) ? 'M' : 'N',
+                        easting + 0.5 * agg->cell_size,
+                        northing + 0.5 * agg->cell_size, 0.0, 0.9996, DATUM_WGS84
+                       };
+        if (utm.zone < 1 || utm.zone > 60)
+        {
+            return COORD_ERROR_INVALID_INPUT;
+        }
+        GeoCoord centre;
+        geo_from_utm_unchecked(agg->ctx, &utm, &centre);
+        utm.band = coord_get_utm_band(centre.latitude);
+        utm.easting = easting;
+        utm.northing = northing;
+        if (agg->format == COORD_FORMAT_UTM)
+        {
+            return coord_format_utm(&utm, buffer, buffer_size);
+        }
+        MGRSPoint mgrs;
+        mgrs_from_utm_unchecked(&utm, &mgrs);
+        written = agg->digits == 0 ?
+                  snprintf(buffer, buffer_size, "%d%c %s", mgrs.zone, mgrs.band,
+                           mgrs.square) :
+                  snprintf(buffer, buffer_size, "%d%c %s %0*d %0*d", mgrs.zone,
+                           mgrs.band, mgrs.square, agg->digits,
+                           (int)mgrs.easting / scale, agg->digits,
+                           (int)mgrs.northing / scale);
+    }
+    return (written < 0
+            || (size_t)written >= buffer_size) ? COORD_ERROR_FORMAT : COORD_SUCCESS;
+}
+
+// ==================== Geodesic calculation functions ====================
+// The context's geodesic object, created on first use (NULL if out of memory)
+static const struct geod_geodesic *context_geod(CoordContext *ctx)
+{
+    if (!ctx->geod)
+    {
+        ctx->geod = (struct geod_geodesic *)coord_alloc(&ctx->owner,
+                    sizeof(struct geod_geodesic));
+        if (!ctx->geod)
+        {
+            set_error(COORD_ERROR_MEMORY, "Failed to create geodesic object");
+            return NULL;
+        }
+        geod_init(ctx->geod, ctx->ellipsoid.a, ctx->ellipsoid.f);
+    }
+    return ctx->geod;
+}
+
+int coord_distance(CoordContext *ctx, const GeoCoord *p1, const GeoCoord *p2,
+                   double *distance, double *azi1, double *azi2)
+{
+    if (!ctx || !p1 || !p2)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(p1) || !coord_validate_point(p2))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    const struct geod_geodesic *geod = context_geod(ctx);
+    if (!geod)
+    {
+        return COORD_ERROR_MEMORY;
+    }
+    double s12, a1, a2;
+    // If datums differ, convert
+    if (p1->datum != p2->datum)
+    {
+        GeoCoord p2_same_datum;
+        int ret = coord_convert_datum(ctx, p2, p1->datum, &p2_same_datum);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+        geod_inverse(geod, p1->latitude, p1->longitude,
+                     p2_same_datum.latitude, p2_same_datum.longitude,
+                     &s12, &a1, &a2);
+    }
+    else
+    {
+        geod_inverse(geod, p1->latitude, p1->longitude,
+                     p2->latitude, p2->longitude,
+                     &s12, &a1, &a2);
+    }
+    if (distance)
+    {
+        *distance = s12;
+    }
+    if (azi1)
+    {
+        *azi1 = a1;
+    }
+    if (azi2)
+    {
+        *azi2 = a2;
+    }
+    return COORD_SUCCESS;
+}
+
+int coord_direct(CoordContext *ctx, const GeoCoord *start,
+                 double distance, double azimuth, GeoCoord *end)
+{
+    if (!ctx || !start || !end)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(start))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    if (distance < 0.0)
+    {
+        return COORD_ERROR_OUT_OF_RANGE;
+    }
+    const struct geod_geodesic *geod = context_geod(ctx);
+    if (!geod)
+    {
+        return COORD_ERROR_MEMORY;
+    }
+    double lat2, lon2, azi2;
+    geod_direct(geod, start->latitude, start->longitude,
+                azimuth, distance, &lat2, &lon2, &azi2);
+    end->latitude = coord_normalize_latitude(lat2);
+    end->longitude = coord_normalize_longitude(lon2);
+    end->altitude = 0.0;
+    end->datum = start->datum;
+    return COORD_SUCCESS;
+}
+
+int coord_inverse(CoordContext *ctx, const GeoCoord *p1, const GeoCoord *p2,
+                  GeodesicResult *result)
+{
+    if (!ctx || !p1 || !p2 || !result)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    if (!coord_validate_point(p1) || !coord_validate_point(p2))
+    {
+        return COORD_ERROR_INVALID_COORD;
+    }
+    const struct geod_geodesic *geod = context_geod(ctx);
+    if (!geod)
+    {
+        return COORD_ERROR_MEMORY;
+    }
+    // If datums differ, convert
+    if (p1->datum != p2->datum)
+    {
+        GeoCoord p2_same_datum;
+        int ret = coord_convert_datum(ctx, p2, p1->datum, &p2_same_datum);
+        if (ret != COORD_SUCCESS)
+        {
+            return ret;
+        }
+        geod_inverse(geod, p1->latitude, p1->longitude,
+                     p2_same_datum.latitude, p2_same_datum.longitude,
+                     &result->distance, &result->azimuth1, &result->azimuth2);
+    }
+    else
+    {
+        geod_inverse(geod, p1->latitude, p1->longitude,
+                     p2->latitude, p2->longitude,
+                     &result->distance, &result->azimuth1, &result->azimuth2);
+    }
+    return COORD_SUCCESS;
+}
+
+// ==================== Datum transform utility functions ====================
+int coord_set_transform_params(CoordContext *ctx, MapDatum from, MapDatum to,
+                               const DatumTransform *params)
+{
+    if (!ctx || from >= DATUM_MAX || to >= DATUM_MAX || !params)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    // Copy on first write; the defaults stay shared by other contexts
+    if (ctx->transforms == DEFAULT_TRANSFORMS)
+    {
+        void *copy = coord_alloc(&ctx->owner, sizeof(DEFAULT_TRANSFORMS));
+        if (!copy)
+        {
+            set_error(COORD_ERROR_MEMORY, "Failed to copy transform table");
+            return COORD_ERROR_MEMORY;
+        }
+        memcpy(copy, DEFAULT_TRANSFORMS, sizeof(DEFAULT_TRANSFORMS));
+        ctx->transforms = (const DatumTransform (*)[DATUM_MAX])copy;
+    }
+    // The table is the context's own copy from here on
+    DatumTransform (*table)[DATUM_MAX] = (DatumTransform (*)[DATUM_MAX])ctx->transforms;
+    table[from][to] = *params;
+    // Set inverse transform parameters (correct 7-parameter inverse)
+    if (from != to)
+    {
+        // Correct formula for 7-parameter inverse transform:
+        // Inverse transform requires inversion via rotation matrix
+        // If forward: X2 = T + s*R*X1
+        // Then inverse: X1 = (-1/s)*R^T*(X2-T) = (-1/s)*R^T*X2 + (1/s)*R^T*T
+        //
+        // For small-angle approximation (arc-seconds), inverse params are approximately:
+        // Inverse translation = -R^T * T / (1+s)
+        // Inverse rotation ≈ -rotation (but more accurate calc needed)
 
-    // Compute footpoint latitude
-    double e1 = (1.0 - sqrt(1.0 - e2)) / (1.0 + sqrt(1.0 - e2));
-    double J1 = 3.0 * e1 / 2.0 - 27.0 * e1 * e1 * e1 / 32.0;
-    double J2 = 21.0 * e1 * e1 / 16.0 - 55.0 * e1 * e1 * e1 * e1 / 32.0;
-    double J3 = 151.0 * e1 * e1 * e1 / 96.0;
-    double J4 = 1097.0 * e1 * e1 * e1 * e1 / 512.0;
+        double s = params->scale * PPM_TO_SCALE;
 
-    double fp = mu + J1 * sin(2.0 * mu) + J2 * sin(4.0 * mu)
-                + J3 * sin(6.0 * mu) + J4 * sin(8.0 * mu);
+        // Build rotation matrix R
+        // R = Rz(θz) * Ry(θy) * Rx(θx)
+        // For small angles, can be approximated as:
+        // R ≈ [ 1    -rz    ry
+        //       rz     1   -rx
+        //      -ry    rx     1 ]
 
-    double sin_fp = sin(fp);
-    double cos_fp = cos(fp);
-    double tan_fp = sin_fp / cos_fp;
+        // Compute inverse transform parameters
+        // Inverse scale factor
+        table[to][from].scale = -params->scale;
 
-    double C1 = e2 * cos_fp * cos_fp / (1.0 - e2);
-    double T1 = tan_fp * tan_fp;
-    double R1 = a * (1.0 - e2) / pow(1.0 - e2 * sin_fp * sin_fp, 1.5);
-    double N1 = a / sqrt(1.0 - e2 * sin_fp * sin_fp);
+        // Inverse rotation parameters (approximate, for small angles)
+        table[to][from].rx = -params->rx;
+        table[to][from].ry = -params->ry;
+        table[to][from].rz = -params->rz;
 
-    // D computed from easting
-    double D = easting / (N1 * k0);
-    double D2 = D * D;
-    double D3 = D2 * D;
-    double D4 = D3 * D;
-    double D5 = D4 * D;
-    double D6 = D5 * D;
+        // Inverse translation parameters: T_back = -(dx,dy,dz) / (1+s)
+        // More accurate calculation requires considering rotation matrix transpose
+        double factor = 1.0 / (1.0 + s);
+        table[to][from].dx = -params->dx * factor;
+        table[to][from].dy = -params->dy * factor;
+        table[to][from].dz = -params->dz * factor;
 
-    // Compute latitude correction
-    double Q1 = N1 * tan_fp / R1;
-    double Q2 = 0.5 * D2;
-    double Q3 = (5.0 + 3.0 * T1 + 10.0 * C1 - 4.0 * C1 * C1
-                - 9.0 * e2) * D4 / 24.0;
-    double Q4 = (61.0 + 90.0 * T1 + 298.0 * C1 + 45.0 * T1 * T1
-                - 252.0 * e2 - 3.0 * C1 * C1) * D6 / 720.0;
+        // For small angles, add rotation correction term
+        // Correction: T_back ≈ -(T + R×T) / (1+s)
+        // Here we use first-order approximation
+        double dx_corr = params->ry * params->dz - params->rz * params->dy;
+        double dy_corr = params->rz * params->dx - params->rx * params->dz;
+        double dz_corr = params->rx * params->dy - params->ry * params->dx;
+        // Adjustment for converting arc-seconds to radians
+        dx_corr *= ARC_SEC_TO_RAD;
+        dy_corr *= ARC_SEC_TO_RAD;
+        dz_corr *= ARC_SEC_TO_RAD;
 
-    double lat_rad = fp - Q1 * (Q2 - Q3 + Q4);
+        table[to][from].dx -= dx_corr * factor;
+        table[to][from].dy -= dy_corr * factor;
+        table[to][from].dz -= dz_corr * factor;
+    }
+    return COORD_SUCCESS;
+}
 
-    // Compute longitude correction
-    double Q5 = D;
-    double Q6 = (1.0 + 2.0 * T1 + C1) * D3 / 6.0;
-    double Q7 = (5.0 - 2.0 * C1 + 28.0 * T1 - 3.0 * C1 * C1
-                + 8.0 * e2 + 24.0 * T1 * T1) * D5 / 120.0;
+int coord_get_transform_params(CoordContext *ctx, MapDatum from, MapDatum to,
+                               DatumTransform *params)
+{
+    if (!ctx || from >= DATUM_MAX || to >= DATUM_MAX || !params)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    *params = ctx->transforms[from][to];
+    return COORD_SUCCESS;
+}
 
-    double lon_rad = lon0 + (Q5 - Q6 + Q7) / cos_fp;
+// ==================== Ellipsoid utility functions ====================
+const Ellipsoid *coord_get_ellipsoid(MapDatum datum)
+{
+    if (datum >= DATUM_MAX)
+    {
+        return NULL;
+    }
+    return &ELLIPSOIDS[datum];
+}
 
-    // Convert to degrees
-    geo->latitude = coord_rad_to_deg(lat_rad);
-    geo->longitude = coord_rad_to_deg(lon_rad);
-    geo->altitude = 0.0;
-    geo->datum = DATUM_TOKYO;
+int coord_set_custom_ellipsoid(CoordContext *ctx, double a, double f)
+{
+    if (!ctx || a <= 0.0 || f <= 0.0)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    ctx->ellipsoid.a = a;
+    ctx->ellipsoid.f = f;
+    ctx->ellipsoid.b = a * (1.0 - f);
+    ctx->ellipsoid.e2 = 2 * f - f * f;
+    ctx->ellipsoid.ep2 = ctx->ellipsoid.e2 / (1.0 - ctx->ellipsoid.e2);
+    ctx->ellipsoid.name = "Custom";
+    // Reinitialize GeographicLib geodesic object
+    if (ctx->geod)
+    {
+        geod_init(ctx->geod, a, f);
+    }
+    return COORD_SUCCESS;
+}
 
-    // If WGS84 coordinates are needed, perform datum conversion
-    if (geo->datum == DATUM_WGS84)
+// ==================== Error handling functions ====================
+const char *coord_get_error_string(int error_code)
+{
+    if (error_code < 0
+            || error_code >= (int)(sizeof(ERROR_MESSAGES) / sizeof(ERROR_MESSAGES[0])))
     {
-        GeoCoord tokyo_coord = *geo;
-        tokyo_coord.datum = DATUM_TOKYO;
-        int ret = coord_convert_datum(ctx, &tokyo_coord, DATUM_WGS84, geo);
-        if (ret != COORD_SUCCESS)
-        {
-            return ret;
-        }
+        return "Unknown error";
     }
+    return ERROR_MESSAGES[error_code];
+}
 
-    return COORD_SUCCESS;
+void coord_set_error_callback(void (*callback)(int, const char *))
+{
+    error_callback = callback;
 }
 
-// ==================== Datum conversion functions ====================
-int coord_convert_datum(CoordContext *ctx, const GeoCoord *src,
-                        MapDatum target_datum, GeoCoord *dst)
+// ==================== Main format conversion function ====================
+int coord_convert(CoordContext *ctx, const GeoCoord *src,
+                  CoordFormat target_format, MapDatum target_datum,
+                  char *result_buffer, size_t buffer_size)
 {
-    if (!ctx || !src || !dst)
+    if (!result_buffer)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (src->datum == target_datum)
+    CoordValue value;
+    return coord_convert_typed(ctx, src, target_format, target_datum, &value,
+                               result_buffer, buffer_size);
+}
+
+// UTM point re-expressed in the natural zone of its position
+static void utm_rezone_unchecked(const CoordContext *ctx, const UTMPoint *src,
+                                 UTMPoint *dst)
+{
+    GeoCoord geo;
+    geo_from_utm_unchecked(ctx, src, &geo);
+    int zone = utm_zone_unchecked(geo.longitude, geo.latitude);
+    if (zone == src->zone)
     {
         *dst = *src;
-        return COORD_SUCCESS;
+        return;
     }
-    if (!coord_validate_point(src))
+    utm_to_zone_unchecked(&ctx->ellipsoid, src, zone, dst);
+}
+
+static int is_geographic_format(CoordFormat format)
+{
+    return format == COORD_FORMAT_DD || format == COORD_FORMAT_DMM ||
+           format == COORD_FORMAT_DMS;
+}
+
+// Geographic coordinate of any source value (validated by the public inverses)
+static int any_to_geo(CoordContext *ctx, CoordFormat format, const void *src,
+                      GeoCoord *geo)
+{
+    switch (format)
     {
-        return COORD_ERROR_INVALID_COORD;
+        case COORD_FORMAT_DD:
+        case COORD_FORMAT_DMM:
+        case COORD_FORMAT_DMS:
+            *geo = *(const GeoCoord *)src;
+            if (geo->datum >= DATUM_MAX)
+            {
+                return COORD_ERROR_INVALID_INPUT;
+            }
+            return coord_validate_point(geo) ? COORD_SUCCESS : COORD_ERROR_INVALID_COORD;
+        case COORD_FORMAT_UTM:
+            return coord_from_utm(ctx, (const UTMPoint *)src, geo);
+        case COORD_FORMAT_MGRS:
+            return coord_from_mgrs(ctx, (const MGRSPoint *)src, geo);
+        case COORD_FORMAT_BRITISH_GRID:
+            return coord_from_british_grid(ctx, (const BritishGridPoint *)src, geo);
+        case COORD_FORMAT_JAPAN_GRID:
+            return coord_from_japan_grid(ctx, (const JapanGridPoint *)src, geo);
+        case COORD_FORMAT_WEB_MERCATOR:
+            return coord_from_web_mercator(ctx, (const WebMercatorPoint *)src, geo);
+        case COORD_FORMAT_GEOHASH:
+            return coord_from_geohash(ctx, (const GeohashPoint *)src, geo);
+        case COORD_FORMAT_QUADKEY:
+            return coord_from_quadkey(ctx, (const QuadkeyPoint *)src, geo);
+        default:
+            return COORD_ERROR_UNSUPPORTED_FORMAT;
     }
-    // Get transform parameters
-    DatumTransform *params = &ctx->transforms[src->datum][target_datum];
-    if (params->dx == 0.0 && params->dy == 0.0 && params->dz == 0.0 &&
-            params->rx == 0.0 && params->ry == 0.0 && params->rz == 0.0 &&
-            params->scale == 0.0)
+}
+
+// Any target value from a validated geographic coordinate
+static int geo_to_any(const CoordContext *ctx, const GeoCoord *geo,
+                      CoordFormat format, void *dst)
+{
+    switch (format)
     {
-        // No transform parameters; return directly
-        *dst = *src;
-        dst->datum = target_datum;
-        return COORD_SUCCESS;
+        case COORD_FORMAT_DD:
+        case COORD_FORMAT_DMM:
+        case COORD_FORMAT_DMS:
+            *(GeoCoord *)dst = *geo;
+            return COORD_SUCCESS;
+        case COORD_FORMAT_UTM:
+            return utm_from_geo_unchecked(ctx, geo, (UTMPoint *)dst);
+        case COORD_FORMAT_MGRS:
+            return mgrs_from_geo_unchecked(ctx, geo, (MGRSPoint *)dst);
+        case COORD_FORMAT_BRITISH_GRID:
+            return bng_from_geo_unchecked(ctx, geo, (BritishGridPoint *)dst);
+        case COORD_FORMAT_JAPAN_GRID:
+            return japan_grid_from_geo_unchecked(ctx, geo, (JapanGridPoint *)dst);
+        case COORD_FORMAT_WEB_MERCATOR:
+            return web_mercator_from_geo_unchecked(ctx, geo, ctx->tile_zoom,
+                                                   (WebMercatorPoint *)dst);
+        case COORD_FORMAT_GEOHASH:
+            return geohash_from_geo_unchecked(geo, GEOHASH_MAX_PRECISION,
+                                              (GeohashPoint *)dst);
+        case COORD_FORMAT_QUADKEY:
+            if (ctx->tile_zoom < 1)
+            {
+                return COORD_ERROR_INVALID_INPUT;
+            }
+            return quadkey_from_geo_unchecked(ctx, geo, ctx->tile_zoom,
+                                              (QuadkeyPoint *)dst);
+        default:
+            return COORD_ERROR_UNSUPPORTED_FORMAT;
     }
-    // Get source ellipsoid parameters
-    const Ellipsoid *src_ell = &ELLIPSOIDS[src->datum];
-    const Ellipsoid *dst_ell = &ELLIPSOIDS[target_datum];
-    // Convert lat/lon to geocentric Cartesian coordinates
-    double lat_rad = coord_deg_to_rad(src->latitude);
-    double lon_rad = coord_deg_to_rad(src->longitude);
-    double alt = src->altitude;
-    double sin_lat = sin(lat_rad);
-    double cos_lat = cos(lat_rad);
-    double sin_lon = sin(lon_rad);
-    double cos_lon = cos(lon_rad);
-    double N = src_ell->a / sqrt(1.0 - src_ell->e2 * sin_lat * sin_lat);
-    double X = (N + alt) * cos_lat * cos_lon;
-    double Y = (N + alt) * cos_lat * sin_lon;
-    double Z = (N * (1.0 - src_ell->e2) + alt) * sin_lat;
-    // Apply 7-parameter transform
-    double rx_rad = params->rx * ARC_SEC_TO_RAD;
-    double ry_rad = params->ry * ARC_SEC_TO_RAD;
-    double rz_rad = params->rz * ARC_SEC_TO_RAD;
-    double scale_factor = 1.0 + params->scale * PPM_TO_SCALE;
-    double X2 = params->dx + X * scale_factor + Y * rz_rad - Z * ry_rad;
-    double Y2 = params->dy - X * rz_rad + Y * scale_factor + Z * rx_rad;
-    double Z2 = params->dz + X * ry_rad - Y * rx_rad + Z * scale_factor;
-    // Convert back to geodetic coordinates
-    double p = sqrt(X2 * X2 + Y2 * Y2);
-    double theta = atan2(Z2 * dst_ell->a, p * dst_ell->b);
-    double sin_theta = sin(theta);
-    double cos_theta = cos(theta);
-    double lat_rad_out = atan2(Z2 + dst_ell->ep2 * dst_ell->b * sin_theta *
-                               sin_theta * sin_theta,
-                               p - dst_ell->e2 * dst_ell->a * cos_theta * cos_theta * cos_theta);
-    double lon_rad_out = atan2(Y2, X2);
-    double N2 = dst_ell->a / sqrt(1.0 - dst_ell->e2 * sin(lat_rad_out) * sin(
-                                      lat_rad_out));
-    double alt_out = p / cos(lat_rad_out) - N2;
-    dst->latitude = coord_normalize_latitude(coord_rad_to_deg(lat_rad_out));
-    dst->longitude = coord_normalize_longitude(coord_rad_to_deg(lon_rad_out));
-    dst->altitude = alt_out;
-    dst->datum = target_datum;
-    return COORD_SUCCESS;
 }
 
-// ==================== Geodesic calculation functions ====================
-int coord_distance(CoordContext *ctx, const GeoCoord *p1, const GeoCoord *p2,
-                   double *distance, double *azi1, double *azi2)
+int coord_convert_any(CoordContext *ctx, CoordFormat src_format,
+                      const void *src, CoordFormat dst_format, void *dst)
 {
-    if (!ctx || !p1 || !p2)
+    if (!ctx || !src || !dst)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_point(p1) || !coord_validate_point(p2))
+    if (src_format >= COORD_FORMAT_MAX || dst_format >= COORD_FORMAT_MAX)
     {
-        return COORD_ERROR_INVALID_COORD;
+        return COORD_ERROR_UNSUPPORTED_FORMAT;
     }
-    double s12, a1, a2;
-    // If datums differ, convert
-    if (p1->datum != p2->datum)
+    // Direct grid-to-grid routes
+    if (src_format == COORD_FORMAT_MGRS && dst_format == COORD_FORMAT_UTM)
     {
-        GeoCoord p2_same_datum;
-        int ret = coord_convert_datum(ctx, p2, p1->datum, &p2_same_datum);
-        if (ret != COORD_SUCCESS)
+        return coord_mgrs_to_utm((const MGRSPoint *)src, (UTMPoint *)dst);
+    }
+    if (src_format == COORD_FORMAT_UTM && dst_format == COORD_FORMAT_MGRS)
+    {
+        return coord_utm_to_mgrs((const UTMPoint *)src, (MGRSPoint *)dst);
+    }
+    if (src_format == COORD_FORMAT_UTM && dst_format == COORD_FORMAT_UTM)
+    {
+        if (!coord_validate_utm((const UTMPoint *)src))
         {
-            return ret;
+            return COORD_ERROR_INVALID_COORD;
         }
-        geod_inverse(ctx->geod, p1->latitude, p1->longitude,
-                     p2_same_datum.latitude, p2_same_datum.longitude,
-                     &s12, &a1, &a2);
+        utm_rezone_unchecked(ctx, (const UTMPoint *)src, (UTMPoint *)dst);
+        return COORD_SUCCESS;
     }
-    else
+    if (src_format == COORD_FORMAT_MGRS && dst_format == COORD_FORMAT_MGRS)
     {
-        geod_inverse(ctx->geod, p1->latitude, p1->longitude,
-                     p2->latitude, p2->longitude,
-                     &s12, &a1, &a2);
+        if (!coord_validate_mgrs((const MGRSPoint *)src))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        *(MGRSPoint *)dst = *(const MGRSPoint *)src;
+        return COORD_SUCCESS;
     }
-    if (distance)
+    if (is_geographic_format(src_format) && is_geographic_format(dst_format))
     {
-        *distance = s12;
+        return any_to_geo(ctx, src_format, src, (GeoCoord *)dst);
     }
-    if (azi1)
+    // General route through geographic coordinates
+    GeoCoord geo;
+    int ret = any_to_geo(ctx, src_format, src, &geo);
+    if (ret != COORD_SUCCESS)
     {
-        *azi1 = a1;
+        return ret;
     }
-    if (azi2)
+    return geo_to_any(ctx, &geo, dst_format, dst);
+}
+
+// ==================== Typed conversion ====================
+int coord_format_value(const CoordValue *value, char *buffer,
+                       size_t buffer_size)
+{
+    if (!value || !buffer)
     {
-        *azi2 = a2;
+        return COORD_ERROR_INVALID_INPUT;
     }
-    return COORD_SUCCESS;
+    switch (value->format)
+    {
+        case COORD_FORMAT_DD:
+        case COORD_FORMAT_DMM:
+        case COORD_FORMAT_DMS:
+            return coord_format_to_string(&value->value.geo, value->format, buffer,
+                                          buffer_size);
+        case COORD_FORMAT_UTM:
+            return coord_format_utm(&value->value.utm, buffer, buffer_size);
+        case COORD_FORMAT_MGRS:
+            return coord_format_mgrs(&value->value.mgrs, buffer, buffer_size);
+        case COORD_FORMAT_BRITISH_GRID:
+            return coord_format_british_grid(&value->value.bg, buffer, buffer_size);
+        case COORD_FORMAT_JAPAN_GRID:
+            return coord_format_japan_grid(&value->value.jg, buffer, buffer_size);
+        case COORD_FORMAT_WEB_MERCATOR:
+            return coord_format_web_mercator(&value->value.wm, buffer, buffer_size);
+        case COORD_FORMAT_GEOHASH:
+            return coord_format_geohash(&value->value.gh, buffer, buffer_size);
+        case COORD_FORMAT_QUADKEY:
+            return coord_format_quadkey(&value->value.qk, buffer, buffer_size);
+        default:
+            return COORD_ERROR_UNSUPPORTED_FORMAT;
+    }
+}
+
+// Datum shift and projection of a validated point into a tagged value
+static int convert_typed_unchecked(const CoordContext *ctx, const GeoCoord *src,
+                                   CoordFormat target_format,
+                                   MapDatum target_datum, CoordValue *result)
+{
+    GeoCoord target_geo;
+    datum_convert_unchecked(ctx, src, target_datum, ctx->shift_method,
+                            &target_geo);
+    result->format = target_format;
+    return geo_to_any(ctx, &target_geo, target_format, &result->value);
 }
 
-int coord_direct(CoordContext *ctx, const GeoCoord *start,
-                 double distance, double azimuth, GeoCoord *end)
+int coord_convert_typed(CoordContext *ctx, const GeoCoord *src,
+                        CoordFormat target_format, MapDatum target_datum,
+                        CoordValue *result, char *result_buffer,
+                        size_t buffer_size)
 {
-    if (!ctx || !start || !end)
+    if (!ctx || !src || !result || src->datum >= DATUM_MAX ||
+            target_datum >= DATUM_MAX)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_point(start))
+    if (target_format >= COORD_FORMAT_MAX)
+    {
+        return COORD_ERROR_UNSUPPORTED_FORMAT;
+    }
+    if (!coord_validate_point(src))
     {
         return COORD_ERROR_INVALID_COORD;
     }
-    if (distance < 0.0)
+    int ret = convert_typed_unchecked(ctx, src, target_format, target_datum,
+                                      result);
+    if (ret != COORD_SUCCESS || !result_buffer)
     {
-        return COORD_ERROR_OUT_OF_RANGE;
+        return ret;
     }
-    double lat2, lon2, azi2;
-    geod_direct(ctx->geod, start->latitude, start->longitude,
-                azimuth, distance, &lat2, &lon2, &azi2);
-    end->latitude = coord_normalize_latitude(lat2);
-    end->longitude = coord_normalize_longitude(lon2);
-    end->altitude = 0.0;
-    end->datum = start->datum;
-    return COORD_SUCCESS;
+    return coord_format_value(result, result_buffer, buffer_size);
 }
 
-int coord_inverse(CoordContext *ctx, const GeoCoord *p1, const GeoCoord *p2,
-                  GeodesicResult *result)
+// Typed batch, visiting points in the given order (NULL for input order).
+// Points come from src, or from the packed view when src is NULL.
+static int typed_batch(CoordContext *ctx, const GeoCoord *src,
+                       const GeoBatch *packed, size_t count,
+                       const size_t *order, CoordFormat target_format,
+                       MapDatum target_datum, CoordValue *results)
 {
-    if (!ctx || !p1 || !p2 || !result)
+    if (!ctx || (count > 0 && ((!src && !packed) || !results)) ||
+            target_datum >= DATUM_MAX)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_point(p1) || !coord_validate_point(p2))
+    if (target_format >= COORD_FORMAT_MAX)
     {
-        return COORD_ERROR_INVALID_COORD;
+        return COORD_ERROR_UNSUPPORTED_FORMAT;
     }
-    // If datums differ, convert
-    if (p1->datum != p2->datum)
+    for (size_t n = 0; n < count; n++)
     {
-        GeoCoord p2_same_datum;
-        int ret = coord_convert_datum(ctx, p2, p1->datum, &p2_same_datum);
+        size_t i = order ? order[n] : n;
+        if (i >= count)
+        {
+            return COORD_ERROR_INVALID_INPUT;
+        }
+        GeoCoord point;
+        if (src)
+        {
+            point = src[i];
+        }
+        else
+        {
+            geo_batch_get(packed, i, &point);
+        }
+        if (point.datum >= DATUM_MAX)
+        {
+            return COORD_ERROR_INVALID_INPUT;
+        }
+        if (!coord_validate_point(&point))
+        {
+            return COORD_ERROR_INVALID_COORD;
+        }
+        int ret = convert_typed_unchecked(ctx, &point, target_format,
+                                          target_datum, &results[i]);
         if (ret != COORD_SUCCESS)
         {
             return ret;
         }
-        geod_inverse(ctx->geod, p1->latitude, p1->longitude,
-                     p2_same_datum.latitude, p2_same_datum.longitude,
-                     &result->distance, &result->azimuth1, &result->azimuth2);
     }
-    else
+    return COORD_SUCCESS;
+}
+
+int coord_convert_typed_batch(CoordContext *ctx, const GeoCoord *src,
+                              size_t count, CoordFormat target_format,
+                              MapDatum target_datum, CoordValue *results)
+{
+    return typed_batch(ctx, src, NULL, count, NULL, target_format, target_datum,
+                       results);
+}
+
+int coord_convert_typed_batch_ordered(CoordContext *ctx, const GeoCoord *src,
+                                      size_t count, const size_t *order,
+                                      CoordFormat target_format,
+                                      MapDatum target_datum,
+                                      CoordValue *results)
+{
+    if (count > 0 && !order)
     {
-        geod_inverse(ctx->geod, p1->latitude, p1->longitude,
-                     p2->latitude, p2->longitude,
-                     &result->distance, &result->azimuth1, &result->azimuth2);
+        return COORD_ERROR_INVALID_INPUT;
     }
-    return COORD_SUCCESS;
+    return typed_batch(ctx, src, NULL, count, order, target_format, target_datum,
+                       results);
 }
 
-// ==================== Datum transform utility functions ====================
-int coord_set_transform_params(CoordContext *ctx, MapDatum from, MapDatum to,
-                               const DatumTransform *params)
+int coord_convert_typed_packed(CoordContext *ctx, const GeoBatch *src,
+                               CoordFormat target_format, MapDatum target_datum,
+                               CoordValue *results)
 {
-    if (!ctx || from >= DATUM_MAX || to >= DATUM_MAX || !params)
+    if (!geo_batch_usable(src))
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    ctx->transforms[from][to] = *params;
-    // Set inverse transform parameters (correct 7-parameter inverse)
-    if (from != to)
+    return typed_batch(ctx, NULL, src, src->count, NULL, target_format,
+                       target_datum, results);
+}
+
+int coord_convert_typed_packed_ordered(CoordContext *ctx, const GeoBatch *src,
+                                       const size_t *order,
+                                       CoordFormat target_format,
+                                       MapDatum target_datum,
+                                       CoordValue *results)
+{
+    if (!geo_batch_usable(src) || (src->count > 0 && !order))
     {
-        // Correct formula for 7-parameter inverse transform:
-        // Inverse transform requires inversion via rotation matrix
-        // If forward: X2 = T + s*R*X1
-        // Then inverse: X1 = (-1/s)*R^T*(X2-T) = (-1/s)*R^T*X2 + (1/s)*R^T*T
-        //
-        // For small-angle approximation (arc-seconds), inverse params are approximately:
-        // Inverse translation = -R^T * T / (1+s)
-        // Inverse rotation ≈ -rotation (but more accurate calc needed)
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    return typed_batch(ctx, NULL, src, src->count, order, target_format,
+                       target_datum, results);
+}
 
-        double s = params->scale * PPM_TO_SCALE;
+// ==================== Display sessions ====================
+#define DISPLAY_MAX_DECIMALS 6
+#define DISPLAY_MAX_DIGITS 5
+#define DISPLAY_SKIP_STEP 1e-3      // Largest move checked against the slack (radians)
+#define DISPLAY_SCALE_BOUND 1.01    // Bound on grid scale over ground distance
 
-        // Build rotation matrix R
-        // R = Rz(θz) * Ry(θy) * Rx(θx)
-        // For small angles, can be approximated as:
-        // R ≈ [ 1    -rz    ry
-        //       rz     1   -rx
-        //      -ry    rx     1 ]
+static const int64_t DISPLAY_POW10[7] =
+{
+    1, 10, 100, 1000, 10000, 100000, 1000000
+};
 
-        // Compute inverse transform parameters
-        // Inverse scale factor
-        ctx->transforms[to][from].scale = -params->scale;
+// Units per degree of the last field of DD, DMM or DMS
+static int64_t display_angle_units(CoordFormat format, int decimals)
+{
+    int64_t per_degree = format == COORD_FORMAT_DMS ? 3600 :
+                         format == COORD_FORMAT_DMM ? 60 : 1;
+    return per_degree * DISPLAY_POW10[decimals];
+}
 
-        // Inverse rotation parameters (approximate, for small angles)
-        ctx->transforms[to][from].rx = -params->rx;
-        ctx->transforms[to][from].ry = -params->ry;
-        ctx->transforms[to][from].rz = -params->rz;
+// Key of an angle: magnitude rounded to the last displayed unit, hemisphere
+// in bit 0. Rounding the whole angle carries into minutes and degrees, so
+// 59.996" is shown as the next minute rather than 60.00".
+static int64_t display_angle_key(double value, int64_t units)
+{
+    return (int64_t)nearbyint(fabs(value) * (double)units) * 2 + (value < 0.0);
+}
 
-        // Inverse translation parameters: T_back = -(dx,dy,dz) / (1+s)
-        // More accurate calculation requires considering rotation matrix transpose
-        double factor = 1.0 / (1.0 + s);
-        ctx->transforms[to][from].dx = -params->dx * factor;
-        ctx->transforms[to][from].dy = -params->dy * factor;
-        ctx->transforms[to][from].dz = -params->dz * factor;
+static void display_format_angle(CoordFormat format, int decimals, int64_t key,
+                                 const char *hemispheres, char *buffer,
+                                 size_t buffer_size)
+{
+    int64_t scale = DISPLAY_POW10[decimals];
+    int64_t whole = (key >> 1) / scale;
+    char dir = hemispheres[key & 1];
+    char fraction[DISPLAY_MAX_DECIMALS + 2] = "";
+    if (decimals > 0)
+    {
+        int64_t digits = (key >> 1) % scale;
+        fraction[0] = '.';
+        for (int d = decimals; d > 0; d--, digits /= 10)
+        {
+            fraction[d] = (char)('0' + digits % 10);
+        }
+        fraction[decimals + 1] = '\0';
+    }
+    switch (format)
+    {
+        case COORD_FORMAT_DD:
+            snprintf(buffer, buffer_size, "%d%s°%c", (int)whole, fraction, dir);
+            break;
+        case COORD_FORMAT_DMM:
+            snprintf(buffer, buffer_size, "%d°%d%s'%c", (int)(whole / 60),
+                     (int)(whole % 60), fraction, dir);
+            break;
+        default:
+            snprintf(buffer, buffer_size, "%d°%d'%d%s\"%c", (int)(whole / 3600),
+                     (int)(whole / 60 % 60), (int)(whole % 60), fraction, dir);
+            break;
+    }
+}
 
-        // For small angles, add rotation correction term
-        // Correction: T_back ≈ -(T + R×T) / (1+s)
-        // Here we use first-order approximation
-        double dx_corr = params->ry * params->dz - params->rz * params->dy;
-        double dy_corr = params->rz * params->dx - params->rx * params->dz;
-        double dz_corr = params->rx * params->dy - params->ry * params->dx;
-        // Adjustment for converting arc-seconds to radians
-        dx_corr *= ARC_SEC_TO_RAD;
-        dy_corr *= ARC_SEC_TO_RAD;
-        dz_corr *= ARC_SEC_TO_RAD;
+// Metres per displayed grid digit; precision is at most DISPLAY_MAX_DIGITS here
+static double display_grid_unit(int precision)
+{
+    return (double)DISPLAY_POW10[DISPLAY_MAX_DIGITS - precision];
+}
 
-        ctx->transforms[to][from].dx -= dx_corr * factor;
-        ctx->transforms[to][from].dy -= dy_corr * factor;
-        ctx->transforms[to][from].dz -= dz_corr * factor;
+// Field text from its key
+static void display_format_field(CoordDisplaySession *session, int field)
+{
+    int64_t key = session->keys[field];
+    char *buffer = session->fields[field];
+    size_t size = sizeof(session->fields[field]);
+    int digits = session->precision;
+    switch (session->format)
+    {
+        case COORD_FORMAT_DD:
+        case COORD_FORMAT_DMM:
+        case COORD_FORMAT_DMS:
+            display_format_angle(session->format, digits, key,
+                                 field == 0 ? "NS" : "EW", buffer, size);
+            break;
+        case COORD_FORMAT_UTM:
+            if (field == 0)
+            {
+                snprintf(buffer, size, "%d%c", (int)(key >> 8), (char)(key & 0xFF));
+            }
+            else
+            {
+                snprintf(buffer, size, "%.0f%c", (double)key * display_grid_unit(digits),
+                         field == 1 ? 'E' : 'N');
+            }
+            break;
+        default:
+            if (field == 0)
+            {
+                snprintf(buffer, size, "%d%c", (int)(key >> 8), (char)(key & 0xFF));
+            }
+            else if (field == 1)
+            {
+                snprintf(buffer, size, "%c%c", (char)(key >> 8), (char)(key & 0xFF));
+            }
+            else
+            {
+                snprintf(buffer, size, "%0*d", digits, (int)key);
+            }
+            break;
     }
-    return COORD_SUCCESS;
 }
 
-int coord_get_transform_params(CoordContext *ctx, MapDatum from, MapDatum to,
-                               DatumTransform *params)
+// Whole string from the fields
+static void display_join(CoordDisplaySession *session)
 {
-    if (!ctx || from >= DATUM_MAX || to >= DATUM_MAX || !params)
+    const char *separator = is_geographic_format(session->format) ? ", " : " ";
+    size_t separator_length = strlen(separator);
+    size_t length = 0;
+    for (int i = 0; i < session->field_count; i++)
     {
-        return COORD_ERROR_INVALID_INPUT;
+        size_t n = strlen(session->fields[i]);
+        if (i > 0)
+        {
+            memcpy(session->text + length, separator, separator_length);
+            length += separator_length;
+        }
+        memcpy(session->text + length, session->fields[i], n);
+        length += n;
     }
-    *params = ctx->transforms[from][to];
-    return COORD_SUCCESS;
+    session->text[length] = '\0';
 }
 
-// ==================== Ellipsoid utility functions ====================
-const Ellipsoid *coord_get_ellipsoid(MapDatum datum)
+// Whether a fix is certain to stay in the cell of the anchor. The grid
+// displacement is at most the ground distance times the grid scale, and the
+// ground distance is bounded with the largest radius of curvature (a / (1 - f))
+// and the larger of the two latitude cosines.
+static int display_in_cell(const CoordDisplaySession *session,
+                           const GeoCoord *geo)
 {
-    if (datum >= DATUM_MAX)
+    double dlat = coord_deg_to_rad(geo->latitude - session->anchor.latitude);
+    double dlon = coord_deg_to_rad(geo->longitude - session->anchor.longitude);
+    if (!(fabs(dlat) < DISPLAY_SKIP_STEP && fabs(dlon) < DISPLAY_SKIP_STEP))
     {
-        return NULL;
+        return 0;
     }
-    return &ELLIPSOIDS[datum];
+    int zone;
+    char band;
+    utm_classify(geo->longitude, geo->latitude, &zone, &band);
+    if (((int64_t)zone << 8 | (unsigned char)band) != session->keys[0])
+    {
+        return 0;
+    }
+    const Ellipsoid *ell = &session->ctx->ellipsoid;
+    double reach = DISPLAY_SCALE_BOUND * ell->a / (1.0 - ell->f) *
+                   hypot(dlat, dlon * (session->anchor_cos + fabs(dlat)));
+    return reach < session->slack;
 }
 
-int coord_set_custom_ellipsoid(CoordContext *ctx, double a, double f)
+// Grid keys of a projected fix, rounded as coord_format_utm() and
+// coord_format_mgrs() round; also moves the anchor there. Only UTM and MGRS
+// sessions get here, so precision is at most DISPLAY_MAX_DIGITS.
+static void display_grid_keys(CoordDisplaySession *session, const GeoCoord *geo,
+                              const UTMPoint *utm, int64_t *keys)
 {
-    if (!ctx || a <= 0.0 || f <= 0.0)
+    double unit = display_grid_unit(session->precision);
+    double easting = utm->easting;
+    double northing = utm->northing;
+    keys[0] = (int64_t)utm->zone << 8 | (unsigned char)utm->band;
+    // Displayed digits change half a unit either side of the rounded value
+    double east_slack = 0.5 * unit - fabs(easting - nearbyint(easting / unit) * unit);
+    double north_slack = 0.5 * unit - fabs(northing - nearbyint(northing / unit) * unit);
+    if (session->format == COORD_FORMAT_MGRS)
+    {
+        MGRSPoint mgrs;
+        mgrs_from_utm_unchecked(utm, &mgrs);
+        keys[1] = (int64_t)mgrs.square[0] << 8 | (unsigned char)mgrs.square[1];
+        keys[2] = (int64_t)nearbyint(mgrs.easting / unit);
+        keys[3] = (int64_t)nearbyint(mgrs.northing / unit);
+        // The square letters change on the 100 km lines, inside a rounded cell
+        east_slack = fmin(east_slack, fmin(mgrs.easting, 100000.0 - mgrs.easting));
+        north_slack = fmin(north_slack, fmin(mgrs.northing, 100000.0 - mgrs.northing));
+    }
+    else
     {
-        return COORD_ERROR_INVALID_INPUT;
+        keys[1] = (int64_t)nearbyint(easting / unit);
+        keys[2] = (int64_t)nearbyint(northing / unit);
     }
-    ctx->ellipsoid.a = a;
-    ctx->ellipsoid.f = f;
-    ctx->ellipsoid.b = a * (1.0 - f);
-    ctx->ellipsoid.e2 = 2 * f - f * f;
-    ctx->ellipsoid.ep2 = ctx->ellipsoid.e2 / (1.0 - ctx->ellipsoid.e2);
-    ctx->ellipsoid.name = "Custom";
-    // Reinitialize GeographicLib geodesic object
-    geod_init(ctx->geod, a, f);
-    return COORD_SUCCESS;
+    session->slack = fmin(east_slack, north_slack);
+    session->anchor = *geo;
+    session->anchor_cos = cos(coord_deg_to_rad(geo->latitude));
 }
 
-// ==================== Error handling functions ====================
-const char *coord_get_error_string(int error_code)
+int coord_display_init(CoordContext *ctx, CoordFormat format, MapDatum datum,
+                       int precision, CoordDisplaySession *session)
 {
-    if (error_code < 0
-            || error_code >= (int)(sizeof(ERROR_MESSAGES) / sizeof(ERROR_MESSAGES[0])))
+    if (!ctx || !session || datum >= DATUM_MAX)
     {
-        return "Unknown error";
+        return COORD_ERROR_INVALID_INPUT;
     }
-    return ERROR_MESSAGES[error_code];
+    int max_precision;
+    switch (format)
+    {
+        case COORD_FORMAT_DD:
+        case COORD_FORMAT_DMM:
+        case COORD_FORMAT_DMS:
+            max_precision = DISPLAY_MAX_DECIMALS;
+            break;
+        case COORD_FORMAT_UTM:
+        case COORD_FORMAT_MGRS:
+            max_precision = DISPLAY_MAX_DIGITS;
+            break;
+        default:
+            return COORD_ERROR_UNSUPPORTED_FORMAT;
+    }
+    if (precision < 0 || precision > max_precision)
+    {
+        return COORD_ERROR_INVALID_INPUT;
+    }
+    memset(session, 0, sizeof(*session));
+    session->ctx = ctx;
+    session->format = format;
+    session->datum = datum;
+    session->precision = precision;
+    if (format == COORD_FORMAT_UTM)
+    {
+        session->field_count = 3;
+    }
+    else if (format == COORD_FORMAT_MGRS)
+    {
+        session->field_count = precision > 0 ? 4 : 2;
+    }
+    else
+    {
+        session->field_count = 2;
+    }
+    return COORD_SUCCESS;
 }
 
-void coord_set_error_callback(void (*callback)(int, const char *))
+void coord_display_reset(CoordDisplaySession *session)
 {
-    error_callback = callback;
+    if (session)
+    {
+        session->shown = 0;
+        session->projected_count = 0;
+        session->skipped_count = 0;
+    }
 }
 
-// ==================== Main format conversion function ====================
-int coord_convert(CoordContext *ctx, const GeoCoord *src,
-                  CoordFormat target_format, MapDatum target_datum,
-                  char *result_buffer, size_t buffer_size)
+int coord_display_update(CoordDisplaySession *session, const GeoCoord *fix,
+                         unsigned *changed)
 {
-    if (!ctx || !src || !result_buffer)
+    if (!session || !session->ctx || !fix || !changed || fix->datum >= DATUM_MAX)
     {
         return COORD_ERROR_INVALID_INPUT;
     }
-    if (!coord_validate_point(src))
+    *changed = 0;
+    if (!coord_validate_point(fix))
     {
         return COORD_ERROR_INVALID_COORD;
     }
-    // Convert to target datum
-    GeoCoord target_geo;
-    if (src->datum != target_datum)
+    const CoordContext *ctx = session->ctx;
+    GeoCoord geo;
+    datum_convert_unchecked(ctx, fix, session->datum, ctx->shift_method, &geo);
+    int64_t keys[COORD_DISPLAY_MAX_FIELDS];
+    if (is_geographic_format(session->format))
     {
-        int ret = coord_convert_datum(ctx, src, target_datum, &target_geo);
-        if (ret != COORD_SUCCESS)
-        {
-            return ret;
-        }
+        int64_t units = display_angle_units(session->format, session->precision);
+        keys[0] = display_angle_key(geo.latitude, units);
+        keys[1] = display_angle_key(geo.longitude, units);
     }
     else
     {
-        target_geo = *src;
-    }
-    // Format according to target format
-    switch (target_format)
-    {
-        case COORD_FORMAT_DD:
-        case COORD_FORMAT_DMM:
-        case COORD_FORMAT_DMS:
-            return coord_format_to_string(&target_geo, target_format, result_buffer,
-                                          buffer_size);
-        case COORD_FORMAT_UTM:
-        {
-            UTMPoint utm;
-            int ret = coord_to_utm(ctx, &target_geo, &utm);
-            if (ret != COORD_SUCCESS)
-            {
-                return ret;
-            }
-            return coord_format_utm(&utm, result_buffer, buffer_size);
-        }
-        case COORD_FORMAT_MGRS:
+        if (session->shown && display_in_cell(session, &geo))
         {
-            MGRSPoint mgrs;
-            int ret = coord_to_mgrs(ctx, &target_geo, &mgrs);
-            if (ret != COORD_SUCCESS)
-            {
-                return ret;
-            }
-            return coord_format_mgrs(&mgrs, result_buffer, buffer_size);
+            session->skipped_count++;
+            return COORD_SUCCESS;
         }
-        case COORD_FORMAT_BRITISH_GRID:
+        UTMPoint utm;
+        int ret = utm_from_geo_unchecked(ctx, &geo, &utm);
+        if (ret != COORD_SUCCESS)
         {
-            BritishGridPoint bg;
-            int ret = coord_to_british_grid(ctx, &target_geo, &bg);
-            if (ret != COORD_SUCCESS)
-            {
-                return ret;
-            }
-            return coord_format_british_grid(&bg, result_buffer, buffer_size);
+            return ret;
         }
-        case COORD_FORMAT_JAPAN_GRID:
+        display_grid_keys(session, &geo, &utm, keys);
+        session->projected_count++;
+    }
+    unsigned mask = 0;
+    for (int i = 0; i < session->field_count; i++)
+    {
+        if (!session->shown || keys[i] != session->keys[i])
         {
-            JapanGridPoint jg;
-            int ret = coord_to_japan_grid(ctx, &target_geo, &jg);
-            if (ret != COORD_SUCCESS)
-            {
-                return ret;
-            }
-            return coord_format_japan_grid(&jg, result_buffer, buffer_size);
+            session->keys[i] = keys[i];
+            display_format_field(session, i);
+            mask |= 1u << i;
         }
-        default:
-            return COORD_ERROR_UNSUPPORTED_FORMAT;
     }
+    if (mask)
+    {
+        display_join(session);
+    }
+    session->shown = 1;
+    *changed = mask;
+    return COORD_SUCCESS;
 }
@@ -32,6 +32,9 @@ typedef enum
     COORD_FORMAT_MGRS,          // MGRS coordinates (default)
     COORD_FORMAT_BRITISH_GRID,  // British National Grid
     COORD_FORMAT_JAPAN_GRID,    // Japan grid
+    COORD_FORMAT_WEB_MERCATOR,  // Web Mercator XYZ tile and pixel
+    COORD_FORMAT_GEOHASH,       // Geohash (base-32 cell, up to 12 characters)
+    COORD_FORMAT_QUADKEY,       // Bing Maps quadkey (Web Mercator tile path)
     COORD_FORMAT_MAX
 } CoordFormat;
 
@@ -68,6 +71,15 @@ typedef struct
     double scale;               // Scale factor (ppm)
 } DatumTransform;
 
+// Datum shift method
+typedef enum
+{
+    DATUM_SHIFT_HELMERT = 0,            // Geodetic->ECEF->7-parameter->geodetic (default)
+    DATUM_SHIFT_MOLODENSKY,             // Standard Molodensky (dx, dy, dz and ellipsoid deltas)
+    DATUM_SHIFT_ABRIDGED_MOLODENSKY,    // Abridged Molodensky (no height terms)
+    DATUM_SHIFT_MAX
+} DatumShiftMethod;
+
 // Geographic coordinate
 typedef struct
 {
@@ -118,6 +130,58 @@ typedef struct
     MapDatum datum;             // Datum
 } JapanGridPoint;
 
+// Web Mercator (EPSG:3857) XYZ tile with the pixel offset inside the tile.
+// Tiles are 256 pixels square, numbered from the north-west corner.
+typedef struct
+{
+    int zoom;                   // Zoom level (0-30)
+    int x;                      // Tile column (0 to 2^zoom - 1)
+    int y;                      // Tile row (0 to 2^zoom - 1, north to south)
+    double pixel_x;             // Pixel offset in the tile (0-256, east)
+    double pixel_y;             // Pixel offset in the tile (0-256, south)
+    MapDatum datum;             // Datum (always WGS84)
+} WebMercatorPoint;
+
+// Geohash cell; the precision is the string length (1-12). The hash encodes
+// latitude/longitude on the recorded datum.
+typedef struct
+{
+    char hash[13];              // Geohash characters
+    MapDatum datum;             // Datum of the encoded coordinate
+} GeohashPoint;
+
+// Quadkey: one base-4 digit per zoom level (1-30) of the Web Mercator tile
+typedef struct
+{
+    char key[31];               // Quadkey digits ('0'-'3')
+    MapDatum datum;             // Datum (always WGS84)
+} QuadkeyPoint;
+
+// Earth-centered, Earth-fixed coordinate
+typedef struct
+{
+    double x;                   // X (meters)
+    double y;                   // Y (meters)
+    double z;                   // Z (meters)
+    MapDatum datum;             // Datum (selects the ellipsoid)
+} ECEFPoint;
+
+// Local tangent plane coordinate (East-North-Up)
+typedef struct
+{
+    double east;                // East (meters)
+    double north;               // North (meters)
+    double up;                  // Up (meters)
+} ENUPoint;
+
+// Local tangent plane origin with cached ECEF position and rotation
+typedef struct
+{
+    GeoCoord origin;            // Origin geographic coordinate
+    double ecef[3];             // Origin ECEF position (meters)
+    double rotation[3][3];      // ECEF->ENU rotation (rows: east, north, up)
+} LocalOrigin;
+
 // Parse result
 typedef struct
 {
@@ -136,14 +200,173 @@ typedef struct
     double azimuth2;            // Reverse azimuth (degrees)
 } GeodesicResult;
 
+// Interpolation kernel for projection meshes
+typedef enum
+{
+    MESH_INTERP_BILINEAR = 0,   // Bilinear on cell corners
+    MESH_INTERP_BICUBIC,        // Bicubic Hermite using corner derivatives
+    MESH_INTERP_MAX
+} MeshInterp;
+
+// Result of a typed conversion; format selects the active member
+typedef struct
+{
+    CoordFormat format;
+    union
+    {
+        GeoCoord geo;           // DD, DMM, DMS
+        UTMPoint utm;
+        MGRSPoint mgrs;
+        BritishGridPoint bg;
+        JapanGridPoint jg;
+        WebMercatorPoint wm;
+        GeohashPoint gh;
+        QuadkeyPoint qk;
+    } value;
+} CoordValue;
+
+// Packed batch of geographic points with one datum for the whole batch.
+// Element i of each array is at index i * stride: stride 1 for separate
+// lat/lon/alt arrays, stride 2 for interleaved 16-byte lat/lon pairs
+// (lon = lat + 1). alt may be NULL when altitude is not needed (reads as 0).
+typedef struct
+{
+    double *lat;                // Latitudes (degrees)
+    double *lon;                // Longitudes (degrees)
+    double *alt;                // Altitudes (meters), optional
+    size_t stride;              // Element spacing, in doubles
+    size_t count;               // Number of points
+    MapDatum datum;             // Datum of every point
+} GeoBatch;
+
+// Packed UTM results: easting/northing follow the GeoBatch stride rules, zone
+// and band are plain per-point arrays; convergence and scale factor are not
+// stored
+typedef struct
+{
+    double *easting;            // Eastings (meters)
+    double *northing;           // Northings (meters)
+    unsigned char *zone;        // UTM zones (1-60)
+    char *band;                 // Latitude bands (C-X)
+    size_t stride;              // Element spacing of easting/northing
+    size_t count;               // Number of points
+    MapDatum datum;             // Datum of every point
+} UTMBatch;
+
+// Space-filling curve used to order batches for locality
+typedef enum
+{
+    LOCALITY_MORTON = 0,        // Z-order (bit interleave)
+    LOCALITY_HILBERT,           // Hilbert curve (no long jumps between quadrants)
+    LOCALITY_MAX
+} LocalityCurve;
+
+// Adaptive interpolation mesh for bulk projection (see coord_mesh_create)
+typedef struct ProjectionMesh ProjectionMesh;
+
+// Per-cell counts and sums over UTM/MGRS or British Grid squares (see
+// coord_grid_agg_create)
+typedef struct GridAggregator GridAggregator;
+
+typedef struct
+{
+    uint64_t key;               // Cell key (see coord_grid_cell_label)
+    uint64_t count;             // Points in the cell
+    double sum;                 // Sum of the per-point values
+} GridCell;
+
+// Allocation hooks; user_data is passed through unchanged
+typedef void *(*CoordMallocFn)(size_t size, void *user_data);
+typedef void *(*CoordReallocFn)(void *ptr, size_t size, void *user_data);
+typedef void (*CoordFreeFn)(void *ptr, void *user_data);
+
+typedef struct
+{
+    CoordMallocFn malloc_fn;    // NULL selects the C library allocator
+    CoordReallocFn realloc_fn;
+    CoordFreeFn free_fn;
+    void *user_data;
+} CoordAllocator;
+
 // Coordinate transform context
 typedef struct
 {
-    struct geod_geodesic *geod;  // Pointer to GeographicLib geodesic object
+    struct geod_geodesic *geod;  // GeographicLib geodesic, created on first use
     Ellipsoid ellipsoid;        // Current ellipsoid
-    DatumTransform transforms[DATUM_MAX][DATUM_MAX]; // Transform parameter table
+    // Transform parameter table: the shared defaults until
+    // coord_set_transform_params() gives the context its own copy
+    const DatumTransform (*transforms)[DATUM_MAX];
+    DatumShiftMethod shift_method;  // Method used by coord_convert_datum()
+    int tile_zoom;              // Zoom of COORD_FORMAT_WEB_MERCATOR conversions
+    size_t mesh_max_cells;      // Cell budget of coord_mesh_create()
+    CoordAllocator allocator;   // Used for memory owned by context operations
+    CoordAllocator owner;       // Allocator that created the context itself
 } CoordContext;
 
+// Stateful UTM projector for dense tracks
+// Points near the last exact evaluation (the anchor) are projected with a
+// second-order expansion; the projector re-anchors when the error bound,
+// zone or band would be exceeded.
+typedef struct
+{
+    CoordContext *ctx;          // Context providing the ellipsoid
+    double max_error;           // Allowed expansion error (meters)
+    double radius;              // Expansion radius around the anchor (degrees)
+    int anchored;               // Anchor valid flag
+    GeoCoord anchor;            // Last exactly projected point
+    UTMPoint anchor_utm;        // Exact projection of the anchor
+    double jacobian[2][2];      // d(easting, northing)/d(lat, lon) (m/degree)
+    double hessian[2][3];       // d2/dlat2, d2/dlat.dlon, d2/dlon2 (m/degree^2)
+    double convergence_gradient[2]; // d(convergence)/d(lat, lon)
+    unsigned long exact_count;  // Full series evaluations (anchors and probes)
+    unsigned long approx_count; // Points served by the expansion
+} UTMTrackProjector;
+
+// Display session for text redrawn on every fix (watch faces): keeps what is
+// on screen per field and reformats only the fields whose digits change. The
+// fields are latitude and longitude for DD/DMM/DMS; zone+band, easting and
+// northing for UTM; zone+band, 100 km square, easting and northing for MGRS.
+#define COORD_DISPLAY_MAX_FIELDS 4
+typedef struct
+{
+    CoordContext *ctx;          // Context providing the ellipsoid and datum shifts
+    CoordFormat format;         // DD, DMM, DMS, UTM or MGRS
+    MapDatum datum;             // Datum of the displayed coordinates
+    int precision;              // Decimals (DD/DMM/DMS) or digits per axis (UTM/MGRS)
+    int shown;                  // Fields hold a rendered fix
+    int field_count;            // Fields used by the format
+    int64_t keys[COORD_DISPLAY_MAX_FIELDS];     // Displayed value of each field
+    char fields[COORD_DISPLAY_MAX_FIELDS][24];  // Text of each field
+    char text[96];              // Whole string, fields joined as coord_convert() does
+    GeoCoord anchor;            // Last projected fix (UTM/MGRS, display datum)
+    double anchor_cos;          // Cosine of the anchor latitude
+    double slack;               // Distance from the anchor to its cell edges (meters)
+    unsigned long projected_count;  // Fixes that needed the projection
+    unsigned long skipped_count;    // Fixes shown to stay in the displayed cell
+} CoordDisplaySession;
+
+// Quantization used by the compressed track codec
+typedef enum
+{
+    TRACK_CODEC_E7 = 0,         // Latitude/longitude in 1e-7 degrees (~1 cm)
+    TRACK_CODEC_UTM_CM,         // Easting/northing in centimetres, one zone per track
+    TRACK_CODEC_MAX
+} TrackCodec;
+
+// Streaming decoder over an encoded track (see coord_track_decoder_init)
+typedef struct
+{
+    CoordContext *ctx;          // Context providing the ellipsoid
+    const unsigned char *data;  // Encoded track
+    size_t size;                // Encoded size (bytes)
+    size_t pos;                 // Read offset
+    size_t remaining;           // Points not yet decoded
+    TrackCodec codec;           // Quantization
+    MapDatum datum;             // Datum of every point
+    int zone;                   // UTM zone (TRACK_CODEC_UTM_CM)
+    int64_t value[2];           // Last decoded quantized pair
+} TrackDecoder;
+
 // ============================ Public API ============================
 
 // Error codes
@@ -163,6 +386,15 @@ typedef struct
 CoordContext *coord_create_context(MapDatum datum);
 void coord_destroy_context(CoordContext *ctx);
 int coord_set_datum(CoordContext *ctx, MapDatum datum);
+// Allocator hooks: pass all three functions, or all NULL for malloc/realloc/free.
+// The global allocator is used for new contexts and deserialized meshes; a
+// context keeps it for its own lifetime and can override it for the memory
+// its operations allocate (meshes, lattice scratch space).
+int coord_set_allocator(CoordMallocFn malloc_fn, CoordReallocFn realloc_fn,
+                        CoordFreeFn free_fn, void *user_data);
+int coord_context_set_allocator(CoordContext *ctx, CoordMallocFn malloc_fn,
+                                CoordReallocFn realloc_fn, CoordFreeFn free_fn,
+                                void *user_data);
 
 // ==================== Parsing functions ====================
 ParseResult coord_parse_string(const char *str, CoordFormat format,
@@ -181,13 +413,38 @@ int coord_format_british_grid(const BritishGridPoint *bg, char *buffer,
                               size_t buffer_size);
 int coord_format_japan_grid(const JapanGridPoint *jg, char *buffer,
                             size_t buffer_size);
+int coord_format_web_mercator(const WebMercatorPoint *wm, char *buffer,
+                              size_t buffer_size);
+int coord_format_geohash(const GeohashPoint *gh, char *buffer,
+                         size_t buffer_size);
+int coord_format_quadkey(const QuadkeyPoint *qk, char *buffer,
+                         size_t buffer_size);
 
 // ==================== Coordinate conversion functions ====================
 // Geographic coordinate to other formats
 int coord_to_utm(CoordContext *ctx, const GeoCoord *geo, UTMPoint *utm);
 int coord_from_utm(CoordContext *ctx, const UTMPoint *utm, GeoCoord *geo);
+// Forced-zone projection (e.g. a neighbouring zone for features that straddle
+// a boundary); accuracy follows the series and degrades beyond ~9 degrees
+// from the central meridian
+int coord_to_utm_zone(CoordContext *ctx, const GeoCoord *geo, int zone,
+                      UTMPoint *utm);
+// Direct zone-to-zone transform without a geographic round trip
+int coord_utm_to_zone(CoordContext *ctx, const UTMPoint *src, int zone,
+                      UTMPoint *dst);
+int coord_utm_to_zone_batch(CoordContext *ctx, const UTMPoint *src,
+                            size_t count, int zone, UTMPoint *dst);
+// Incremental UTM projection of successive track points
+int coord_track_projector_init(CoordContext *ctx, double max_error,
+                               UTMTrackProjector *proj);
+int coord_track_project(UTMTrackProjector *proj, const GeoCoord *geo,
+                        UTMPoint *utm);
+void coord_track_projector_reset(UTMTrackProjector *proj);
 int coord_to_mgrs(CoordContext *ctx, const GeoCoord *geo, MGRSPoint *mgrs);
 int coord_from_mgrs(CoordContext *ctx, const MGRSPoint *mgrs, GeoCoord *geo);
+// MGRS <-> UTM lettering only (no projection math)
+int coord_utm_to_mgrs(const UTMPoint *utm, MGRSPoint *mgrs);
+int coord_mgrs_to_utm(const MGRSPoint *mgrs, UTMPoint *utm);
 int coord_to_british_grid(CoordContext *ctx, const GeoCoord *geo,
                           BritishGridPoint *bg);
 int coord_from_british_grid(CoordContext *ctx, const BritishGridPoint *bg,
@@ -196,10 +453,224 @@ int coord_to_japan_grid(CoordContext *ctx, const GeoCoord *geo,
                         JapanGridPoint *jg);
 int coord_from_japan_grid(CoordContext *ctx, const JapanGridPoint *jg,
                           GeoCoord *geo);
+// Web Mercator tiles are WGS84: other datums are shifted with the context's
+// method first. Latitudes beyond +-85.0511 degrees are out of range.
+// COORD_FORMAT_WEB_MERCATOR conversions use the context zoom (default 18).
+int coord_to_web_mercator(CoordContext *ctx, const GeoCoord *geo, int zoom,
+                          WebMercatorPoint *wm);
+int coord_from_web_mercator(CoordContext *ctx, const WebMercatorPoint *wm,
+                            GeoCoord *geo);
+int coord_set_tile_zoom(CoordContext *ctx, int zoom);
+int coord_to_web_mercator_packed(CoordContext *ctx, const GeoBatch *geo,
+                                 int zoom, WebMercatorPoint *wm);
+// geo->lat/lon and stride are set by the caller; geo->count and datum are set
+// from the input (WGS84)
+int coord_from_web_mercator_packed(CoordContext *ctx,
+                                   const WebMercatorPoint *wm, size_t count,
+                                   GeoBatch *geo);
+// Tile indices only, through 32-bit fixed-point map coordinates (a shift per
+// zoom level); matches coord_to_web_mercator() tile for tile
+int coord_web_mercator_tiles(CoordContext *ctx, const GeoBatch *geo, int zoom,
+                             uint32_t *tile_x, uint32_t *tile_y);
+// Geohash and quadkey cells, encoded by bit interleaving (pdep/pext when
+// built with BMI2). COORD_FORMAT_GEOHASH uses 12 characters and
+// COORD_FORMAT_QUADKEY the context tile zoom. Decoding returns the cell
+// centre.
+int coord_to_geohash(CoordContext *ctx, const GeoCoord *geo, int precision,
+                     GeohashPoint *gh);
+int coord_from_geohash(CoordContext *ctx, const GeohashPoint *gh,
+                       GeoCoord *geo);
+int coord_to_quadkey(CoordContext *ctx, const GeoCoord *geo, int zoom,
+                     QuadkeyPoint *qk);
+int coord_from_quadkey(CoordContext *ctx, const QuadkeyPoint *qk,
+                       GeoCoord *geo);
+int coord_to_geohash_packed(CoordContext *ctx, const GeoBatch *geo,
+                            int precision, GeohashPoint *gh);
+int coord_to_quadkey_packed(CoordContext *ctx, const GeoBatch *geo, int zoom,
+                            QuadkeyPoint *qk);
+// Integer cells for indexing: 5 * precision geohash bits or 2 * zoom quadkey
+// bits, right-aligned, so code >> (5 * k) (or 2 * k) is the cell k
+// characters shorter and sorted codes keep prefixes together
+int coord_geohash_codes(const GeoBatch *geo, int precision, uint64_t *codes);
+int coord_quadkey_codes(CoordContext *ctx, const GeoBatch *geo, int zoom,
+                        uint64_t *codes);
+
+// UTM/MGRS batches: results match per-point calls and keep the input order.
+// Input is validated up front; nothing is written if a point is invalid.
+int coord_to_utm_batch(CoordContext *ctx, const GeoCoord *geo, size_t count,
+                       UTMPoint *utm);
+int coord_to_mgrs_batch(CoordContext *ctx, const GeoCoord *geo, size_t count,
+                        MGRSPoint *mgrs);
+
+// Compressed tracks: points are quantized, delta-coded against the previous
+// point and stored as zigzag varints (typically 2-6 bytes per point). UTM_CM
+// tracks are projected into the zone of the first point. Altitude is not
+// stored. With buffer == NULL, coord_track_encode() only reports the size.
+int coord_track_encode(CoordContext *ctx, const GeoBatch *geo, TrackCodec codec,
+                       void *buffer, size_t buffer_size, size_t *encoded_size);
+int coord_track_decoder_init(CoordContext *ctx, const void *buffer, size_t size,
+                             TrackDecoder *dec);
+// Decode up to max_points into out (lat/lon arrays and stride set by the
+// caller); out->count is 0 once the track is exhausted
+int coord_track_decode(TrackDecoder *dec, size_t max_points, GeoBatch *out);
+// Track length straight from the quantized deltas (meters)
+int coord_track_length(CoordContext *ctx, const void *buffer, size_t size,
+                       double *length);
+
+// Packed batch views and conversions. Outputs take their count (and datum)
+// from the input; the caller sizes the output arrays.
+GeoBatch coord_geo_batch_soa(double *lat, double *lon, double *alt,
+                             size_t count, MapDatum datum);
+GeoBatch coord_geo_batch_pairs(double *lat_lon, size_t count, MapDatum datum);
+UTMBatch coord_utm_batch_soa(double *easting, double *northing,
+                             unsigned char *zone, char *band, size_t count,
+                             MapDatum datum);
+UTMBatch coord_utm_batch_pairs(double *easting_northing, unsigned char *zone,
+                               char *band, size_t count, MapDatum datum);
+int coord_to_utm_packed(CoordContext *ctx, const GeoBatch *geo, UTMBatch *utm);
+int coord_to_mgrs_packed(CoordContext *ctx, const GeoBatch *geo,
+                         MGRSPoint *mgrs);
+int coord_from_utm_packed(CoordContext *ctx, const UTMBatch *utm,
+                          GeoBatch *geo);
+int coord_convert_datum_packed(CoordContext *ctx, const GeoBatch *src,
+                               MapDatum target_datum, GeoBatch *dst);
+size_t coord_classify_utm_packed(const GeoBatch *geo, int *zones, char *bands);
+
+// Locality pre-pass: order[n] is the index of the n-th point along the curve
+// over the batch bounding box (16 bits per axis). The _ordered batches visit
+// points in that order and still write results at the caller's indices.
+int coord_locality_order(CoordContext *ctx, const GeoBatch *geo,
+                         LocalityCurve curve, size_t *order);
+
+// Prevalidated batch mode: coord_validate_batch() sets bit (i % 64) of
+// valid_mask[i / 64] for each point in range on a known datum and returns the
+// number of valid points. The _trusted conversions then run without per-point
+// checks; points whose bit is clear are projected as (0, 0) with zone 0.
+size_t coord_validate_batch(const GeoCoord *geo, size_t count,
+                            uint64_t *valid_mask);
+int coord_to_utm_batch_trusted(CoordContext *ctx, const GeoCoord *geo,
+                               size_t count, const uint64_t *valid_mask,
+                               UTMPoint *utm);
+int coord_to_mgrs_batch_trusted(CoordContext *ctx, const GeoCoord *geo,
+                                size_t count, const uint64_t *valid_mask,
+                                MGRSPoint *mgrs);
+// Packed forms; the batch datum is checked once and clears every bit if unknown
+size_t coord_validate_packed(const GeoBatch *geo, uint64_t *valid_mask);
+int coord_to_utm_packed_trusted(CoordContext *ctx, const GeoBatch *geo,
+                                const uint64_t *valid_mask, UTMBatch *utm);
+int coord_to_mgrs_packed_trusted(CoordContext *ctx, const GeoBatch *geo,
+                                 const uint64_t *valid_mask, MGRSPoint *mgrs);
+
+// Regular lat/lon lattice to UTM or British Grid (row-major, nlat x nlon)
+// Latitude terms are computed once per row and longitude terms once per column.
+// zones receives the UTM zone per node and may be NULL.
+int coord_project_lattice(CoordContext *ctx, double lat0, double dlat,
+                          size_t nlat, double lon0, double dlon, size_t nlon,
+                          MapDatum datum, CoordFormat format,
+                          double *easting, double *northing, int *zones);
+
+// ==================== Interpolation meshes ====================
+// Sample the exact projection (UTM or British Grid, including the datum
+// shift from 'datum') over a lat/lon window, subdividing cells until the
+// interpolation error at check points is below max_error (meters).
+// UTM meshes use the zone of the window center throughout. A build that
+// would need more cells than the context budget (default 1048576, about
+// 75 MB of samples bilinear or 270 MB bicubic) fails with COORD_ERROR_MEMORY.
+ProjectionMesh *coord_mesh_create(CoordContext *ctx, CoordFormat format,
+                                  MapDatum datum, double lat_min, double lat_max,
+                                  double lon_min, double lon_max,
+                                  double max_error, MeshInterp interp);
+// Budget of 1 to 67108863 cells
+int coord_set_mesh_max_cells(CoordContext *ctx, size_t max_cells);
+void coord_mesh_destroy(ProjectionMesh *mesh);
+size_t coord_mesh_cell_count(const ProjectionMesh *mesh);
+int coord_mesh_eval(const ProjectionMesh *mesh, double lat, double lon,
+                    double *easting, double *northing);
+// Points outside the window get NaN and COORD_ERROR_OUT_OF_RANGE is returned
+int coord_mesh_eval_batch(const ProjectionMesh *mesh, const double *lat,
+                          const double *lon, size_t count,
+                          double *easting, double *northing);
+int coord_mesh_eval_batch_ordered(const ProjectionMesh *mesh,
+                                  const double *lat, const double *lon,
+                                  size_t count, const size_t *order,
+                                  double *easting, double *northing);
+// Packed input; geo->datum must be the datum the mesh was created for
+int coord_mesh_eval_packed(const ProjectionMesh *mesh, const GeoBatch *geo,
+                           double *easting, double *northing);
+int coord_mesh_eval_packed_ordered(const ProjectionMesh *mesh,
+                                   const GeoBatch *geo, const size_t *order,
+                                   double *easting, double *northing);
+// Serialization (native byte order)
+size_t coord_mesh_serialized_size(const ProjectionMesh *mesh);
+int coord_mesh_serialize(const ProjectionMesh *mesh, void *buffer,
+                         size_t buffer_size);
+ProjectionMesh *coord_mesh_deserialize(const void *buffer, size_t size);
+
+// ==================== Grid-cell aggregation ====================
+// Counts (and optional value sums) per 1 m - 100 km square of the UTM, MGRS or
+// British Grid. Cell keys come straight from the projected coordinates; the
+// table is open-addressing and grows as needed. For threads, give each one a
+// context and aggregator and merge them at the end. The context must outlive
+// the aggregator. Points beyond the grid (UTM outside 80S-84N, British Grid
+// outside its 700 x 1300 km extent) are counted separately.
+GridAggregator *coord_grid_agg_create(CoordContext *ctx, CoordFormat format,
+                                      double cell_size);
+void coord_grid_agg_destroy(GridAggregator *agg);
+// values (optional) holds one value per point, summed per cell
+int coord_grid_agg_add(GridAggregator *agg, const GeoBatch *geo,
+                       const double *values);
+int coord_grid_agg_merge(GridAggregator *dst, const GridAggregator *src);
+// Copies the cells sorted by key when max_cells is large enough; returns the
+// number of cells either way
+size_t coord_grid_agg_cells(const GridAggregator *agg, GridCell *cells,
+                            size_t max_cells);
+uint64_t coord_grid_agg_outside(const GridAggregator *agg);
+// Label of a cell: "31U DQ 48 12" (MGRS), "TQ 30 80" (British Grid) or the
+// south-west corner "31U 448000E 5411000N" (UTM)
+int coord_grid_cell_label(const GridAggregator *agg, uint64_t key,
+                          char *buffer, size_t buffer_size);
 
 // Datum conversion
 int coord_convert_datum(CoordContext *ctx, const GeoCoord *src,
                         MapDatum target_datum, GeoCoord *dst);
+// Datum conversion with an explicit shift method (overrides the context method)
+int coord_convert_datum_ex(CoordContext *ctx, const GeoCoord *src,
+                           MapDatum target_datum, DatumShiftMethod method,
+                           GeoCoord *dst);
+// Batch datum conversion using the context method; stops at the first error
+int coord_convert_datum_batch(CoordContext *ctx, const GeoCoord *src,
+                              size_t count, MapDatum target_datum,
+                              GeoCoord *dst);
+// Select the shift method used by coord_convert_datum() and grid conversions
+int coord_set_datum_shift_method(CoordContext *ctx, DatumShiftMethod method);
+
+// ==================== ECEF and local ENU ====================
+int coord_to_ecef(CoordContext *ctx, const GeoCoord *geo, ECEFPoint *ecef);
+int coord_from_ecef(CoordContext *ctx, const ECEFPoint *ecef, GeoCoord *geo);
+int coord_to_ecef_batch(CoordContext *ctx, const GeoCoord *geo, size_t count,
+                        ECEFPoint *ecef);
+int coord_from_ecef_batch(CoordContext *ctx, const ECEFPoint *ecef,
+                          size_t count, GeoCoord *geo);
+// Cache origin ECEF and rotation; points in other datums are shifted first
+int coord_init_local_origin(CoordContext *ctx, const GeoCoord *origin,
+                            LocalOrigin *local);
+int coord_to_enu(CoordContext *ctx, const LocalOrigin *local,
+                 const GeoCoord *geo, ENUPoint *enu);
+int coord_from_enu(CoordContext *ctx, const LocalOrigin *local,
+                   const ENUPoint *enu, GeoCoord *geo);
+int coord_to_enu_batch(CoordContext *ctx, const LocalOrigin *local,
+                       const GeoCoord *geo, size_t count, ENUPoint *enu);
+int coord_from_enu_batch(CoordContext *ctx, const LocalOrigin *local,
+                         const ENUPoint *enu, size_t count, GeoCoord *geo);
+// Packed forms. GeoBatch outputs get their count and datum set; the ECEF
+// points given to coord_from_ecef_packed() must share one datum.
+int coord_to_ecef_packed(CoordContext *ctx, const GeoBatch *geo, ECEFPoint *ecef);
+int coord_from_ecef_packed(CoordContext *ctx, const ECEFPoint *ecef,
+                           size_t count, GeoBatch *geo);
+int coord_to_enu_packed(CoordContext *ctx, const LocalOrigin *local,
+                        const GeoBatch *geo, ENUPoint *enu);
+int coord_from_enu_packed(CoordContext *ctx, const LocalOrigin *local,
+                          const ENUPoint *enu, size_t count, GeoBatch *geo);
 
 // ==================== Geodesic calculations ====================
 int coord_distance(CoordContext *ctx, const GeoCoord *p1, const GeoCoord *p2,
@@ -212,6 +683,10 @@ int coord_inverse(CoordContext *ctx, const GeoCoord *p1, const GeoCoord *p2,
 // ==================== Utility functions ====================
 int coord_get_utm_zone(double longitude, double latitude);
 char coord_get_utm_band(double latitude);
+// Zone and band of every point; invalid points get zone 0 and band 'Z'.
+// Returns the number of valid points.
+size_t coord_classify_utm_batch(const GeoCoord *geo, size_t count, int *zones,
+                                char *bands);
 int coord_validate_point(const GeoCoord *coord);
 int coord_validate_utm(const UTMPoint *utm);
 int coord_is_valid_latitude(double lat);
@@ -222,6 +697,12 @@ double coord_deg_to_rad(double deg);
 double coord_rad_to_deg(double rad);
 double coord_meters_to_feet(double meters);
 double coord_feet_to_meters(double feet);
+// Trig kernels of the UTM, datum and Web Mercator paths: libm, or
+// range-reduced minimax polynomials when the library is built with
+// -DCOORD_FAST_TRIG
+void coord_sincos(double x, double *s, double *c);
+double coord_atan2(double y, double x);
+double coord_asinh(double x);
 
 // ==================== Datum transform utilities ====================
 int coord_set_transform_params(CoordContext *ctx, MapDatum from, MapDatum to,
@@ -241,5 +722,54 @@ void coord_set_error_callback(void (*callback)(int, const char *));
 int coord_convert(CoordContext *ctx, const GeoCoord *src,
                   CoordFormat target_format, MapDatum target_datum,
                   char *result_buffer, size_t buffer_size);
+// Same pipeline as coord_convert() without the string step: fills a tagged
+// value, and also formats it when result_buffer is not NULL
+int coord_convert_typed(CoordContext *ctx, const GeoCoord *src,
+                        CoordFormat target_format, MapDatum target_datum,
+                        CoordValue *result, char *result_buffer,
+                        size_t buffer_size);
+// Batch form (no formatting); stops at the first error
+int coord_convert_typed_batch(CoordContext *ctx, const GeoCoord *src,
+                              size_t count, CoordFormat target_format,
+                              MapDatum target_datum, CoordValue *results);
+int coord_convert_typed_batch_ordered(CoordContext *ctx, const GeoCoord *src,
+                                      size_t count, const size_t *order,
+                                      CoordFormat target_format,
+                                      MapDatum target_datum,
+                                      CoordValue *results);
+int coord_convert_typed_packed(CoordContext *ctx, const GeoBatch *src,
+                               CoordFormat target_format, MapDatum target_datum,
+                               CoordValue *results);
+int coord_convert_typed_packed_ordered(CoordContext *ctx, const GeoBatch *src,
+                                       const size_t *order,
+                                       CoordFormat target_format,
+                                       MapDatum target_datum,
+                                       CoordValue *results);
+// Format a typed value according to its format tag
+int coord_format_value(const CoordValue *value, char *buffer,
+                       size_t buffer_size);
+// Convert a value between any two formats. Values are GeoCoord for DD, DMM
+// and DMS, otherwise the point type of the format. Grid-to-grid routes skip
+// geographic coordinates where possible: MGRS<->UTM is letter arithmetic only,
+// and UTM->UTM re-expresses the point in its natural zone with one inverse
+// and one forward series.
+int coord_convert_any(CoordContext *ctx, CoordFormat src_format,
+                      const void *src, CoordFormat dst_format, void *dst);
+
+// ==================== Display sessions ====================
+// precision: decimals of the last field for DD, DMM and DMS (0-6; coord_convert
+// uses 6, 3 and 2), digits per axis for UTM and MGRS (0-5, 5 = 1 m). Values are
+// rounded as the coord_format_*() functions round them, so at coord_convert()
+// precisions the text is the same as coord_convert() gives, except that angles
+// round as a whole and carry where coord_format_dms() would show 60.00".
+int coord_display_init(CoordContext *ctx, CoordFormat format, MapDatum datum,
+                       int precision, CoordDisplaySession *session);
+// Renders a fix; changed gets bit i set for each field whose text changed, so
+// 0 means the screen is up to date. The first fix after init or reset reports
+// every field. UTM/MGRS fixes that provably stay in the displayed cell skip the
+// projection. On error the session keeps the previous fix.
+int coord_display_update(CoordDisplaySession *session, const GeoCoord *fix,
+                         unsigned *changed);
+void coord_display_reset(CoordDisplaySession *session);
 
 #endif // COORD_TRANSFORM_H
@@ -0,0 +1,498 @@
+/*
+ * =====================================================================================
+ *
+ * Copyright (c) 2026 Zepp Health. All Rights Reserved. This computer program includes
+ * Confidential, Proprietary Information and is a Trade Secret of Zepp Health Ltd.
+ * All use, disclosure, and/or reproduction is prohibited unless authorized in writing.
+ * Licensed under the MIT License. You can contact below email if need.
+ *
+ * version: 0.0.1
+ * Author: wangwenbing@zepp.com
+ *
+ * =====================================================================================
+ */
+
+// CPython bindings over the packed batch APIs. Arrays are taken through the
+// buffer protocol (NumPy arrays, array.array, memoryview) and used in place:
+// inputs and outputs are 1-D double columns with any stride that is a whole
+// number of doubles, so interleaved lat/lon pairs and structured-array fields
+// work without copies. Outputs are preallocated by the caller. The GIL is
+// released while the batch runs; each call uses its own context, so calls
+// from several Python threads run in parallel.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "coord_datum_transform.h"
+
+// A held buffer and its element stride
+typedef struct
+{
+    Py_buffer view;
+    int held;
+    size_t stride;              // Element spacing, in items
+} Column;
+
+static void column_release(Column *col)
+{
+    if (col->held)
+    {
+        PyBuffer_Release(&col->view);
+        col->held = 0;
+    }
+}
+
+// Acquire obj as a 1-D column of doubles ('d') or bytes (itemsize 1);
+// Py_None is accepted (and left unheld) when optional is set
+static int column_get(PyObject *obj, const char *name, int writable,
+                      int bytes, int optional, Column *col)
+{
+    col->held = 0;
+    col->stride = 0;
+    if (obj == Py_None && optional)
+    {
+        return 0;
+    }
+    int flags = PyBUF_STRIDES | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+    if (PyObject_GetBuffer(obj, &col->view, flags) < 0)
+    {
+        return -1;
+    }
+    col->held = 1;
+    const char *format = col->view.format ? col->view.format : "B";
+    if (strchr("@=<", format[0]))
+    {
+        format++;
+    }
+    int format_ok = bytes ? col->view.itemsize == 1 :
+                    (strcmp(format, "d") == 0 && col->view.itemsize == sizeof(double));
+    if (!format_ok || col->view.ndim != 1 || col->view.strides[0] <= 0 ||
+            col->view.strides[0] % col->view.itemsize != 0 ||
+            (bytes && col->view.strides[0] != 1))
+    {
+        PyErr_Format(PyExc_TypeError, "%s must be a 1-D %s array", name,
+                     bytes ? "contiguous 1-byte" : "float64 (stride a multiple of 8)");
+        column_release(col);
+        return -1;
+    }
+    col->stride = (size_t)(col->view.strides[0] / col->view.itemsize);
+    return 0;
+}
+
+static size_t column_length(const Column *col)
+{
+    return (size_t)col->view.shape[0];
+}
+
+// Paired columns of a packed batch must share one stride and one base layout
+static int column_pair_stride(const Column *a, const Column *b,
+                              const char *names)
+{
+    if (a->stride != b->stride)
+    {
+        PyErr_Format(PyExc_ValueError, "%s must have the same stride", names);
+        return -1;
+    }
+    return 0;
+}
+
+static int check_lengths(size_t expected, const Column *cols, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (cols[i].held && column_length(&cols[i]) < expected)
+        {
+            PyErr_SetString(PyExc_ValueError, "output arrays are shorter than the input");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int check_datum(int datum)
+{
+    if (datum < 0 || datum >= DATUM_MAX)
+    {
+        PyErr_Format(PyExc_ValueError, "unknown datum %d", datum);
+        return -1;
+    }
+    return 0;
+}
+
+// None on success, otherwise the library error as a Python exception
+static PyObject *coord_result(int code)
+{
+    if (code == COORD_SUCCESS)
+    {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    PyErr_SetString(code == COORD_ERROR_MEMORY ? PyExc_MemoryError : PyExc_ValueError,
+                    coord_get_error_string(code));
+    return NULL;
+}
+
+static PyObject *py_to_utm(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"lat", "lon", "easting", "northing", "zone", "band",
+                               "datum", NULL
+                              };
+    PyObject *objs[6];
+    int datum = DATUM_WGS84;
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOOO|i", keywords, &objs[0],
+                                     &objs[1], &objs[2], &objs[3], &objs[4], &objs[5],
+                                     &datum) || check_datum(datum) < 0)
+    {
+        return NULL;
+    }
+    Column cols[6];
+    memset(cols, 0, sizeof(cols));
+    PyObject *result = NULL;
+    if (column_get(objs[0], "lat", 0, 0, 0, &cols[0]) < 0 ||
+            column_get(objs[1], "lon", 0, 0, 0, &cols[1]) < 0 ||
+            column_get(objs[2], "easting", 1, 0, 0, &cols[2]) < 0 ||
+            column_get(objs[3], "northing", 1, 0, 0, &cols[3]) < 0 ||
+            column_get(objs[4], "zone", 1, 1, 0, &cols[4]) < 0 ||
+            column_get(objs[5], "band", 1, 1, 0, &cols[5]) < 0 ||
+            column_pair_stride(&cols[0], &cols[1], "lat and lon") < 0 ||
+            column_pair_stride(&cols[2], &cols[3], "easting and northing") < 0)
+    {
+        goto done;
+    }
+    size_t count = column_length(&cols[0]);
+    if (column_length(&cols[1]) != count)
+    {
+        PyErr_SetString(PyExc_ValueError, "lat and lon differ in length");
+        goto done;
+    }
+    if (check_lengths(count, cols + 2, 4) < 0)
+    {
+        goto done;
+    }
+    GeoBatch geo = {(double *)cols[0].view.buf, (double *)cols[1].view.buf, NULL,
+                    cols[0].stride, count, (MapDatum)datum
+                   };
+    UTMBatch utm = {(double *)cols[2].view.buf, (double *)cols[3].view.buf,
+                    (unsigned char *)cols[4].view.buf, (char *)cols[5].view.buf,
+                    cols[2].stride, count, (MapDatum)datum
+                   };
+    CoordContext *ctx = coord_create_context((MapDatum)datum);
+    if (!ctx)
+    {
+        PyErr_NoMemory();
+        goto done;
+    }
+    int ret;
+    Py_BEGIN_ALLOW_THREADS
+    ret = coord_to_utm_packed(ctx, &geo, &utm);
+    Py_END_ALLOW_THREADS
+    coord_destroy_context(ctx);
+    result = coord_result(ret);
+done:
+    for (int i = 0; i < 6; i++)
+    {
+        column_release(&cols[i]);
+    }
+    return result;
+}
+
+static PyObject *py_from_utm(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"easting", "northing", "zone", "band", "lat", "lon",
+                               "datum", NULL
+                              };
+    PyObject *objs[6];
+    int datum = DATUM_WGS84;
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOOO|i", keywords, &objs[0],
+                                     &objs[1], &objs[2], &objs[3], &objs[4], &objs[5],
+                                     &datum) || check_datum(datum) < 0)
+    {
+        return NULL;
+    }
+    Column cols[6];
+    memset(cols, 0, sizeof(cols));
+    PyObject *result = NULL;
+    if (column_get(objs[0], "easting", 0, 0, 0, &cols[0]) < 0 ||
+            column_get(objs[1], "northing", 0, 0, 0, &cols[1]) < 0 ||
+            column_get(objs[2], "zone", 0, 1, 0, &cols[2]) < 0 ||
+            column_get(objs[3], "band", 0, 1, 0, &cols[3]) < 0 ||
+            column_get(objs[4], "lat", 1, 0, 0, &cols[4]) < 0 ||
+            column_get(objs[5], "lon", 1, 0, 0, &cols[5]) < 0 ||
+            column_pair_stride(&cols[0], &cols[1], "easting and northing") < 0 ||
+            column_pair_stride(&cols[4], &cols[5], "lat and lon") < 0)
+    {
+        goto done;
+    }
+    size_t count = column_length(&cols[0]);
+    if (column_length(&cols[1]) != count)
+    {
+        PyErr_SetString(PyExc_ValueError, "easting and northing differ in length");
+        goto done;
+    }
+    if (check_lengths(count, cols + 2, 4) < 0)
+    {
+        goto done;
+    }
+    UTMBatch utm = {(double *)cols[0].view.buf, (double *)cols[1].view.buf,
+                    (unsigned char *)cols[2].view.buf, (char *)cols[3].view.buf,
+                    cols[0].stride, count, (MapDatum)datum
+                   };
+    GeoBatch geo = {(double *)cols[4].view.buf, (double *)cols[5].view.buf, NULL,
+                    cols[4].stride, 0, (MapDatum)datum
+                   };
+    CoordContext *ctx = coord_create_context((MapDatum)datum);
+    if (!ctx)
+    {
+        PyErr_NoMemory();
+        goto done;
+    }
+    int ret;
+    Py_BEGIN_ALLOW_THREADS
+    ret = coord_from_utm_packed(ctx, &utm, &geo);
+    Py_END_ALLOW_THREADS
+    coord_destroy_context(ctx);
+    result = coord_result(ret);
+done:
+    for (int i = 0; i < 6; i++)
+    {
+        column_release(&cols[i]);
+    }
+    return result;
+}
+
+static PyObject *py_convert_datum(PyObject *self, PyObject *args,
+                                  PyObject *kwargs)
+{
+    static char *keywords[] = {"lat", "lon", "lat_out", "lon_out", "source", "target",
+                               "alt", "alt_out", "method", NULL
+                              };
+    PyObject *objs[6] = {NULL, NULL, NULL, NULL, Py_None, Py_None};
+    int source, target, method = DATUM_SHIFT_HELMERT;
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOii|OOi", keywords, &objs[0],
+                                     &objs[1], &objs[2], &objs[3], &source, &target,
+                                     &objs[4], &objs[5], &method) ||
+            check_datum(source) < 0 || check_datum(target) < 0)
+    {
+        return NULL;
+    }
+    if (method < 0 || method >= DATUM_SHIFT_MAX)
+    {
+        PyErr_Format(PyExc_ValueError, "unknown datum shift method %d", method);
+        return NULL;
+    }
+    Column cols[6];
+    memset(cols, 0, sizeof(cols));
+    PyObject *result = NULL;
+    if (column_get(objs[0], "lat", 0, 0, 0, &cols[0]) < 0 ||
+            column_get(objs[1], "lon", 0, 0, 0, &cols[1]) < 0 ||
+            column_get(objs[2], "lat_out", 1, 0, 0, &cols[2]) < 0 ||
+            column_get(objs[3], "lon_out", 1, 0, 0, &cols[3]) < 0 ||
+            column_get(objs[4], "alt", 0, 0, 1, &cols[4]) < 0 ||
+            column_get(objs[5], "alt_out", 1, 0, 1, &cols[5]) < 0 ||
+            column_pair_stride(&cols[0], &cols[1], "lat and lon") < 0 ||
+            column_pair_stride(&cols[2], &cols[3], "lat_out and lon_out") < 0 ||
+            (cols[4].held && column_pair_stride(&cols[0], &cols[4], "lat and alt") < 0) ||
+            (cols[5].held && column_pair_stride(&cols[2], &cols[5],
+                                                "lat_out and alt_out") < 0))
+    {
+        goto done;
+    }
+    size_t count = column_length(&cols[0]);
+    if (column_length(&cols[1]) != count)
+    {
+        PyErr_SetString(PyExc_ValueError, "lat and lon differ in length");
+        goto done;
+    }
+    if (check_lengths(count, cols + 2, 4) < 0)
+    {
+        goto done;
+    }
+    GeoBatch src = {(double *)cols[0].view.buf, (double *)cols[1].view.buf,
+                    cols[4].held ? (double *)cols[4].view.buf : NULL, cols[0].stride,
+                    count, (MapDatum)source
+                   };
+    GeoBatch dst = {(double *)cols[2].view.buf, (double *)cols[3].view.buf,
+                    cols[5].held ? (double *)cols[5].view.buf : NULL, cols[2].stride,
+                    0, (MapDatum)target
+                   };
+    CoordContext *ctx = coord_create_context((MapDatum)source);
+    if (!ctx)
+    {
+        PyErr_NoMemory();
+        goto done;
+    }
+    coord_set_datum_shift_method(ctx, (DatumShiftMethod)method);
+    int ret;
+    Py_BEGIN_ALLOW_THREADS
+    ret = coord_convert_datum_packed(ctx, &src, (MapDatum)target, &dst);
+    Py_END_ALLOW_THREADS
+    coord_destroy_context(ctx);
+    result = coord_result(ret);
+done:
+    for (int i = 0; i < 6; i++)
+    {
+        column_release(&cols[i]);
+    }
+    return result;
+}
+
+static PyObject *py_distance(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"lat1", "lon1", "lat2", "lon2", "distance", "azi1",
+                               "azi2", "datum", NULL
+                              };
+    PyObject *objs[7] = {NULL, NULL, NULL, NULL, NULL, Py_None, Py_None};
+    int datum = DATUM_WGS84;
+    (void)self;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOO|OOi", keywords, &objs[0],
+                                     &objs[1], &objs[2], &objs[3], &objs[4], &objs[5],
+                                     &objs[6], &datum) || check_datum(datum) < 0)
+    {
+        return NULL;
+    }
+    static const char *names[7] = {"lat1", "lon1", "lat2", "lon2", "distance",
+                                   "azi1", "azi2"
+                                  };
+    Column cols[7];
+    memset(cols, 0, sizeof(cols));
+    PyObject *result = NULL;
+    for (int i = 0; i < 7; i++)
+    {
+        if (column_get(objs[i], names[i], i >= 4, 0, i >= 5, &cols[i]) < 0)
+        {
+            goto done;
+        }
+    }
+    size_t count = column_length(&cols[0]);
+    for (int i = 1; i < 4; i++)
+    {
+        if (column_length(&cols[i]) != count)
+        {
+            PyErr_SetString(PyExc_ValueError, "coordinate arrays differ in length");
+            goto done;
+        }
+    }
+    if (check_lengths(count, cols + 4, 3) < 0)
+    {
+        goto done;
+    }
+    CoordContext *ctx = coord_create_context((MapDatum)datum);
+    if (!ctx)
+    {
+        PyErr_NoMemory();
+        goto done;
+    }
+    int ret = COORD_SUCCESS;
+    Py_BEGIN_ALLOW_THREADS
+    const double *v[4];
+    for (int c = 0; c < 4; c++)
+    {
+        v[c] = (const double *)cols[c].view.buf;
+    }
+    double *out = (double *)cols[4].view.buf;
+    double *az1 = cols[5].held ? (double *)cols[5].view.buf : NULL;
+    double *az2 = cols[6].held ? (double *)cols[6].view.buf : NULL;
+    for (size_t i = 0; i < count; i++)
+    {
+        GeoCoord p1 = {v[0][i * cols[0].stride], v[1][i * cols[1].stride], 0.0,
+                       (MapDatum)datum
+                      };
+        GeoCoord p2 = {v[2][i * cols[2].stride], v[3][i * cols[3].stride], 0.0,
+                       (MapDatum)datum
+                      };
+        double s12, a1, a2;
+        ret = coord_distance(ctx, &p1, &p2, &s12, &a1, &a2);
+        if (ret != COORD_SUCCESS)
+        {
+            break;
+        }
+        out[i * cols[4].stride] = s12;
+        if (az1)
+        {
+            az1[i * cols[5].stride] = a1;
+        }
+        if (az2)
+        {
+            az2[i * cols[6].stride] = a2;
+        }
+    }
+    Py_END_ALLOW_THREADS
+    coord_destroy_context(ctx);
+    result = coord_result(ret);
+done:
+    for (int i = 0; i < 7; i++)
+    {
+        column_release(&cols[i]);
+    }
+    return result;
+}
+
+static PyMethodDef coord_methods[] =
+{
+    {
+        "to_utm", (PyCFunction)(void (*)(void))py_to_utm, METH_VARARGS | METH_KEYWORDS,
+        "to_utm(lat, lon, easting, northing, zone, band, datum=DATUM_WGS84)\n"
+        "Project lat/lon columns into preallocated UTM columns (zone and band "
+        "are 1-byte arrays)."
+    },
+    {
+        "from_utm", (PyCFunction)(void (*)(void))py_from_utm, METH_VARARGS | METH_KEYWORDS,
+        "from_utm(easting, northing, zone, band, lat, lon, datum=DATUM_WGS84)\n"
+        "Inverse of to_utm into preallocated lat/lon columns."
+    },
+    {
+        "convert_datum", (PyCFunction)(void (*)(void))py_convert_datum,
+        METH_VARARGS | METH_KEYWORDS,
+        "convert_datum(lat, lon, lat_out, lon_out, source, target, alt=None, "
+        "alt_out=None, method=DATUM_SHIFT_HELMERT)\n"
+        "Datum shift; outputs may be the input arrays."
+    },
+    {
+        "distance", (PyCFunction)(void (*)(void))py_distance, METH_VARARGS | METH_KEYWORDS,
+        "distance(lat1, lon1, lat2, lon2, distance, azi1=None, azi2=None, "
+        "datum=DATUM_WGS84)\n"
+        "Geodesic distance (meters) and azimuths (degrees) per pair."
+    },
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef coord_module =
+{
+    PyModuleDef_HEAD_INIT, "coordtransform",
+    "Batch coordinate conversions over buffer-protocol arrays.", -1, coord_methods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_coordtransform(void)
+{
+    PyObject *module = PyModule_Create(&coord_module);
+    if (!module)
+    {
+        return NULL;
+    }
+    static const struct
+    {
+        const char *name;
+        int value;
+    } constants[] =
+    {
+        {"DATUM_WGS84", DATUM_WGS84}, {"DATUM_MGRS_GRID", DATUM_MGRS_GRID},
+        {"DATUM_UTM_GRID", DATUM_UTM_GRID}, {"DATUM_NAD83", DATUM_NAD83},
+        {"DATUM_NAD27", DATUM_NAD27}, {"DATUM_ED50", DATUM_ED50},
+        {"DATUM_TOKYO", DATUM_TOKYO}, {"DATUM_OSGB36", DATUM_OSGB36},
+        {"DATUM_SHIFT_HELMERT", DATUM_SHIFT_HELMERT},
+        {"DATUM_SHIFT_MOLODENSKY", DATUM_SHIFT_MOLODENSKY},
+        {"DATUM_SHIFT_ABRIDGED_MOLODENSKY", DATUM_SHIFT_ABRIDGED_MOLODENSKY}
+    };
+    for (size_t i = 0; i < sizeof(constants) / sizeof(constants[0]); i++)
+    {
+        if (PyModule_AddIntConstant(module, constants[i].name, constants[i].value) < 0)
+        {
+            Py_DECREF(module);
+            return NULL;
+        }
+    }
+    return module;
+}
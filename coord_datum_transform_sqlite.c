@@ -0,0 +1,380 @@
+/*
+ * =====================================================================================
+ *
+ * Copyright (c) 2026 Zepp Health. All Rights Reserved. This computer program includes
+ * Confidential, Proprietary Information and is a Trade Secret of Zepp Health Ltd.
+ * All use, disclosure, and/or reproduction is prohibited unless authorized in writing.
+ * Licensed under the MIT License. You can contact below email if need.
+ *
+ * version: 0.0.1
+ * Author: wangwenbing@zepp.com
+ *
+ * =====================================================================================
+ */
+
+// SQLite loadable extension. Load it with ".load ./coordsqlite" (or
+// sqlite3_load_extension()) to register:
+//
+//   coord_convert(lat, lon, format [, datum [, source_datum]])   -> TEXT
+//   coord_distance(lat1, lon1, lat2, lon2)                       -> REAL meters
+//   coord_parse(text [, format])                                 -> TEXT '[lat,lon]'
+//   coord_parse_lat(text [, format]), coord_parse_lon(...)       -> REAL
+//   coord_track_length(lat, lon)                  aggregate      -> REAL meters
+//
+// Formats and datums are names ('MGRS', 'ED50', case-insensitive) or enum
+// values. Points are WGS84 unless source_datum says otherwise; parsed points
+// are returned in WGS84. Rows that cannot be converted give NULL, unknown
+// format or datum names raise an error.
+//
+// Each connection owns one CoordContext shared by all the functions (SQLite
+// runs one statement step at a time per connection), so no row pays for
+// coord_create_context(). Format and datum names are resolved once per
+// statement through auxdata, and the last parsed string is kept so that
+// coord_parse_lat() and coord_parse_lon() on the same value parse it once.
+
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+#include "coord_datum_transform.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef SQLITE_INNOCUOUS
+#define SQLITE_INNOCUOUS 0
+#endif
+
+#define SQL_PARSE_CACHE_TEXT 128   // Longest input kept by the parse cache
+
+// Per-connection state
+typedef struct
+{
+    CoordContext *ctx;
+    int refs;                   // Registered functions holding the state
+    char parse_text[SQL_PARSE_CACHE_TEXT];  // Last parsed input ("" if none)
+    int parse_format;           // Its format argument, -1 for auto-detection
+    ParseResult parse;          // Its result, already in WGS84
+} SqlState;
+
+// Running sums of coord_track_length()
+typedef struct
+{
+    double lat;                 // Previous point
+    double lon;
+    double length;              // Meters so far
+    int started;
+} SqlTrack;
+
+static const char *const format_names[COORD_FORMAT_MAX] =
+{
+    "DD", "DMM", "DMS", "UTM", "MGRS", "BNG", "JAPAN_GRID", "WEB_MERCATOR",
+    "GEOHASH", "QUADKEY"
+};
+
+static const char *const datum_names[DATUM_MAX] =
+{
+    "WGS84", "MGRS_GRID", "UTM_GRID", "NAD83", "NAD27", "ED50", "TOKYO", "OSGB36"
+};
+
+static void sql_state_release(void *data)
+{
+    SqlState *state = (SqlState *)data;
+    if (--state->refs == 0)
+    {
+        coord_destroy_context(state->ctx);
+        sqlite3_free(state);
+    }
+}
+
+// Resolve a format or datum argument given by name or number; -1 if unknown.
+// Name lookups are cached on the statement when the argument is constant.
+static int sql_lookup(sqlite3_context *context, sqlite3_value **argv, int arg,
+                      const char *const *names, int count)
+{
+    if (sqlite3_value_type(argv[arg]) == SQLITE_INTEGER)
+    {
+        int value = sqlite3_value_int(argv[arg]);
+        return value >= 0 && value < count ? value : -1;
+    }
+    const int *cached = (const int *)sqlite3_get_auxdata(context, arg);
+    if (cached)
+    {
+        return *cached;
+    }
+    const char *name = (const char *)sqlite3_value_text(argv[arg]);
+    int found = -1;
+    for (int i = 0; name && i < count && found < 0; i++)
+    {
+        if (sqlite3_stricmp(name, names[i]) == 0)
+        {
+            found = i;
+        }
+    }
+    int *slot = found >= 0 ? (int *)sqlite3_malloc(sizeof(int)) : NULL;
+    if (slot)
+    {
+        *slot = found;
+        sqlite3_set_auxdata(context, arg, slot, sqlite3_free);
+    }
+    return found;
+}
+
+static int sql_any_null(int argc, sqlite3_value **argv)
+{
+    for (int i = 0; i < argc; i++)
+    {
+        if (sqlite3_value_type(argv[i]) == SQLITE_NULL)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void sql_convert(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    if (argc < 3 || argc > 5)
+    {
+        sqlite3_result_error(context,
+                             "coord_convert(lat, lon, format [, datum [, source_datum]])",
+                             -1);
+        return;
+    }
+    if (sql_any_null(argc, argv))
+    {
+        sqlite3_result_null(context);
+        return;
+    }
+    SqlState *state = (SqlState *)sqlite3_user_data(context);
+    int format = sql_lookup(context, argv, 2, format_names, COORD_FORMAT_MAX);
+    int datum = argc > 3 ? sql_lookup(context, argv, 3, datum_names, DATUM_MAX) :
+                DATUM_WGS84;
+    int source = argc > 4 ? sql_lookup(context, argv, 4, datum_names, DATUM_MAX) :
+                 DATUM_WGS84;
+    if (format < 0 || datum < 0 || source < 0)
+    {
+        sqlite3_result_error(context, "unknown coordinate format or datum", -1);
+        return;
+    }
+    GeoCoord point = {sqlite3_value_double(argv[0]), sqlite3_value_double(argv[1]),
+                      0.0, (MapDatum)source
+                     };
+    char text[128];
+    if (coord_convert(state->ctx, &point, (CoordFormat)format, (MapDatum)datum,
+                      text, sizeof(text)) == COORD_SUCCESS)
+    {
+        sqlite3_result_text(context, text, -1, SQLITE_TRANSIENT);
+    }
+    else
+    {
+        sqlite3_result_null(context);
+    }
+}
+
+static void sql_distance(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    if (sql_any_null(argc, argv))
+    {
+        sqlite3_result_null(context);
+        return;
+    }
+    SqlState *state = (SqlState *)sqlite3_user_data(context);
+    GeoCoord p1 = {sqlite3_value_double(argv[0]), sqlite3_value_double(argv[1]),
+                   0.0, DATUM_WGS84
+                  };
+    GeoCoord p2 = {sqlite3_value_double(argv[2]), sqlite3_value_double(argv[3]),
+                   0.0, DATUM_WGS84
+                  };
+    double distance;
+    if (coord_distance(state->ctx, &p1, &p2, &distance, NULL, NULL) == COORD_SUCCESS)
+    {
+        sqlite3_result_double(context, distance);
+    }
+    else
+    {
+        sqlite3_result_null(context);
+    }
+}
+
+// Parse argv[0] (auto-detected, or in the format of argv[1]) through the
+// connection's one-entry cache. Returns NULL when the row gives NULL; errors
+// are already reported.
+static const ParseResult *sql_parse(sqlite3_context *context, int argc,
+                                    sqlite3_value **argv)
+{
+    if (argc < 1 || argc > 2)
+    {
+        sqlite3_result_error(context, "expected (text [, format])", -1);
+        return NULL;
+    }
+    if (sql_any_null(argc, argv))
+    {
+        sqlite3_result_null(context);
+        return NULL;
+    }
+    SqlState *state = (SqlState *)sqlite3_user_data(context);
+    int format = argc > 1 ? sql_lookup(context, argv, 1, format_names,
+                                       COORD_FORMAT_MAX) : -1;
+    if (argc > 1 && format < 0)
+    {
+        sqlite3_result_error(context, "unknown coordinate format", -1);
+        return NULL;
+    }
+    const char *text = (const char *)sqlite3_value_text(argv[0]);
+    size_t length = text ? strlen(text) : 0;
+    if (!text || length >= SQL_PARSE_CACHE_TEXT || format != state->parse_format ||
+            strcmp(text, state->parse_text) != 0)
+    {
+        ParseResult result = format < 0 ? coord_auto_parse(text) :
+                             coord_parse_string(text, (CoordFormat)format, DATUM_WGS84);
+        if (result.success && result.coord.datum != DATUM_WGS84)
+        {
+            GeoCoord wgs84;
+            result.success = coord_convert_datum(state->ctx, &result.coord,
+                                                 DATUM_WGS84, &wgs84) == COORD_SUCCESS;
+            result.coord = wgs84;
+        }
+        state->parse = result;
+        state->parse_format = format;
+        state->parse_text[0] = '\0';
+        if (text && length < SQL_PARSE_CACHE_TEXT)
+        {
+            memcpy(state->parse_text, text, length + 1);
+        }
+    }
+    if (!state->parse.success)
+    {
+        sqlite3_result_null(context);
+        return NULL;
+    }
+    return &state->parse;
+}
+
+static void sql_parse_json(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    const ParseResult *result = sql_parse(context, argc, argv);
+    if (result)
+    {
+        char text[64];
+        snprintf(text, sizeof(text), "[%.9f,%.9f]", result->coord.latitude,
+                 result->coord.longitude);
+        sqlite3_result_text(context, text, -1, SQLITE_TRANSIENT);
+    }
+}
+
+static void sql_parse_lat(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    const ParseResult *result = sql_parse(context, argc, argv);
+    if (result)
+    {
+        sqlite3_result_double(context, result->coord.latitude);
+    }
+}
+
+static void sql_parse_lon(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    const ParseResult *result = sql_parse(context, argc, argv);
+    if (result)
+    {
+        sqlite3_result_double(context, result->coord.longitude);
+    }
+}
+
+// coord_track_length(): geodesic length through the rows in the order the
+// aggregate sees them (order the input in a subquery); NULL rows are skipped
+static void sql_track_step(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    SqlTrack *track = (SqlTrack *)sqlite3_aggregate_context(context, sizeof(SqlTrack));
+    if (!track)
+    {
+        sqlite3_result_error_nomem(context);
+        return;
+    }
+    if (sql_any_null(argc, argv))
+    {
+        return;
+    }
+    GeoCoord point = {sqlite3_value_double(argv[0]), sqlite3_value_double(argv[1]),
+                      0.0, DATUM_WGS84
+                     };
+    if (track->started)
+    {
+        SqlState *state = (SqlState *)sqlite3_user_data(context);
+        GeoCoord previous = {track->lat, track->lon, 0.0, DATUM_WGS84};
+        double distance;
+        if (coord_distance(state->ctx, &previous, &point, &distance, NULL, NULL) !=
+                COORD_SUCCESS)
+        {
+            sqlite3_result_error(context, "invalid track point", -1);
+            return;
+        }
+        track->length += distance;
+    }
+    track->lat = point.latitude;
+    track->lon = point.longitude;
+    track->started = 1;
+}
+
+static void sql_track_final(sqlite3_context *context)
+{
+    SqlTrack *track = (SqlTrack *)sqlite3_aggregate_context(context, 0);
+    sqlite3_result_double(context, track ? track->length : 0.0);
+}
+
+#ifdef _WIN32
+__declspec(dllexport)
+#endif
+int sqlite3_coordsqlite_init(sqlite3 *db, char **error,
+                             const sqlite3_api_routines *api)
+{
+    SQLITE_EXTENSION_INIT2(api);
+    static const struct
+    {
+        const char *name;
+        int n_args;             // -1 checks the count in the function
+        void (*func)(sqlite3_context *, int, sqlite3_value **);
+        void (*step)(sqlite3_context *, int, sqlite3_value **);
+        void (*final)(sqlite3_context *);
+    } functions[] =
+    {
+        {"coord_convert", -1, sql_convert, NULL, NULL},
+        {"coord_distance", 4, sql_distance, NULL, NULL},
+        {"coord_parse", -1, sql_parse_json, NULL, NULL},
+        {"coord_parse_lat", -1, sql_parse_lat, NULL, NULL},
+        {"coord_parse_lon", -1, sql_parse_lon, NULL, NULL},
+        {"coord_track_length", 2, NULL, sql_track_step, sql_track_final}
+    };
+
+    SqlState *state = (SqlState *)sqlite3_malloc(sizeof(SqlState));
+    if (!state)
+    {
+        return SQLITE_NOMEM;
+    }
+    memset(state, 0, sizeof(*state));
+    state->parse_format = -1;
+    state->ctx = coord_create_context(DATUM_WGS84);
+    if (!state->ctx)
+    {
+        sqlite3_free(state);
+        return SQLITE_NOMEM;
+    }
+
+    // The state goes away with the last function still registered
+    state->refs = 1;
+    int rc = SQLITE_OK;
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]) && rc == SQLITE_OK;
+            i++)
+    {
+        int flags = SQLITE_UTF8 | SQLITE_INNOCUOUS |
+                    (functions[i].step ? 0 : SQLITE_DETERMINISTIC);
+        state->refs++;
+        rc = sqlite3_create_function_v2(db, functions[i].name, functions[i].n_args,
+                                        flags, state, functions[i].func,
+                                        functions[i].step, functions[i].final,
+                                        sql_state_release);
+    }
+    if (rc != SQLITE_OK && error)
+    {
+        *error = sqlite3_mprintf("coordsqlite: %s", sqlite3_errmsg(db));
+    }
+    sql_state_release(state);
+    return rc;
+}
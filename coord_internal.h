@@ -0,0 +1,27 @@
+/*
+ * =====================================================================================
+ *
+ * Copyright (c) 2026 Zepp Health. All Rights Reserved. This computer program includes
+ * Confidential, Proprietary Information and is a Trade Secret of Zepp Health Ltd.
+ * All use, disclosure, and/or reproduction is prohibited unless authorized in writing.
+ * Licensed under the MIT License. You can contact below email if need.
+ *
+ * version: 0.0.1
+ * Author: wangwenbing@zepp.com
+ *
+ * =====================================================================================
+ */
+
+// Helpers shared between the library's own source files; not part of the API
+
+#ifndef COORD_INTERNAL_H
+#define COORD_INTERNAL_H
+
+#include "coord_datum_transform.h"
+
+// Allocator dispatch: the hooks of alloc when set, the C library otherwise
+void *coord_alloc(const CoordAllocator *alloc, size_t size);
+void *coord_realloc(const CoordAllocator *alloc, void *ptr, size_t size);
+void coord_free(const CoordAllocator *alloc, void *ptr);
+
+#endif // COORD_INTERNAL_H
@@ -13,10 +13,12 @@
  */
 
 #include "coord_datum_transform.h"
+#include "coord_arrow.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 
 // Error callback
 static void error_handler(int code, const char *message)
@@ -691,6 +693,2803 @@ void test_datum_tools()
     printf("\n");
 }
 
+// Test Molodensky datum shift methods against the full Helmert transform
+void test_datum_shift_methods()
+{
+    printf("=== Test datum shift methods ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    struct
+    {
+        const char *name;
+        double lat, lon;
+        MapDatum datum;
+    } cases[] =
+    {
+        {"New York -> NAD27", 40.712776, -74.005974, DATUM_NAD27},
+        {"Paris -> ED50", 48.856614, 2.352222, DATUM_ED50},
+        {"Tokyo -> Tokyo", 35.689487, 139.691711, DATUM_TOKYO},
+        {"London -> OSGB36", 51.507351, -0.127758, DATUM_OSGB36}
+    };
+    const char *method_names[] = {"Helmert", "Molodensky", "Abridged Molodensky"};
+    int num_cases = sizeof(cases) / sizeof(cases[0]);
+    for (int i = 0; i < num_cases; i++)
+    {
+        GeoCoord src = {cases[i].lat, cases[i].lon, 0.0, DATUM_WGS84};
+        GeoCoord full;
+        int ret = coord_convert_datum_ex(ctx, &src, cases[i].datum,
+                                         DATUM_SHIFT_HELMERT, &full);
+        if (ret != COORD_SUCCESS)
+        {
+            printf("  %s: Helmert failed: %s\n", cases[i].name,
+                   coord_get_error_string(ret));
+            continue;
+        }
+        printf("  %s:\n", cases[i].name);
+        for (int m = DATUM_SHIFT_MOLODENSKY; m < DATUM_SHIFT_MAX; m++)
+        {
+            GeoCoord fast;
+            ret = coord_convert_datum_ex(ctx, &src, cases[i].datum,
+                                         (DatumShiftMethod)m, &fast);
+            if (ret != COORD_SUCCESS)
+            {
+                printf("    %s failed: %s\n", method_names[m], coord_get_error_string(ret));
+                continue;
+            }
+            double dn = (fast.latitude - full.latitude) * 111320.0;
+            double de = (fast.longitude - full.longitude) * 111320.0 *
+                        cos(coord_deg_to_rad(full.latitude));
+            printf("    %s vs %s: horizontal %.3f m, height %.3f m\n",
+                   method_names[m], method_names[DATUM_SHIFT_HELMERT],
+                   sqrt(dn * dn + de * de), fast.altitude - full.altitude);
+        }
+    }
+    // Per-context method and batch form
+    GeoCoord batch_src[2] =
+    {
+        {35.689487, 139.691711, 0.0, DATUM_WGS84},
+        {34.693738, 135.502165, 0.0, DATUM_WGS84}
+    };
+    GeoCoord batch_dst[2];
+    coord_set_datum_shift_method(ctx, DATUM_SHIFT_ABRIDGED_MOLODENSKY);
+    int ret = coord_convert_datum_batch(ctx, batch_src, 2, DATUM_TOKYO, batch_dst);
+    printf("  Batch abridged Molodensky to Tokyo: %s\n",
+           ret == COORD_SUCCESS ? "pass" : "fail");
+    if (ret == COORD_SUCCESS)
+    {
+        GeoCoord single;
+        coord_convert_datum(ctx, &batch_src[1], DATUM_TOKYO, &single);
+        printf("  Batch matches per-call result: %s\n",
+               compare_double(single.latitude, batch_dst[1].latitude, 1e-12) &&
+               compare_double(single.longitude, batch_dst[1].longitude, 1e-12) ?
+               "pass" : "fail");
+    }
+    ret = coord_set_datum_shift_method(ctx, DATUM_SHIFT_MAX);
+    printf("  Invalid method rejected: %s\n",
+           ret == COORD_ERROR_INVALID_INPUT ? "pass" : "fail");
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test ECEF and local ENU conversions
+void test_ecef_enu()
+{
+    printf("=== Test ECEF and local ENU conversions ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    GeoCoord shanghai = {31.230416, 121.473701, 12.0, DATUM_WGS84};
+    ECEFPoint ecef;
+    int ret = coord_to_ecef(ctx, &shanghai, &ecef);
+    if (ret == COORD_SUCCESS)
+    {
+        printf("Shanghai ECEF: (%.3f, %.3f, %.3f)\n", ecef.x, ecef.y, ecef.z);
+        GeoCoord back;
+        ret = coord_from_ecef(ctx, &ecef, &back);
+        printf("  ECEF round trip: %s\n",
+               ret == COORD_SUCCESS &&
+               compare_double(back.latitude, shanghai.latitude, 1e-9) &&
+               compare_double(back.longitude, shanghai.longitude, 1e-9) &&
+               compare_double(back.altitude, shanghai.altitude, 1e-4) ? "pass" : "fail");
+    }
+    else
+    {
+        printf("ECEF conversion failed: %s\n", coord_get_error_string(ret));
+    }
+    // Session origin with a short trajectory
+    LocalOrigin origin;
+    ret = coord_init_local_origin(ctx, &shanghai, &origin);
+    if (ret != COORD_SUCCESS)
+    {
+        printf("Failed to initialize local origin: %s\n", coord_get_error_string(ret));
+        coord_destroy_context(ctx);
+        return;
+    }
+    GeoCoord track[3];
+    coord_direct(ctx, &shanghai, 100.0, 0.0, &track[0]);
+    coord_direct(ctx, &shanghai, 100.0, 90.0, &track[1]);
+    track[2] = shanghai;
+    track[2].altitude = 112.0;
+    track[0].altitude = track[1].altitude = shanghai.altitude;
+    ENUPoint enu[3];
+    ret = coord_to_enu_batch(ctx, &origin, track, 3, enu);
+    if (ret == COORD_SUCCESS)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            printf("  ENU[%d]: E=%.3f N=%.3f U=%.3f\n", i, enu[i].east, enu[i].north,
+                   enu[i].up);
+        }
+        printf("  100 m north: %s\n",
+               compare_double(enu[0].north, 100.0, 0.01) &&
+               compare_double(enu[0].east, 0.0, 0.01) ? "pass" : "fail");
+        printf("  100 m east: %s\n",
+               compare_double(enu[1].east, 100.0, 0.01) &&
+               compare_double(enu[1].north, 0.0, 0.01) ? "pass" : "fail");
+        printf("  100 m up: %s\n",
+               compare_double(enu[2].up, 100.0, 1e-6) ? "pass" : "fail");
+        GeoCoord back[3];
+        ret = coord_from_enu_batch(ctx, &origin, enu, 3, back);
+        printf("  ENU round trip: %s\n",
+               ret == COORD_SUCCESS &&
+               compare_double(back[1].latitude, track[1].latitude, 1e-9) &&
+               compare_double(back[1].longitude, track[1].longitude, 1e-9) ? "pass" : "fail");
+    }
+    else
+    {
+        printf("ENU batch conversion failed: %s\n", coord_get_error_string(ret));
+    }
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test incremental UTM projection on a dense track
+void test_track_projector()
+{
+    printf("=== Test incremental track projection ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    UTMTrackProjector proj;
+    double max_error = 0.001;
+    coord_track_projector_init(ctx, max_error, &proj);
+    // 1 Hz track at 5 m/s heading east across the zone 51/52 boundary
+    GeoCoord point = {31.2, 125.9, 0.0, DATUM_WGS84};
+    double worst = 0.0;
+    int zone_changes = 0;
+    int last_zone = 0;
+    int failures = 0;
+    for (int i = 0; i < 7200; i++)
+    {
+        UTMPoint fast, exact;
+        int ret1 = coord_track_project(&proj, &point, &fast);
+        int ret2 = coord_to_utm(ctx, &point, &exact);
+        if (ret1 != COORD_SUCCESS || ret2 != COORD_SUCCESS || fast.zone != exact.zone ||
+                fast.band != exact.band)
+        {
+            failures++;
+        }
+        else
+        {
+            worst = fmax(worst, fmax(fabs(fast.easting - exact.easting),
+                                     fabs(fast.northing - exact.northing)));
+        }
+        if (last_zone != 0 && fast.zone != last_zone)
+        {
+            zone_changes++;
+        }
+        last_zone = fast.zone;
+        GeoCoord next;
+        coord_direct(ctx, &point, 5.0, 80.0, &next);
+        point = next;
+    }
+    printf("  Points: 7200, exact evaluations: %lu, expanded: %lu\n",
+           proj.exact_count, proj.approx_count);
+    printf("  Max error vs coord_to_utm: %.6f m (bound %.3f m): %s\n", worst,
+           max_error, worst <= max_error ? "pass" : "fail");
+    printf("  Zone changes handled: %d, mismatches: %d: %s\n", zone_changes,
+           failures, zone_changes == 1 && failures == 0 ? "pass" : "fail");
+    printf("  Fewer full evaluations than points: %s\n",
+           proj.exact_count * 10 < 7200 ? "pass" : "fail");
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test prevalidated batch conversion against the checked per-point API
+void test_trusted_batch()
+{
+    printf("=== Test prevalidated batch conversion ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    enum { COUNT = 200 };
+    static GeoCoord pts[COUNT];
+    static UTMPoint utm[COUNT];
+    static MGRSPoint mgrs[COUNT];
+    uint64_t mask[(COUNT + 63) / 64];
+    size_t expected_valid = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        pts[i].latitude = -79.0 + 0.79 * i;
+        pts[i].longitude = -179.0 + 1.79 * i;
+        pts[i].altitude = 0.0;
+        pts[i].datum = DATUM_WGS84;
+        if (i % 17 == 3)
+        {
+            pts[i].latitude = 91.0;
+        }
+        else if (i % 29 == 5)
+        {
+            pts[i].longitude = NAN;
+        }
+        expected_valid += coord_validate_point(&pts[i]) != 0;
+    }
+    size_t valid = coord_validate_batch(pts, COUNT, mask);
+    int mask_ok = valid == expected_valid;
+    for (int i = 0; i < COUNT; i++)
+    {
+        int bit = (int)((mask[i / 64] >> (i % 64)) & 1u);
+        mask_ok &= bit == (coord_validate_point(&pts[i]) != 0);
+    }
+    printf("  Validity mask (%zu of %d valid): %s\n", valid, COUNT,
+           mask_ok ? "pass" : "fail");
+
+    int ret = coord_to_utm_batch_trusted(ctx, pts, COUNT, mask, utm);
+    int ret2 = coord_to_mgrs_batch_trusted(ctx, pts, COUNT, mask, mgrs);
+    int mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        UTMPoint u;
+        MGRSPoint m;
+        if (coord_to_utm(ctx, &pts[i], &u) != COORD_SUCCESS ||
+                coord_to_mgrs(ctx, &pts[i], &m) != COORD_SUCCESS)
+        {
+            mismatches += utm[i].zone != 0 || mgrs[i].zone != 0;
+            continue;
+        }
+        mismatches += u.zone != utm[i].zone || u.band != utm[i].band ||
+                      u.easting != utm[i].easting || u.northing != utm[i].northing;
+        mismatches += m.zone != mgrs[i].zone ||
+                      strcmp(m.square, mgrs[i].square) != 0 ||
+                      m.easting != mgrs[i].easting || m.northing != mgrs[i].northing;
+    }
+    printf("  Trusted UTM/MGRS batch matches checked API: %s\n",
+           ret == COORD_SUCCESS && ret2 == COORD_SUCCESS && mismatches == 0 ?
+           "pass" : "fail");
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test that corrupt angles cost constant time on the public path
+void test_worst_case_latency()
+{
+    printf("=== Test worst-case latency ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    struct
+    {
+        double input, expected;
+    } wraps[] =
+    {
+        {540.0, 180.0}, {-540.0, -180.0}, {725.25, 5.25}, {1e12, -80.0},
+        {-1e12, 80.0}, {1e15 + 0.5, -79.5}
+    };
+    int exact = 1;
+    for (size_t i = 0; i < sizeof(wraps) / sizeof(wraps[0]); i++)
+    {
+        exact &= coord_normalize_longitude(wraps[i].input) == wraps[i].expected;
+    }
+    double huge = coord_normalize_longitude(1e300);
+    exact &= huge >= -180.0 && huge <= 180.0;
+    exact &= isnan(coord_normalize_longitude(INFINITY));
+    exact &= isnan(coord_normalize_longitude(NAN));
+    printf("  Exact remainder-based wrap: %s\n", exact ? "pass" : "fail");
+
+    const double adversarial[] = {1e12, -1e12, 1e300, -1e300, INFINITY, -INFINITY, NAN};
+    enum { REPS = 10000 };
+    double worst_us = 0.0;
+    volatile double sink = 0.0;
+    for (size_t i = 0; i < sizeof(adversarial) / sizeof(adversarial[0]); i++)
+    {
+        double a = adversarial[i];
+        GeoCoord geo = {45.0, a, 0.0, DATUM_WGS84};
+        GeoCoord start = {45.0, 10.0, 0.0, DATUM_WGS84};
+        GeoCoord end;
+        UTMPoint utm;
+        clock_t t0 = clock();
+        for (int r = 0; r < REPS; r++)
+        {
+            sink += coord_normalize_longitude(a + r);
+            sink += coord_get_utm_zone(a, 45.0);
+            sink += coord_to_utm(ctx, &geo, &utm);
+            sink += coord_direct(ctx, &start, 1000.0, a, &end);
+        }
+        double us = 1e6 * (double)(clock() - t0) / CLOCKS_PER_SEC / REPS;
+        worst_us = fmax(worst_us, us);
+    }
+    // A linear walk would need ~1e9 iterations for 1e12 degrees alone
+    printf("  Worst per-call latency over corrupt inputs: %.2f us: %s\n",
+           worst_us, worst_us < 100.0 ? "pass" : "fail");
+    (void)sink;
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Counting allocator used to check allocator routing and hot-path allocations
+typedef struct
+{
+    size_t mallocs, reallocs, frees;
+    long live;                  // Outstanding blocks
+} AllocCounter;
+
+static void *counting_malloc(size_t size, void *user_data)
+{
+    ((AllocCounter *)user_data)->mallocs++;
+    ((AllocCounter *)user_data)->live++;
+    return malloc(size);
+}
+
+static void *counting_realloc(void *ptr, size_t size, void *user_data)
+{
+    ((AllocCounter *)user_data)->reallocs++;
+    ((AllocCounter *)user_data)->live += ptr == NULL;
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *ptr, void *user_data)
+{
+    ((AllocCounter *)user_data)->frees++;
+    ((AllocCounter *)user_data)->live--;
+    free(ptr);
+}
+
+// Test allocator hooks and zero-allocation conversion paths
+void test_allocator_hooks()
+{
+    printf("=== Test allocator hooks ===\n");
+    AllocCounter global = {0, 0, 0, 0};
+    AllocCounter local = {0, 0, 0, 0};
+    printf("  Partial hook set rejected: %s\n",
+           coord_set_allocator(counting_malloc, NULL, counting_free, &global) ==
+           COORD_ERROR_INVALID_INPUT ? "pass" : "fail");
+    coord_set_allocator(counting_malloc, counting_realloc, counting_free, &global);
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    coord_set_allocator(NULL, NULL, NULL, NULL);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    printf("  Context allocated through global hooks (%zu allocations): %s\n",
+           global.mallocs, global.mallocs > 0 ? "pass" : "fail");
+
+    // Conversion hot paths must not allocate
+    size_t before = global.mallocs + global.reallocs;
+    GeoCoord geo = {51.5074, -0.1278, 0.0, DATUM_WGS84};
+    UTMPoint utm;
+    MGRSPoint mgrs;
+    BritishGridPoint bg;
+    GeoCoord back;
+    char buffer[128];
+    UTMTrackProjector proj;
+    coord_track_projector_init(ctx, 0.001, &proj);
+    for (int i = 0; i < 1000; i++)
+    {
+        GeoCoord p = geo;
+        p.latitude += 1e-4 * i;
+        coord_to_utm(ctx, &p, &utm);
+        coord_from_utm(ctx, &utm, &back);
+        coord_to_mgrs(ctx, &p, &mgrs);
+        coord_from_mgrs(ctx, &mgrs, &back);
+        coord_to_british_grid(ctx, &p, &bg);
+        coord_convert_datum(ctx, &p, DATUM_ED50, &back);
+        coord_convert(ctx, &p, COORD_FORMAT_MGRS, DATUM_WGS84, buffer, sizeof(buffer));
+        coord_track_project(&proj, &p, &utm);
+    }
+    printf("  Conversion hot paths allocation-free: %s\n",
+           global.mallocs + global.reallocs == before && local.mallocs == 0 ?
+           "pass" : "fail");
+
+    // Per-context hooks own the memory of context operations
+    coord_context_set_allocator(ctx, counting_malloc, counting_realloc,
+                                counting_free, &local);
+    ProjectionMesh *mesh = coord_mesh_create(ctx, COORD_FORMAT_UTM, DATUM_WGS84,
+                           31.0, 31.5, 121.0, 121.5, 0.01, MESH_INTERP_BICUBIC);
+    static double easting[16 * 16], northing[16 * 16];
+    coord_project_lattice(ctx, 31.0, 0.01, 16, 121.0, 0.01, 16, DATUM_WGS84,
+                          COORD_FORMAT_UTM, easting, northing, NULL);
+    size_t local_before = local.mallocs + local.reallocs;
+    double e, n;
+    for (int i = 0; i < 1000 && mesh; i++)
+    {
+        coord_mesh_eval(mesh, 31.0 + 5e-4 * i, 121.2, &e, &n);
+    }
+    int mesh_eval_ok = local.mallocs + local.reallocs == local_before;
+    coord_mesh_destroy(mesh);
+    printf("  Mesh and lattice use context hooks (%zu allocations): %s\n",
+           local.mallocs + local.reallocs, mesh && local.mallocs > 0 &&
+           local.live == 0 && mesh_eval_ok ? "pass" : "fail");
+
+    // The context is released through the allocator that created it
+    coord_destroy_context(ctx);
+    printf("  Context freed through creating hooks: %s\n",
+           global.live == 0 && global.frees > 0 ? "pass" : "fail");
+    printf("\n");
+}
+
+// Test direct grid-to-grid routes of coord_convert_any()
+void test_convert_any()
+{
+    printf("=== Test any-to-any conversion ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    // MGRS <-> UTM lettering against the projection round trip
+    int mismatches = 0;
+    int checked = 0;
+    double worst = 0.0;
+    for (double lat = -79.5; lat < 84.0; lat += 3.7)
+    {
+        for (double lon = -179.5; lon < 180.0; lon += 4.3)
+        {
+            GeoCoord geo = {lat, lon, 0.0, DATUM_WGS84};
+            UTMPoint utm, utm_back;
+            MGRSPoint mgrs, mgrs_direct;
+            GeoCoord back;
+            if (coord_convert_any(ctx, COORD_FORMAT_DD, &geo, COORD_FORMAT_UTM,
+                                  &utm) != COORD_SUCCESS ||
+                    coord_to_mgrs(ctx, &geo, &mgrs) != COORD_SUCCESS ||
+                    coord_convert_any(ctx, COORD_FORMAT_UTM, &utm, COORD_FORMAT_MGRS,
+                                      &mgrs_direct) != COORD_SUCCESS ||
+                    coord_convert_any(ctx, COORD_FORMAT_MGRS, &mgrs, COORD_FORMAT_UTM,
+                                      &utm_back) != COORD_SUCCESS ||
+                    coord_convert_any(ctx, COORD_FORMAT_MGRS, &mgrs, COORD_FORMAT_DD,
+                                      &back) != COORD_SUCCESS)
+            {
+                mismatches++;
+                continue;
+            }
+            checked++;
+            mismatches += strcmp(mgrs.square, mgrs_direct.square) != 0 ||
+                          utm_back.zone != utm.zone || utm_back.band != utm.band;
+            worst = fmax(worst, fmax(fabs(utm_back.easting - utm.easting),
+                                     fabs(utm_back.northing - utm.northing)));
+            // MGRS -> DD must agree with the UTM inverse of the same point
+            GeoCoord expected;
+            coord_from_utm(ctx, &utm, &expected);
+            worst = fmax(worst, 1e5 * fmax(fabs(back.latitude - expected.latitude),
+                                           fabs(back.longitude - expected.longitude)));
+        }
+    }
+    printf("  MGRS <-> UTM lettering (%d points, max error %.2e m): %s\n",
+           checked, worst, mismatches == 0 && worst < 1e-6 ? "pass" : "fail");
+
+    // UTM in zone 31 moved into the Norway exception comes back in zone 32
+    GeoCoord edge = {55.95, 5.0, 0.0, DATUM_WGS84};
+    UTMPoint z31, z32;
+    GeoCoord g31, g32;
+    coord_to_utm(ctx, &edge, &z31);
+    z31.northing += 20000.0;
+    int ret = coord_convert_any(ctx, COORD_FORMAT_UTM, &z31, COORD_FORMAT_UTM, &z32);
+    coord_from_utm(ctx, &z31, &g31);
+    coord_from_utm(ctx, &z32, &g32);
+    printf("  UTM zone %d -> natural zone %d: %s\n", z31.zone, z32.zone,
+           ret == COORD_SUCCESS && z31.zone == 31 && z32.zone == 32 &&
+           fabs(g31.latitude - g32.latitude) < 1e-7 &&
+           fabs(g31.longitude - g32.longitude) < 1e-7 ? "pass" : "fail");
+
+    // Cross-family route and format errors
+    BritishGridPoint bg;
+    JapanGridPoint jg;
+    GeoCoord london = {51.5074, -0.1278, 0.0, DATUM_WGS84};
+    printf("  DD -> British Grid and unsupported format: %s\n",
+           coord_convert_any(ctx, COORD_FORMAT_DD, &london, COORD_FORMAT_BRITISH_GRID,
+                             &bg) == COORD_SUCCESS &&
+           coord_convert_any(ctx, COORD_FORMAT_BRITISH_GRID, &bg,
+                             COORD_FORMAT_JAPAN_GRID, &jg) == COORD_SUCCESS &&
+           coord_convert_any(ctx, COORD_FORMAT_DD, &london, COORD_FORMAT_MAX,
+                             &jg) == COORD_ERROR_UNSUPPORTED_FORMAT ? "pass" : "fail");
+
+    // Timing: lettering versus inverse + forward projection
+    GeoCoord shanghai = {31.2304, 121.4737, 0.0, DATUM_WGS84};
+    MGRSPoint mgrs;
+    UTMPoint utm;
+    GeoCoord tmp;
+    coord_to_mgrs(ctx, &shanghai, &mgrs);
+    enum { REPS = 200000 };
+    clock_t t0 = clock();
+    for (int i = 0; i < REPS; i++)
+    {
+        coord_from_mgrs(ctx, &mgrs, &tmp);
+        coord_to_utm(ctx, &tmp, &utm);
+    }
+    clock_t t1 = clock();
+    for (int i = 0; i < REPS; i++)
+    {
+        coord_convert_any(ctx, COORD_FORMAT_MGRS, &mgrs, COORD_FORMAT_UTM, &utm);
+    }
+    clock_t t2 = clock();
+    printf("    MGRS -> UTM x%d: via geographic %.2f ms, direct %.2f ms\n", REPS,
+           1000.0 * (t1 - t0) / CLOCKS_PER_SEC, 1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test typed conversion against the string pipeline
+void test_convert_typed()
+{
+    printf("=== Test typed conversion ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    GeoCoord src = {35.6812, 139.7671, 0.0, DATUM_WGS84};
+    int same = 1;
+    for (int f = COORD_FORMAT_DD; f < COORD_FORMAT_MAX; f++)
+    {
+        char expected[128], typed[128], formatted[128];
+        CoordValue value;
+        int r1 = coord_convert(ctx, &src, (CoordFormat)f, DATUM_WGS84, expected,
+                               sizeof(expected));
+        int r2 = coord_convert_typed(ctx, &src, (CoordFormat)f, DATUM_WGS84, &value,
+                                     typed, sizeof(typed));
+        int r3 = coord_format_value(&value, formatted, sizeof(formatted));
+        same &= r1 == COORD_SUCCESS && r2 == COORD_SUCCESS && r3 == COORD_SUCCESS &&
+                value.format == (CoordFormat)f && strcmp(expected, typed) == 0 &&
+                strcmp(expected, formatted) == 0;
+    }
+    printf("  Typed value formats like coord_convert(): %s\n", same ? "pass" : "fail");
+
+    CoordValue value;
+    UTMPoint utm;
+    coord_to_utm(ctx, &src, &utm);
+    int ret = coord_convert_typed(ctx, &src, COORD_FORMAT_UTM, DATUM_WGS84, &value,
+                                  NULL, 0);
+    printf("  UTM numbers without formatting: %s\n",
+           ret == COORD_SUCCESS && value.value.utm.zone == utm.zone &&
+           value.value.utm.easting == utm.easting &&
+           value.value.utm.northing == utm.northing ? "pass" : "fail");
+
+    enum { COUNT = 1000 };
+    static GeoCoord pts[COUNT];
+    static CoordValue values[COUNT];
+    for (int i = 0; i < COUNT; i++)
+    {
+        pts[i].latitude = 50.0 + 0.005 * i;
+        pts[i].longitude = -5.0 + 0.007 * i;
+        pts[i].altitude = 0.0;
+        pts[i].datum = DATUM_WGS84;
+    }
+    ret = coord_convert_typed_batch(ctx, pts, COUNT, COORD_FORMAT_BRITISH_GRID,
+                                    DATUM_WGS84, values);
+    int batch_ok = ret == COORD_SUCCESS;
+    for (int i = 0; i < COUNT && batch_ok; i++)
+    {
+        BritishGridPoint bg;
+        coord_to_british_grid(ctx, &pts[i], &bg);
+        batch_ok = values[i].format == COORD_FORMAT_BRITISH_GRID &&
+                   values[i].value.bg.easting == bg.easting &&
+                   values[i].value.bg.northing == bg.northing;
+    }
+    printf("  Typed batch matches per-point conversion: %s\n",
+           batch_ok ? "pass" : "fail");
+
+    enum { REPS = 100000 };
+    char buffer[128];
+    clock_t t0 = clock();
+    for (int i = 0; i < REPS; i++)
+    {
+        coord_convert(ctx, &src, COORD_FORMAT_MGRS, DATUM_WGS84, buffer,
+                      sizeof(buffer));
+    }
+    clock_t t1 = clock();
+    for (int i = 0; i < REPS; i++)
+    {
+        coord_convert_typed(ctx, &src, COORD_FORMAT_MGRS, DATUM_WGS84, &value,
+                            NULL, 0);
+    }
+    clock_t t2 = clock();
+    printf("    MGRS x%d: string %.2f ms, typed %.2f ms\n", REPS,
+           1000.0 * (t1 - t0) / CLOCKS_PER_SEC, 1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test forced-zone projection and direct zone-to-zone transforms
+void test_utm_zone_transform()
+{
+    printf("=== Test UTM zone-to-zone transform ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    // Points within 3 degrees of the 120E boundary (zones 50 and 51) and the
+    // 180 meridian (zones 60 and 1)
+    enum { COUNT = 2000 };
+    static UTMPoint natural[COUNT], moved[COUNT], back[COUNT];
+    static int target[COUNT];
+    static GeoCoord pts[COUNT];
+    for (int i = 0; i < COUNT; i++)
+    {
+        double boundary = (i % 2) ? 120.0 : 180.0;
+        pts[i].latitude = -70.0 + 140.0 * (i % 97) / 96.0;
+        pts[i].longitude = boundary - 2.95 + 5.9 * (i % 89) / 88.0;
+        pts[i].longitude = coord_normalize_longitude(pts[i].longitude);
+        pts[i].altitude = 0.0;
+        pts[i].datum = DATUM_WGS84;
+        coord_to_utm(ctx, &pts[i], &natural[i]);
+        // Neighbour zone on the other side of the boundary
+        int east = (boundary == 120.0) ? 51 : 1;
+        int west = (boundary == 120.0) ? 50 : 60;
+        target[i] = natural[i].zone == east ? west : east;
+    }
+    double worst = 0.0, worst_back = 0.0;
+    int failures = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        UTMPoint forced;
+        failures += coord_to_utm_zone(ctx, &pts[i], target[i], &forced) != COORD_SUCCESS;
+        failures += coord_utm_to_zone(ctx, &natural[i], target[i], &moved[i]) !=
+                    COORD_SUCCESS;
+        failures += coord_utm_to_zone(ctx, &moved[i], natural[i].zone, &back[i]) !=
+                    COORD_SUCCESS;
+        failures += moved[i].zone != target[i] || moved[i].band != forced.band;
+        worst = fmax(worst, fmax(fabs(moved[i].easting - forced.easting),
+                                 fabs(moved[i].northing - forced.northing)));
+        worst_back = fmax(worst_back, fmax(fabs(back[i].easting - natural[i].easting),
+                                           fabs(back[i].northing - natural[i].northing)));
+    }
+    // Agreement is limited by the inverse series, not by the fused kernel
+    printf("  Direct vs forced-zone projection: max %.4f m, round trip %.4f m: %s\n",
+           worst, worst_back, failures == 0 && worst < 0.1 && worst_back < 0.1 ?
+           "pass" : "fail");
+
+    UTMPoint bad;
+    printf("  Invalid target zone rejected: %s\n",
+           coord_utm_to_zone(ctx, &natural[0], 61, &bad) == COORD_ERROR_INVALID_UTM_ZONE &&
+           coord_to_utm_zone(ctx, &pts[0], 0, &bad) == COORD_ERROR_INVALID_UTM_ZONE ?
+           "pass" : "fail");
+
+    // Batch into a single zone, compared with the geographic round trip
+    enum { REPS = 20 };
+    for (int i = 0; i < COUNT; i++)
+    {
+        // Keep eastings inside the range coord_from_utm() accepts
+        GeoCoord geo = {30.0 + 40.0 * (i % 97) / 96.0, 117.2 + 3.7 * (i % 89) / 88.0,
+                        0.0, DATUM_WGS84
+                       };
+        coord_to_utm_zone(ctx, &geo, 50, &natural[i]);
+    }
+    clock_t t0 = clock();
+    for (int rep = 0; rep < REPS; rep++)
+    {
+        for (int i = 0; i < COUNT; i++)
+        {
+            GeoCoord geo;
+            coord_from_utm(ctx, &natural[i], &geo);
+            coord_to_utm_zone(ctx, &geo, 51, &back[i]);
+        }
+    }
+    clock_t t1 = clock();
+    int ret = COORD_SUCCESS;
+    for (int rep = 0; rep < REPS && ret == COORD_SUCCESS; rep++)
+    {
+        ret = coord_utm_to_zone_batch(ctx, natural, COUNT, 51, moved);
+    }
+    clock_t t2 = clock();
+    double batch_diff = 0.0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        batch_diff = fmax(batch_diff, fmax(fabs(moved[i].easting - back[i].easting),
+                                           fabs(moved[i].northing - back[i].northing)));
+    }
+    printf("  Batch zone 50 -> 51 matches geographic route (%.2e m): %s\n",
+           batch_diff, ret == COORD_SUCCESS && batch_diff < 1e-6 ? "pass" : "fail");
+    printf("    %d points x%d: via geographic %.2f ms, direct %.2f ms\n", COUNT, REPS,
+           1000.0 * (t1 - t0) / CLOCKS_PER_SEC, 1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test the UTM/MGRS batch engine on globally shuffled input
+void test_utm_batch()
+{
+    printf("=== Test UTM/MGRS batch projection ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    enum { COUNT = 200000 };
+    GeoCoord *pts = (GeoCoord *)malloc(COUNT * sizeof(GeoCoord));
+    UTMPoint *single = (UTMPoint *)malloc(COUNT * sizeof(UTMPoint));
+    UTMPoint *batch = (UTMPoint *)malloc(COUNT * sizeof(UTMPoint));
+    MGRSPoint *mgrs = (MGRSPoint *)malloc(COUNT * sizeof(MGRSPoint));
+    if (!pts || !single || !batch || !mgrs)
+    {
+        printf("  Allocation failed\n");
+        free(pts);
+        free(single);
+        free(batch);
+        free(mgrs);
+        coord_destroy_context(ctx);
+        return;
+    }
+    unsigned long seed = 12345;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double u = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double v = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        pts[i].latitude = -80.0 + 163.9 * u;
+        pts[i].longitude = -180.0 + 359.9 * v;
+        pts[i].altitude = 0.0;
+        pts[i].datum = DATUM_WGS84;
+    }
+    // The antimeridian, north and south (180E is in zone 1)
+    const double antimeridian[4][2] = {{10.0, 180.0}, {-10.0, 180.0},
+        {10.0, -180.0}, {-10.0, -180.0}
+    };
+    for (int i = 0; i < 4; i++)
+    {
+        pts[i].latitude = antimeridian[i][0];
+        pts[i].longitude = antimeridian[i][1];
+    }
+    clock_t t0 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        coord_to_utm(ctx, &pts[i], &single[i]);
+    }
+    clock_t t1 = clock();
+    int ret = coord_to_utm_batch(ctx, pts, COUNT, batch);
+    clock_t t2 = clock();
+    int ret2 = coord_to_mgrs_batch(ctx, pts, COUNT, mgrs);
+    int mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        MGRSPoint m;
+        coord_to_mgrs(ctx, &pts[i], &m);
+        mismatches += single[i].zone != batch[i].zone || single[i].band != batch[i].band ||
+                      single[i].easting != batch[i].easting ||
+                      single[i].northing != batch[i].northing ||
+                      single[i].convergence != batch[i].convergence;
+        mismatches += strcmp(m.square, mgrs[i].square) != 0 || m.band != mgrs[i].band ||
+                      m.easting != mgrs[i].easting || m.northing != mgrs[i].northing;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        mismatches += batch[i].easting < 100000.0 || batch[i].easting > 900000.0;
+    }
+    printf("  Batch results identical and in input order: %s\n",
+           ret == COORD_SUCCESS && ret2 == COORD_SUCCESS && mismatches == 0 ?
+           "pass" : "fail");
+    printf("  180E: %d%c %.0fE %.0fN, MGRS %d%c %s %05.0f %05.0f\n", batch[1].zone,
+           batch[1].band, batch[1].easting, batch[1].northing, mgrs[1].zone,
+           mgrs[1].band, mgrs[1].square, mgrs[1].easting, mgrs[1].northing);
+    double per_point = 1000.0 * (t1 - t0) / CLOCKS_PER_SEC;
+    double batched = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC;
+    printf("    %d shuffled points: per-point %.2f ms, batch %.2f ms (%.1fx)\n",
+           COUNT, per_point, batched, batched > 0.0 ? per_point / batched : 0.0);
+
+    pts[COUNT / 2].latitude = 95.0;
+    batch[0].zone = -1;
+    printf("  Invalid point rejects batch before output: %s\n",
+           coord_to_utm_batch(ctx, pts, COUNT, batch) == COORD_ERROR_INVALID_COORD &&
+           batch[0].zone == -1 ? "pass" : "fail");
+    free(pts);
+    free(single);
+    free(batch);
+    free(mgrs);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Reference zone/band rules written as the comparison chains they replace
+static int reference_utm_zone(double lon, double lat)
+{
+    if (lat >= 56.0 && lat < 64.0 && lon >= 3.0 && lon < 12.0)
+    {
+        return 32;
+    }
+    if (lat >= 72.0 && lat < 84.0 && lon >= 0.0 && lon < 42.0)
+    {
+        return lon < 9.0 ? 31 : lon < 21.0 ? 33 : lon < 33.0 ? 35 : 37;
+    }
+    int zone = (int)((lon + 180.0) / 6.0) + 1;
+    return zone > 60 ? 60 : zone;
+}
+
+static char reference_utm_band(double lat)
+{
+    const char *letters = "CDEFGHJKLMNPQRSTUVWX";
+    if (lat < -80.0)
+    {
+        return 'C';
+    }
+    if (lat >= 72.0)
+    {
+        return 'X';
+    }
+    int i = 0;
+    while (lat >= -72.0 + 8.0 * i)
+    {
+        i++;
+    }
+    return letters[i];
+}
+
+// Test the table-driven zone/band classifier against the reference rules
+void test_utm_classifier()
+{
+    printf("=== Test table-driven UTM classifier ===\n");
+    enum { COUNT = 200000 };
+    int mismatches = 0;
+    // Every 0.25 degree, plus points just either side of each edge
+    for (int i = 0; i <= 4 * 180; i++)
+    {
+        for (int j = 0; j < 4 * 360; j++)
+        {
+            for (int k = -1; k <= 1; k++)
+            {
+                double lat = nextafter(-90.0 + 0.25 * i, k < 0 ? -100.0 : 100.0);
+                double lon = nextafter(-180.0 + 0.25 * j, k < 0 ? -200.0 : 200.0);
+                lat = k == 0 ? -90.0 + 0.25 * i : lat;
+                lon = k == 0 ? -180.0 + 0.25 * j : lon;
+                if (lat < -90.0 || lat > 90.0 || lon < -180.0)
+                {
+                    continue;
+                }
+                mismatches += coord_get_utm_zone(lon, lat) != reference_utm_zone(lon, lat);
+                mismatches += coord_get_utm_band(lat) != reference_utm_band(lat);
+            }
+        }
+    }
+    printf("  Matches reference rules on a 0.25 degree grid and edges: %s\n",
+           mismatches == 0 ? "pass" : "fail");
+    printf("  84N is band X (was Z): %s\n",
+           coord_get_utm_band(84.0) == 'X' && coord_get_utm_zone(10.0, 84.0) == 32 ?
+           "pass" : "fail");
+
+    GeoCoord *pts = (GeoCoord *)malloc(COUNT * sizeof(GeoCoord));
+    int *zones = (int *)malloc(COUNT * sizeof(int));
+    char *bands = (char *)malloc(COUNT);
+    if (!pts || !zones || !bands)
+    {
+        printf("  Allocation failed\n");
+        free(pts);
+        free(zones);
+        free(bands);
+        return;
+    }
+    unsigned long seed = 777;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double u = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double v = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        pts[i].latitude = -80.0 + 164.0 * u;
+        pts[i].longitude = -180.0 + 360.0 * v;
+        pts[i].altitude = 0.0;
+        pts[i].datum = DATUM_WGS84;
+    }
+    pts[7].latitude = 91.0;
+    volatile int sink = 0;
+    clock_t t0 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        sink += reference_utm_zone(pts[i].longitude, pts[i].latitude) +
+                reference_utm_band(pts[i].latitude);
+    }
+    clock_t t1 = clock();
+    size_t valid = coord_classify_utm_batch(pts, COUNT, zones, bands);
+    clock_t t2 = clock();
+    mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        if (i == 7)
+        {
+            continue;
+        }
+        mismatches += zones[i] != reference_utm_zone(pts[i].longitude, pts[i].latitude);
+        mismatches += bands[i] != reference_utm_band(pts[i].latitude);
+    }
+    printf("  Batch classifier matches, invalid point masked: %s\n",
+           mismatches == 0 && valid == COUNT - 1 && zones[7] == 0 && bands[7] == 'Z' ?
+           "pass" : "fail");
+    double chains = 1000.0 * (t1 - t0) / CLOCKS_PER_SEC;
+    double table = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC;
+    printf("    %d shuffled points: comparison chains %.2f ms, table batch %.2f ms\n",
+           COUNT, chains, table);
+    free(pts);
+    free(zones);
+    free(bands);
+    (void)sink;
+    printf("\n");
+}
+
+// Test packed (SoA and lat/lon pair) batches against the GeoCoord batches
+void test_packed_batches()
+{
+    printf("=== Test packed batch layouts ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    enum { COUNT = 100000 };
+    GeoCoord *pts = (GeoCoord *)malloc(COUNT * sizeof(GeoCoord));
+    UTMPoint *ref = (UTMPoint *)malloc(COUNT * sizeof(UTMPoint));
+    double *lat = (double *)malloc(COUNT * sizeof(double));
+    double *lon = (double *)malloc(COUNT * sizeof(double));
+    double *pairs = (double *)malloc(2 * COUNT * sizeof(double));
+    double *en = (double *)malloc(2 * COUNT * sizeof(double));
+    unsigned char *zone = (unsigned char *)malloc(COUNT);
+    char *band = (char *)malloc(COUNT);
+    MGRSPoint *mgrs_ref = (MGRSPoint *)malloc(COUNT * sizeof(MGRSPoint));
+    MGRSPoint *mgrs = (MGRSPoint *)malloc(COUNT * sizeof(MGRSPoint));
+    if (!pts || !ref || !lat || !lon || !pairs || !en || !zone || !band ||
+            !mgrs_ref || !mgrs)
+    {
+        printf("  Allocation failed\n");
+        free(pts);
+        free(ref);
+        free(lat);
+        free(lon);
+        free(pairs);
+        free(en);
+        free(zone);
+        free(band);
+        free(mgrs_ref);
+        free(mgrs);
+        coord_destroy_context(ctx);
+        return;
+    }
+    unsigned long seed = 4242;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double u = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double v = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        pts[i].latitude = -80.0 + 163.9 * u;
+        pts[i].longitude = -180.0 + 359.9 * v;
+        pts[i].altitude = 0.0;
+        pts[i].datum = DATUM_WGS84;
+        lat[i] = pairs[2 * i] = pts[i].latitude;
+        lon[i] = pairs[2 * i + 1] = pts[i].longitude;
+    }
+    clock_t t0 = clock();
+    coord_to_utm_batch(ctx, pts, COUNT, ref);
+    clock_t t1 = clock();
+    GeoBatch geo = coord_geo_batch_pairs(pairs, COUNT, DATUM_WGS84);
+    UTMBatch utm = coord_utm_batch_pairs(en, zone, band, 0, DATUM_WGS84);
+    int ret = coord_to_utm_packed(ctx, &geo, &utm);
+    clock_t t2 = clock();
+    int mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        mismatches += en[2 * i] != ref[i].easting || en[2 * i + 1] != ref[i].northing ||
+                      zone[i] != ref[i].zone || band[i] != ref[i].band;
+    }
+    printf("  Pairs -> packed UTM matches GeoCoord batch: %s\n",
+           ret == COORD_SUCCESS && utm.count == COUNT && mismatches == 0 ? "pass" : "fail");
+    double aos = 1000.0 * (t1 - t0) / CLOCKS_PER_SEC;
+    double packed = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC;
+    printf("    %d points: GeoCoord/UTMPoint %.2f ms (%zu bytes/point), "
+           "packed %.2f ms (%zu bytes/point)\n", COUNT, aos,
+           sizeof(GeoCoord) + sizeof(UTMPoint), packed, 4 * sizeof(double) + 2);
+
+    GeoBatch soa = coord_geo_batch_soa(lat, lon, NULL, COUNT, DATUM_WGS84);
+    coord_to_mgrs_batch(ctx, pts, COUNT, mgrs_ref);
+    ret = coord_to_mgrs_packed(ctx, &soa, mgrs);
+    mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        mismatches += strcmp(mgrs[i].square, mgrs_ref[i].square) != 0 ||
+                      mgrs[i].easting != mgrs_ref[i].easting ||
+                      mgrs[i].northing != mgrs_ref[i].northing;
+    }
+    printf("  SoA -> MGRS matches GeoCoord batch: %s\n",
+           ret == COORD_SUCCESS && mismatches == 0 ? "pass" : "fail");
+
+    // Inverse into SoA arrays, compared with per-point coord_from_utm()
+    ret = coord_from_utm_packed(ctx, &utm, &soa);
+    mismatches = 0;
+    for (int i = 0; i < COUNT; i += 97)
+    {
+        GeoCoord back;
+        coord_from_utm(ctx, &ref[i], &back);
+        mismatches += lat[i] != back.latitude || lon[i] != back.longitude;
+    }
+    printf("  Packed UTM -> SoA matches coord_from_utm: %s\n",
+           ret == COORD_SUCCESS && mismatches == 0 ? "pass" : "fail");
+
+    // The other batch APIs through packed views: the first points of the SoA
+    // arrays against GeoCoord copies of the same values
+    enum { SUB = 2000 };
+    GeoCoord *sub = (GeoCoord *)malloc(SUB * sizeof(GeoCoord));
+    ECEFPoint *ecef = (ECEFPoint *)malloc(2 * SUB * sizeof(ECEFPoint));
+    ENUPoint *enu = (ENUPoint *)malloc(2 * SUB * sizeof(ENUPoint));
+    CoordValue *values = (CoordValue *)malloc(2 * SUB * sizeof(CoordValue));
+    GeoCoord *back = (GeoCoord *)malloc(SUB * sizeof(GeoCoord));
+    double *lat2 = (double *)malloc(6 * SUB * sizeof(double));
+    size_t *order = (size_t *)malloc(SUB * sizeof(size_t));
+    uint64_t mask[2][(SUB + 63) / 64];
+    if (sub && ecef && enu && values && back && lat2 && order)
+    {
+        double *lon2 = lat2 + SUB, *alt2 = lat2 + 2 * SUB;
+        for (int i = 0; i < SUB; i++)
+        {
+            sub[i].latitude = lat[i];
+            sub[i].longitude = lon[i];
+            sub[i].altitude = 0.0;
+            sub[i].datum = DATUM_WGS84;
+        }
+        GeoBatch view = coord_geo_batch_soa(lat, lon, NULL, SUB, DATUM_WGS84);
+        GeoBatch out = coord_geo_batch_soa(lat2, lon2, alt2, 0, DATUM_WGS84);
+        mismatches = 0;
+        int r1 = coord_to_ecef_packed(ctx, &view, ecef);
+        coord_to_ecef_batch(ctx, sub, SUB, ecef + SUB);
+        int r2 = coord_from_ecef_packed(ctx, ecef, SUB, &out);
+        coord_from_ecef_batch(ctx, ecef, SUB, back);
+        for (int i = 0; i < SUB; i++)
+        {
+            mismatches += ecef[i].x != ecef[SUB + i].x || ecef[i].y != ecef[SUB + i].y ||
+                          ecef[i].z != ecef[SUB + i].z || lat2[i] != back[i].latitude ||
+                          lon2[i] != back[i].longitude || alt2[i] != back[i].altitude;
+        }
+        printf("  ECEF packed forms match GeoCoord batches: %s\n",
+               r1 == COORD_SUCCESS && r2 == COORD_SUCCESS && out.count == SUB &&
+               mismatches == 0 ? "pass" : "fail");
+
+        LocalOrigin origin;
+        coord_init_local_origin(ctx, &sub[0], &origin);
+        mismatches = 0;
+        r1 = coord_to_enu_packed(ctx, &origin, &view, enu);
+        coord_to_enu_batch(ctx, &origin, sub, SUB, enu + SUB);
+        r2 = coord_from_enu_packed(ctx, &origin, enu, SUB, &out);
+        coord_from_enu_batch(ctx, &origin, enu, SUB, back);
+        for (int i = 0; i < SUB; i++)
+        {
+            mismatches += enu[i].east != enu[SUB + i].east ||
+                          enu[i].north != enu[SUB + i].north || enu[i].up != enu[SUB + i].up ||
+                          lat2[i] != back[i].latitude || lon2[i] != back[i].longitude;
+        }
+        printf("  ENU packed forms match GeoCoord batches: %s\n",
+               r1 == COORD_SUCCESS && r2 == COORD_SUCCESS && mismatches == 0 ? "pass" :
+               "fail");
+
+        // Typed, in input and in Hilbert order
+        mismatches = 0;
+        r1 = coord_convert_typed_packed(ctx, &view, COORD_FORMAT_MGRS, DATUM_ED50, values);
+        coord_convert_typed_batch(ctx, sub, SUB, COORD_FORMAT_MGRS, DATUM_ED50, values + SUB);
+        coord_locality_order(ctx, &view, LOCALITY_HILBERT, order);
+        r2 = coord_convert_typed_packed_ordered(ctx, &view, order, COORD_FORMAT_MGRS,
+                                                DATUM_ED50, values);
+        for (int i = 0; i < SUB; i++)
+        {
+            char t1[64], t2[64];
+            coord_format_value(&values[i], t1, sizeof(t1));
+            coord_format_value(&values[SUB + i], t2, sizeof(t2));
+            mismatches += strcmp(t1, t2) != 0;
+        }
+        printf("  Typed packed batch (input and Hilbert order) matches: %s\n",
+               r1 == COORD_SUCCESS && r2 == COORD_SUCCESS && mismatches == 0 ? "pass" :
+               "fail");
+
+        // Prevalidated: same mask, same results; point 5 is out of range
+        double saved = lat[5];
+        lat[5] = sub[5].latitude = 95.0;
+        size_t valid = coord_validate_packed(&view, mask[0]);
+        size_t valid_ref = coord_validate_batch(sub, SUB, mask[1]);
+        UTMBatch tu = coord_utm_batch_soa(lat2, lon2, zone, band, 0, DATUM_WGS84);
+        r1 = coord_to_utm_packed_trusted(ctx, &view, mask[0], &tu);
+        coord_to_utm_batch_trusted(ctx, sub, SUB, mask[1], ref);
+        r2 = coord_to_mgrs_packed_trusted(ctx, &view, mask[0], mgrs);
+        coord_to_mgrs_batch_trusted(ctx, sub, SUB, mask[1], mgrs_ref);
+        mismatches = memcmp(mask[0], mask[1], sizeof(mask[0])) != 0;
+        for (int i = 0; i < SUB; i++)
+        {
+            mismatches += lat2[i] != ref[i].easting || lon2[i] != ref[i].northing ||
+                          zone[i] != ref[i].zone || band[i] != ref[i].band ||
+                          strcmp(mgrs[i].square, mgrs_ref[i].square) != 0 ||
+                          mgrs[i].zone != mgrs_ref[i].zone ||
+                          mgrs[i].easting != mgrs_ref[i].easting;
+        }
+        view.datum = DATUM_MAX;
+        size_t none = coord_validate_packed(&view, mask[0]);
+        view.datum = DATUM_WGS84;
+        printf("  Trusted packed batch matches (%zu of %d valid): %s\n", valid, SUB,
+               r1 == COORD_SUCCESS && r2 == COORD_SUCCESS && valid == valid_ref &&
+               valid == SUB - 1 && zone[5] == 0 && none == 0 && mismatches == 0 ?
+               "pass" : "fail");
+        lat[5] = sub[5].latitude = saved;
+
+        // Mesh over pairs; a view on another datum is refused
+        ProjectionMesh *mesh = coord_mesh_create(ctx, COORD_FORMAT_UTM, DATUM_WGS84,
+                               31.0, 32.0, 121.0, 122.0, 0.01, MESH_INTERP_BICUBIC);
+        for (int i = 0; i < SUB; i++)
+        {
+            lat2[i] = 31.0 + (i % 50) / 50.0;
+            lon2[i] = 121.0 + (i / 50) / 40.0;
+            alt2[2 * i] = lat2[i];
+            alt2[2 * i + 1] = lon2[i];
+        }
+        GeoBatch mesh_pairs = coord_geo_batch_pairs(alt2, SUB, DATUM_WGS84);
+        double *me = (double *)ecef, *mn = me + SUB, *me2 = mn + SUB, *mn2 = me2 + SUB;
+        r1 = coord_mesh_eval_packed(mesh, &mesh_pairs, me, mn);
+        coord_mesh_eval_batch(mesh, lat2, lon2, SUB, me2, mn2);
+        coord_locality_order(ctx, &mesh_pairs, LOCALITY_MORTON, order);
+        r2 = coord_mesh_eval_packed_ordered(mesh, &mesh_pairs, order, me, mn);
+        mismatches = 0;
+        for (int i = 0; i < SUB; i++)
+        {
+            mismatches += me[i] != me2[i] || mn[i] != mn2[i];
+        }
+        mesh_pairs.datum = DATUM_ED50;
+        printf("  Mesh packed batch matches, other datum refused: %s\n",
+               mesh && r1 == COORD_SUCCESS && r2 == COORD_SUCCESS && mismatches == 0 &&
+               coord_mesh_eval_packed(mesh, &mesh_pairs, me, mn) ==
+               COORD_ERROR_INVALID_INPUT ? "pass" : "fail");
+        coord_mesh_destroy(mesh);
+    }
+    free(sub);
+    free(ecef);
+    free(enu);
+    free(values);
+    free(back);
+    free(lat2);
+    free(order);
+
+    // In-place datum shift of the pairs with one datum tag for the batch
+    GeoCoord shifted[16];
+    coord_convert_datum_batch(ctx, pts, 16, DATUM_ED50, shifted);
+    geo.count = 16;
+    ret = coord_convert_datum_packed(ctx, &geo, DATUM_ED50, &geo);
+    mismatches = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        mismatches += pairs[2 * i] != shifted[i].latitude ||
+                      pairs[2 * i + 1] != shifted[i].longitude;
+    }
+    printf("  In-place packed datum shift: %s\n",
+           ret == COORD_SUCCESS && geo.datum == DATUM_ED50 && mismatches == 0 ?
+           "pass" : "fail");
+
+    geo.datum = DATUM_MAX;
+    int bad_datum = coord_to_utm_packed(ctx, &geo, &utm);
+    lat[0] = 95.0;
+    soa.count = 1;
+    int bad_point = coord_to_mgrs_packed(ctx, &soa, mgrs);
+    printf("  Bad datum and bad point rejected: %s\n",
+           bad_datum == COORD_ERROR_INVALID_INPUT &&
+           bad_point == COORD_ERROR_INVALID_COORD ? "pass" : "fail");
+    free(pts);
+    free(ref);
+    free(lat);
+    free(lon);
+    free(pairs);
+    free(en);
+    free(zone);
+    free(band);
+    free(mgrs_ref);
+    free(mgrs);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test compressed track encoding, streaming decode and track length
+void test_compressed_track()
+{
+    printf("=== Test compressed track codec ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    enum { COUNT = 100000, CHUNK = 256 };
+    double *pairs = (double *)malloc(2 * COUNT * sizeof(double));
+    unsigned char *buffer = (unsigned char *)malloc(16 * COUNT + 32);
+    if (!pairs || !buffer)
+    {
+        printf("  Allocation failed\n");
+        free(pairs);
+        free(buffer);
+        coord_destroy_context(ctx);
+        return;
+    }
+    // ~3 m random-walk steps from Oslo, like a 1 Hz activity recording
+    unsigned long seed = 99;
+    double lat = 59.91, lon = 10.75, heading = 0.0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        heading += ((double)((seed >> 11) & 0xFFFF) / 65536.0 - 0.5) * 0.5;
+        lat += 2.7e-5 * cos(heading);
+        lon += 5.4e-5 * sin(heading);
+        pairs[2 * i] = lat;
+        pairs[2 * i + 1] = lon;
+    }
+    GeoBatch track = coord_geo_batch_pairs(pairs, COUNT, DATUM_WGS84);
+    double reference = 0.0;
+    for (int i = 1; i < COUNT; i++)
+    {
+        GeoCoord p1 = {pairs[2 * i - 2], pairs[2 * i - 1], 0.0, DATUM_WGS84};
+        GeoCoord p2 = {pairs[2 * i], pairs[2 * i + 1], 0.0, DATUM_WGS84};
+        double d;
+        coord_distance(ctx, &p1, &p2, &d, NULL, NULL);
+        reference += d;
+    }
+
+    const char *names[TRACK_CODEC_MAX] = {"E7", "UTM cm"};
+    const double tolerance[TRACK_CODEC_MAX] = {5.1e-8, 2e-7};
+    for (int codec = 0; codec < TRACK_CODEC_MAX; codec++)
+    {
+        size_t needed = 0, size = 0;
+        coord_track_encode(ctx, &track, (TrackCodec)codec, NULL, 0, &needed);
+        int ret = coord_track_encode(ctx, &track, (TrackCodec)codec, buffer,
+                                     16 * COUNT + 32, &size);
+        printf("  %s: %zu bytes (%.2f bytes/point, %.1fx smaller than lat/lon "
+               "doubles, %.1fx than GeoCoord): %s\n", names[codec], size,
+               (double)size / COUNT, 16.0 * COUNT / size, 32.0 * COUNT / size,
+               ret == COORD_SUCCESS && size == needed ? "pass" : "fail");
+
+        // Stream chunks through the packed UTM batch without a full array
+        TrackDecoder dec;
+        double lat_chunk[CHUNK], lon_chunk[CHUNK], en[2 * CHUNK];
+        unsigned char zones[CHUNK];
+        char bands[CHUNK];
+        GeoBatch chunk = coord_geo_batch_soa(lat_chunk, lon_chunk, NULL, 0,
+                                             DATUM_WGS84);
+        UTMBatch utm = coord_utm_batch_pairs(en, zones, bands, 0, DATUM_WGS84);
+        double max_err = 0.0;
+        size_t decoded = 0;
+        clock_t t0 = clock();
+        ret = coord_track_decoder_init(ctx, buffer, size, &dec);
+        while (ret == COORD_SUCCESS)
+        {
+            ret = coord_track_decode(&dec, CHUNK, &chunk);
+            if (ret != COORD_SUCCESS || chunk.count == 0)
+            {
+                break;
+            }
+            ret = coord_to_utm_packed(ctx, &chunk, &utm);
+            for (size_t i = 0; i < chunk.count; i++)
+            {
+                size_t k = decoded + i;
+                max_err = fmax(max_err, fabs(lat_chunk[i] - pairs[2 * k]));
+                max_err = fmax(max_err, fabs(lon_chunk[i] - pairs[2 * k + 1]));
+            }
+            decoded += chunk.count;
+        }
+        clock_t t1 = clock();
+        double length = 0.0;
+        int length_ret = coord_track_length(ctx, buffer, size, &length);
+        clock_t t2 = clock();
+        printf("  %s: streamed %zu points, max error %.1e deg: %s\n", names[codec],
+               decoded, max_err, ret == COORD_SUCCESS && decoded == COUNT &&
+               max_err <= tolerance[codec] ? "pass" : "fail");
+        printf("  %s: length %.2f m vs geodesic %.2f m: %s\n", names[codec], length,
+               reference, length_ret == COORD_SUCCESS &&
+               fabs(length - reference) < 1e-5 * reference ? "pass" : "fail");
+        printf("    decode+project %.2f ms, length scan %.2f ms\n",
+               1000.0 * (t1 - t0) / CLOCKS_PER_SEC, 1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+
+        ret = coord_track_length(ctx, buffer, size - 1, &length);
+        printf("  %s: truncated buffer rejected: %s\n", names[codec],
+               ret == COORD_ERROR_PARSE_FAILED ? "pass" : "fail");
+    }
+    free(pairs);
+    free(buffer);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test Hilbert/Morton locality ordering of shuffled batches
+void test_locality_order()
+{
+    printf("=== Test locality-ordered batches ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    enum { COUNT = 400000 };
+    double *lat = (double *)malloc(COUNT * sizeof(double));
+    double *lon = (double *)malloc(COUNT * sizeof(double));
+    double *e = (double *)malloc(4 * COUNT * sizeof(double));
+    size_t *order = (size_t *)malloc(COUNT * sizeof(size_t));
+    if (!lat || !lon || !e || !order)
+    {
+        printf("  Allocation failed\n");
+        free(lat);
+        free(lon);
+        free(e);
+        free(order);
+        coord_destroy_context(ctx);
+        return;
+    }
+    double *n = e + COUNT, *e2 = e + 2 * COUNT, *n2 = e + 3 * COUNT;
+    // National dataset: shuffled points over Great Britain, evaluated through
+    // a dense British Grid mesh (the grid-shift style lookup path)
+    unsigned long seed = 31337;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double u = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double v = (double)((seed >> 11) & 0xFFFFF) / 1048576.0;
+        lat[i] = 50.0 + 8.5 * u;
+        lon[i] = -6.0 + 7.5 * v;
+    }
+    GeoBatch geo = coord_geo_batch_soa(lat, lon, NULL, COUNT, DATUM_WGS84);
+    ProjectionMesh *mesh = coord_mesh_create(ctx, COORD_FORMAT_BRITISH_GRID,
+                           DATUM_WGS84, 50.0, 58.5, -6.0, 1.5, 0.1,
+                           MESH_INTERP_BILINEAR);
+    if (mesh)
+    {
+        const char *curves[LOCALITY_MAX] = {"Morton", "Hilbert"};
+        clock_t t0 = clock();
+        coord_mesh_eval_batch(mesh, lat, lon, COUNT, e, n);
+        clock_t t1 = clock();
+        printf("    %d points, %zu-cell mesh: input order %.2f ms\n", COUNT,
+               coord_mesh_cell_count(mesh), 1000.0 * (t1 - t0) / CLOCKS_PER_SEC);
+        for (int c = 0; c < LOCALITY_MAX; c++)
+        {
+            clock_t t2 = clock();
+            int ret = coord_locality_order(ctx, &geo, (LocalityCurve)c, order);
+            clock_t t3 = clock();
+            coord_mesh_eval_batch_ordered(mesh, lat, lon, COUNT, order, e2, n2);
+            clock_t t4 = clock();
+            int mismatches = 0;
+            for (int i = 0; i < COUNT; i++)
+            {
+                mismatches += e[i] != e2[i] || n[i] != n2[i];
+            }
+            printf("  %s-ordered mesh batch matches input order: %s\n", curves[c],
+                   ret == COORD_SUCCESS && mismatches == 0 ? "pass" : "fail");
+            printf("    %s: ordering %.2f ms, ordered evaluation %.2f ms\n", curves[c],
+                   1000.0 * (t3 - t2) / CLOCKS_PER_SEC,
+                   1000.0 * (t4 - t3) / CLOCKS_PER_SEC);
+        }
+        coord_mesh_destroy(mesh);
+    }
+    else
+    {
+        printf("  Failed to create mesh\n");
+    }
+
+    // The order is a permutation and consecutive points are close together
+    char *seen = (char *)calloc(COUNT, 1);
+    int permutation = seen != NULL;
+    double step_shuffled = 0.0, step_ordered = 0.0;
+    for (int i = 0; permutation && i < COUNT; i++)
+    {
+        permutation = order[i] < COUNT && !seen[order[i]];
+        seen[order[i]] = 1;
+        if (i > 0)
+        {
+            step_shuffled += hypot(lat[i] - lat[i - 1], lon[i] - lon[i - 1]);
+            step_ordered += hypot(lat[order[i]] - lat[order[i - 1]],
+                                  lon[order[i]] - lon[order[i - 1]]);
+        }
+    }
+    free(seen);
+    printf("  Hilbert order is a permutation with short steps: %s\n",
+           permutation && step_ordered * 100.0 < step_shuffled ? "pass" : "fail");
+
+    // Global dataset through the typed UTM batch
+    GeoCoord *pts = (GeoCoord *)malloc(COUNT / 4 * sizeof(GeoCoord));
+    CoordValue *v1 = (CoordValue *)malloc(COUNT / 4 * sizeof(CoordValue));
+    CoordValue *v2 = (CoordValue *)malloc(COUNT / 4 * sizeof(CoordValue));
+    if (pts && v1 && v2)
+    {
+        for (int i = 0; i < COUNT / 4; i++)
+        {
+            pts[i].latitude = -80.0 + 164.0 * (lat[i] - 50.0) / 8.5;
+            pts[i].longitude = -180.0 + 360.0 * (lon[i] + 6.0) / 7.5;
+            pts[i].altitude = 0.0;
+            pts[i].datum = DATUM_WGS84;
+        }
+        GeoBatch global = coord_geo_batch_soa(&pts[0].latitude, &pts[0].longitude,
+                                              NULL, COUNT / 4, DATUM_WGS84);
+        global.stride = sizeof(GeoCoord) / sizeof(double);
+        clock_t t0 = clock();
+        coord_convert_typed_batch(ctx, pts, COUNT / 4, COORD_FORMAT_UTM,
+                                  DATUM_WGS84, v1);
+        clock_t t1 = clock();
+        int ret = coord_locality_order(ctx, &global, LOCALITY_HILBERT, order);
+        ret |= coord_convert_typed_batch_ordered(ctx, pts, COUNT / 4, order,
+                COORD_FORMAT_UTM, DATUM_WGS84, v2);
+        clock_t t2 = clock();
+        int mismatches = 0;
+        for (int i = 0; i < COUNT / 4; i++)
+        {
+            mismatches += v1[i].value.utm.easting != v2[i].value.utm.easting ||
+                          v1[i].value.utm.northing != v2[i].value.utm.northing ||
+                          v1[i].value.utm.zone != v2[i].value.utm.zone;
+        }
+        printf("  Hilbert-ordered global typed batch matches: %s\n",
+               ret == COORD_SUCCESS && mismatches == 0 ? "pass" : "fail");
+        printf("    %d global points to UTM: input order %.2f ms, "
+               "ordered (incl. ordering) %.2f ms\n", COUNT / 4,
+               1000.0 * (t1 - t0) / CLOCKS_PER_SEC, 1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+    }
+    free(pts);
+    free(v1);
+    free(v2);
+    free(lat);
+    free(lon);
+    free(e);
+    free(order);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test Web Mercator tiles and the fixed-point tile path
+void test_web_mercator()
+{
+    printf("=== Test Web Mercator tiles ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    // Reference tile (slippy-map formula) and pixel round trip
+    GeoCoord london = {51.5074, -0.1278, 0.0, DATUM_WGS84};
+    WebMercatorPoint wm;
+    GeoCoord back;
+    int ret = coord_to_web_mercator(ctx, &london, 15, &wm);
+    printf("  London z15 tile 16372/10896: %s\n",
+           ret == COORD_SUCCESS && wm.x == 16372 && wm.y == 10896 &&
+           fabs(wm.pixel_x - 94.044) < 1e-3 && fabs(wm.pixel_y - 50.259) < 1e-3 ?
+           "pass" : "fail");
+    ret = coord_from_web_mercator(ctx, &wm, &back);
+    printf("  Pixel round trip: %s\n",
+           ret == COORD_SUCCESS && fabs(back.latitude - london.latitude) < 1e-9 &&
+           fabs(back.longitude - london.longitude) < 1e-9 ? "pass" : "fail");
+
+    // Edges, limits and the datum shift through the context
+    GeoCoord pole = {86.0, 0.0, 0.0, DATUM_WGS84};
+    GeoCoord east = {-85.0511287798, 180.0, 0.0, DATUM_WGS84};
+    WebMercatorPoint edge;
+    printf("  Polar latitude rejected, east/south edge in last tile: %s\n",
+           coord_to_web_mercator(ctx, &pole, 10, &wm) == COORD_ERROR_OUT_OF_RANGE &&
+           coord_to_web_mercator(ctx, &east, 10, &edge) == COORD_SUCCESS &&
+           edge.x == 1023 && edge.pixel_x == 256.0 && edge.y == 1023 &&
+           coord_to_web_mercator(ctx, &london, 31, &wm) == COORD_ERROR_INVALID_INPUT ?
+           "pass" : "fail");
+    GeoCoord ed50, shifted;
+    WebMercatorPoint wm_ed50, wm_wgs;
+    coord_convert_datum(ctx, &london, DATUM_ED50, &ed50);
+    coord_convert_datum(ctx, &ed50, DATUM_WGS84, &shifted);
+    coord_to_web_mercator(ctx, &ed50, 20, &wm_ed50);
+    coord_to_web_mercator(ctx, &shifted, 20, &wm_wgs);
+    printf("  ED50 input shifted to WGS84 tiles: %s\n",
+           wm_ed50.x == wm_wgs.x && wm_ed50.y == wm_wgs.y &&
+           wm_ed50.pixel_x == wm_wgs.pixel_x && wm_ed50.datum == DATUM_WGS84 ?
+           "pass" : "fail");
+
+    // String format through the context zoom, parsing and auto-detection
+    char buffer[64];
+    GeoCoord tokyo = {35.6812, 139.7671, 0.0, DATUM_WGS84};
+    coord_set_tile_zoom(ctx, 18);
+    ret = coord_convert(ctx, &tokyo, COORD_FORMAT_WEB_MERCATOR, DATUM_WGS84, buffer,
+                        sizeof(buffer));
+    ParseResult parsed = coord_auto_parse(buffer);
+    ParseResult centre = coord_parse_string("18/232847/103226",
+                                            COORD_FORMAT_WEB_MERCATOR, DATUM_WGS84);
+    printf("  Format \"%s\", auto-parse round trip: %s\n", buffer,
+           ret == COORD_SUCCESS && strcmp(buffer, "18/232847/103226 (75.85, 147.02)") == 0 &&
+           parsed.success && fabs(parsed.coord.latitude - tokyo.latitude) < 1e-6 &&
+           fabs(parsed.coord.longitude - tokyo.longitude) < 1e-6 &&
+           centre.success && fabs(centre.coord.latitude - tokyo.latitude) < 1e-3 ?
+           "pass" : "fail");
+
+    // 1M random points: per point, packed, and fixed-point tile indices
+    enum { COUNT = 1000000 };
+    double *lat_lon = (double *)malloc(2 * COUNT * sizeof(double));
+    WebMercatorPoint *tiles = (WebMercatorPoint *)malloc(COUNT * sizeof(WebMercatorPoint));
+    uint32_t *tx = (uint32_t *)malloc(2 * COUNT * sizeof(uint32_t));
+    if (!lat_lon || !tiles || !tx)
+    {
+        printf("  Allocation failed\n");
+        free(lat_lon);
+        free(tiles);
+        free(tx);
+        coord_destroy_context(ctx);
+        return;
+    }
+    uint32_t *ty = tx + COUNT;
+    unsigned long seed = 4242;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lat_lon[2 * i] = -85.0 + 170.0 * (double)(seed >> 11) / 9007199254740992.0;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lat_lon[2 * i + 1] = -180.0 + 360.0 * (double)(seed >> 11) / 9007199254740992.0;
+    }
+    GeoBatch geo = coord_geo_batch_pairs(lat_lon, COUNT, DATUM_WGS84);
+    clock_t t0 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        GeoCoord p = {lat_lon[2 * i], lat_lon[2 * i + 1], 0.0, DATUM_WGS84};
+        coord_to_web_mercator(ctx, &p, 17, &tiles[i]);
+    }
+    clock_t t1 = clock();
+    ret = coord_to_web_mercator_packed(ctx, &geo, 17, tiles);
+    clock_t t2 = clock();
+    ret |= coord_web_mercator_tiles(ctx, &geo, 17, tx, ty);
+    clock_t t3 = clock();
+    int mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        mismatches += (uint32_t)tiles[i].x != tx[i] || (uint32_t)tiles[i].y != ty[i];
+    }
+    // Every zoom level, on a subset
+    GeoBatch subset = coord_geo_batch_pairs(lat_lon, COUNT / 100, DATUM_WGS84);
+    for (int z = 0; z <= 30; z++)
+    {
+        ret |= coord_to_web_mercator_packed(ctx, &subset, z, tiles);
+        ret |= coord_web_mercator_tiles(ctx, &subset, z, tx, ty);
+        for (int i = 0; i < COUNT / 100; i++)
+        {
+            mismatches += (uint32_t)tiles[i].x != tx[i] || (uint32_t)tiles[i].y != ty[i];
+        }
+    }
+    printf("  Fixed-point tiles match the exact path at zooms 0-30: %s\n",
+           ret == COORD_SUCCESS && mismatches == 0 ? "pass" : "fail");
+    printf("    %d points at z17: per point %.2f ms, packed %.2f ms, "
+           "tile indices %.2f ms\n", COUNT, 1000.0 * (t1 - t0) / CLOCKS_PER_SEC,
+           1000.0 * (t2 - t1) / CLOCKS_PER_SEC, 1000.0 * (t3 - t2) / CLOCKS_PER_SEC);
+    free(lat_lon);
+    free(tiles);
+    free(tx);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Reference geohash by interval bisection, one bit at a time
+static void geohash_reference(double lat, double lon, int precision, char *hash)
+{
+    static const char alphabet[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+    double lat_lo = -90.0, lat_hi = 90.0, lon_lo = -180.0, lon_hi = 180.0;
+    int bit = 0, value = 0, n = 0;
+    while (n < precision)
+    {
+        double *lo = bit % 2 == 0 ? &lon_lo : &lat_lo;
+        double *hi = bit % 2 == 0 ? &lon_hi : &lat_hi;
+        double v = bit % 2 == 0 ? lon : lat;
+        double mid = (*lo + *hi) / 2.0;
+        value = value * 2 + (v >= mid);
+        *(v >= mid ? lo : hi) = mid;
+        if (++bit % 5 == 0)
+        {
+            hash[n++] = alphabet[value];
+            value = 0;
+        }
+    }
+    hash[n] = '\0';
+}
+
+// Test Geohash and quadkey cells
+void test_geohash_quadkey()
+{
+    printf("=== Test Geohash and quadkey ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    // Published examples and round trips
+    GeoCoord jutland = {57.64911, 10.40744, 0.0, DATUM_WGS84};
+    GeohashPoint gh;
+    GeoCoord back;
+    int ret = coord_to_geohash(ctx, &jutland, 11, &gh);
+    ret |= coord_from_geohash(ctx, &gh, &back);
+    printf("  Geohash \"%s\" and cell centre: %s\n", gh.hash,
+           ret == COORD_SUCCESS && strcmp(gh.hash, "u4pruydqqvj") == 0 &&
+           fabs(back.latitude - jutland.latitude) < 1e-5 &&
+           fabs(back.longitude - jutland.longitude) < 1e-5 ? "pass" : "fail");
+    QuadkeyPoint qk;
+    WebMercatorPoint wm;
+    GeoCoord tile_centre;
+    wm.zoom = 3;
+    wm.x = 3;
+    wm.y = 5;
+    wm.pixel_x = wm.pixel_y = 128.0;
+    coord_from_web_mercator(ctx, &wm, &tile_centre);
+    ret = coord_to_quadkey(ctx, &tile_centre, 3, &qk);
+    ret |= coord_from_quadkey(ctx, &qk, &back);
+    printf("  Quadkey of tile 3/3/5 is \"%s\" and decodes to its centre: %s\n", qk.key,
+           ret == COORD_SUCCESS && strcmp(qk.key, "213") == 0 &&
+           fabs(back.latitude - tile_centre.latitude) < 1e-9 &&
+           fabs(back.longitude - tile_centre.longitude) < 1e-9 ? "pass" : "fail");
+
+    // Datum is kept by Geohash; quadkeys are shifted to WGS84 tiles
+    GeoCoord ed50;
+    GeohashPoint gh_ed50;
+    coord_convert_datum(ctx, &jutland, DATUM_ED50, &ed50);
+    coord_to_geohash(ctx, &ed50, 12, &gh_ed50);
+    coord_from_geohash(ctx, &gh_ed50, &back);
+    printf("  Geohash keeps the datum: %s\n",
+           gh_ed50.datum == DATUM_ED50 && back.datum == DATUM_ED50 &&
+           strncmp(gh_ed50.hash, "u4pruydqqvj", 11) != 0 ? "pass" : "fail");
+
+    // Strings: format, explicit and automatic parsing
+    char buffer[64];
+    ParseResult hash_parse = coord_auto_parse("u4pruydqqvj");
+    ParseResult key_parse = coord_auto_parse(" 213 ");
+    ParseResult bad = coord_parse_string("u4pa", COORD_FORMAT_GEOHASH, DATUM_WGS84);
+    ret = coord_format_to_string(&jutland, COORD_FORMAT_GEOHASH, buffer, sizeof(buffer));
+    printf("  Format \"%s\", auto-parse and rejects: %s\n", buffer,
+           ret == COORD_SUCCESS && strcmp(buffer, "u4pruydqqvj8") == 0 &&
+           hash_parse.success && hash_parse.format == COORD_FORMAT_GEOHASH &&
+           fabs(hash_parse.coord.latitude - jutland.latitude) < 1e-5 &&
+           key_parse.success && key_parse.format == COORD_FORMAT_QUADKEY &&
+           fabs(key_parse.coord.latitude - tile_centre.latitude) < 1e-9 &&
+           !bad.success ? "pass" : "fail");
+
+    // 1M random points against the bisection reference and the tile path
+    enum { COUNT = 1000000 };
+    double *lat_lon = (double *)malloc(2 * COUNT * sizeof(double));
+    uint64_t *codes = (uint64_t *)malloc(2 * COUNT * sizeof(uint64_t));
+    GeohashPoint *hashes = (GeohashPoint *)malloc(COUNT * sizeof(GeohashPoint));
+    if (!lat_lon || !codes || !hashes)
+    {
+        printf("  Allocation failed\n");
+        free(lat_lon);
+        free(codes);
+        free(hashes);
+        coord_destroy_context(ctx);
+        return;
+    }
+    uint64_t *short_codes = codes + COUNT;
+    unsigned long seed = 977;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lat_lon[2 * i] = -85.0 + 170.0 * (double)(seed >> 11) / 9007199254740992.0;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lat_lon[2 * i + 1] = -180.0 + 360.0 * (double)(seed >> 11) / 9007199254740992.0;
+    }
+    GeoBatch geo = coord_geo_batch_pairs(lat_lon, COUNT, DATUM_WGS84);
+    clock_t t0 = clock();
+    char reference[13];
+    int mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        geohash_reference(lat_lon[2 * i], lat_lon[2 * i + 1], 12, reference);
+        mismatches += reference[11] == '\0';
+    }
+    clock_t t1 = clock();
+    ret = coord_to_geohash_packed(ctx, &geo, 12, hashes);
+    clock_t t2 = clock();
+    ret |= coord_geohash_codes(&geo, 12, codes);
+    clock_t t3 = clock();
+    ret |= coord_geohash_codes(&geo, 5, short_codes);
+    for (int i = 0; i < COUNT; i++)
+    {
+        geohash_reference(lat_lon[2 * i], lat_lon[2 * i + 1], 12, reference);
+        mismatches += strcmp(reference, hashes[i].hash) != 0 ||
+                      codes[i] >> 35 != short_codes[i];
+    }
+    printf("  Geohashes match bisection, codes keep prefixes: %s\n",
+           ret == COORD_SUCCESS && mismatches == 0 ? "pass" : "fail");
+    printf("    %d points, 12 chars: bisection %.2f ms, interleaved strings %.2f ms, "
+           "integer codes %.2f ms\n", COUNT, 1000.0 * (t1 - t0) / CLOCKS_PER_SEC,
+           1000.0 * (t2 - t1) / CLOCKS_PER_SEC, 1000.0 * (t3 - t2) / CLOCKS_PER_SEC);
+
+    // Quadkey codes against the Web Mercator tiles they interleave
+    uint32_t *tile_x = (uint32_t *)hashes;
+    uint32_t *tile_y = tile_x + COUNT;
+    clock_t t4 = clock();
+    ret = coord_quadkey_codes(ctx, &geo, 17, codes);
+    clock_t t5 = clock();
+    ret |= coord_web_mercator_tiles(ctx, &geo, 17, tile_x, tile_y);
+    mismatches = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        uint64_t expected = 0;
+        for (int b = 16; b >= 0; b--)
+        {
+            expected = (expected << 2) | ((tile_x[i] >> b) & 1) |
+                       (((tile_y[i] >> b) & 1) << 1);
+        }
+        mismatches += codes[i] != expected;
+    }
+    GeoCoord first = {lat_lon[0], lat_lon[1], 0.0, DATUM_WGS84};
+    ret |= coord_to_quadkey(ctx, &first, 17, &qk);
+    mismatches += strtoull(qk.key, NULL, 4) != codes[0];
+    printf("  Quadkey codes interleave the Web Mercator tiles: %s\n",
+           ret == COORD_SUCCESS && mismatches == 0 ? "pass" : "fail");
+    printf("    %d points, zoom 17 quadkey codes %.2f ms\n", COUNT,
+           1000.0 * (t5 - t4) / CLOCKS_PER_SEC);
+    free(lat_lon);
+    free(codes);
+    free(hashes);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+static int label_compare(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+// Test grid-cell aggregation against per-point MGRS labels
+void test_grid_aggregation()
+{
+    printf("=== Test grid-cell aggregation ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    CoordContext *ctx2 = coord_create_context(DATUM_WGS84);
+    if (!ctx || !ctx2)
+    {
+        printf("Failed to create context\n");
+        coord_destroy_context(ctx);
+        coord_destroy_context(ctx2);
+        return;
+    }
+    // Known squares
+    char label[64];
+    GeoCoord london = {51.5074, -0.1278, 0.0, DATUM_WGS84};
+    GridAggregator *bng = coord_grid_agg_create(ctx, COORD_FORMAT_BRITISH_GRID, 1000.0);
+    GridAggregator *mgrs = coord_grid_agg_create(ctx, COORD_FORMAT_MGRS, 1000.0);
+    GeoBatch one = coord_geo_batch_soa(&london.latitude, &london.longitude, NULL, 1,
+                                       DATUM_WGS84);
+    GridCell cell;
+    int ret = coord_grid_agg_add(bng, &one, NULL);
+    ret |= coord_grid_agg_cells(bng, &cell, 1) != 1;
+    ret |= coord_grid_cell_label(bng, cell.key, label, sizeof(label));
+    BritishGridPoint bg;
+    char expected[64];
+    coord_to_british_grid(ctx, &london, &bg);
+    snprintf(expected, sizeof(expected), "%s %02d %02d", bg.letters,
+             (int)fmod(bg.easting, 100000.0) / 1000, (int)fmod(bg.northing, 100000.0) / 1000);
+    printf("  London British Grid 1 km square \"%s\": %s\n", label,
+           ret == COORD_SUCCESS && strcmp(label, expected) == 0 ? "pass" : "fail");
+    double far_lat[2] = {40.7128, 85.0}, far_lon[2] = {-74.0060, 10.0};
+    GeoBatch far = coord_geo_batch_soa(far_lat, far_lon, NULL, 2, DATUM_WGS84);
+    ret = coord_grid_agg_add(bng, &far, NULL);
+    ret |= coord_grid_agg_add(mgrs, &far, NULL);
+    printf("  Points beyond the grids counted as outside: %s\n",
+           ret == COORD_SUCCESS && coord_grid_agg_outside(bng) == 2 &&
+           coord_grid_agg_outside(mgrs) == 1 &&
+           coord_grid_agg_create(ctx, COORD_FORMAT_MGRS, 500.0) == NULL ?
+           "pass" : "fail");
+    coord_grid_agg_destroy(bng);
+    coord_grid_agg_destroy(mgrs);
+
+    // The antimeridian, north and south: 180E and 180W share zone 1
+    double edge_lat[4] = {10.0, -10.0, 10.0, -10.0};
+    double edge_lon[4] = {180.0, 180.0, -180.0, -180.0};
+    GeoBatch edge = coord_geo_batch_soa(edge_lat, edge_lon, NULL, 4, DATUM_WGS84);
+    GridCell edge_cells[4];
+    mgrs = coord_grid_agg_create(ctx, COORD_FORMAT_MGRS, 1000.0);
+    ret = coord_grid_agg_add(mgrs, &edge, NULL);
+    size_t n_edge = coord_grid_agg_cells(mgrs, edge_cells, 4);
+    int edge_ok = ret == COORD_SUCCESS && n_edge == 2 &&
+                  coord_grid_agg_outside(mgrs) == 0;
+    for (int i = 0; edge_ok && i < 2; i++)
+    {
+        GeoCoord p = {edge_lat[i], edge_lon[i], 0.0, DATUM_WGS84};
+        MGRSPoint m;
+        coord_to_mgrs(ctx, &p, &m);
+        snprintf(expected, sizeof(expected), "%d%c %s %02d %02d", m.zone, m.band,
+                 m.square, (int)m.easting / 1000, (int)m.northing / 1000);
+        int found = 0;
+        for (size_t c = 0; c < n_edge; c++)
+        {
+            coord_grid_cell_label(mgrs, edge_cells[c].key, label, sizeof(label));
+            found |= strcmp(label, expected) == 0 && edge_cells[c].count == 2;
+        }
+        edge_ok &= found;
+    }
+    printf("  180E/180W at 10N and 10S land in their zone 1 squares: %s\n",
+           edge_ok ? "pass" : "fail");
+    coord_grid_agg_destroy(mgrs);
+
+    // 1M points over southern England and northern France (bands U, zones
+    // 30-31), split across two aggregators and merged
+    enum { COUNT = 1000000 };
+    double *lat_lon = (double *)malloc(2 * COUNT * sizeof(double));
+    double *values = (double *)malloc(COUNT * sizeof(double));
+    char (*labels)[24] = (char (*)[24])malloc(COUNT * sizeof(*labels));
+    GridCell *cells = NULL;
+    mgrs = coord_grid_agg_create(ctx, COORD_FORMAT_MGRS, 1000.0);
+    GridAggregator *part = coord_grid_agg_create(ctx2, COORD_FORMAT_MGRS, 1000.0);
+    if (!lat_lon || !values || !labels || !mgrs || !part)
+    {
+        printf("  Allocation failed\n");
+        free(lat_lon);
+        free(values);
+        free(labels);
+        coord_grid_agg_destroy(mgrs);
+        coord_grid_agg_destroy(part);
+        coord_destroy_context(ctx);
+        coord_destroy_context(ctx2);
+        return;
+    }
+    unsigned long seed = 2718;
+    double total = 0.0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lat_lon[2 * i] = 49.0 + 2.5 * (double)(seed >> 11) / 9007199254740992.0;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        lat_lon[2 * i + 1] = -1.5 + 3.0 * (double)(seed >> 11) / 9007199254740992.0;
+        values[i] = (double)(i % 7);
+        total += values[i];
+    }
+    GeoBatch half1 = coord_geo_batch_pairs(lat_lon, COUNT / 2, DATUM_WGS84);
+    GeoBatch half2 = coord_geo_batch_pairs(lat_lon + COUNT, COUNT - COUNT / 2,
+                                           DATUM_WGS84);
+    clock_t t0 = clock();
+    ret = coord_grid_agg_add(mgrs, &half1, values);
+    ret |= coord_grid_agg_add(part, &half2, values + COUNT / 2);
+    ret |= coord_grid_agg_merge(mgrs, part);
+    clock_t t1 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        GeoCoord p = {lat_lon[2 * i], lat_lon[2 * i + 1], 0.0, DATUM_WGS84};
+        MGRSPoint m;
+        coord_to_mgrs(ctx, &p, &m);
+        snprintf(labels[i], sizeof(labels[i]), "%d%c %s %02d %02d", m.zone, m.band,
+                 m.square, (int)m.easting / 1000, (int)m.northing / 1000);
+    }
+    clock_t t2 = clock();
+    qsort(labels, COUNT, sizeof(labels[0]), label_compare);
+    size_t distinct = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        distinct += i == 0 || strcmp(labels[i], labels[i - 1]) != 0;
+    }
+    size_t n_cells = coord_grid_agg_cells(mgrs, NULL, 0);
+    cells = (GridCell *)malloc(n_cells * sizeof(GridCell));
+    int mismatches = cells == NULL || n_cells != distinct;
+    double sum = 0.0;
+    uint64_t counted = 0;
+    if (cells)
+    {
+        coord_grid_agg_cells(mgrs, cells, n_cells);
+        for (size_t c = 0; c < n_cells; c++)
+        {
+            // Count of the label among the per-point references
+            coord_grid_cell_label(mgrs, cells[c].key, label, sizeof(label));
+            char *first = (char *)bsearch(label, labels, COUNT, sizeof(labels[0]),
+                                          label_compare);
+            size_t lo = first ? (size_t)(first - labels[0]) / sizeof(labels[0]) : 0;
+            size_t hi = lo;
+            while (lo > 0 && strcmp(labels[lo - 1], label) == 0)
+            {
+                lo--;
+            }
+            while (first && hi < COUNT && strcmp(labels[hi], label) == 0)
+            {
+                hi++;
+            }
+            mismatches += !first || hi - lo != cells[c].count;
+            sum += cells[c].sum;
+            counted += cells[c].count;
+        }
+    }
+    printf("  %zu merged 1 km cells match per-point MGRS labels: %s\n", n_cells,
+           ret == COORD_SUCCESS && mismatches == 0 && counted == COUNT &&
+           fabs(sum - total) < 1e-6 * total ? "pass" : "fail");
+    printf("    %d points: aggregation %.2f ms, coord_to_mgrs + label %.2f ms\n",
+           COUNT, 1000.0 * (t1 - t0) / CLOCKS_PER_SEC,
+           1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+    free(cells);
+    free(lat_lon);
+    free(values);
+    free(labels);
+    coord_grid_agg_destroy(mgrs);
+    coord_grid_agg_destroy(part);
+    coord_destroy_context(ctx);
+    coord_destroy_context(ctx2);
+    printf("\n");
+}
+
+// Release callbacks of the test's own producer arrays, whose buffers are static
+static void arrow_static_release(struct ArrowArray *array)
+{
+    array->release = NULL;
+}
+
+static void arrow_static_release_schema(struct ArrowSchema *schema)
+{
+    schema->release = NULL;
+}
+
+// Test Arrow C Data Interface import in place and export against per-point calls
+void test_arrow_interface()
+{
+    printf("=== Test Arrow C Data Interface ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    AllocCounter counter = {0, 0, 0, 0};
+    coord_context_set_allocator(ctx, counting_malloc, counting_realloc,
+                                counting_free, &counter);
+
+    // Producer columns holding one leading row that the offset slices away
+    enum { ROWS = 200000 };
+    double *lat_values = (double *)malloc((ROWS + 1) * sizeof(double));
+    double *lon_values = (double *)malloc((ROWS + 1) * sizeof(double));
+    char (*texts)[32] = (char (*)[32])malloc(ROWS * sizeof(*texts));
+    if (!lat_values || !lon_values || !texts)
+    {
+        printf("  Allocation failed\n");
+        free(lat_values);
+        free(lon_values);
+        free(texts);
+        coord_destroy_context(ctx);
+        return;
+    }
+    for (int i = 0; i <= ROWS; i++)
+    {
+        lat_values[i] = -79.0 + fmod(i * 37.31, 162.0);
+        lon_values[i] = -180.0 + fmod(i * 91.73, 360.0);
+    }
+    uint8_t validity[ROWS / 8 + 1];
+    const void *lat_buffers[2] = {NULL, lat_values};
+    const void *lon_buffers[2] = {NULL, lon_values};
+    struct ArrowSchema g = {"g", "lat", NULL, 0, 0, NULL, NULL,
+                            arrow_static_release_schema, NULL
+                           };
+    struct ArrowSchema f = g;
+    f.format = "f";
+    struct ArrowArray lat = {ROWS, 0, 1, 2, 0, lat_buffers, NULL, NULL,
+                             arrow_static_release, NULL
+                            };
+    struct ArrowArray lon = lat;
+    lon.buffers = lon_buffers;
+    GeoBatch geo;
+    int ret = coord_arrow_import_columns(&g, &lat, &g, &lon, NULL, NULL,
+                                         DATUM_WGS84, &geo);
+    printf("  float64 columns viewed in place at their offset: %s\n",
+           ret == COORD_SUCCESS && geo.lat == lat_values + 1 &&
+           geo.lon == lon_values + 1 && geo.stride == 1 && geo.count == ROWS ?
+           "pass" : "fail");
+
+    // Nulls in the used range and non-float64 columns are refused
+    GeoBatch refused;
+    memset(validity, 0xFF, sizeof(validity));
+    validity[13] &= (uint8_t)~(1u << 5);
+    lat_buffers[0] = validity;
+    lat.null_count = 1;
+    ret = coord_arrow_import_columns(&g, &lat, &g, &lon, NULL, NULL, DATUM_WGS84,
+                                     &refused) == COORD_ERROR_INVALID_INPUT;
+    lat_buffers[0] = NULL;
+    lat.null_count = 0;
+    ret &= coord_arrow_import_columns(&f, &lat, &g, &lon, NULL, NULL, DATUM_WGS84,
+                                      &refused) == COORD_ERROR_INVALID_INPUT;
+    printf("  Null slots and float32 columns refused: %s\n", ret ? "pass" : "fail");
+
+    // MGRS utf8 against coord_to_mgrs + coord_format_mgrs
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    clock_t t0 = clock();
+    ret = coord_arrow_export_mgrs(ctx, &geo, &schema, &array);
+    clock_t t1 = clock();
+    for (int i = 0; i < ROWS; i++)
+    {
+        GeoCoord p = {lat_values[i + 1], lon_values[i + 1], 0.0, DATUM_WGS84};
+        MGRSPoint m;
+        coord_to_mgrs(ctx, &p, &m);
+        coord_format_mgrs(&m, texts[i], sizeof(texts[i]));
+    }
+    clock_t t2 = clock();
+    int mismatches = ret != COORD_SUCCESS;
+    if (ret == COORD_SUCCESS)
+    {
+        const int32_t *offsets = (const int32_t *)array.buffers[1];
+        const char *text = (const char *)array.buffers[2];
+        mismatches += strcmp(schema.format, "u") != 0 || array.length != ROWS;
+        for (int i = 0; i < ROWS; i++)
+        {
+            size_t len = (size_t)(offsets[i + 1] - offsets[i]);
+            mismatches += len != strlen(texts[i]) ||
+                          memcmp(text + offsets[i], texts[i], len) != 0;
+        }
+        array.release(&array);
+        schema.release(&schema);
+    }
+    printf("  MGRS utf8 column matches coord_format_mgrs: %s\n",
+           mismatches == 0 ? "pass" : "fail");
+    printf("    %d rows: Arrow export %.2f ms, coord_to_mgrs + format %.2f ms\n",
+           ROWS, 1000.0 * (t1 - t0) / CLOCKS_PER_SEC,
+           1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+
+    // UTM struct; a child moved out outlives its released parent
+    ret = coord_arrow_export_utm(ctx, &geo, &schema, &array);
+    mismatches = ret != COORD_SUCCESS;
+    if (ret == COORD_SUCCESS)
+    {
+        struct ArrowArray easting = *array.children[2];
+        array.children[2]->release = NULL;
+        const unsigned char *zone = (const unsigned char *)array.children[0]->buffers[1];
+        const char *band = (const char *)array.children[1]->buffers[2];
+        mismatches += strcmp(schema.format, "+s") != 0 || schema.n_children != 4 ||
+                      strcmp(schema.children[3]->name, "northing") != 0;
+        for (int i = 0; i < ROWS; i += 97)
+        {
+            GeoCoord p = {lat_values[i + 1], lon_values[i + 1], 0.0, DATUM_WGS84};
+            UTMPoint u;
+            coord_to_utm(ctx, &p, &u);
+            mismatches += zone[i] != u.zone || band[i] != u.band;
+        }
+        array.release(&array);
+        schema.release(&schema);
+        for (int i = 0; i < ROWS; i += 97)
+        {
+            GeoCoord p = {lat_values[i + 1], lon_values[i + 1], 0.0, DATUM_WGS84};
+            UTMPoint u;
+            coord_to_utm(ctx, &p, &u);
+            mismatches += fabs(((const double *)easting.buffers[1])[i] - u.easting) > 1e-6;
+        }
+        easting.release(&easting);
+    }
+    printf("  UTM struct matches coord_to_utm, moved child kept: %s\n",
+           mismatches == 0 ? "pass" : "fail");
+
+    // ED50 struct, sliced and imported back by field name
+    ret = coord_arrow_export_datum(ctx, &geo, DATUM_ED50, &schema, &array);
+    mismatches = ret != COORD_SUCCESS;
+    if (ret == COORD_SUCCESS)
+    {
+        array.offset = 10;
+        array.length = ROWS - 10;
+        GeoBatch back;
+        ret = coord_arrow_import_struct(&schema, &array, "lat", "lon", NULL,
+                                        DATUM_ED50, &back);
+        mismatches += ret != COORD_SUCCESS || back.count != ROWS - 10 ||
+                      back.lat != (const double *)array.children[0]->buffers[1] + 10 ||
+                      coord_arrow_import_struct(&schema, &array, "lat", "height", NULL,
+                                                DATUM_ED50, &refused) == COORD_SUCCESS;
+        for (size_t i = 0; ret == COORD_SUCCESS && i < back.count; i += 101)
+        {
+            GeoCoord p = {lat_values[i + 11], lon_values[i + 11], 0.0, DATUM_WGS84};
+            GeoCoord q;
+            coord_convert_datum(ctx, &p, DATUM_ED50, &q);
+            mismatches += fabs(back.lat[i] - q.latitude) > 1e-12 ||
+                          fabs(back.lon[i] - q.longitude) > 1e-12;
+        }
+        array.release(&array);
+        schema.release(&schema);
+    }
+    printf("  ED50 struct export imports back by field name: %s\n",
+           mismatches == 0 ? "pass" : "fail");
+    printf("  Exports freed through the context allocator: %s\n",
+           counter.mallocs > 0 && counter.live == 0 ? "pass" : "fail");
+
+    free(lat_values);
+    free(lon_values);
+    free(texts);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Error of got against want, in units of the last place of want
+static double ulp_error(double got, double want)
+{
+    if (got == want)
+    {
+        return 0.0;
+    }
+    double ulp = nextafter(fabs(want), HUGE_VAL) - fabs(want);
+    return fabs(got - want) / ulp;
+}
+
+// Correctly rounded sin/cos, atan2 and asinh (from long double), so that the
+// libm build is checked against something other than itself
+static const double trig_sincos_refs[][3] =
+{
+    {0.5, 0.47942553860420301, 0.87758256189037276},
+    {-1.0, -0.8414709848078965, 0.54030230586813977},
+    {0.78539816339744828, 0.70710678118654746, 0.70710678118654757},
+    {2.0943951023931957, 0.86602540378443849, -0.50000000000000022},
+    {2.6179938779914944, 0.49999999999999994, -0.86602540378443871},
+    {-0.95993108859688125, -0.8191520442889918, 0.57357643635104616},
+    {-3.0, -0.14112000805986721, -0.98999249660044542},
+    {0.001, 0.00099999983333334168, 0.99999950000004167},
+    {1e-9, 1e-9, 1.0},
+    // Multiples of pi/2 and a neighbour, where the reduction cancels
+    {1.5707963267948966, 1.0, 6.123233995736766e-17},
+    {1.5707963267948968, 1.0, -1.6081226496766366e-16},
+    {3.1415926535897931, 1.2246467991473532e-16, -1.0},
+    {-3.1415926535897931, -1.2246467991473532e-16, -1.0},
+    {4.7123889803846897, -1.0, -1.8369701987210297e-16},
+    {6.2831853071795862, -2.4492935982947064e-16, 1.0},
+    {-6.2831853071795862, 2.4492935982947064e-16, 1.0},
+    {1570.7963267948965, -1.6070832296378168e-13, 1.0},
+    {1570796.3267948965, -1.1159560906804355e-10, 1.0},
+};
+
+static const double trig_atan2_refs[][3] =
+{
+    {1.0, 1.0, 0.78539816339744828},
+    {4500000.0, -3200000.0, 2.188940552730084},
+    {-6356752.3, 1200.0, -1.5706075511545834},
+    {-1.0, -0.001, -1.5717963264615635},
+    {0.3, 5.0, 0.059928155121207881},
+    {5.0, 0.3, 1.5108681716736887},
+    {2500000.0, -2500000.0, 2.3561944901923448},
+    {-1e-8, -6378137.0, -3.1415926535897918},
+};
+
+static const double trig_asinh_refs[][2] =
+{
+    {1e-10, 1e-10},
+    {0.25, 0.24746646154726346},
+    {-0.41421356237309498, -0.40319971916151143},
+    {0.51540500909047759, 0.49494786161076032},
+    {1.0, 0.88137358701954305},
+    {2.0, 1.4436354751788103},
+    {-2.0000000000000004, -1.4436354751788105},
+    {11.430052302761343, 3.1313013314716449},      // tan(85 degrees)
+    {100000.0, 12.206072645555174},
+    {-30000000.0, -17.909855120186375},
+    {1e300, 691.46867507877369},
+};
+
+// Test the trig kernels against stored values and, when they are the fast
+// kernels, against libm over geodetic and geocentric ranges
+void test_trig_kernels()
+{
+    printf("=== Test trig kernels ===\n");
+    double ref_sincos = 0.0, ref_atan2 = 0.0, ref_asinh = 0.0;
+    for (size_t i = 0; i < sizeof(trig_sincos_refs) / sizeof(trig_sincos_refs[0]); i++)
+    {
+        double s, c;
+        coord_sincos(trig_sincos_refs[i][0], &s, &c);
+        ref_sincos = fmax(ref_sincos, fmax(ulp_error(s, trig_sincos_refs[i][1]),
+                                           ulp_error(c, trig_sincos_refs[i][2])));
+    }
+    for (size_t i = 0; i < sizeof(trig_atan2_refs) / sizeof(trig_atan2_refs[0]); i++)
+    {
+        ref_atan2 = fmax(ref_atan2, ulp_error(coord_atan2(trig_atan2_refs[i][0],
+                                              trig_atan2_refs[i][1]), trig_atan2_refs[i][2]));
+    }
+    for (size_t i = 0; i < sizeof(trig_asinh_refs) / sizeof(trig_asinh_refs[0]); i++)
+    {
+        ref_asinh = fmax(ref_asinh, ulp_error(coord_asinh(trig_asinh_refs[i][0]),
+                                              trig_asinh_refs[i][1]));
+    }
+#if defined(COORD_FAST_TRIG)
+    printf("  Kernels: minimax (COORD_FAST_TRIG)\n");
+#else
+    printf("  Kernels: libm; build with -DCOORD_FAST_TRIG to test the minimax ones\n");
+#endif
+    printf("  sincos within 1 ulp of stored values (max %.2f): %s\n", ref_sincos,
+           ref_sincos <= 1.0 ? "pass" : "fail");
+    printf("  atan2 within 2 ulp of stored values (max %.2f): %s\n", ref_atan2,
+           ref_atan2 <= 2.0 ? "pass" : "fail");
+    printf("  asinh within 2 ulp of stored values (max %.2f): %s\n", ref_asinh,
+           ref_asinh <= 2.0 ? "pass" : "fail");
+
+    enum { COUNT = 1000000 };
+    double *x = (double *)malloc(COUNT * sizeof(double));
+    double *y = (double *)malloc(COUNT * sizeof(double));
+    if (!x || !y)
+    {
+        printf("  Allocation failed\n");
+        free(x);
+        free(y);
+        return;
+    }
+    unsigned long seed = 98;
+    for (int i = 0; i < COUNT; i++)
+    {
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        x[i] = ((double)(seed >> 11) / 9007199254740992.0 - 0.5) * 12.566370614359172;  // +-2 pi
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        y[i] = ((double)(seed >> 11) / 9007199254740992.0 - 0.5) * 1.3e7;
+    }
+
+#if defined(COORD_FAST_TRIG)
+    // Angles within +-2 pi, ECEF-sized atan2 arguments in all quadrants, and
+    // asinh of the tangents of the angles (Web Mercator isometric latitudes)
+    double sincos_ulp = 0.0;
+    double atan2_ulp = 0.0;
+    double asinh_ulp = 0.0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        double s, c;
+        coord_sincos(x[i], &s, &c);
+        sincos_ulp = fmax(sincos_ulp, fmax(ulp_error(s, sin(x[i])),
+                                           ulp_error(c, cos(x[i]))));
+        double yx = y[i] * x[i] / 6.0;
+        atan2_ulp = fmax(atan2_ulp, ulp_error(coord_atan2(y[i], yx), atan2(y[i], yx)));
+        double t = tan(x[i]);
+        asinh_ulp = fmax(asinh_ulp, ulp_error(coord_asinh(t), asinh(t)));
+    }
+    // Multiples of pi/2 (180E, the poles) and their neighbours, where the
+    // reduced argument cancels, up to the end of the fast reduction
+    double multiple_ulp = 0.0;
+    for (int k = -600; k <= 600; k++)
+    {
+        double base = (k < -500 || k > 500 ? k * 1000.0 : k) * 1.5707963267948966;
+        for (int d = -2; d <= 2; d++)
+        {
+            double angle = base;
+            for (int step = 0; step < abs(d); step++)
+            {
+                angle = nextafter(angle, d < 0 ? -HUGE_VAL : HUGE_VAL);
+            }
+            double s, c;
+            coord_sincos(angle, &s, &c);
+            multiple_ulp = fmax(multiple_ulp, fmax(ulp_error(s, sin(angle)),
+                                                   ulp_error(c, cos(angle))));
+        }
+    }
+    double s0, c0;
+    coord_sincos(0.0, &s0, &c0);
+    int specials = s0 == 0.0 && c0 == 1.0 && coord_atan2(0.0, -1.0) == atan2(0.0, -1.0) &&
+                   coord_atan2(-1.0, 0.0) == atan2(-1.0, 0.0) &&
+                   coord_atan2(1.0, -HUGE_VAL) == atan2(1.0, -HUGE_VAL) &&
+                   coord_asinh(-0.0) == 0.0 && signbit(coord_asinh(-0.0)) &&
+                   coord_asinh(-HUGE_VAL) == -HUGE_VAL && isnan(coord_asinh(NAN));
+    coord_sincos(1e9, &s0, &c0);
+    specials &= s0 == sin(1e9) && c0 == cos(1e9);
+    printf("  sincos within 1 ulp of libm (max %.2f): %s\n", sincos_ulp,
+           sincos_ulp <= 1.0 ? "pass" : "fail");
+    printf("  sincos at k pi/2 within 1 ulp of libm (max %.2f): %s\n", multiple_ulp,
+           multiple_ulp <= 1.0 ? "pass" : "fail");
+    printf("  atan2 within 2 ulp of libm (max %.2f): %s\n", atan2_ulp,
+           atan2_ulp <= 2.0 ? "pass" : "fail");
+    printf("  asinh within 1 ulp of libm (max %.2f): %s\n", asinh_ulp,
+           asinh_ulp <= 1.0 ? "pass" : "fail");
+    printf("  Zeros, infinities and huge angles follow libm: %s\n",
+           specials ? "pass" : "fail");
+#endif
+
+    // Per-call cost against libm sin + cos and atan2
+    volatile double sink = 0.0;
+    clock_t t0 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        double s, c;
+        coord_sincos(x[i], &s, &c);
+        sink += s + c;
+    }
+    clock_t t1 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        sink += sin(x[i]) + cos(x[i]);
+    }
+    clock_t t2 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        sink += coord_atan2(y[i], x[i]);
+    }
+    clock_t t3 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        sink += atan2(y[i], x[i]);
+    }
+    clock_t t4 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        sink += coord_asinh(x[i]);
+    }
+    clock_t t5 = clock();
+    for (int i = 0; i < COUNT; i++)
+    {
+        sink += asinh(x[i]);
+    }
+    clock_t t6 = clock();
+    double ms = 1000.0 / CLOCKS_PER_SEC;
+    printf("    %d calls: sincos %.2f ms, libm sin + cos %.2f ms, atan2 %.2f ms, "
+           "libm %.2f ms, asinh %.2f ms, libm %.2f ms\n", COUNT, ms * (t1 - t0),
+           ms * (t2 - t1), ms * (t3 - t2), ms * (t4 - t3), ms * (t5 - t4),
+           ms * (t6 - t5));
+    free(x);
+    free(y);
+    printf("\n");
+}
+
+// Test shared default transform tables and lazily created geodesic objects
+void test_shared_context_tables()
+{
+    printf("=== Test shared context tables ===\n");
+    AllocCounter counter = {0, 0, 0, 0};
+    coord_set_allocator(counting_malloc, counting_realloc, counting_free, &counter);
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    CoordContext *other = coord_create_context(DATUM_WGS84);
+    coord_set_allocator(NULL, NULL, NULL, NULL);
+    if (!ctx || !other)
+    {
+        printf("Failed to create context\n");
+        coord_destroy_context(ctx);
+        coord_destroy_context(other);
+        return;
+    }
+    printf("  Context is %zu bytes, one allocation each: %s\n", sizeof(CoordContext),
+           sizeof(CoordContext) <= 256 && counter.mallocs == 2 &&
+           ctx->transforms == other->transforms ? "pass" : "fail");
+
+    // The geodesic object appears on first use, once
+    GeoCoord london = {51.5074, -0.1278, 0.0, DATUM_WGS84};
+    GeoCoord paris = {48.8566, 2.3522, 0.0, DATUM_WGS84};
+    double first = 0.0, second = 0.0;
+    int ret = coord_distance(ctx, &london, &paris, &first, NULL, NULL);
+    ret |= coord_distance(ctx, &london, &paris, &second, NULL, NULL);
+    printf("  Geodesic created on first distance (%.2f m): %s\n", first,
+           ret == COORD_SUCCESS && counter.mallocs == 3 && first == second &&
+           fabs(first - 343923.12) < 0.1 ? "pass" : "fail");
+
+    // Writing parameters copies the table for that context only
+    DatumTransform custom = {-10.0, 150.0, 170.0, 0.0, 0.0, 0.0, 0.0};
+    DatumTransform seen, untouched;
+    GeoCoord shifted, reference;
+    ret = coord_set_transform_params(ctx, DATUM_WGS84, DATUM_NAD27, &custom);
+    ret |= coord_get_transform_params(ctx, DATUM_WGS84, DATUM_NAD27, &seen);
+    ret |= coord_get_transform_params(other, DATUM_WGS84, DATUM_NAD27, &untouched);
+    ret |= coord_convert_datum(ctx, &london, DATUM_NAD27, &shifted);
+    ret |= coord_convert_datum(other, &london, DATUM_NAD27, &reference);
+    int copied = ctx->transforms != other->transforms && counter.mallocs == 4;
+    ret |= coord_set_transform_params(ctx, DATUM_WGS84, DATUM_ED50, &custom);
+    printf("  Copy on first write, other contexts unchanged: %s\n",
+           ret == COORD_SUCCESS && copied && counter.mallocs == 4 &&
+           seen.dx == -10.0 && untouched.dx == -8.0 &&
+           shifted.latitude != reference.latitude ? "pass" : "fail");
+    coord_destroy_context(ctx);
+    coord_destroy_context(other);
+    printf("  Copies and geodesic freed with the context: %s\n",
+           counter.live == 0 ? "pass" : "fail");
+
+    // Many short-lived contexts, as in per-connection or per-thread use
+    enum { CONTEXTS = 100000 };
+    clock_t t0 = clock();
+    for (int i = 0; i < CONTEXTS; i++)
+    {
+        CoordContext *c = coord_create_context(DATUM_WGS84);
+        GeoCoord out;
+        coord_convert_datum(c, &london, DATUM_ED50, &out);
+        coord_destroy_context(c);
+    }
+    clock_t t1 = clock();
+    printf("    %d contexts created, used and destroyed: %.2f ms\n", CONTEXTS,
+           1000.0 * (t1 - t0) / CLOCKS_PER_SEC);
+    printf("\n");
+}
+
+// Test display sessions against fresh renderings along a walking track
+void test_display_session()
+{
+    printf("=== Test display session ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    // Same text as coord_convert() at its own precisions, on random points
+    const CoordFormat formats[5] = {COORD_FORMAT_DD, COORD_FORMAT_DMM, COORD_FORMAT_DMS,
+                                    COORD_FORMAT_UTM, COORD_FORMAT_MGRS
+                                   };
+    const int precisions[5] = {6, 3, 2, 5, 5};
+    enum { RANDOM = 100000 };
+    int differ = 0, carries = 0;
+    unsigned changed;
+    for (int f = 0; f < 5; f++)
+    {
+        CoordDisplaySession session;
+        coord_display_init(ctx, formats[f], DATUM_WGS84, precisions[f], &session);
+        unsigned long seed = 1000 + f;
+        for (int i = 0; i < RANDOM; i++)
+        {
+            seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+            double u = (double)(seed >> 11) / 9007199254740992.0;
+            seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+            double v = (double)(seed >> 11) / 9007199254740992.0;
+            GeoCoord point = {-80.0 + 164.0 * u, -180.0 + 360.0 * v, 0.0, DATUM_WGS84};
+            char expected[128];
+            int ret = coord_display_update(&session, &point, &changed);
+            ret |= coord_convert(ctx, &point, formats[f], DATUM_WGS84, expected,
+                                 sizeof(expected));
+            // coord_format_dmm/dms print 60.000' or 60.00" where the session carries
+            int carried = strstr(expected, "60.000'") != NULL ||
+                          strstr(expected, "'60.00\"") != NULL;
+            carries += carried;
+            differ += ret != COORD_SUCCESS ||
+                      (!carried && strcmp(session.text, expected) != 0);
+        }
+    }
+    CoordDisplaySession mgrs_session;
+    GeoCoord london = {51.5074, -0.1278, 0.0, DATUM_WGS84};
+    coord_display_init(ctx, COORD_FORMAT_MGRS, DATUM_WGS84, 5, &mgrs_session);
+    coord_display_update(&mgrs_session, &london, &changed);
+    printf("  London: %s\n", mgrs_session.text);
+    printf("  Text matches coord_convert on %d random points per format "
+           "(%d carried): %s\n", RANDOM, carries,
+           differ == 0 && changed == 15 ? "pass" : "fail");
+
+    // Six decimals, the most DD allows
+    CoordDisplaySession dd;
+    GeoCoord tokyo = {35.6762, 139.6503, 0.0, DATUM_WGS84};
+    int ret = coord_display_init(ctx, COORD_FORMAT_DD, DATUM_WGS84, 6, &dd);
+    ret |= coord_display_update(&dd, &tokyo, &changed);
+    printf("  DD at 6 decimals: %s: %s\n", dd.text,
+           ret == COORD_SUCCESS && changed == 3 &&
+           strcmp(dd.text, "35.676200°N, 139.650300°E") == 0 ? "pass" : "fail");
+
+    // Rounding carries into minutes and degrees
+    CoordDisplaySession dms;
+    GeoCoord edge = {51.9999999, -0.0000001, 0.0, DATUM_WGS84};
+    coord_display_init(ctx, COORD_FORMAT_DMS, DATUM_WGS84, 2, &dms);
+    coord_display_update(&dms, &edge, &changed);
+    printf("  Carry: %s: %s\n", dms.text,
+           strcmp(dms.text, "52°0'0.00\"N, 0°0'0.00\"W") == 0 ? "pass" : "fail");
+
+    // Invalid fixes and formats leave the screen alone
+    GeoCoord bad = {NAN, 0.0, 0.0, DATUM_WGS84};
+    ret = coord_display_update(&dms, &bad, &changed);
+    int unsupported = coord_display_init(ctx, COORD_FORMAT_GEOHASH, DATUM_WGS84, 2, &dms);
+    int range = coord_display_init(ctx, COORD_FORMAT_MGRS, DATUM_WGS84, 6,
+                                   &mgrs_session);
+    printf("  Invalid fix, format and precision rejected: %s\n",
+           ret == COORD_ERROR_INVALID_COORD && changed == 0 &&
+           unsupported == COORD_ERROR_UNSUPPORTED_FORMAT &&
+           range == COORD_ERROR_INVALID_INPUT ? "pass" : "fail");
+
+    // One hour walking east at 1.4 m/s across the 31/32 zone boundary, then
+    // half an hour at rest, one fix per second with metre-level noise
+    enum { WALK = 3600, REST = 1800, FIXES = WALK + REST };
+    static GeoCoord fixes[FIXES];
+    unsigned long seed = 100;
+    for (int i = 0; i < FIXES; i++)
+    {
+        double t = i < WALK ? i : WALK;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double u = (double)((seed >> 11) & 0xFFFFF) / 1048576.0 - 0.5;
+        seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+        double v = (double)((seed >> 11) & 0xFFFFF) / 1048576.0 - 0.5;
+        fixes[i].latitude = 51.3 + (0.2 * t + 3.0 * u) / 111200.0;
+        fixes[i].longitude = 5.97 + (1.4 * t + 3.0 * v) / 69600.0;
+        fixes[i].altitude = 0.0;
+        fixes[i].datum = DATUM_WGS84;
+    }
+    struct
+    {
+        CoordFormat format;
+        MapDatum datum;
+        int precision;
+        const char *name;
+    } cases[] =
+    {
+        {COORD_FORMAT_DMS, DATUM_WGS84, 2, "DMS 0.01\""},
+        {COORD_FORMAT_DMS, DATUM_WGS84, 0, "DMS 1\""},
+        {COORD_FORMAT_DD, DATUM_ED50, 4, "DD 4 places, ED50"},
+        {COORD_FORMAT_UTM, DATUM_WGS84, 5, "UTM 1 m"},
+        {COORD_FORMAT_MGRS, DATUM_WGS84, 5, "MGRS 1 m"},
+        {COORD_FORMAT_MGRS, DATUM_WGS84, 4, "MGRS 10 m"},
+        {COORD_FORMAT_MGRS, DATUM_ED50, 3, "MGRS 100 m, ED50"},
+    };
+    int consistent = 1;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        CoordDisplaySession session;
+        coord_display_init(ctx, cases[c].format, cases[c].datum, cases[c].precision,
+                           &session);
+        char previous[COORD_DISPLAY_MAX_FIELDS][24];
+        int redraws = 0, fields = 0;
+        for (int i = 0; i < FIXES; i++)
+        {
+            CoordDisplaySession fresh;
+            unsigned fresh_changed;
+            ret = coord_display_update(&session, &fixes[i], &changed);
+            coord_display_init(ctx, cases[c].format, cases[c].datum,
+                               cases[c].precision, &fresh);
+            ret |= coord_display_update(&fresh, &fixes[i], &fresh_changed);
+            unsigned differs = 0;
+            for (int k = 0; k < session.field_count; k++)
+            {
+                if (i == 0 || strcmp(previous[k], session.fields[k]) != 0)
+                {
+                    differs |= 1u << k;
+                }
+                fields += (changed >> k) & 1;
+                memcpy(previous[k], session.fields[k], sizeof(previous[k]));
+            }
+            redraws += changed != 0;
+            if (ret != COORD_SUCCESS || changed != differs ||
+                    strcmp(session.text, fresh.text) != 0)
+            {
+                consistent = 0;
+            }
+        }
+        printf("    %-18s %4d of %d fixes redrawn, %5d fields formatted, "
+               "%4lu projections\n", cases[c].name, redraws, FIXES, fields,
+               session.projected_count);
+    }
+    printf("  Every update matches a fresh rendering and reports its fields: %s\n",
+           consistent ? "pass" : "fail");
+
+    // Per-second cost against formatting every fix
+    enum { ROUNDS = 20 };
+    char text[64];
+    volatile int sink = 0;
+    clock_t t0 = clock();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        for (int i = 0; i < FIXES; i++)
+        {
+            coord_convert(ctx, &fixes[i], COORD_FORMAT_MGRS, DATUM_WGS84, text,
+                          sizeof(text));
+            sink += text[4];
+        }
+    }
+    clock_t t1 = clock();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        coord_display_init(ctx, COORD_FORMAT_MGRS, DATUM_WGS84, 4, &mgrs_session);
+        for (int i = 0; i < FIXES; i++)
+        {
+            coord_display_update(&mgrs_session, &fixes[i], &changed);
+            sink += (int)changed;
+        }
+    }
+    clock_t t2 = clock();
+    (void)sink;
+    printf("    %d fixes, MGRS: coord_convert %.2f ms, display session (10 m) %.2f ms\n",
+           ROUNDS * FIXES, 1000.0 * (t1 - t0) / CLOCKS_PER_SEC,
+           1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test lattice reprojection against per-point calls
+void test_project_lattice()
+{
+    printf("=== Test lattice projection ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    enum { NLAT = 256, NLON = 256 };
+    static double easting[NLAT * NLON], northing[NLAT * NLON];
+    static int zones[NLAT * NLON];
+    struct
+    {
+        const char *name;
+        CoordFormat format;
+        double lat0, lon0, step;
+    } cases[] =
+    {
+        {"UTM tile (Shanghai)", COORD_FORMAT_UTM, 31.0, 120.5, 0.004},
+        {"UTM tile (Norway exception)", COORD_FORMAT_UTM, 59.5, 2.5, 0.004},
+        {"British Grid tile (London)", COORD_FORMAT_BRITISH_GRID, 51.3, -0.6, 0.002}
+    };
+    for (int c = 0; c < 3; c++)
+    {
+        clock_t t0 = clock();
+        int ret = 0;
+        for (int rep = 0; rep < 5 && ret == COORD_SUCCESS; rep++)
+        {
+            ret = coord_project_lattice(ctx, cases[c].lat0, cases[c].step, NLAT,
+                                        cases[c].lon0, cases[c].step, NLON, DATUM_WGS84,
+                                        cases[c].format, easting, northing, zones);
+        }
+        clock_t t1 = clock();
+        if (ret != COORD_SUCCESS)
+        {
+            printf("  %s failed: %s\n", cases[c].name, coord_get_error_string(ret));
+            continue;
+        }
+        double worst = 0.0;
+        int zone_mismatch = 0;
+        for (int rep = 0; rep < 5; rep++)
+        {
+            for (int i = 0; i < NLAT; i++)
+            {
+                for (int j = 0; j < NLON; j++)
+                {
+                    GeoCoord geo = {cases[c].lat0 + cases[c].step * i,
+                                    cases[c].lon0 + cases[c].step * j, 0.0, DATUM_WGS84
+                                   };
+                    int k = i * NLON + j;
+                    if (cases[c].format == COORD_FORMAT_UTM)
+                    {
+                        UTMPoint utm;
+                        coord_to_utm(ctx, &geo, &utm);
+                        worst = fmax(worst, fmax(fabs(utm.easting - easting[k]),
+                                                 fabs(utm.northing - northing[k])));
+                        zone_mismatch += utm.zone != zones[k];
+                    }
+                    else
+                    {
+                        BritishGridPoint bg;
+                        coord_to_british_grid(ctx, &geo, &bg);
+                        worst = fmax(worst, fmax(fabs(bg.easting - easting[k]),
+                                                 fabs(bg.northing - northing[k])));
+                    }
+                }
+            }
+        }
+        clock_t t2 = clock();
+        double lattice_ms = 1000.0 * (t1 - t0) / CLOCKS_PER_SEC / 5;
+        double point_ms = 1000.0 * (t2 - t1) / CLOCKS_PER_SEC / 5;
+        printf("  %s: lattice %.2f ms, per-point %.2f ms, speedup %.1fx\n",
+               cases[c].name, lattice_ms, point_ms,
+               lattice_ms > 0.0 ? point_ms / lattice_ms : 0.0);
+        printf("    Max difference %.2e m, zone mismatches %d: %s\n", worst, zone_mismatch,
+               worst < 1e-6 && zone_mismatch == 0 ? "pass" : "fail");
+    }
+    // Column buffers whose size would overflow are refused before any write
+    size_t wide = SIZE_MAX / 4;
+    int utm_wide = coord_project_lattice(ctx, 51.0, 0.0, 1, 0.0, 0.0, wide, DATUM_WGS84,
+                                         COORD_FORMAT_UTM, easting, northing, zones);
+    int bng_wide = coord_project_lattice(ctx, 51.0, 0.0, 1, 0.0, 0.0, wide, DATUM_WGS84,
+                                         COORD_FORMAT_BRITISH_GRID, easting, northing,
+                                         NULL);
+    printf("  Overflowing lattice width rejected: %s\n",
+           utm_wide == COORD_ERROR_MEMORY && bng_wide == COORD_ERROR_MEMORY ?
+           "pass" : "fail");
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
+// Test adaptive interpolation meshes
+void test_projection_mesh()
+{
+    printf("=== Test adaptive interpolation mesh ===\n");
+    CoordContext *ctx = coord_create_context(DATUM_WGS84);
+    if (!ctx)
+    {
+        printf("Failed to create context\n");
+        return;
+    }
+    enum { COUNT = 100000 };
+    static double lat[COUNT], lon[COUNT], east[COUNT], north[COUNT];
+    srand(7);
+    for (int i = 0; i < COUNT; i++)
+    {
+        lat[i] = 50.5 + 2.0 * rand() / (double)RAND_MAX;
+        lon[i] = -2.5 + 3.0 * rand() / (double)RAND_MAX;
+    }
+    MeshInterp kinds[] = {MESH_INTERP_BILINEAR, MESH_INTERP_BICUBIC};
+    const char *names[] = {"bilinear", "bicubic"};
+    double bounds[] = {1.0, 0.001};
+    for (int m = 0; m < 2; m++)
+    {
+        ProjectionMesh *mesh = coord_mesh_create(ctx, COORD_FORMAT_BRITISH_GRID,
+                               DATUM_WGS84, 50.5, 52.5, -2.5, 0.5,
+                               bounds[m], kinds[m]);
+        if (!mesh)
+        {
+            printf("  Failed to create %s mesh\n", names[m]);
+            continue;
+        }
+        clock_t t0 = clock();
+        int ret = coord_mesh_eval_batch(mesh, lat, lon, COUNT, east, north);
+        clock_t t1 = clock();
+        double worst = 0.0;
+        for (int i = 0; i < COUNT; i++)
+        {
+            GeoCoord geo = {lat[i], lon[i], 0.0, DATUM_WGS84};
+            BritishGridPoint bg;
+            coord_to_british_grid(ctx, &geo, &bg);
+            worst = fmax(worst, fmax(fabs(bg.easting - east[i]), fabs(bg.northing - north[i])));
+        }
+        clock_t t2 = clock();
+        printf("  WGS84->BNG %s mesh: %zu cells, bound %.3f m, max error %.4f m: %s\n",
+               names[m], coord_mesh_cell_count(mesh), bounds[m], worst,
+               ret == COORD_SUCCESS && worst <= bounds[m] ? "pass" : "fail");
+        printf("    %d points: mesh %.2f ms, exact %.2f ms\n", COUNT,
+               1000.0 * (t1 - t0) / CLOCKS_PER_SEC, 1000.0 * (t2 - t1) / CLOCKS_PER_SEC);
+        // Serialize and reload
+        size_t size = coord_mesh_serialized_size(mesh);
+        void *buffer = malloc(size);
+        if (buffer && coord_mesh_serialize(mesh, buffer, size) == COORD_SUCCESS)
+        {
+            ProjectionMesh *loaded = coord_mesh_deserialize(buffer, size);
+            double e1, n1, e2, n2;
+            int same = loaded != NULL &&
+                       coord_mesh_eval(mesh, 51.5, -0.1, &e1, &n1) == COORD_SUCCESS &&
+                       coord_mesh_eval(loaded, 51.5, -0.1, &e2, &n2) == COORD_SUCCESS &&
+                       e1 == e2 && n1 == n2;
+            printf("    Serialized %zu bytes, reload matches: %s\n", size,
+                   same ? "pass" : "fail");
+            printf("    Truncated buffer rejected: %s\n",
+                   coord_mesh_deserialize(buffer, size / 2) == NULL ? "pass" : "fail");
+            // Header fields after magic and version: format, interp, datum, zone
+            // (int32 each); no build produces any of these values
+            const size_t offsets[] = {8, 16, 20, 20};
+            const int32_t values[] = {COORD_FORMAT_MGRS, DATUM_MAX, 0, 61};
+            int rejected = 1;
+            for (int f = 0; f < 4; f++)
+            {
+                int32_t saved;
+                memcpy(&saved, (char *)buffer + offsets[f], sizeof(saved));
+                memcpy((char *)buffer + offsets[f], &values[f], sizeof(values[f]));
+                ProjectionMesh *bad = coord_mesh_deserialize(buffer, size);
+                rejected &= bad == NULL;
+                coord_mesh_destroy(bad);
+                memcpy((char *)buffer + offsets[f], &saved, sizeof(saved));
+            }
+            printf("    Bad format, datum and zone rejected: %s\n", rejected ? "pass" : "fail");
+            coord_mesh_destroy(loaded);
+        }
+        free(buffer);
+        double e, n;
+        printf("    Outside window rejected: %s\n",
+               coord_mesh_eval(mesh, 55.0, 0.0, &e, &n) == COORD_ERROR_OUT_OF_RANGE ? "pass" :
+               "fail");
+        coord_mesh_destroy(mesh);
+    }
+    // A 0.1 mm bound over a whole degree needs millions of cells; a small
+    // budget makes the build give up early instead
+    coord_set_mesh_max_cells(ctx, 4096);
+    clock_t t0 = clock();
+    ProjectionMesh *huge = coord_mesh_create(ctx, COORD_FORMAT_UTM, DATUM_WGS84,
+                           31.0, 32.0, 121.0, 122.0, 1e-4, MESH_INTERP_BILINEAR);
+    printf("  Cell budget stops a 0.1 mm mesh after %.2f ms: %s\n",
+           1000.0 * (clock() - t0) / CLOCKS_PER_SEC, huge == NULL ? "pass" : "fail");
+    coord_mesh_destroy(huge);
+    printf("  Budget outside 1..67108863 rejected: %s\n",
+           coord_set_mesh_max_cells(ctx, 0) == COORD_ERROR_INVALID_INPUT &&
+           coord_set_mesh_max_cells(ctx, 67108864) == COORD_ERROR_INVALID_INPUT ? "pass" :
+           "fail");
+    coord_set_mesh_max_cells(ctx, 1048576);
+    // UTM mesh in the southern hemisphere
+    ProjectionMesh *utm_mesh = coord_mesh_create(ctx, COORD_FORMAT_UTM, DATUM_WGS84,
+                               -34.5, -33.0, 150.2, 151.8, 0.01,
+                               MESH_INTERP_BICUBIC);
+    if (utm_mesh)
+    {
+        GeoCoord sydney = {-33.868820, 151.209290, 0.0, DATUM_WGS84};
+        UTMPoint utm;
+        double e, n;
+        coord_to_utm(ctx, &sydney, &utm);
+        coord_mesh_eval(utm_mesh, sydney.latitude, sydney.longitude, &e, &n);
+        printf("  UTM mesh (Sydney): %zu cells, error %.4f m: %s\n",
+               coord_mesh_cell_count(utm_mesh), fmax(fabs(e - utm.easting), fabs(n - utm.northing)),
+               fabs(e - utm.easting) <= 0.01 && fabs(n - utm.northing) <= 0.01 ? "pass" : "fail");
+        coord_mesh_destroy(utm_mesh);
+    }
+    coord_destroy_context(ctx);
+    printf("\n");
+}
+
 // Test error handling
 void test_error_handling()
 {
@@ -862,6 +3661,29 @@ int main()
     test_coord_conversion();
     test_geodesic_calculation();
     test_datum_tools();
+    test_datum_shift_methods();
+    test_ecef_enu();
+    test_track_projector();
+    test_project_lattice();
+    test_projection_mesh();
+    test_trusted_batch();
+    test_worst_case_latency();
+    test_allocator_hooks();
+    test_convert_any();
+    test_convert_typed();
+    test_utm_zone_transform();
+    test_utm_batch();
+    test_utm_classifier();
+    test_packed_batches();
+    test_compressed_track();
+    test_locality_order();
+    test_web_mercator();
+    test_geohash_quadkey();
+    test_grid_aggregation();
+    test_arrow_interface();
+    test_trig_kernels();
+    test_shared_context_tables();
+    test_display_session();
     test_error_handling();
     test_comprehensive();
     printf("=== All tests completed ===\n");
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Correctness checks for the coordtransform extension.
+
+Build the extension first (see README, "Python Bindings"), then run:
+
+    python3 test_python_bindings.py
+
+Only array.array is used, so NumPy is not needed. Exits non-zero on failure.
+"""
+
+import array
+import sys
+
+import coordtransform as ct
+
+failures = 0
+
+
+def check(name, ok):
+    global failures
+    failures += not ok
+    print(f"  {name}: {'pass' if ok else 'fail'}")
+
+
+def doubles(*values):
+    return array.array("d", values)
+
+
+def fill(n, value=0.0, typecode="d"):
+    return array.array(typecode, [value] * n)
+
+
+def main():
+    print("=== Test Python bindings ===")
+    # The README's verification points: 50R NA 12425 22845, 56H LH 34436 50816
+    lat, lon = doubles(31.841234, -33.87), doubles(117.131325, 151.21)
+    easting, northing = fill(2), fill(2)
+    zone, band = fill(2, 0, "B"), fill(2, 0, "B")
+    ct.to_utm(lat, lon, easting, northing, zone, band)
+    check("to_utm zones and bands", list(zone) == [50, 56] and bytes(band) == b"RH")
+    check("to_utm eastings and northings",
+          abs(easting[0] - 512425.68) < 0.01 and abs(northing[0] - 3522845.41) < 0.01 and
+          abs(easting[1] - 334435.71) < 0.01 and abs(northing[1] - 6250816.40) < 0.01)
+
+    lat2, lon2 = fill(2), fill(2)
+    ct.from_utm(easting, northing, zone, band, lat2, lon2)
+    check("from_utm round trip",
+          max(abs(lat2[i] - lat[i]) + abs(lon2[i] - lon[i]) for i in range(2)) < 1e-7)
+
+    ct.convert_datum(lat, lon, lat2, lon2, ct.DATUM_WGS84, ct.DATUM_ED50)
+    shift = max(abs(lat2[i] - lat[i]) + abs(lon2[i] - lon[i]) for i in range(2))
+    check("convert_datum moves the points", 0.0 < shift < 0.01)
+
+    # Shanghai to Beijing
+    dist, azi1, azi2 = fill(1), fill(1), fill(1)
+    ct.distance(doubles(31.230416), doubles(121.473701), doubles(39.9042),
+                doubles(116.4074), dist, azi1, azi2)
+    check("distance and azimuths",
+          abs(dist[0] - 1065844.909) < 0.01 and abs(azi1[0] + 24.0692) < 1e-3 and
+          abs(azi2[0] + 27.0258) < 1e-3)
+
+    # A failing row raises and leaves its own and later outputs untouched
+    dist, azi1 = fill(3, -1.0), fill(3, -1.0)
+    try:
+        ct.distance(doubles(10.0, 95.0, 20.0), doubles(0.0, 0.0, 0.0),
+                    doubles(11.0, 11.0, 21.0), doubles(0.0, 0.0, 0.0), dist, azi1)
+        raised = False
+    except ValueError:
+        raised = True
+    check("distance stops at an invalid row",
+          raised and dist[0] > 0.0 and list(dist[1:]) == [-1.0, -1.0] and
+          list(azi1[1:]) == [-1.0, -1.0])
+
+    try:
+        ct.to_utm(doubles(1.0, 2.0), doubles(1.0), fill(2), fill(2), fill(2, 0, "B"),
+                  fill(2, 0, "B"))
+        raised = False
+    except ValueError:
+        raised = True
+    check("mismatched lengths rejected", raised)
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())